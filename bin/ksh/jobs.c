@@ -30,6 +30,7 @@
 #include "ksh_wait.h"
 #include "ksh_times.h"
 #include "tty.h"
+#include <spawn.h>
 
 /* Start of system configuration stuff */
 
@@ -223,6 +224,10 @@ static void		check_job ARGS((Job *j));
 static void		put_job ARGS((Job *j, int where));
 static void		remove_job ARGS((Job *j, const char *where));
 static int		kill_job ARGS((Job *j, int sig));
+#ifdef JOB_SIGS
+static pid_t		spawn_child ARGS((struct op *t, int flags, int close_fd,
+					  Job *j, sigset_t *omask));
+#endif /* JOB_SIGS */
 
 /* initialize job control */
 void
@@ -431,6 +436,73 @@ j_change()
 }
 #endif /* JOBS */
 
+#ifdef JOB_SIGS
+/* Start a simple command with posix_spawn(), so that the shell's address
+ * space needn't be copied.  Returns 0 if the caller should fall back to
+ * fork(), i.e. if the child needs some set up that posix_spawn() can't do
+ * or the command could not be executed directly (eg, it's a shell script).
+ */
+static pid_t
+spawn_child(t, flags, close_fd, j, omask)
+	struct op	*t;
+	int		flags;
+	int		close_fd;
+	Job		*j;
+	sigset_t	*omask;
+{
+	posix_spawn_file_actions_t fa;
+	posix_spawnattr_t sa;
+	sigset_t	sigdef;
+	short		sflags = POSIX_SPAWN_SETSIGMASK|POSIX_SPAWN_SETSIGDEF;
+	Trap		*p;
+	pid_t		pid;
+	int		i, rv;
+
+	if (t->type != TEXEC || (flags & XCOPROC)
+	    || ((flags & XBGND) && !Flag(FMONITOR)))
+		return 0;
+
+	/* see restoresigs() - signals can only be reset to SIG_DFL here */
+	sigemptyset(&sigdef);
+	for (i = SIGNALS+1, p = sigtraps; --i >= 0; p++) {
+		if ((p->flags & TF_EXEC_IGN) && p->cursig != SIG_IGN)
+			return 0;
+		if (p->flags & TF_EXEC_DFL)
+			sigaddset(&sigdef, p->signal);
+	}
+
+	posix_spawnattr_init(&sa);
+#ifdef JOBS
+	if (Flag(FMONITOR) && !(flags & XXCOM)) {
+# ifdef TTY_PGRP
+		for (i = NELEM(tt_sigs); --i >= 0; )
+			sigaddset(&sigdef, tt_sigs[i]);
+# endif /* TTY_PGRP */
+		/* first process of a job becomes the process group leader */
+		sflags |= POSIX_SPAWN_SETPGROUP;
+		posix_spawnattr_setpgroup(&sa, j->pgrp);
+	}
+#endif /* JOBS */
+	posix_spawnattr_setflags(&sa, sflags);
+	posix_spawnattr_setsigmask(&sa, omask);
+	posix_spawnattr_setsigdefault(&sa, &sigdef);
+
+	if (posix_spawn_file_actions_init(&fa)) {
+		posix_spawnattr_destroy(&sa);
+		return 0;
+	}
+	if ((flags & XCCLOSE) && close_fd >= 0)
+		posix_spawn_file_actions_addclose(&fa, close_fd);
+
+	rv = posix_spawn(&pid, t->str, &fa, &sa, t->args, makenv());
+
+	posix_spawn_file_actions_destroy(&fa);
+	posix_spawnattr_destroy(&sa);
+
+	return rv ? 0 : pid;
+}
+#endif /* JOB_SIGS */
+
 /* execute tree in child subprocess */
 int
 exchild(t, flags, close_fd)
@@ -509,12 +581,19 @@ exchild(t, flags, close_fd)
 	snptreef(p->command, sizeof(p->command), "%T", t);
 
 	/* create child process */
-	forksleep = 1;
-	while ((i = fork()) < 0 && errno == EAGAIN && forksleep < 32) {
-		if (intrsig)	 /* allow user to ^C out... */
-			break;
-		sleep(forksleep);
-		forksleep <<= 1;
+#ifdef JOB_SIGS
+	i = spawn_child(t, flags, close_fd, j, &omask);
+#else /* JOB_SIGS */
+	i = 0;
+#endif /* JOB_SIGS */
+	if (i == 0) {
+		forksleep = 1;
+		while ((i = fork()) < 0 && errno == EAGAIN && forksleep < 32) {
+			if (intrsig)	 /* allow user to ^C out... */
+				break;
+			sleep(forksleep);
+			forksleep <<= 1;
+		}
 	}
 	if (i < 0) {
 		kill_job(j, SIGKILL);
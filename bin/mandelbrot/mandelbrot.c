@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <fcntl.h>
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <sys/fb.h>
@@ -10,6 +11,7 @@
 #define WIDTH 640
 #define HEIGHT 480
 #define PALETTE_LEN 256
+#define NTHREADS 4
 
 #define STR(x) #x
 
@@ -62,17 +64,12 @@ static int fun(float re, float im) {
   return (50 - n) * 250 / 50;
 }
 
-int main(void) {
-  int vgafd = open("/dev/vga", O_WRONLY, 0);
-  if (vgafd < 0) {
-    printf("can't open /dev/vga file\n");
-    return 1;
-  }
+/* Rows are interleaved between threads, since some parts of the image take
+ * much longer to compute than others. */
+static void *render(void *arg) {
+  unsigned int first = (uintptr_t)arg;
 
-  prepare_videomode(vgafd);
-  prepare_palette(vgafd);
-
-  for (unsigned int y = 0; y < HEIGHT; y++) {
+  for (unsigned int y = first; y < HEIGHT; y += NTHREADS) {
     for (unsigned int x = 0; x < WIDTH; x++) {
       float re = (x / (float)WIDTH) * 2.0f - 1.0f;
       float im = (y / (float)HEIGHT) * 2.0f - 1.0f;
@@ -89,6 +86,31 @@ int main(void) {
     }
   }
 
+  return NULL;
+}
+
+int main(void) {
+  pthread_t threads[NTHREADS];
+
+  int vgafd = open("/dev/vga", O_WRONLY, 0);
+  if (vgafd < 0) {
+    printf("can't open /dev/vga file\n");
+    return 1;
+  }
+
+  prepare_videomode(vgafd);
+  prepare_palette(vgafd);
+
+  for (unsigned int i = 0; i < NTHREADS; i++) {
+    if (pthread_create(&threads[i], NULL, render, (void *)(uintptr_t)i)) {
+      printf("can't create rendering thread\n");
+      return 1;
+    }
+  }
+
+  for (unsigned int i = 0; i < NTHREADS; i++)
+    pthread_join(threads[i], NULL);
+
   /* Draw color scale at the top of the screen. */
   for (unsigned int x = 0; x < WIDTH; x++) {
     int q = 256.0f * x / WIDTH;
@@ -0,0 +1,69 @@
+/*
+ * ps - report process status
+ *
+ * Reads a snapshot of all processes from /dev/procstat. With -H each process
+ * is followed by its threads. RSS is expressed in kilobytes.
+ */
+#include <sys/types.h>
+#include <sys/procstat.h>
+
+#include <err.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <util.h>
+
+static void usage(void) {
+  fprintf(stderr, "usage: ps [-H]\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  bool hflag = false;
+  int ch;
+
+  while ((ch = getopt(argc, argv, "H")) != -1) {
+    switch (ch) {
+      case 'H':
+        hflag = true;
+        break;
+      default:
+        usage();
+    }
+  }
+
+  if (optind < argc)
+    usage();
+
+  kinfo_header_t *kh = procstat_read();
+  if (kh == NULL)
+    err(EXIT_FAILURE, "/dev/procstat");
+
+  printf("%5s %5s %5s %5s %5s %5s %6s %8s  %s\n", "EUID", "PID", "PPID",
+         "PGRP", "SID", "STAT", "RSS", "TIME", "COMMAND");
+
+  for (unsigned i = 0; i < kh->kh_nproc; i++) {
+    kinfo_proc_t *kp = kinfo_proc(kh, i);
+    unsigned secs = kp->kp_rtime / 1000000000;
+    unsigned rss = kp->kp_rss * kh->kh_pagesize / 1024;
+
+    printf("%5u %5d %5d %5d %5d %5c %6u %5u:%02u  %s\n", kp->kp_uid,
+           kp->kp_pid, kp->kp_ppid, kp->kp_pgrp, kp->kp_sid, kp->kp_stat, rss,
+           secs / 60, secs % 60, kp->kp_comm);
+
+    if (!hflag)
+      continue;
+
+    for (unsigned j = 0; j < kp->kp_nthread; j++) {
+      kinfo_thread_t *kt = kinfo_thread(kh, kp->kp_thread + j);
+      secs = kt->kt_rtime / 1000000000;
+
+      printf("%5s %5d %5s %5s %5s %5c %6s %5u:%02u    %s\n", "", kt->kt_tid,
+             "", "", "", kt->kt_stat, "", secs / 60, secs % 60, kt->kt_name);
+    }
+  }
+
+  free(kh);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+/*
+ * top - display processes sorted by processor usage
+ *
+ * Takes snapshots of /dev/procstat every few seconds and reports how much of
+ * the last interval each process (or thread with -H) spent running.
+ */
+#include <sys/types.h>
+#include <sys/procstat.h>
+
+#include <err.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <util.h>
+
+typedef struct entry {
+  void *rec;      /* kinfo_proc_t or kinfo_thread_t */
+  uint64_t rtime; /* [ns] time spent running during the interval */
+} entry_t;
+
+static kinfo_header_t *read_snapshot(void) {
+  kinfo_header_t *kh = procstat_read();
+  if (kh == NULL)
+    err(EXIT_FAILURE, "/dev/procstat");
+  return kh;
+}
+
+/* Running time of process `kp` since `prev` snapshot was taken. */
+static uint64_t proc_delta(kinfo_header_t *prev, kinfo_proc_t *kp) {
+  for (unsigned i = 0; i < prev->kh_nproc; i++) {
+    kinfo_proc_t *old = kinfo_proc(prev, i);
+    if (old->kp_pid == kp->kp_pid && old->kp_rtime <= kp->kp_rtime)
+      return kp->kp_rtime - old->kp_rtime;
+  }
+  /* Process has been created during the interval. */
+  return kp->kp_rtime;
+}
+
+/* Running time of thread `kt` since `prev` snapshot was taken. */
+static uint64_t thread_delta(kinfo_header_t *prev, kinfo_thread_t *kt) {
+  for (unsigned i = 0; i < prev->kh_nthread; i++) {
+    kinfo_thread_t *old = kinfo_thread(prev, i);
+    if (old->kt_tid == kt->kt_tid && old->kt_rtime <= kt->kt_rtime)
+      return kt->kt_rtime - old->kt_rtime;
+  }
+  /* Thread has been created during the interval. */
+  return kt->kt_rtime;
+}
+
+static int compare(const void *a, const void *b) {
+  const entry_t *e1 = a, *e2 = b;
+
+  if (e1->rtime != e2->rtime)
+    return e1->rtime < e2->rtime ? 1 : -1;
+  return 0;
+}
+
+/* Prints percentage of `interval` with a single decimal digit. */
+static void print_usage(uint64_t rtime, uint64_t interval) {
+  unsigned permille = rtime * 1000 / interval;
+  printf(" %3u.%u", permille / 10, permille % 10);
+}
+
+static void print_time(uint64_t ns) {
+  unsigned secs = ns / 1000000000;
+  printf(" %5u:%02u", secs / 60, secs % 60);
+}
+
+static void display(kinfo_header_t *prev, kinfo_header_t *cur, bool threads) {
+  uint64_t interval = cur->kh_uptime - prev->kh_uptime;
+  unsigned n = threads ? cur->kh_nthread : cur->kh_nproc;
+  uint64_t busy = 0;
+
+  if (interval == 0)
+    interval = 1;
+
+  entry_t *entries = calloc(n, sizeof(entry_t));
+  if (entries == NULL)
+    err(EXIT_FAILURE, "calloc");
+
+  for (unsigned i = 0; i < n; i++) {
+    entry_t *e = &entries[i];
+    if (threads) {
+      e->rec = kinfo_thread(cur, i);
+      e->rtime = thread_delta(prev, e->rec);
+    } else {
+      e->rec = kinfo_proc(cur, i);
+      e->rtime = proc_delta(prev, e->rec);
+    }
+    busy += e->rtime;
+  }
+
+  qsort(entries, n, sizeof(entry_t), compare);
+
+  if (isatty(STDOUT_FILENO))
+    printf("\033[H\033[J");
+
+  unsigned secs = cur->kh_uptime / 1000000000;
+  printf("up %u:%02u:%02u, %u processes, %u threads, cpu:", secs / 3600,
+         secs / 60 % 60, secs % 60, cur->kh_nproc, cur->kh_nthread);
+  print_usage(busy, interval);
+  printf("%% busy\n\n");
+
+  if (threads)
+    printf("%5s %5s %4s %4s %5s %8s  %s\n", "TID", "PID", "STAT", "PRI",
+           "%CPU", "TIME", "NAME");
+  else
+    printf("%5s %5s %4s %4s %6s %5s %8s  %s\n", "PID", "EUID", "STAT", "THR",
+           "RES", "%CPU", "TIME", "COMMAND");
+
+  for (unsigned i = 0; i < n; i++) {
+    entry_t *e = &entries[i];
+    if (threads) {
+      kinfo_thread_t *kt = e->rec;
+      printf("%5d %5d %4c %4u", kt->kt_tid, kt->kt_pid, kt->kt_stat,
+             kt->kt_prio);
+      print_usage(e->rtime, interval);
+      print_time(kt->kt_rtime);
+      printf("  %s\n", kt->kt_name);
+    } else {
+      kinfo_proc_t *kp = e->rec;
+      printf("%5d %5u %4c %4u %5lluK", kp->kp_pid, kp->kp_uid, kp->kp_stat,
+             kp->kp_nthread,
+             (unsigned long long)kp->kp_rss * cur->kh_pagesize / 1024);
+      print_usage(e->rtime, interval);
+      print_time(kp->kp_rtime);
+      printf("  %s\n", kp->kp_comm);
+    }
+  }
+
+  fflush(stdout);
+  free(entries);
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: top [-H] [-d delay] [-n count]\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  bool hflag = false;
+  int delay = 2, count = 0;
+  int ch;
+
+  while ((ch = getopt(argc, argv, "Hd:n:")) != -1) {
+    switch (ch) {
+      case 'H':
+        hflag = true;
+        break;
+      case 'd':
+        delay = atoi(optarg);
+        break;
+      case 'n':
+        count = atoi(optarg);
+        break;
+      default:
+        usage();
+    }
+  }
+
+  if (optind < argc || delay <= 0 || count < 0)
+    usage();
+
+  kinfo_header_t *prev = read_snapshot();
+
+  /* Zero count means run until interrupted. */
+  for (int i = 0; count == 0 || i < count; i++) {
+    sleep(delay);
+
+    kinfo_header_t *cur = read_snapshot();
+    display(prev, cur, hflag);
+    free(prev);
+    prev = cur;
+  }
+
+  free(prev);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,43 @@
+#include "utest.h"
+
+#include <sys/evcnt.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NRECS 512
+
+static evcnt_record_t recs[NRECS];
+
+static uint64_t evcnt_get(int fd, const char *group, const char *name) {
+  assert(lseek(fd, 0, SEEK_SET) == 0);
+
+  ssize_t n = read(fd, recs, sizeof(recs));
+  assert(n > 0 && n % sizeof(evcnt_record_t) == 0);
+
+  for (size_t i = 0; i < n / sizeof(evcnt_record_t); i++)
+    if (!strcmp(recs[i].er_group, group) && !strcmp(recs[i].er_name, name))
+      return recs[i].er_count;
+
+  assert(0);
+  return 0;
+}
+
+TEST_ADD(evcnt_syscall) {
+  int fd = open("/dev/evcnt", O_RDONLY);
+  assert(fd >= 0);
+
+  uint64_t before = evcnt_get(fd, "syscall", "getpid");
+  for (int i = 0; i < 10; i++)
+    getpid();
+  uint64_t after = evcnt_get(fd, "syscall", "getpid");
+
+  /* No other thread in the system is expected to call getpid meanwhile. */
+  assert(after - before == 10);
+
+  /* At least the process that started this test went to sleep. */
+  assert(evcnt_get(fd, "sched", "voluntary switch") > 0);
+
+  close(fd);
+  return 0;
+}
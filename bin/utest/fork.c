@@ -1,5 +1,8 @@
 #include "utest.h"
+#include "util.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <sched.h>
 #include <signal.h>
 #include <stdio.h>
@@ -61,3 +64,38 @@ TEST_ADD(fork_sigchld_ignored) {
   assert(wait(NULL) == -1);
   return 0;
 }
+
+/* Returns descriptor number that was opened by a child created with rfork. */
+static int rfork_open(int flags) {
+  int status;
+
+  pid_t pid = rfork(flags);
+  if (pid == 0)
+    _exit(open("/dev/null", O_RDONLY));
+
+  assert(pid > 0);
+  assert(waitpid(pid, &status, 0) == pid);
+  assert(WIFEXITED(status));
+  return WEXITSTATUS(status);
+}
+
+TEST_ADD(fork_rfork_fdtable) {
+  /* Descriptor opened by the child is visible to the parent. */
+  int fd = rfork_open(RFPROC);
+  assert(fd >= 0);
+  assert(fcntl(fd, F_GETFD) >= 0);
+  assert(close(fd) == 0);
+
+  /* ... unless the child got its own copy of the table. */
+  fd = rfork_open(RFPROC | RFFDG);
+  assert(fcntl(fd, F_GETFD) < 0);
+  assert(errno == EBADF);
+
+  /* Child created with an empty table gets descriptor number 0. */
+  assert(rfork_open(RFPROC | RFCFDG) == 0);
+
+  /* Creating a process is the only supported way of using rfork. */
+  assert(rfork(RFFDG) < 0);
+  assert(errno == EINVAL);
+  return 0;
+}
@@ -0,0 +1,138 @@
+#include "utest.h"
+#include "util.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/futex.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static void wait_until_ready(volatile int *ready, int n) {
+  while (*ready < n)
+    usleep(1000);
+  /* Give the waiters some time to actually fall asleep. */
+  usleep(10000);
+}
+
+TEST_ADD(futex_basic) {
+  int f = 0;
+  struct timespec ts = {.tv_sec = 0, .tv_nsec = 10000000};
+
+  /* Futex value doesn't match. */
+  assert(futex(&f, FUTEX_WAIT_PRIVATE, 1, NULL, NULL, 0) == -1);
+  assert(errno == EAGAIN);
+
+  /* Nobody wakes us up. */
+  assert(futex(&f, FUTEX_WAIT_PRIVATE, 0, &ts, NULL, 0) == -1);
+  assert(errno == ETIMEDOUT);
+
+  /* Nobody to wake up. */
+  assert(futex(&f, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0) == 0);
+
+  /* Misaligned address. */
+  assert(futex((int *)((char *)&f + 1), FUTEX_WAKE, 1, NULL, NULL, 0) == -1);
+  assert(errno == EINVAL);
+
+  return 0;
+}
+
+TEST_ADD(futex_shared) {
+  size_t pgsz = getpagesize();
+  volatile int *map =
+    mmap(NULL, pgsz, PROT_READ | PROT_WRITE, MAP_ANON | MAP_SHARED, -1, 0);
+  assert(map != (int *)MAP_FAILED);
+
+  int *f = (int *)&map[0];
+  volatile int *ready = &map[1];
+
+  pid_t pid = fork();
+  assert(pid >= 0);
+
+  if (pid == 0) {
+    __sync_fetch_and_add(ready, 1);
+    while (*f == 0)
+      futex(f, FUTEX_WAIT, 0, NULL, NULL, 0);
+    exit(0);
+  }
+
+  wait_until_ready(ready, 1);
+
+  *f = 1;
+  assert(futex(f, FUTEX_WAKE, 1, NULL, NULL, 0) == 1);
+
+  wait_for_child_exit(pid, 0);
+  assert(munmap((void *)map, pgsz) == 0);
+  return 0;
+}
+
+TEST_ADD(futex_requeue) {
+  size_t pgsz = getpagesize();
+  volatile int *map =
+    mmap(NULL, pgsz, PROT_READ | PROT_WRITE, MAP_ANON | MAP_SHARED, -1, 0);
+  assert(map != (int *)MAP_FAILED);
+
+  int *f1 = (int *)&map[0];
+  int *f2 = (int *)&map[1];
+  volatile int *ready = &map[2];
+  pid_t pid[2];
+
+  for (int i = 0; i < 2; i++) {
+    pid[i] = fork();
+    assert(pid[i] >= 0);
+
+    if (pid[i] == 0) {
+      __sync_fetch_and_add(ready, 1);
+      futex(f1, FUTEX_WAIT, 0, NULL, NULL, 0);
+      exit(0);
+    }
+  }
+
+  wait_until_ready(ready, 2);
+
+  /* Wake up one waiter and move the other one to the second futex. */
+  assert(futex(f1, FUTEX_REQUEUE, 1, NULL, f2, 1) == 1);
+  assert(futex(f1, FUTEX_WAKE, 1, NULL, NULL, 0) == 0);
+  assert(futex(f2, FUTEX_WAKE, 1, NULL, NULL, 0) == 1);
+
+  for (int i = 0; i < 2; i++)
+    wait_for_child_exit(pid[i], 0);
+
+  assert(munmap((void *)map, pgsz) == 0);
+  return 0;
+}
+
+TEST_ADD(futex_requeue_self) {
+  size_t pgsz = getpagesize();
+  volatile int *map =
+    mmap(NULL, pgsz, PROT_READ | PROT_WRITE, MAP_ANON | MAP_SHARED, -1, 0);
+  assert(map != (int *)MAP_FAILED);
+
+  int *f = (int *)&map[0];
+  volatile int *ready = &map[1];
+  pid_t pid[2];
+
+  for (int i = 0; i < 2; i++) {
+    pid[i] = fork();
+    assert(pid[i] >= 0);
+
+    if (pid[i] == 0) {
+      __sync_fetch_and_add(ready, 1);
+      futex(f, FUTEX_WAIT, 0, NULL, NULL, 0);
+      exit(0);
+    }
+  }
+
+  wait_until_ready(ready, 2);
+
+  /* Requeueing onto the same futex must not wake up or lose anyone. */
+  assert(futex(f, FUTEX_REQUEUE, 0, NULL, f, INT_MAX) == 0);
+  assert(futex(f, FUTEX_WAKE, 2, NULL, NULL, 0) == 2);
+
+  for (int i = 0; i < 2; i++)
+    wait_for_child_exit(pid[i], 0);
+
+  assert(munmap((void *)map, pgsz) == 0);
+  return 0;
+}
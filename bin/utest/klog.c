@@ -0,0 +1,52 @@
+#include "utest.h"
+
+#include <sys/klog.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+TEST_ADD(klog_read) {
+  static char buf[4096] __aligned(sizeof(uintptr_t));
+  bintime_t last = {};
+  ssize_t n;
+
+  int fd = open("/dev/klog", O_RDONLY);
+  assert(fd >= 0);
+
+  /* There can be only one reader. */
+  assert(open("/dev/klog", O_RDONLY) < 0);
+  assert(errno == EBUSY);
+
+  /* Make sure there's something in the log. */
+  getpid();
+
+  /* Only whole records are returned. */
+  assert(read(fd, buf, 1) < 0);
+  assert(errno == EINVAL);
+
+  assert((n = read(fd, buf, sizeof(buf))) > 0);
+
+  for (ssize_t off = 0; off < n;) {
+    klog_record_t *rec = (klog_record_t *)(buf + off);
+    assert(rec->kr_size > sizeof(klog_record_t));
+    assert(rec->kr_size % sizeof(uintptr_t) == 0);
+    assert(off + rec->kr_size <= n);
+
+    /* Both strings must be NUL-terminated within the record. */
+    const char *file = (const char *)(rec + 1);
+    size_t len = rec->kr_size - sizeof(klog_record_t);
+    size_t filelen = strnlen(file, len);
+    assert(filelen < len);
+    assert(strnlen(file + filelen + 1, len - filelen - 1) < len - filelen - 1);
+
+    /* Records are sorted by their timestamps. */
+    assert(bintime_cmp(&last, &rec->kr_timestamp, <=));
+    last = rec->kr_timestamp;
+
+    off += rec->kr_size;
+  }
+
+  close(fd);
+  return 0;
+}
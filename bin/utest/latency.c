@@ -0,0 +1,59 @@
+#include "utest.h"
+
+#include <sys/ioctl.h>
+#include <sys/latency.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+TEST_ADD(latency_tracer) {
+  latency_record_t lrs[LAT_NTYPES * LAT_NWORST];
+  bool seen[LAT_NTYPES] = {false};
+  int state, fds[2];
+  char c = 'x';
+
+  int fd = open("/dev/latency", O_RDONLY);
+  assert(fd >= 0);
+
+  assert(ioctl(fd, LATIOCRESET) == 0);
+  state = 1;
+  assert(ioctl(fd, LATIOCSSTATE, &state) == 0);
+  assert(ioctl(fd, LATIOCGSTATE, &state) == 0);
+  assert(state == 1);
+
+  /* Pipes wake up waiters with preemption disabled and context switches run
+   * with interrupts disabled. */
+  assert(pipe(fds) == 0);
+  for (int i = 0; i < 10; i++) {
+    assert(write(fds[1], &c, 1) == 1);
+    assert(read(fds[0], &c, 1) == 1);
+    sched_yield();
+  }
+  close(fds[0]);
+  close(fds[1]);
+
+  state = 0;
+  assert(ioctl(fd, LATIOCSSTATE, &state) == 0);
+
+  assert(read(fd, lrs, sizeof(lrs)) == sizeof(lrs));
+
+  for (int i = 0; i < LAT_NTYPES * LAT_NWORST; i++) {
+    if (lrs[i].lr_count == 0)
+      continue;
+    assert(lrs[i].lr_type >= 0 && lrs[i].lr_type < LAT_NTYPES);
+    assert(lrs[i].lr_start_pc != 0 && lrs[i].lr_end_pc != 0);
+    seen[lrs[i].lr_type] = true;
+  }
+  assert(seen[LAT_IRQSOFF] && seen[LAT_PREEMPTOFF]);
+
+  /* Reset forgets all sections. */
+  assert(ioctl(fd, LATIOCRESET) == 0);
+  assert(lseek(fd, 0, SEEK_SET) == 0);
+  assert(read(fd, lrs, sizeof(lrs)) == sizeof(lrs));
+  for (int i = 0; i < LAT_NTYPES * LAT_NWORST; i++)
+    assert(lrs[i].lr_count == 0);
+
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,48 @@
+#include "utest.h"
+
+#include <sys/memstat.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NRECS 256
+
+static memstat_record_t recs[NRECS];
+
+TEST_ADD(memstat_read) {
+  bool pool = false, kmalloc = false;
+  uint64_t order = 0;
+
+  int fd = open("/dev/memstat", O_RDONLY);
+  assert(fd >= 0);
+
+  ssize_t n = read(fd, recs, sizeof(recs));
+  assert(n > 0 && n % sizeof(memstat_record_t) == 0);
+  close(fd);
+
+  for (size_t i = 0; i < n / sizeof(memstat_record_t); i++) {
+    memstat_record_t *mr = &recs[i];
+
+    if (mr->mr_kind == MS_POOL && !strcmp(mr->mr_name, "thread")) {
+      /* At least this thread has been allocated from the pool. */
+      assert(mr->mr_pool.nused > 0);
+      assert(mr->mr_pool.nused <= mr->mr_pool.nmaxused);
+      assert(mr->mr_pool.nused <= mr->mr_pool.ntotal);
+      assert(mr->mr_pool.nempty <= mr->mr_pool.nslabs);
+      assert(mr->mr_pool.nused * mr->mr_pool.itemsize <= mr->mr_pool.nbytes);
+      pool = true;
+    } else if (mr->mr_kind == MS_KMALLOC &&
+               !strcmp(mr->mr_name, "temporaries")) {
+      assert(mr->mr_kmalloc.used <= mr->mr_kmalloc.maxused);
+      kmalloc = true;
+    } else if (mr->mr_kind == MS_PHYSMEM) {
+      /* Orders are reported in increasing sequence. */
+      assert(mr->mr_physmem.order == order++);
+      assert(mr->mr_physmem.npages > 0);
+    }
+  }
+
+  assert(pool && kmalloc && order > 0);
+  return 0;
+}
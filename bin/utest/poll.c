@@ -0,0 +1,213 @@
+#include "utest.h"
+#include "util.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/termios.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+TEST_ADD(poll_pipe) {
+  int pipe_fd[2];
+  char c;
+
+  assert(pipe(pipe_fd) == 0);
+
+  struct pollfd pfd[2] = {
+    {.fd = pipe_fd[0], .events = POLLIN},
+    {.fd = pipe_fd[1], .events = POLLOUT},
+  };
+
+  /* Empty pipe: only the write end is ready. */
+  assert(poll(pfd, 2, 0) == 1);
+  assert(pfd[0].revents == 0);
+  assert(pfd[1].revents == POLLOUT);
+
+  /* Nothing to read: time out after a while. */
+  assert(poll(pfd, 1, 10) == 0);
+  assert(pfd[0].revents == 0);
+
+  assert(write(pipe_fd[1], "x", 1) == 1);
+  assert(poll(pfd, 2, -1) == 2);
+  assert(pfd[0].revents == POLLIN);
+  assert(pfd[1].revents == POLLOUT);
+
+  assert(read(pipe_fd[0], &c, 1) == 1);
+  assert(poll(pfd, 1, 0) == 0);
+
+  /* Closed write end: the read end reports a hangup. */
+  close(pipe_fd[1]);
+  assert(poll(pfd, 1, -1) == 1);
+  assert(pfd[0].revents & POLLHUP);
+
+  close(pipe_fd[0]);
+  return 0;
+}
+
+TEST_ADD(poll_bad_fd) {
+  int pipe_fd[2];
+
+  assert(pipe(pipe_fd) == 0);
+  close(pipe_fd[1]);
+
+  struct pollfd pfd[3] = {
+    {.fd = pipe_fd[1], .events = POLLIN},
+    {.fd = -1, .events = POLLIN},
+    {.fd = pipe_fd[0], .events = 0},
+  };
+
+  /* Negative descriptors are ignored, closed ones are reported as invalid. */
+  assert(poll(pfd, 3, 0) == 1);
+  assert(pfd[0].revents == POLLNVAL);
+  assert(pfd[1].revents == 0);
+  assert(pfd[2].revents == 0);
+
+  close(pipe_fd[0]);
+  return 0;
+}
+
+TEST_ADD(poll_wakeup) {
+  int pipe_fd[2];
+  char c;
+
+  assert(pipe(pipe_fd) == 0);
+
+  pid_t pid = fork();
+  assert(pid >= 0);
+
+  if (pid == 0) {
+    close(pipe_fd[0]);
+    usleep(10000);
+    assert(write(pipe_fd[1], "x", 1) == 1);
+    exit(EXIT_SUCCESS);
+  }
+
+  close(pipe_fd[1]);
+
+  /* Sleep until the child writes to the pipe. */
+  struct pollfd pfd = {.fd = pipe_fd[0], .events = POLLIN};
+  assert(poll(&pfd, 1, -1) == 1);
+  assert(pfd.revents & POLLIN);
+  assert(read(pipe_fd[0], &c, 1) == 1);
+
+  wait_for_child_exit(pid, EXIT_SUCCESS);
+  close(pipe_fd[0]);
+  return 0;
+}
+
+TEST_ADD(poll_pty) {
+  int master_fd, slave_fd;
+  char c;
+
+  open_pty(&master_fd, &slave_fd);
+
+  struct termios t;
+  assert(tcgetattr(slave_fd, &t) == 0);
+  cfmakeraw(&t);
+  assert(tcsetattr(slave_fd, TCSANOW, &t) == 0);
+
+  struct pollfd pfd[2] = {
+    {.fd = master_fd, .events = POLLIN},
+    {.fd = slave_fd, .events = POLLIN},
+  };
+
+  assert(poll(pfd, 2, 0) == 0);
+
+  /* Data written to the master is available on the slave side. */
+  assert(write(master_fd, "x", 1) == 1);
+  assert(poll(pfd, 2, -1) == 1);
+  assert(pfd[0].revents == 0);
+  assert(pfd[1].revents == POLLIN);
+  assert(read(slave_fd, &c, 1) == 1);
+
+  /* ... and vice versa. */
+  assert(write(slave_fd, "x", 1) == 1);
+  assert(poll(pfd, 2, -1) == 1);
+  assert(pfd[0].revents == POLLIN);
+  assert(pfd[1].revents == 0);
+  assert(read(master_fd, &c, 1) == 1);
+
+  close(slave_fd);
+  close(master_fd);
+  return 0;
+}
+
+static sig_atomic_t sigusr1_handled;
+
+static void sigusr1_handler(int signo) {
+  sigusr1_handled = 1;
+}
+
+TEST_ADD(poll_ppoll_sigmask) {
+  int pipe_fd[2];
+  sigset_t mask, omask;
+
+  assert(pipe(pipe_fd) == 0);
+
+  sigusr1_handled = 0;
+  signal(SIGUSR1, sigusr1_handler);
+
+  /* Block SIGUSR1 and make it pending. */
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGUSR1);
+  assert(sigprocmask(SIG_BLOCK, &mask, &omask) == 0);
+  assert(kill(getpid(), SIGUSR1) == 0);
+  assert(!sigusr1_handled);
+
+  /* ppoll atomically unblocks SIGUSR1 and gets interrupted by it. */
+  struct pollfd pfd = {.fd = pipe_fd[0], .events = POLLIN};
+  sigemptyset(&mask);
+  assert(ppoll(&pfd, 1, NULL, &mask) == -1);
+  assert(errno == EINTR);
+  assert(sigusr1_handled);
+
+  /* Original mask has been restored. */
+  assert(sigprocmask(SIG_BLOCK, NULL, &mask) == 0);
+  assert(sigismember(&mask, SIGUSR1));
+
+  assert(sigprocmask(SIG_SETMASK, &omask, NULL) == 0);
+  signal(SIGUSR1, SIG_DFL);
+  close(pipe_fd[0]);
+  close(pipe_fd[1]);
+  return 0;
+}
+
+TEST_ADD(select_pipe) {
+  int pipe_fd[2];
+  fd_set rfds, wfds;
+  struct timeval tv = {.tv_sec = 0, .tv_usec = 10000};
+
+  assert(pipe(pipe_fd) == 0);
+  int nfds = (pipe_fd[0] > pipe_fd[1] ? pipe_fd[0] : pipe_fd[1]) + 1;
+
+  /* Nothing to read: time out after a while. */
+  FD_ZERO(&rfds);
+  FD_SET(pipe_fd[0], &rfds);
+  assert(select(nfds, &rfds, NULL, NULL, &tv) == 0);
+  assert(!FD_ISSET(pipe_fd[0], &rfds));
+
+  assert(write(pipe_fd[1], "x", 1) == 1);
+
+  FD_ZERO(&rfds);
+  FD_ZERO(&wfds);
+  FD_SET(pipe_fd[0], &rfds);
+  FD_SET(pipe_fd[1], &wfds);
+  assert(select(nfds, &rfds, &wfds, NULL, NULL) == 2);
+  assert(FD_ISSET(pipe_fd[0], &rfds));
+  assert(FD_ISSET(pipe_fd[1], &wfds));
+
+  /* Closed descriptors are reported as errors. */
+  close(pipe_fd[1]);
+  FD_ZERO(&wfds);
+  FD_SET(pipe_fd[1], &wfds);
+  assert(select(nfds, NULL, &wfds, NULL, NULL) == -1);
+  assert(errno == EBADF);
+
+  close(pipe_fd[0]);
+  return 0;
+}
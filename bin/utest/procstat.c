@@ -1,26 +1,53 @@
 #include "utest.h"
 
-#include <stdio.h>
+#include <sys/procstat.h>
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <unistd.h>
 
 TEST_ADD(procstat) {
-  int euid, pid, ppid, pgrp, session, got;
-  char state;
-#define PROC_COMM_MAX 128
-  char command[PROC_COMM_MAX];
+  static char buf[65536];
+  pid_t pid = getpid();
+  bool found = false;
+
+  int fd = open("/dev/procstat", O_RDONLY);
+  assert(fd >= 0);
+
+  /* Whole snapshot must be returned by a single read. */
+  ssize_t len = read(fd, buf, sizeof(buf));
+  assert(len >= (ssize_t)sizeof(kinfo_header_t));
+  assert(read(fd, buf, sizeof(buf)) == 0);
+  close(fd);
 
-  FILE *pstat = fopen("/dev/procstat", "r");
-  assert(pstat != NULL);
+  kinfo_header_t *kh = (kinfo_header_t *)buf;
+  assert(kh->kh_version == PROCSTAT_VERSION);
+  assert(kh->kh_procsize == sizeof(kinfo_proc_t));
+  assert(kh->kh_threadsize == sizeof(kinfo_thread_t));
+  assert(len == (ssize_t)(sizeof(kinfo_header_t) +
+                          kh->kh_nproc * sizeof(kinfo_proc_t) +
+                          kh->kh_nthread * sizeof(kinfo_thread_t)));
 
-  for (;;) {
-    if ((got = fscanf(pstat, "%d\t%d\t%d\t%d\t%d\t%c\t", &euid, &pid, &ppid,
-                      &pgrp, &session, &state)) == -1)
-      break;
+  kinfo_proc_t *kp = (kinfo_proc_t *)(kh + 1);
+  kinfo_thread_t *kt = (kinfo_thread_t *)(kp + kh->kh_nproc);
 
-    if (got < 6)
-      return 1;
+  for (unsigned i = 0; i < kh->kh_nproc; i++) {
+    assert(kp[i].kp_thread + kp[i].kp_nthread <= kh->kh_nthread);
 
-    if ((fgets(command, PROC_COMM_MAX, pstat)) == NULL)
-      return 1;
+    if (kp[i].kp_pid != pid)
+      continue;
+
+    found = true;
+    assert(kp[i].kp_stat == 'R');
+    assert(kp[i].kp_nthread == 1);
+
+    /* We're the thread that is running right now. */
+    kinfo_thread_t *td = &kt[kp[i].kp_thread];
+    assert(td->kt_pid == pid);
+    assert(td->kt_stat == 'O');
+    assert(td->kt_rtime > 0);
   }
+
+  assert(found);
   return 0;
 }
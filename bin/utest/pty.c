@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/event.h>
 #include <sys/fcntl.h>
 #include <sys/termios.h>
 #include <unistd.h>
@@ -64,3 +65,79 @@ TEST_ADD(pty_simple) {
 
   return 0;
 }
+
+/* Transfer blocks of data in both directions in raw mode. */
+TEST_ADD(pty_bulk) {
+  int master_fd, slave_fd;
+  open_pty(&master_fd, &slave_fd);
+
+  struct termios t;
+  assert(tcgetattr(slave_fd, &t) == 0);
+  cfmakeraw(&t);
+  assert(tcsetattr(slave_fd, TCSANOW, &t) == 0);
+
+  /* Must fit into tty queues, since nobody reads while we write. */
+  static char src[1000], dst[1000];
+  for (size_t i = 0; i < sizeof(src); i++)
+    src[i] = i % 251;
+
+  assert(write(master_fd, src, sizeof(src)) == sizeof(src));
+  for (size_t n = 0; n < sizeof(dst);) {
+    ssize_t r = read(slave_fd, dst + n, sizeof(dst) - n);
+    assert(r > 0);
+    n += r;
+  }
+  assert(memcmp(src, dst, sizeof(src)) == 0);
+
+  memset(dst, 0, sizeof(dst));
+  assert(write(slave_fd, src, sizeof(src)) == sizeof(src));
+  for (size_t n = 0; n < sizeof(dst);) {
+    ssize_t r = read(master_fd, dst + n, sizeof(dst) - n);
+    assert(r > 0);
+    n += r;
+  }
+  assert(memcmp(src, dst, sizeof(src)) == 0);
+
+  close(slave_fd);
+  close(master_fd);
+
+  return 0;
+}
+
+/* A knote on the master keeps reporting EOF only while the slave is closed. */
+TEST_ADD(pty_kqueue_reopen) {
+  int master_fd, slave_fd;
+  open_pty(&master_fd, &slave_fd);
+
+  struct termios t;
+  assert(tcgetattr(slave_fd, &t) == 0);
+  cfmakeraw(&t);
+  assert(tcsetattr(slave_fd, TCSANOW, &t) == 0);
+
+  int kq = kqueue();
+  assert(kq >= 0);
+
+  timespec_t nowait = {.tv_sec = 0, .tv_nsec = 0};
+  struct kevent kev;
+  EV_SET(&kev, master_fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+  assert(kevent(kq, &kev, 1, NULL, 0, &nowait) == 0);
+
+  close(slave_fd);
+  assert(kevent(kq, NULL, 0, &kev, 1, &nowait) == 1);
+  assert(kev.flags & EV_EOF);
+
+  slave_fd = open(ptsname(master_fd), O_NOCTTY | O_RDWR);
+  assert(slave_fd >= 0);
+  assert(kevent(kq, NULL, 0, &kev, 1, &nowait) == 0);
+
+  char c;
+  assert(write(slave_fd, "x", 1) == 1);
+  assert(kevent(kq, NULL, 0, &kev, 1, &nowait) == 1);
+  assert(!(kev.flags & EV_EOF));
+  assert(read(master_fd, &c, 1) == 1);
+
+  close(kq);
+  close(slave_fd);
+  close(master_fd);
+  return 0;
+}
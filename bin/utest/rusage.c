@@ -0,0 +1,56 @@
+#include "utest.h"
+#include "util.h"
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NPAGES 16
+
+/* Touches NPAGES fresh pages and returns number of faults it took. */
+static long touch_pages(void) {
+  struct rusage before, after;
+  size_t pgsz = getpagesize();
+
+  char *buf = mmap(NULL, NPAGES * pgsz, PROT_READ | PROT_WRITE,
+                   MAP_ANON | MAP_PRIVATE, -1, 0);
+  assert(buf != MAP_FAILED);
+
+  syscall_ok(getrusage(RUSAGE_SELF, &before));
+  for (int i = 0; i < NPAGES; i++)
+    buf[i * pgsz] = i;
+  syscall_ok(getrusage(RUSAGE_SELF, &after));
+
+  /* Memory gets zero-filled on first touch, so no I/O is involved. */
+  assert(after.ru_majflt == before.ru_majflt);
+  assert(after.ru_maxrss >= before.ru_maxrss);
+
+  munmap(buf, NPAGES * pgsz);
+  return after.ru_minflt - before.ru_minflt;
+}
+
+TEST_ADD(getrusage_faults) {
+  struct rusage ru;
+
+  assert(touch_pages() >= NPAGES);
+
+  syscall_ok(getrusage(RUSAGE_SELF, &ru));
+  assert(ru.ru_maxrss > 0);
+
+  /* Usage of children is accounted once they're waited for. */
+  syscall_ok(getrusage(RUSAGE_CHILDREN, &ru));
+  long minflt = ru.ru_minflt;
+
+  pid_t pid = fork();
+  if (pid == 0)
+    exit(touch_pages() < NPAGES);
+  wait_for_child_exit(pid, 0);
+
+  syscall_ok(getrusage(RUSAGE_CHILDREN, &ru));
+  assert(ru.ru_minflt - minflt >= NPAGES);
+
+  syscall_fail(getrusage(42, &ru), EINVAL);
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include "utest.h"
+
+#include <sys/ioctl.h>
+#include <sys/sdt.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+static int sdt_find_probe(int fd, const char *provider, const char *name) {
+  sdt_probe_info_t info;
+
+  for (info.spi_id = 0; ioctl(fd, SDTIOCGPROBE, &info) == 0; info.spi_id++)
+    if (!strcmp(info.spi_provider, provider) && !strcmp(info.spi_name, name))
+      return info.spi_id;
+
+  assert(errno == ENOENT);
+  return -1;
+}
+
+TEST_ADD(sdt_syscall) {
+  sdt_record_t recs[64];
+  bool found = false;
+  ssize_t n;
+
+  int fd = open("/dev/sdt", O_RDONLY);
+  assert(fd >= 0);
+
+  /* There's only one consumer buffer. */
+  assert(open("/dev/sdt", O_RDONLY) < 0);
+  assert(errno == EBUSY);
+
+  int entry = sdt_find_probe(fd, "syscall", "entry");
+  assert(entry >= 0);
+
+  /* Nothing is recorded until the probe gets enabled. */
+  getpid();
+  assert(read(fd, recs, sizeof(recs)) == 0);
+
+  assert(ioctl(fd, SDTIOCENABLE, &entry) == 0);
+  getpid();
+  assert(ioctl(fd, SDTIOCDISABLE, &entry) == 0);
+
+  /* Only whole records are returned. */
+  assert(read(fd, recs, 1) < 0);
+  assert(errno == EINVAL);
+
+  assert((n = read(fd, recs, sizeof(recs))) > 0);
+  assert(n % sizeof(sdt_record_t) == 0);
+
+  for (size_t i = 0; i < n / sizeof(sdt_record_t); i++) {
+    assert(recs[i].sr_probe == (unsigned)entry);
+    if (recs[i].sr_args[0] == SYS_getpid)
+      found = true;
+  }
+  assert(found);
+
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,89 @@
+#include "utest.h"
+#include "util.h"
+
+#include <errno.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+TEST_ADD(vfork_shared_memory) {
+  static volatile int value;
+
+  value = 0;
+
+  pid_t pid = vfork();
+  if (pid == 0) {
+    /* The parent is suspended until we exit, and then sees our changes. */
+    value = 42;
+    _exit(0);
+  }
+
+  assert(pid > 0);
+  assert(value == 42);
+  wait_for_child_exit(pid, 0);
+  return 0;
+}
+
+TEST_ADD(vfork_exec) {
+  pid_t pid = vfork();
+  if (pid == 0) {
+    execl("/bin/ksh", "ksh", "-c", "exit 7", NULL);
+    _exit(1);
+  }
+
+  assert(pid > 0);
+  wait_for_child_exit(pid, 7);
+  return 0;
+}
+
+TEST_ADD(posix_spawn_exit) {
+  char *const argv[] = {"ksh", "-c", "exit 7", NULL};
+  pid_t pid;
+
+  assert(posix_spawn(&pid, "/bin/ksh", NULL, NULL, argv, environ) == 0);
+  wait_for_child_exit(pid, 7);
+  return 0;
+}
+
+TEST_ADD(posix_spawn_file_actions) {
+  char *const argv[] = {"ksh", "-c", "echo spawned", NULL};
+  posix_spawn_file_actions_t fa;
+  char buf[16];
+  int fds[2];
+  pid_t pid;
+
+  assert(pipe(fds) == 0);
+  assert(posix_spawn_file_actions_init(&fa) == 0);
+  assert(posix_spawn_file_actions_adddup2(&fa, fds[1], STDOUT_FILENO) == 0);
+  assert(posix_spawn_file_actions_addclose(&fa, fds[0]) == 0);
+  assert(posix_spawn_file_actions_addclose(&fa, fds[1]) == 0);
+
+  assert(posix_spawn(&pid, "/bin/ksh", &fa, NULL, argv, environ) == 0);
+  assert(posix_spawn_file_actions_destroy(&fa) == 0);
+  close(fds[1]);
+
+  assert(read(fds[0], buf, sizeof(buf)) == 8);
+  assert(strncmp(buf, "spawned\n", 8) == 0);
+  close(fds[0]);
+
+  wait_for_child_exit(pid, 0);
+  return 0;
+}
+
+TEST_ADD(posix_spawn_noent) {
+  char *const argv[] = {"nonexistent", NULL};
+  pid_t pid;
+
+  assert(posix_spawn(&pid, "/nonexistent", NULL, NULL, argv, environ) ==
+         ENOENT);
+  assert(posix_spawnp(&pid, "nonexistent", NULL, NULL, argv, environ) ==
+         ENOENT);
+
+  /* Child that failed to start must have been reaped already. */
+  assert(waitpid(-1, NULL, WNOHANG) == -1);
+  assert(errno == ECHILD);
+  return 0;
+}
@@ -0,0 +1,166 @@
+#include "utest.h"
+#include "util.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NTHREADS 4
+
+static void *thread_retval(void *arg) {
+  return (void *)((uintptr_t)arg * 2);
+}
+
+TEST_ADD(thread_create_join) {
+  pthread_t td[NTHREADS];
+  void *retval;
+
+  for (uintptr_t i = 0; i < NTHREADS; i++)
+    assert(pthread_create(&td[i], NULL, thread_retval, (void *)i) == 0);
+
+  for (uintptr_t i = 0; i < NTHREADS; i++) {
+    assert(pthread_join(td[i], &retval) == 0);
+    assert(retval == (void *)(i * 2));
+  }
+
+  assert(pthread_join(pthread_self(), NULL) == EDEADLK);
+  return 0;
+}
+
+#define NINCREMENTS 10000
+
+static pthread_mutex_t counter_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int counter;
+
+static void *thread_increment(void *arg) {
+  for (int i = 0; i < NINCREMENTS; i++) {
+    pthread_mutex_lock(&counter_lock);
+    counter++;
+    if (i % 1000 == 0)
+      sched_yield();
+    pthread_mutex_unlock(&counter_lock);
+  }
+  return NULL;
+}
+
+TEST_ADD(thread_mutex) {
+  pthread_t td[NTHREADS];
+
+  for (int i = 0; i < NTHREADS; i++)
+    assert(pthread_create(&td[i], NULL, thread_increment, NULL) == 0);
+
+  for (int i = 0; i < NTHREADS; i++)
+    assert(pthread_join(td[i], NULL) == 0);
+
+  assert(counter == NTHREADS * NINCREMENTS);
+  assert(pthread_mutex_trylock(&counter_lock) == 0);
+  assert(pthread_mutex_trylock(&counter_lock) == EBUSY);
+  assert(pthread_mutex_unlock(&counter_lock) == 0);
+  return 0;
+}
+
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_nonempty = PTHREAD_COND_INITIALIZER;
+static int queue_items;
+
+static void *thread_consume(void *arg) {
+  pthread_mutex_lock(&queue_lock);
+  while (queue_items == 0)
+    pthread_cond_wait(&queue_nonempty, &queue_lock);
+  queue_items--;
+  pthread_mutex_unlock(&queue_lock);
+  return NULL;
+}
+
+TEST_ADD(thread_cond) {
+  pthread_t td[NTHREADS];
+
+  for (int i = 0; i < NTHREADS; i++)
+    assert(pthread_create(&td[i], NULL, thread_consume, NULL) == 0);
+
+  /* Let the consumers fall asleep on the condition variable. */
+  usleep(10000);
+
+  pthread_mutex_lock(&queue_lock);
+  queue_items = NTHREADS;
+  pthread_cond_broadcast(&queue_nonempty);
+  pthread_mutex_unlock(&queue_lock);
+
+  for (int i = 0; i < NTHREADS; i++)
+    assert(pthread_join(td[i], NULL) == 0);
+
+  assert(queue_items == 0);
+  return 0;
+}
+
+static volatile int sigusr1_ready;
+static pthread_t sigusr1_handled_by;
+
+static void sigusr1_handler(int signo) {
+  sigusr1_handled_by = pthread_self();
+}
+
+static void *thread_sigusr1(void *arg) {
+  sigset_t mask;
+
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGUSR1);
+  assert(pthread_sigmask(SIG_UNBLOCK, &mask, NULL) == 0);
+  sigusr1_ready = 1;
+
+  while (sigusr1_handled_by == NULL)
+    usleep(1000);
+  return NULL;
+}
+
+TEST_ADD(thread_sigmask) {
+  sigset_t mask, omask;
+  pthread_t td;
+
+  signal(SIGUSR1, sigusr1_handler);
+
+  /* The new thread inherits signal mask that blocks SIGUSR1. */
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGUSR1);
+  assert(pthread_sigmask(SIG_BLOCK, &mask, &omask) == 0);
+  assert(pthread_create(&td, NULL, thread_sigusr1, NULL) == 0);
+
+  while (!sigusr1_ready)
+    usleep(1000);
+
+  /* Only the other thread doesn't block the signal, so it must handle it. */
+  kill(getpid(), SIGUSR1);
+  assert(pthread_join(td, NULL) == 0);
+  assert(sigusr1_handled_by == td);
+
+  assert(pthread_sigmask(SIG_SETMASK, &omask, NULL) == 0);
+  signal(SIGUSR1, SIG_DFL);
+  return 0;
+}
+
+static void *thread_sleep(void *arg) {
+  for (;;)
+    pause();
+  return NULL;
+}
+
+static int exit_with_threads(void *arg) {
+  pthread_t td;
+
+  for (int i = 0; i < NTHREADS; i++)
+    assert(pthread_create(&td, NULL, thread_sleep, NULL) == 0);
+
+  /* Let the other threads fall asleep, then terminate all of them. */
+  usleep(10000);
+  return 42;
+}
+
+TEST_ADD(thread_exit) {
+  utest_spawn(exit_with_threads, NULL);
+  utest_child_exited(42);
+  return 0;
+}
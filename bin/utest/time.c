@@ -5,7 +5,11 @@
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/event.h>
+#include <sys/mman.h>
 #include <sys/time.h>
+#include <sys/timepage.h>
 
 TEST_ADD(gettimeofday) {
   timeval_t time1, time2;
@@ -151,3 +155,142 @@ TEST_ADD(itimer) {
   assert(!timerisset(&it2.it_interval));
   return 0;
 }
+
+static siginfo_t timer_si;
+
+static void timer_handler(int signo, siginfo_t *info, void *uctx) {
+  timer_si = *info;
+}
+
+TEST_ADD(timer_signal) {
+  sigaction_t sa = {.sa_sigaction = timer_handler, .sa_flags = SA_SIGINFO};
+  assert(sigaction(SIGUSR1, &sa, NULL) == 0);
+  sigset_t mask;
+  __sigemptyset(&mask);
+  sigaddset(&mask, SIGUSR1);
+  assert(sigprocmask(SIG_BLOCK, &mask, NULL) == 0);
+
+  struct sigevent sev = {.sigev_notify = SIGEV_SIGNAL,
+                         .sigev_signo = SIGUSR1,
+                         .sigev_value.sival_int = 42};
+  timer_t tid;
+  syscall_ok(timer_create(CLOCK_MONOTONIC, &sev, &tid));
+
+  /* Try non-canonical timespecs and a timer that doesn't exist. */
+  struct itimerspec its, its2;
+  memset(&its, 0, sizeof(its));
+  its.it_value.tv_nsec = 1000000000;
+  syscall_fail(timer_settime(tid, 0, &its, NULL), EINVAL);
+  its.it_value.tv_nsec = 0;
+  its.it_interval.tv_sec = -1;
+  syscall_fail(timer_settime(tid, 0, &its, NULL), EINVAL);
+  its.it_interval.tv_sec = 0;
+  its.it_value.tv_sec = 1;
+  syscall_fail(timer_settime(tid + 1, 0, &its, NULL), EINVAL);
+
+  /* No timer should be currently set. */
+  syscall_ok(timer_gettime(tid, &its2));
+  assert(!timespecisset(&its2.it_value));
+  assert(!timespecisset(&its2.it_interval));
+
+  /* Set periodic timer with period of 1ms. */
+  timespec_t t, t2;
+  syscall_ok(clock_gettime(CLOCK_MONOTONIC, &t));
+  memset(&its, 0, sizeof(its));
+  its.it_value.tv_nsec = 1000000;
+  its.it_interval.tv_nsec = 1000000;
+  syscall_ok(timer_settime(tid, 0, &its, NULL));
+  wait_for_signal(SIGUSR1);
+  wait_for_signal(SIGUSR1);
+  syscall_ok(clock_gettime(CLOCK_MONOTONIC, &t2));
+  timespecsub(&t2, &t, &t);
+  its.it_value.tv_nsec = 2000000;
+  assert(timespeccmp(&t, &its.it_value, >=));
+
+  /* The signal tells which timer has expired. */
+  assert(timer_si.si_signo == SIGUSR1);
+  assert(timer_si.si_code == SI_TIMER);
+  assert(timer_si.si_value.sival_int == 42);
+  assert(timer_si.si_timerid == tid);
+  assert(timer_getoverrun(tid) >= 0);
+
+  /* Clear the timer, the old setting should be returned. */
+  memset(&its, 0, sizeof(its));
+  syscall_ok(timer_settime(tid, 0, &its, &its2));
+  assert(its2.it_interval.tv_sec == 0 && its2.it_interval.tv_nsec == 1000000);
+  syscall_ok(timer_gettime(tid, &its2));
+  assert(!timespecisset(&its2.it_value));
+
+  syscall_ok(timer_delete(tid));
+  syscall_fail(timer_delete(tid), EINVAL);
+  return 0;
+}
+
+TEST_ADD(timer_kqueue) {
+  struct sigevent sev = {.sigev_notify = SIGEV_NONE};
+  timer_t tid;
+  syscall_ok(timer_create(CLOCK_REALTIME, &sev, &tid));
+
+  int kq = kqueue();
+  assert(kq >= 0);
+
+  timespec_t nowait = {.tv_sec = 0, .tv_nsec = 0};
+  struct kevent kev;
+  EV_SET(&kev, tid, EVFILT_TIMER, EV_ADD, 0, 0, &sev);
+  syscall_ok(kevent(kq, &kev, 1, NULL, 0, &nowait));
+
+  /* Expire at an absolute time 5ms from now and then every 5ms. */
+  struct itimerspec its;
+  memset(&its, 0, sizeof(its));
+  its.it_interval.tv_nsec = 5000000;
+  syscall_ok(clock_gettime(CLOCK_REALTIME, &its.it_value));
+  timespecadd(&its.it_value, &its.it_interval, &its.it_value);
+  syscall_ok(timer_settime(tid, TIMER_ABSTIME, &its, NULL));
+
+  /* Each expiration is reported once. */
+  int64_t expirations = 0;
+  while (expirations < 3) {
+    assert(kevent(kq, NULL, 0, &kev, 1, NULL) == 1);
+    assert(kev.ident == (uintptr_t)tid && kev.filter == EVFILT_TIMER);
+    assert(kev.udata == &sev);
+    assert(kev.data > 0);
+    expirations += kev.data;
+  }
+
+  /* A stopped timer doesn't report any events. */
+  memset(&its, 0, sizeof(its));
+  syscall_ok(timer_settime(tid, 0, &its, NULL));
+  kevent(kq, NULL, 0, &kev, 1, &nowait);
+  timespec_t wait = {.tv_sec = 0, .tv_nsec = 20000000};
+  assert(kevent(kq, NULL, 0, &kev, 1, &wait) == 0);
+
+  syscall_ok(timer_delete(tid));
+  syscall_ok(close(kq));
+  return 0;
+}
+
+TEST_ADD(timepage) {
+  timespec_t ts1, ts2;
+
+  /* Kernel's timekeeping data must not be writable by user. */
+  syscall_fail(mprotect((void *)TIMEPAGE_ADDR, getpagesize(),
+                        PROT_READ | PROT_WRITE),
+               EACCES);
+
+  /* Time computed from the page can't move backwards. */
+  syscall_ok(clock_gettime(CLOCK_MONOTONIC, &ts1));
+  for (int g = 0; g < 1000; g++) {
+    syscall_ok(clock_gettime(CLOCK_MONOTONIC, &ts2));
+    assert(!timespeccmp(&ts2, &ts1, <));
+    ts1 = ts2;
+  }
+
+  /* ... and agrees with time kept by the kernel. */
+  timespec_t rqt = {.tv_sec = 0, .tv_nsec = 10000000};
+  syscall_ok(clock_gettime(CLOCK_MONOTONIC, &ts1));
+  syscall_ok(nanosleep(&rqt, NULL));
+  syscall_ok(clock_gettime(CLOCK_MONOTONIC, &ts2));
+  timespecadd(&ts1, &rqt, &ts1);
+  assert(timespeccmp(&ts1, &ts2, <=));
+  return 0;
+}
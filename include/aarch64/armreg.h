@@ -67,6 +67,10 @@
 
 #define UL(x) UINT64_C(x)
 
+/* CNTKCTL_EL1 - Counter-timer Kernel Control register */
+#define CNTKCTL_EL0VCTEN (1 << 1) /* Allow EL0 virtual counter access */
+#define CNTKCTL_EL0PCTEN (1 << 0) /* Allow EL0 physical counter access */
+
 /* CNTHCTL_EL2 - Counter-timer Hypervisor Control register */
 #define CNTHCTL_EVNTI_MASK (0xf << 4) /* Bit to trigger event stream */
 #define CNTHCTL_EVNTDIR (1 << 3)      /* Control transition trigger bit */
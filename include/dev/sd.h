@@ -3,7 +3,6 @@
 
 /* Must be a power of two */
 #define DEFAULT_BLKSIZE 512
-#define SD_KERNEL_BLOCKS 4 /* Number of blocks buffered in kernel memory */
 
 /* The custom R7 response is handled just like R1 response, but has different
  * bitfields, same goes for R6 */
@@ -85,8 +85,12 @@ static inline void uart_tx_disable(device_t *dev) {
   methods->tx_disable(uart->u_state);
 }
 
-void uart_init(device_t *dev, const char *name, size_t buf_size, void *state,
-               tty_t *tty);
+void uart_init(device_t *dev, size_t buf_size, void *state, tty_t *tty);
+
+/* Register `filter` (usually `uart_intr`) for interrupt resource `irq` and
+ * pass received characters to the tty in high priority interrupt thread. */
+void uart_setup_intr(device_t *dev, resource_t *irq, ih_filter_t *filter,
+                     const char *name);
 
 intr_filter_t uart_intr(void *data /* device_t* */);
 
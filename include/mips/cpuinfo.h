@@ -19,6 +19,10 @@ typedef struct cpuinfo {
 
 extern cpuinfo_t cpuinfo;
 
+/* Non-zero if UserLocal register is implemented. Otherwise user-space reads
+ * of thread pointer are emulated. */
+extern int cpu_userlocal;
+
 void init_mips_cpu(void);
 
 #endif /* !_MIPS_CPUINFO_H_ */
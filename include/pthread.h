@@ -0,0 +1,67 @@
+#ifndef _PTHREAD_H_
+#define _PTHREAD_H_
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+#include <sys/time.h>
+
+typedef struct __pthread *pthread_t;
+
+typedef struct {
+  size_t pta_stacksize; /* size of stack allocated for a new thread */
+} pthread_attr_t;
+
+/* Value of `ptm_lock`: 0 - unlocked, 1 - locked, 2 - locked with waiters. */
+typedef struct {
+  int ptm_lock;
+} pthread_mutex_t;
+
+typedef struct {
+  int ptma_dummy;
+} pthread_mutexattr_t;
+
+/* `ptc_seq` is bumped on each signal or broadcast. */
+typedef struct {
+  int ptc_seq;
+} pthread_cond_t;
+
+typedef struct {
+  int ptca_dummy;
+} pthread_condattr_t;
+
+#define PTHREAD_MUTEX_INITIALIZER                                              \
+  { 0 }
+#define PTHREAD_COND_INITIALIZER                                               \
+  { 0 }
+
+#define PTHREAD_STACK_MIN 4096
+
+__BEGIN_DECLS
+int pthread_create(pthread_t *, const pthread_attr_t *, void *(*)(void *),
+                   void *);
+__noreturn void pthread_exit(void *);
+int pthread_join(pthread_t, void **);
+pthread_t pthread_self(void);
+int pthread_equal(pthread_t, pthread_t);
+
+int pthread_attr_init(pthread_attr_t *);
+int pthread_attr_destroy(pthread_attr_t *);
+int pthread_attr_getstacksize(const pthread_attr_t *, size_t *);
+int pthread_attr_setstacksize(pthread_attr_t *, size_t);
+
+int pthread_mutex_init(pthread_mutex_t *, const pthread_mutexattr_t *);
+int pthread_mutex_destroy(pthread_mutex_t *);
+int pthread_mutex_lock(pthread_mutex_t *);
+int pthread_mutex_trylock(pthread_mutex_t *);
+int pthread_mutex_unlock(pthread_mutex_t *);
+
+int pthread_cond_init(pthread_cond_t *, const pthread_condattr_t *);
+int pthread_cond_destroy(pthread_cond_t *);
+int pthread_cond_wait(pthread_cond_t *, pthread_mutex_t *);
+int pthread_cond_timedwait(pthread_cond_t *, pthread_mutex_t *,
+                           const struct timespec *);
+int pthread_cond_signal(pthread_cond_t *);
+int pthread_cond_broadcast(pthread_cond_t *);
+__END_DECLS
+
+#endif /* !_PTHREAD_H_ */
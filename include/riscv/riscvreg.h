@@ -83,6 +83,10 @@
 #define SSTATUS_SD (1 << 31)
 #endif
 
+#define SCOUNTEREN_CY (1 << 0)
+#define SCOUNTEREN_TM (1 << 1)
+#define SCOUNTEREN_IR (1 << 2)
+
 #define SIE_USIE (1 << 0)
 #define SIE_SSIE (1 << 1)
 #define SIE_UTIE (1 << 4)
@@ -16,6 +16,7 @@ struct pmap {
   paddr_t pde;                    /* directory page table physical address */
   vm_pagelist_t pte_pages;        /* pages we allocate in page table */
   TAILQ_HEAD(, pv_entry) pv_list; /* all pages mapped by this physical map */
+  size_t resident;                /* number of entries on `pv_list` */
 
   /* Machine-dependent part */
   pmap_md_t md;
@@ -0,0 +1,120 @@
+#ifndef _SYS_BIO_H_
+#define _SYS_BIO_H_
+
+#include <sys/condvar.h>
+#include <sys/mutex.h>
+#include <sys/queue.h>
+
+/*
+ * Asynchronous block I/O requests.
+ *
+ * Block device drivers provide a routine that transfers a run of blocks and
+ * register it with a request queue. Callers submit requests to the queue and
+ * either wait for them or get notified with a completion callback, so they can
+ * overlap I/O with computation.
+ *
+ * A worker thread dispatches queued requests in ascending order of block
+ * numbers, wrapping around at the end of the device (C-LOOK elevator).
+ * Requests of the same kind for adjacent blocks are merged into a single
+ * transfer of at most BIO_MAXIO bytes. A queue can be plugged to collect
+ * a burst of requests before any of them is dispatched.
+ */
+
+/* Maximum number of bytes moved by a single call to transfer routine. */
+#define BIO_MAXIO (64 * 1024)
+
+typedef struct uio uio_t;
+typedef struct thread thread_t;
+typedef struct bio bio_t;
+typedef struct bio_queue bio_queue_t;
+
+typedef enum { BIO_READ, BIO_WRITE } bio_cmd_t;
+
+/* Called by the worker thread once request is done. From then on the request
+ * belongs to the callback, which may e.g. free it. */
+typedef void (*bio_done_t)(bio_t *bp);
+
+/* Transfers `nblks` blocks starting with `blkno` from or to `data`.
+ * May sleep. Returns 0 on success or an errno value. */
+typedef int (*bio_transfer_t)(void *arg, bio_cmd_t cmd, uint64_t blkno,
+                              void *data, size_t nblks);
+
+typedef TAILQ_HEAD(, bio) bio_list_t;
+
+#define BIO_DONE 1 /* request has been completed */
+
+typedef struct bio {
+  TAILQ_ENTRY(bio) bio_link; /* (q) link on queue or list of merged requests */
+  bio_cmd_t bio_cmd;         /* read or write */
+  unsigned bio_flags;        /* (q) BIO_* flags */
+  uint64_t bio_blkno;        /* first block to transfer */
+  size_t bio_bcount;         /* number of bytes, multiple of block size */
+  void *bio_data;            /* kernel buffer for data */
+  int bio_error;             /* error reported by the driver */
+  bio_done_t bio_done;       /* completion callback or NULL for bio_wait */
+  void *bio_arg;             /* argument for the callback */
+} bio_t;
+
+typedef struct bio_queue {
+  mtx_t bq_lock;              /* (q) protects fields marked with (q) */
+  mtx_t bq_write_lock;        /* serializes writes done by `bioq_uio` */
+  bio_list_t bq_queue;        /* (q) pending requests sorted by block number */
+  condvar_t bq_nonempty;      /* (q) wakes up the worker */
+  condvar_t bq_done;          /* (q) wakes up threads waiting for requests */
+  uint64_t bq_nextblk;        /* (q) elevator position */
+  unsigned bq_plugged;        /* (q) don't dispatch requests if non-zero */
+  bool bq_dying;              /* (q) worker should exit */
+  size_t bq_blksize;          /* size of a block in bytes */
+  uint64_t bq_nblks;          /* number of blocks on the device */
+  bio_transfer_t bq_transfer; /* driver's transfer routine */
+  void *bq_arg;               /* argument for transfer routine */
+  thread_t *bq_thread;        /* worker that dispatches requests */
+  unsigned bq_ntransfers;     /* (q) number of calls to transfer routine */
+  unsigned bq_nmerged;        /* (q) requests merged with preceding ones */
+} bio_queue_t;
+
+/*! \brief Initializes request queue of a device and starts its worker.
+ *
+ * \param name name of the worker thread
+ * \param blksize size of device's block in bytes
+ * \param nblks number of blocks on the device
+ * \param transfer routine that performs transfers on behalf of the queue */
+void bioq_init(bio_queue_t *bq, const char *name, size_t blksize,
+               uint64_t nblks, bio_transfer_t transfer, void *arg);
+
+/*! \brief Waits for pending requests, stops the worker and frees resources. */
+void bioq_destroy(bio_queue_t *bq);
+
+/*! \brief Stops dispatching requests until matching \a bioq_unplug.
+ *
+ * Calls can nest. */
+void bioq_plug(bio_queue_t *bq);
+
+/*! \brief Resumes dispatching requests. */
+void bioq_unplug(bio_queue_t *bq);
+
+/*! \brief Queues request \a bp and returns immediately.
+ *
+ * Fields other than those marked with (q) must be filled in by the caller.
+ * The request must not be touched until it's done. */
+void bio_submit(bio_queue_t *bq, bio_t *bp);
+
+/*! \brief Waits until \a bp is done.
+ *
+ * Only requests without a completion callback can be waited for.
+ *
+ * \returns error reported for the request */
+int bio_wait(bio_queue_t *bq, bio_t *bp);
+
+/*! \brief Transfers \a nblks blocks between the device and \a data.
+ *
+ * The transfer is split into requests which are submitted together. */
+int bioq_rw(bio_queue_t *bq, bio_cmd_t cmd, uint64_t blkno, void *data,
+            size_t nblks);
+
+/*! \brief Implements read and write for device nodes of block devices.
+ *
+ * Offset and length of \a uio don't have to be aligned to block size. */
+int bioq_uio(bio_queue_t *bq, uio_t *uio);
+
+#endif /* !_SYS_BIO_H_ */
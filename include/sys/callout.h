@@ -13,13 +13,15 @@ typedef struct callout {
   timeout_t c_func; /* function to call */
   void *c_arg;      /* function argument */
   uint32_t c_flags;
-  unsigned c_index; /* index of bucket this callout is assigned to */
+  unsigned c_index; /* index of wheel slot this callout is assigned to */
+  unsigned c_cpu;   /* processor whose wheel holds this callout */
 } callout_t;
 
 /* callout has been delegated to callout thread and will be executed soon */
 #define CALLOUT_ACTIVE 0x0001
 #define CALLOUT_PENDING 0x0002 /* callout is waiting for timeout */
 #define CALLOUT_STOPPED 0x0004 /* disallow rescheduling */
+#define CALLOUT_DIRECT 0x0008  /* run in interrupt context */
 
 /*! \brief Called during kernel initialization. */
 void init_callout(void);
@@ -27,6 +29,13 @@ void init_callout(void);
 /* Set up callout @co to call @fn with argument @arg. */
 void callout_setup(callout_t *co, timeout_t fn, void *arg);
 
+/*
+ * Like callout_setup, but @fn will be called directly by system clock in
+ * interrupt context instead of callout thread. Thus @fn must neither sleep nor
+ * acquire sleep mutexes.
+ */
+void callout_setup_direct(callout_t *co, timeout_t fn, void *arg);
+
 /*
  * Add a callout to the queue, using time relative to current time.
  * After ticks @tm passed callout's function will be called.
@@ -63,12 +72,28 @@ bool callout_reschedule(callout_t *co, systime_t tm);
  */
 bool callout_stop(callout_t *handle);
 
+/*
+ * Delegate a callout to callout thread to be executed as soon as possible,
+ * even if it's a direct one. May be called from interrupt context, e.g. by
+ * a hrtimer's function.
+ *
+ * \return False if the callout is already pending or running, in which case
+ * nothing is done.
+ */
+bool callout_run(callout_t *co);
+
 /*
  * Process all callouts that happened since last time and delegate them to
  * callout thread.
  */
 void callout_process(systime_t now);
 
+/*
+ * Returns the time of the earliest pending callout, or \a limit if there are
+ * no callouts due before it.
+ */
+systime_t callout_next(systime_t limit);
+
 /*
  * Wait until a callout ends its execution or return immediately if the
  * callout has already been executed or stopped.
@@ -2,6 +2,7 @@
 #define _SYS_CONDVAR_H_
 
 #include <sys/types.h>
+#include <sys/time.h>
 
 typedef struct mtx mtx_t;
 
@@ -44,6 +45,12 @@ void cv_wait(condvar_t *cv, mtx_t *m);
  */
 int cv_wait_timed(condvar_t *cv, mtx_t *m, systime_t timeout);
 
+/*! \brief Same as \a cv_wait_timed but with high-resolution timeout.
+ *
+ * \arg deadline time since the start of system at which the wait times out
+ */
+int cv_wait_until(condvar_t *cv, mtx_t *m, bintime_t deadline);
+
 /*! \brief Wake a single thread waiting on a conditional variable.
  *
  * If there are multiple waiting threads then the one with the highest priority
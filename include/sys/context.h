@@ -31,6 +31,16 @@ void mcontext_copy(mcontext_t *to, mcontext_t *from);
 /*! \brief Prepare ctx to jump into a user-space program. */
 void mcontext_init(mcontext_t *ctx, void *pc, void *sp);
 
+/*! \brief Prepare ctx of a new user thread to call `pc(arg)` on stack `sp`.
+ *
+ * Registers unrelated to the call are left intact, so the new thread inherits
+ * them from the context ctx was copied from. */
+void mcontext_setup_thread(mcontext_t *ctx, void *pc, void *sp,
+                           register_t arg);
+
+/*! \brief Set thread pointer (i.e. TLS base address) within the ctx. */
+void mcontext_set_tls(mcontext_t *ctx, void *tls);
+
 /*! \brief Set a return value within the ctx and advance the program counter.
  *
  * Useful for returning values from syscalls. */
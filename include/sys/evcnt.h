@@ -0,0 +1,80 @@
+#ifndef _SYS_EVCNT_H_
+#define _SYS_EVCNT_H_
+
+#include <sys/types.h>
+
+/*
+ * Event counters.
+ *
+ * An event counter is a named 64-bit counter that belongs to a group, e.g.
+ * "intr" group has a counter for each interrupt event. Counters are kept per
+ * CPU, hence they're cheap to update. All attached counters can be read from
+ * /dev/evcnt as an array of evcnt_record_t, where each count is summed up
+ * over all CPUs.
+ */
+
+#define EVCNT_GROUPLEN 16
+#define EVCNT_NAMELEN 32
+
+typedef struct evcnt_record {
+  char er_group[EVCNT_GROUPLEN];
+  char er_name[EVCNT_NAMELEN];
+  uint64_t er_count;
+} evcnt_record_t;
+
+#ifdef _KERNEL
+
+#include <sys/linker_set.h>
+#include <sys/pcpu.h>
+#include <sys/queue.h>
+
+typedef struct evcnt {
+  TAILQ_ENTRY(evcnt) ev_link; /* link on list of attached counters */
+  const char *ev_group;       /* group the counter belongs to */
+  const char *ev_name;        /* name of the counter within the group */
+  uint64_t ev_count[MAXCPU];  /* per-CPU counts */
+} evcnt_t;
+
+#define EVCNT_INITIALIZER(group, name)                                         \
+  { .ev_group = (group), .ev_name = (name) }
+
+/* Define a counter, which gets attached by `init_evcnt`. */
+#define EVCNT_DEFINE(sym, group, name)                                         \
+  evcnt_t sym = EVCNT_INITIALIZER(group, name);                                \
+  SET_ENTRY(evcnt_static, sym)
+
+/* Register a function that attaches dynamically initialized counters
+ * during `init_evcnt`. */
+#define EVCNT_ATTACH_INIT(fn) SET_ENTRY(evcnt_ctor_table, fn)
+
+/*! \brief Counts a single event.
+ *
+ * Counts aren't updated atomically, so an update may get lost if the counter
+ * is concurrently incremented by an interrupt on the same CPU. That's fine
+ * for statistics. */
+static inline void evcnt_inc(evcnt_t *ev) {
+  ev->ev_count[curcpu]++;
+}
+
+static inline void evcnt_add(evcnt_t *ev, uint64_t n) {
+  ev->ev_count[curcpu] += n;
+}
+
+/*! \brief Returns count of events summed up over all CPUs. */
+uint64_t evcnt_value(evcnt_t *ev);
+
+/*! \brief Makes a counter visible through /dev/evcnt.
+ *
+ * \a group and \a name must not be freed until the counter is detached. */
+void evcnt_attach(evcnt_t *ev, const char *group, const char *name);
+
+/*! \brief Removes a counter from the list of attached counters. */
+void evcnt_detach(evcnt_t *ev);
+
+/*! \brief Attaches static counters and runs initializers registered with
+ * EVCNT_ATTACH_INIT. */
+void init_evcnt(void);
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_EVCNT_H_ */
@@ -20,7 +20,8 @@
 /* Filter types */
 #define EVFILT_READ 0U
 #define EVFILT_WRITE 1U
-#define EVFILT_SYSCOUNT 2U /* number of filters */
+#define EVFILT_TIMER 2U    /* ident is ID of a timer from timer_create */
+#define EVFILT_SYSCOUNT 3U /* number of filters */
 
 struct kevent {
   uintptr_t ident; /* identifier for this event */
@@ -45,7 +46,11 @@ struct kevent {
 #define EV_ADD 0x0001U    /* add event to kq */
 #define EV_DELETE 0x0002U /* delete event from kq */
 
+/* flags */
+#define EV_CLEAR 0x0020U /* clear event state after reporting */
+
 /* returned values */
+#define EV_EOF 0x8000U   /* EOF detected */
 #define EV_ERROR 0x4000U /* error, data contains errno */
 
 #ifdef _KERNEL
@@ -94,8 +99,8 @@ typedef struct knote {
   void *kn_obj;                   /* (!) monitored object */
   uint32_t kn_status;             /* (q) flags above */
 
-  /* (o) only applies to `fflags`, `data`, `udata`. The rest should remain
-   * unmodified. */
+  /* (o) only applies to `fflags`, `data`, `udata` and `EV_EOF` in `flags`.
+   * The rest should remain unmodified. */
   kevent_t kn_kevent;
 
   /* Following fields should be only set in the filt_attach function and aren't
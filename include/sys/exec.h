@@ -24,6 +24,21 @@ struct exec_args {
   size_t left; /* space left in the buffer */
 };
 
+void exec_args_init(exec_args_t *args);
+void exec_args_destroy(exec_args_t *args);
+
+/*! \brief Copies program path, arguments and environment from user space. */
+int exec_args_copyin(exec_args_t *args, const char *u_path,
+                     char *const *u_argp, char *const *u_envp);
+
+/*! \brief Replaces the program run by the current process.
+ *
+ * The calling thread must be the only one in the process, i.e. all other
+ * threads must have been forcefully terminated before.
+ *
+ * \returns EJUSTRETURN on success */
+int exec_program(exec_args_t *args);
+
 int exec_elf_inspect(vnode_t *vn, Elf_Ehdr *eh);
 int exec_elf_load(proc_t *p, vnode_t *vn, Elf_Ehdr *eh);
 int exec_shebang_inspect(vnode_t *vn);
@@ -14,8 +14,13 @@ void fdtab_drop(fdtab_t *fdt);
 
 /* Allocates a new descriptor table. */
 fdtab_t *fdtab_create(void);
-/* Allocates a new descriptor table making it a copy of an existing one. */
-fdtab_t *fdtab_copy(fdtab_t *fdt);
+/* Allocates a new descriptor table making it a copy of an existing one.
+ * If `onfork` is set, then descriptors that cannot be inherited by forked
+ * process are omitted. */
+fdtab_t *fdtab_copy(fdtab_t *fdt, bool onfork);
+/* Makes sure the caller holds the only reference to the table, by replacing
+ * a shared table with its private copy. Returns the table to be used. */
+fdtab_t *fdtab_unshare(fdtab_t *fdt);
 /* Assign a file structure to a new descriptor with number >= minfd.
  * Increments reference counter of `f` file. */
 int fdtab_install_file(fdtab_t *fdt, file_t *f, int minfd, int *fdp);
@@ -34,7 +39,5 @@ int fd_set_cloexec(fdtab_t *fdt, int fd, bool exclose);
 int fd_get_cloexec(fdtab_t *fdt, int fd, int *resp);
 /* Close file descriptors with cloexec flag. */
 int fdtab_onexec(fdtab_t *fdt);
-/* Close file descriptors which cannot be inherited by forked process. */
-int fdtab_onfork(fdtab_t *fdt);
 
 #endif /* !_SYS_FILEDESC_H_ */
@@ -0,0 +1,54 @@
+#ifndef _SYS_FUTEX_H_
+#define _SYS_FUTEX_H_
+
+#include <sys/types.h>
+
+/* Futex operations. */
+#define FUTEX_WAIT 0
+#define FUTEX_WAKE 1
+#define FUTEX_REQUEUE 3
+
+/* Futex is used only within one address space, so it can be identified by
+ * its virtual address alone (saves a lookup of the mapping). */
+#define FUTEX_PRIVATE_FLAG 128
+
+#define FUTEX_CMD_MASK (~FUTEX_PRIVATE_FLAG)
+
+#define FUTEX_WAIT_PRIVATE (FUTEX_WAIT | FUTEX_PRIVATE_FLAG)
+#define FUTEX_WAKE_PRIVATE (FUTEX_WAKE | FUTEX_PRIVATE_FLAG)
+#define FUTEX_REQUEUE_PRIVATE (FUTEX_REQUEUE | FUTEX_PRIVATE_FLAG)
+
+#ifdef _KERNEL
+
+typedef struct proc proc_t;
+typedef struct timespec timespec_t;
+
+/*! \brief Called during kernel initialization. */
+void init_futex(void);
+
+/*! \brief Performs futex operation on behalf of process \a p.
+ *
+ *  - FUTEX_WAIT: if `*uaddr == val` sleep until woken up by FUTEX_WAKE
+ *    or until relative timeout \a tsp expires (never if NULL),
+ *  - FUTEX_WAKE: wake up at most \a val threads waiting on \a uaddr,
+ *  - FUTEX_REQUEUE: wake up at most \a val threads waiting on \a uaddr and
+ *    move at most \a val2 remaining ones to wait on \a uaddr2.
+ *
+ * For wake operations \a retval is set to the number of woken up threads. */
+int do_futex(proc_t *p, int *uaddr, int op, int val, timespec_t *tsp,
+             int *uaddr2, int val2, int *retval);
+
+#else /* !_KERNEL */
+
+#include <sys/cdefs.h>
+
+struct timespec;
+
+__BEGIN_DECLS
+int futex(int *uaddr, int op, int val, const struct timespec *timeout,
+          int *uaddr2, int val2);
+__END_DECLS
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_FUTEX_H_ */
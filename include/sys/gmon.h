@@ -34,6 +34,9 @@
 #ifndef _SYS_GMON_H_
 #define _SYS_GMON_H_
 
+#include <sys/types.h>
+#include <sys/ioccom.h>
+
 /*
  * Structure prepended to gmon.out profiling data file.
  */
@@ -45,6 +48,7 @@ typedef struct gmonhdr {
   int profrate; /* profiling clock rate */
   int spare[3]; /* reserved */
 } gmonhdr_t;
+extern gmonhdr_t _gmonhdr;
 
 #define GMONVERSION 0x00051879
 
@@ -105,6 +109,16 @@ typedef struct tostruct {
   u_short link;
 } tostruct_t;
 
+/*
+ * a raw arc, with pointers to the calling site and
+ * the called site and a count.
+ */
+typedef struct rawarc {
+  u_long raw_frompc;
+  u_long raw_selfpc;
+  long raw_count;
+} rawarc_t;
+
 /*
  * The profiling data structures are housed in this structure.
  */
@@ -135,4 +149,13 @@ typedef enum {
   GMON_PROF_NOT_INIT = 4,
 } gmon_state_t;
 
+/*
+ * Commands accepted by /dev/kgmon. Reading the device yields gmon.out file
+ * (header, histogram and raw arcs), but only while profiling is stopped.
+ */
+#define GMON_IOC_MAGIC 'g'
+#define GMONIOCGSTATE _IOR(GMON_IOC_MAGIC, 1, int)
+#define GMONIOCSSTATE _IOW(GMON_IOC_MAGIC, 2, int) /* ON or OFF only */
+#define GMONIOCRESET _IO(GMON_IOC_MAGIC, 3)
+
 #endif /* !_SYS_GMON_H_ */
@@ -0,0 +1,56 @@
+#ifndef _SYS_HRTIMER_H_
+#define _SYS_HRTIMER_H_
+
+#include <stdbool.h>
+#include <sys/time.h>
+#include <sys/tree.h>
+
+typedef void (*hrtimer_func_t)(void *);
+
+/*
+ * High-resolution timers.
+ *
+ * Callouts fire with resolution of system clock tick. A hrtimer expires at
+ * given moment of `binuptime()` as precisely as the timer hardware driving
+ * system clock allows, provided the clock runs in tickless mode. Otherwise
+ * hrtimers are checked on every tick.
+ *
+ * Functions of expired hrtimers are called in interrupt context, so they must
+ * neither sleep nor acquire sleep mutexes. Use callouts for anything else.
+ */
+typedef struct hrtimer {
+  RB_ENTRY(hrtimer) hrt_link;
+  bintime_t hrt_time;      /* absolute time of expiration */
+  hrtimer_func_t hrt_func; /* function to call */
+  void *hrt_arg;           /* function argument */
+  unsigned hrt_cpu;        /* processor the timer has been queued on */
+  bool hrt_pending;        /* waiting to expire */
+} hrtimer_t;
+
+/*! \brief Sets up \a hrt to call \a func with \a arg. */
+void hrtimer_setup(hrtimer_t *hrt, hrtimer_func_t func, void *arg);
+
+/*! \brief Arms the timer to expire at \a when.
+ *
+ * If the timer is pending it gets rearmed. */
+void hrtimer_start(hrtimer_t *hrt, bintime_t when);
+
+/*! \brief Disarms the timer.
+ *
+ * When it returns, the timer's function won't be called unless the timer is
+ * started again. The function may be called from the timer's own function.
+ *
+ * \returns true if the timer was pending */
+bool hrtimer_stop(hrtimer_t *hrt);
+
+/*! \brief Calls functions of timers that expired by \a now.
+ *
+ * \note Called by system clock in interrupt context. */
+void hrtimer_process(bintime_t now);
+
+/*! \brief Fetches expiration time of the earliest pending timer.
+ *
+ * \returns false if there are no pending timers */
+bool hrtimer_next(bintime_t *when);
+
+#endif /* !_SYS_HRTIMER_H_ */
@@ -2,6 +2,7 @@
 #define _SYS_INTERRUPT_H_
 
 #include <sys/cdefs.h>
+#include <sys/evcnt.h>
 #include <sys/queue.h>
 #include <sys/mutex.h>
 #include <sys/priority.h>
@@ -32,6 +33,11 @@ void intr_disable(void) __no_profile;
 /*! \brief Enables interrupts. */
 void intr_enable(void) __no_profile;
 
+/* Same as above, but \a pc is reported as the place that disabled or enabled
+ * interrupts to the latency tracer (see sys/latency.h). */
+void _intr_disable(const void *pc) __no_profile;
+void _intr_enable(const void *pc) __no_profile;
+
 /*! \brief Checks if interrupts are disabled now. */
 bool intr_disabled(void) __no_profile;
 
@@ -69,19 +75,51 @@ typedef intr_filter_t ih_filter_t(void *);
 typedef void ih_service_t(void *);
 typedef void ie_action_t(intr_event_t *);
 
+/*
+ * Priorities of interrupt threads. Each interrupt event with a service routine
+ * gets its own interrupt thread that runs at the highest priority among
+ * handlers of the event, so that slow service routines of one device do not
+ * delay service routines of more urgent ones.
+ */
+#define PI_REALTIME prio_ithread(0)
+#define PI_TTY prio_ithread(PRIO_QTY * 1 / 5)
+#define PI_NET prio_ithread(PRIO_QTY * 2 / 5)
+#define PI_DISK prio_ithread(PRIO_QTY * 3 / 5)
+#define PI_USB prio_ithread(PRIO_QTY * 4 / 5)
+#define PI_DULL prio_ithread(PRIO_QTY - 1)
+
+/*
+ * INTR_COALESCE: do not mask the interrupt while service routines are pending
+ * or running. Interrupts delegated in the meantime are merged into a single
+ * run of the service routines. Suitable for devices whose filter must keep
+ * draining hardware buffers, e.g. UARTs.
+ */
+#define INTR_COALESCE 1
+
 /* Software representation of interrupt line. */
 typedef struct intr_event {
   mtx_t ie_lock;
   TAILQ_ENTRY(intr_event) ie_link; /* link on list of all interrupt events */
-  TAILQ_HEAD(, intr_handler) ie_handlers; /* sorted by descending ih_prio */
+  TAILQ_HEAD(, intr_handler) ie_handlers; /* in order of registration */
   ie_action_t *ie_disable; /* called before ithread delegation (mask irq) */
   ie_action_t *ie_enable;  /* called after ithread delagation (unmask irq) */
   void *ie_source;         /* additional argument for actions */
   char ie_name[IENAMELEN]; /* individual event name */
   unsigned ie_irq;         /* physical interrupt request line number */
+  unsigned ie_flags;       /* INTR_* flags requested by handlers */
+  prio_t ie_prio;          /* priority of the interrupt thread */
+  bool ie_pending;         /* service routines await the interrupt thread */
+  bool ie_storming;        /* interrupt thread is being throttled */
+  systime_t ie_window;     /* beginning of storm detection window */
+  unsigned ie_wakeups;     /* interrupt thread wakeups within the window */
   thread_t *ie_ithread;    /* associated interrupt thread */
+  evcnt_t ie_evcnt;        /* number of times the event was dispatched */
 } intr_event_t;
 
+/* Number of interrupt thread wakeups per second above which an interrupt
+ * event is throttled. */
+extern unsigned intr_storm_threshold;
+
 intr_event_t *intr_event_create(void *source, int irq, ie_action_t *disable,
                                 ie_action_t *enable, const char *name);
 intr_handler_t *intr_event_add_handler(intr_event_t *ie, ih_filter_t *filter,
@@ -128,6 +166,17 @@ typedef struct pic_methods {
 void pic_setup_intr(device_t *dev, resource_t *irq, ih_filter_t *filter,
                     ih_service_t *service, void *arg, const char *name);
 
+/*
+ * Configure the interrupt thread running service routine of interrupt source
+ * registered with `pic_setup_intr`.
+ *
+ * Arguments:
+ *  - `r`: interrupt resource
+ *  - `prio`: priority of the service routine (one of PI_*)
+ *  - `flags`: INTR_* flags
+ */
+void intr_setup_service(resource_t *r, prio_t prio, unsigned flags);
+
 /*
  * Remove specified interrupt source.
  *
@@ -2,6 +2,7 @@
 #define _SYS_KLOG_H_
 
 #include <sys/types.h>
+#include <sys/time.h>
 
 /* Kernel log message origin. */
 typedef enum {
@@ -37,6 +38,38 @@ typedef enum {
 
 #define KL_DEFAULT_MASK (KL_ALL & (~(KL_MASK(KL_PMAP) | KL_MASK(KL_PHYSMEM))))
 
+/* Names of kernel subsystems indexed by message origin. */
+#define KL_ORIGIN_NAMES                                                        \
+  {                                                                            \
+    [KL_UNDEF] = "???", [KL_SLEEPQ] = "sleepq", [KL_CALLOUT] = "callout",      \
+    [KL_SIGNAL] = "signal", [KL_INIT] = "init", [KL_PMAP] = "pmap",            \
+    [KL_PHYSMEM] = "physmem", [KL_VM] = "vm", [KL_KMEM] = "kmem",              \
+    [KL_VMEM] = "vmem", [KL_LOCK] = "lock", [KL_SCHED] = "sched",              \
+    [KL_TIME] = "time", [KL_THREAD] = "thread", [KL_INTR] = "intr",            \
+    [KL_DEV] = "dev", [KL_VFS] = "vfs", [KL_PROC] = "proc",                    \
+    [KL_SYSCALL] = "syscall", [KL_USER] = "user", [KL_TEST] = "test",          \
+    [KL_FILE] = "file", [KL_FILESYS] = "filesys", [KL_TTY] = "tty",            \
+  }
+
+/*
+ * Reading /dev/klog returns a sequence of records. Each one is followed by
+ * source file name and format string (both NUL-terminated) and padded to
+ * `kr_size` bytes. Parameters that are strings cannot be decoded in user space,
+ * since they point into kernel memory.
+ */
+#define KL_NPARAMS 6
+
+typedef struct klog_record {
+  bintime_t kr_timestamp;          /* time since boot */
+  uintptr_t kr_params[KL_NPARAMS]; /* format string parameters */
+  tid_t kr_tid;                    /* thread that logged the message */
+  unsigned kr_line;                /* line in source file */
+  uint16_t kr_origin;              /* klog_origin_t */
+  uint16_t kr_size;                /* size of the record including strings */
+} klog_record_t;
+
+#ifdef _KERNEL
+
 /* Mask for subsystem using klog. If not specified using default subsystem. */
 #ifndef KL_LOG
 #define KL_LOG KL_UNDEF
@@ -93,4 +126,6 @@ void klog_clear(void);
       klog_assert(KL_LOG, __FILE__, __LINE__, __STRING(EXPR));                 \
   })
 
+#endif /* !_KERNEL */
+
 #endif /* !_SYS_KLOG_H_ */
@@ -0,0 +1,66 @@
+#ifndef _SYS_LATENCY_H_
+#define _SYS_LATENCY_H_
+
+#include <sys/types.h>
+#include <sys/ioccom.h>
+
+/*
+ * Latency tracer measures how long a processor runs with interrupts or
+ * preemption disabled. A section starts when the outermost `intr_disable` or
+ * `preempt_disable` is called and ends with the matching enable call. For each
+ * kind of section the tracer remembers a few of the longest ones together with
+ * the places that opened and closed them. Sections spent in interrupt filters
+ * are attributed to `intr_root_handler`.
+ *
+ * The tracer is off by default and it's controlled with ioctls on
+ * /dev/latency. Reading the device yields an array of LAT_NTYPES *
+ * LAT_NWORST latency_record_t entries; unused ones have zero `lr_count`.
+ */
+
+typedef enum {
+  LAT_IRQSOFF = 0,    /* interrupts disabled */
+  LAT_PREEMPTOFF = 1, /* preemption disabled */
+  LAT_NTYPES
+} lat_type_t;
+
+#define LAT_NWORST 8
+
+typedef struct latency_record {
+  int lr_type;           /* one of LAT_* values */
+  tid_t lr_tid;          /* thread that closed the longest section */
+  uintptr_t lr_start_pc; /* where the section was opened */
+  uintptr_t lr_end_pc;   /* where the section was closed */
+  uint64_t lr_count;     /* sections seen between these places */
+  uint64_t lr_max;       /* duration of the longest section in ns */
+} latency_record_t;
+
+#define LAT_IOC_MAGIC 'T'
+#define LATIOCGSTATE _IOR(LAT_IOC_MAGIC, 1, int)
+#define LATIOCSSTATE _IOW(LAT_IOC_MAGIC, 2, int)
+#define LATIOCRESET _IO(LAT_IOC_MAGIC, 3)
+
+#ifdef _KERNEL
+
+#include <stdatomic.h>
+
+typedef struct thread thread_t;
+
+/* Non-zero if sections are being measured. */
+extern atomic_int lat_enabled;
+
+#define lat_active()                                                           \
+  __predict_false(atomic_load_explicit(&lat_enabled, memory_order_relaxed))
+
+/* Called when the outermost section of given type begins or ends. */
+void lat_section_begin(lat_type_t type, const void *pc) __no_profile;
+void lat_section_end(lat_type_t type, const void *pc) __no_profile;
+
+/*! \brief Drop sections that cannot be closed on this processor.
+ *
+ * Called just before switching to \a newtd, since preemption is private
+ * to a thread and a new thread enables interrupts without `intr_enable`. */
+void lat_switch(thread_t *newtd) __no_profile;
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_LATENCY_H_ */
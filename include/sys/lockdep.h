@@ -3,6 +3,7 @@
 
 #include <sys/queue.h>
 #include <sys/types.h>
+#include <sys/time.h>
 
 /*
  * Lock depedency validator builds the graph between locks where edge denotes
@@ -32,6 +33,7 @@
  */
 
 #define LOCKDEP_MAX_HELD_LOCKS 16
+#define LOCKDEP_MAX_CLASSES 64
 
 typedef struct lock_class lock_class_t;
 typedef uintptr_t lock_class_key_t;
@@ -41,6 +43,7 @@ typedef struct lock_class_mapping {
   lock_class_key_t *key;
   const char *name;
   lock_class_t *lock_class;
+  bintime_t acquired; /* set by lockstat when the lock was taken */
 } lock_class_mapping_t;
 
 #define LOCKDEP_MAPPING_INITIALIZER(lockname)                                  \
@@ -55,4 +58,9 @@ void lockdep_init(void);
 void lockdep_acquire(lock_class_mapping_t *lock);
 void lockdep_release(lock_class_mapping_t *lock);
 
+/* Lock classes are numbered from 0 in the order of their creation. */
+int lockdep_class_count(void);
+int lockdep_class_index(lock_class_mapping_t *lock);
+const char *lockdep_class_name(int idx);
+
 #endif /* !_SYS_LOCKDEP_H_ */
@@ -0,0 +1,68 @@
+#ifndef _SYS_LOCKSTAT_H_
+#define _SYS_LOCKSTAT_H_
+
+#include <sys/types.h>
+#include <sys/ioccom.h>
+
+/*
+ * Lock contention statistics.
+ *
+ * Statistics are gathered per lock class known to lockdep, hence they're
+ * available only in kernels compiled with LOCKDEP=1. Collection is off by
+ * default and is controlled with ioctls on /dev/lockstat. Reading the device
+ * yields an array of lockstat_record_t, one entry for each lock class.
+ *
+ * All times are expressed in nanoseconds.
+ */
+
+#define LOCKSTAT_NAMELEN 32
+#define LOCKSTAT_NSITES 4
+
+/* Call site that had to wait for a lock. */
+typedef struct lockstat_site {
+  uintptr_t ls_waitpt; /* address of code that acquired the lock */
+  uint64_t ls_count;   /* number of contended acquisitions */
+  uint64_t ls_wait;    /* total time spent waiting */
+} lockstat_site_t;
+
+typedef struct lockstat_record {
+  char lr_name[LOCKSTAT_NAMELEN]; /* name of the lock class */
+  uint64_t lr_acquired;           /* number of acquisitions */
+  uint64_t lr_contended;          /* ... that found the lock taken */
+  uint64_t lr_wait_total;
+  uint64_t lr_wait_max;
+  uint64_t lr_hold_total;
+  uint64_t lr_hold_max;
+  /* Call sites with the longest total wait time, not sorted. */
+  lockstat_site_t lr_sites[LOCKSTAT_NSITES];
+} lockstat_record_t;
+
+#define LOCKSTAT_IOC_MAGIC 'L'
+#define LOCKSTATIOCGSTATE _IOR(LOCKSTAT_IOC_MAGIC, 1, int)
+#define LOCKSTATIOCSSTATE _IOW(LOCKSTAT_IOC_MAGIC, 2, int)
+#define LOCKSTATIOCRESET _IO(LOCKSTAT_IOC_MAGIC, 3)
+
+#ifdef _KERNEL
+
+#include <sys/lockdep.h>
+#include <stdatomic.h>
+
+/* Non-zero if statistics are being collected. */
+extern atomic_int lockstat_enabled;
+
+#define lockstat_active()                                                      \
+  __predict_false(atomic_load_explicit(&lockstat_enabled, memory_order_relaxed))
+
+/*! \brief Account acquisition of a lock.
+ *
+ * Must be called by the new owner of the lock. If the lock was contended then
+ * \a wait_start holds the time when the owner started waiting for it. */
+void lockstat_acquire(lock_class_mapping_t *lock, const void *waitpt,
+                      const bintime_t *wait_start) __no_profile;
+
+/*! \brief Account release of a lock. Must be called by the owner. */
+void lockstat_release(lock_class_mapping_t *lock) __no_profile;
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_LOCKSTAT_H_ */
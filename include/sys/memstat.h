@@ -0,0 +1,68 @@
+#ifndef _SYS_MEMSTAT_H_
+#define _SYS_MEMSTAT_H_
+
+#include <sys/types.h>
+
+/*
+ * Kernel memory statistics.
+ *
+ * /dev/memstat can be read as an array of memstat_record_t. There's a record
+ * for each pool, each kmalloc type and each order of blocks managed by
+ * the physical memory allocator.
+ */
+
+#define MEMSTAT_NAMELEN 32
+
+typedef enum {
+  MS_POOL,    /* pooled allocator, see <sys/pool.h> */
+  MS_KMALLOC, /* kmalloc type, see <sys/malloc.h> */
+  MS_PHYSMEM, /* free blocks of physical memory of given order */
+} memstat_kind_t;
+
+typedef struct memstat_record {
+  int32_t mr_kind; /* memstat_kind_t */
+  char mr_name[MEMSTAT_NAMELEN];
+  union {
+    struct {
+      uint64_t itemsize; /* size of item */
+      uint64_t nused;    /* number of used items */
+      uint64_t nmaxused; /* peak number of used items */
+      uint64_t ntotal;   /* number of items in all slabs */
+      uint64_t nbytes;   /* memory taken by slabs */
+      uint64_t nslabs;   /* number of slabs */
+      uint64_t nempty;   /* number of slabs without used items */
+    } mr_pool;
+    struct {
+      uint64_t nrequests; /* number of allocation requests */
+      uint64_t active;    /* number of allocated blocks */
+      uint64_t used;      /* memory taken by allocated blocks */
+      uint64_t maxused;   /* peak value of `used` */
+    } mr_kmalloc;
+    struct {
+      uint64_t order;  /* blocks consist of 2^order pages */
+      uint64_t nfree;  /* number of free blocks */
+      uint64_t npages; /* number of pages managed by the allocator */
+    } mr_physmem;
+  };
+} memstat_record_t;
+
+#ifdef _KERNEL
+
+/*! \brief Fills in records for at most \a n pools.
+ *
+ * \returns number of all pools */
+size_t pool_memstat(memstat_record_t *recs, size_t n);
+
+/*! \brief Fills in records for at most \a n kmalloc types.
+ *
+ * \returns number of all kmalloc types */
+size_t kmalloc_memstat(memstat_record_t *recs, size_t n);
+
+/*! \brief Fills in records for at most \a n orders of physical memory blocks.
+ *
+ * \returns number of orders */
+size_t vm_physmem_memstat(memstat_record_t *recs, size_t n);
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_MEMSTAT_H_ */
@@ -11,6 +11,7 @@ typedef struct vm_map vm_map_t;
 
 /*! \brief Private per-cpu structure. */
 typedef struct pcpu {
+  unsigned cpuid;        /*!< index of this CPU in _pcpu_data */
   bool no_switch;        /*!< executing code that must not switch out */
   thread_t *curthread;   /*!< thread running on this CPU */
   thread_t *idle_thread; /*!< idle thread executed on this CPU */
@@ -21,11 +22,15 @@ typedef struct pcpu {
   PCPU_MD_FIELDS;
 } pcpu_t;
 
-extern pcpu_t _pcpu_data[1];
+#define MAXCPU 1
+
+extern pcpu_t _pcpu_data[MAXCPU];
 
 /* Read pcpu.h from FreeBSD for API reference */
 #define PCPU_GET(member) (_pcpu_data->member)
 #define PCPU_PTR(member) (&_pcpu_data->member)
 #define PCPU_SET(member, value) (_pcpu_data->member = (value))
 
+#define curcpu PCPU_GET(cpuid)
+
 #endif /* !_SYS_PCPU_H_ */
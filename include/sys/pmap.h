@@ -40,6 +40,9 @@ void pmap_enter(pmap_t *pmap, vaddr_t va, vm_page_t *pg, vm_prot_t prot,
 bool pmap_extract(pmap_t *pmap, vaddr_t va, paddr_t *pap);
 void pmap_remove(pmap_t *pmap, vaddr_t start, vaddr_t end);
 
+/*! \brief Returns number of pages mapped in user space of \a pmap. */
+size_t pmap_resident_count(pmap_t *pmap);
+
 void pmap_kenter(vaddr_t va, paddr_t pa, vm_prot_t prot, unsigned flags);
 bool pmap_kextract(vaddr_t va, paddr_t *pap);
 void pmap_kremove(vaddr_t va, size_t size);
@@ -0,0 +1,64 @@
+/*	$NetBSD: poll.h,v 1.16 2020/12/11 01:25:29 thorpej Exp $	*/
+
+#ifndef _SYS_POLL_H_
+#define _SYS_POLL_H_
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+typedef unsigned int nfds_t;
+
+typedef struct pollfd {
+  int fd;        /* file descriptor */
+  short events;  /* events to look for */
+  short revents; /* events returned */
+} pollfd_t;
+
+/*
+ * Testable events (may be specified in events field).
+ */
+#define POLLIN 0x0001
+#define POLLPRI 0x0002
+#define POLLOUT 0x0004
+#define POLLRDNORM 0x0040
+#define POLLWRNORM POLLOUT
+#define POLLRDBAND 0x0080
+#define POLLWRBAND 0x0100
+
+/*
+ * Non-testable events (may not be specified in events field).
+ */
+#define POLLERR 0x0008
+#define POLLHUP 0x0010
+#define POLLNVAL 0x0020
+
+/*
+ * Infinite timeout value.
+ */
+#define INFTIM -1
+
+#ifdef _KERNEL
+
+typedef struct proc proc_t;
+typedef struct timespec timespec_t;
+
+/* Waits for events on descriptors in `fds` for at most `tsp` (forever if
+ * `tsp` is NULL). Sets `revents` for each descriptor and stores the number of
+ * descriptors with nonzero `revents` in `retval`. */
+int do_poll(proc_t *p, pollfd_t *fds, nfds_t nfds, timespec_t *tsp,
+            int *retval);
+
+#else /* !_KERNEL */
+
+#include <sys/sigtypes.h>
+
+struct timespec;
+
+__BEGIN_DECLS
+int poll(struct pollfd *, nfds_t, int);
+int ppoll(struct pollfd *, nfds_t, const struct timespec *, const sigset_t *);
+__END_DECLS
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_POLL_H_ */
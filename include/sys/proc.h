@@ -11,6 +11,10 @@
 #include <sys/syslimits.h>
 #include <sys/uio.h>
 #include <sys/time.h>
+#include <sys/hrtimer.h>
+#include <sys/callout.h>
+#include <sys/resource.h>
+#include <stdatomic.h>
 
 typedef struct thread thread_t;
 typedef struct proc proc_t;
@@ -33,6 +37,24 @@ void init_proc0(void);
 
 extern proc_t proc0;
 
+typedef struct kitimer kitimer_t;
+typedef void (*kit_notify_t)(kitimer_t *it, unsigned count);
+
+/*! \brief Kernel interval timer.
+ *
+ * Used both for the interval timer and POSIX timers. The hrtimer expires in
+ * interrupt context, where it only counts expirations, so notifications are
+ * sent by `kit_notify` called from `kit_callout` executed by callout thread.
+ * Expirations that happen before the callout runs are counted together. */
+struct kitimer {
+  hrtimer_t kit_timer;     /* not pending means inactive */
+  timespec_t kit_interval; /* time between expirations, 0 means non-periodic */
+  callout_t kit_callout;   /* delivers notifications */
+  kit_notify_t kit_notify; /* called with the number of expirations */
+  proc_t *kit_proc;        /* process the timer belongs to */
+  atomic_uint kit_count;   /* expirations since the last notification */
+};
+
 /*! \brief Structure allocated per session (group of process groups)
  *
  * Field markings and the corresponding locks:
@@ -74,6 +96,7 @@ typedef enum {
   /* Cleared when continued or reported by wait4. */
   PF_STATE_CHANGED = 0x1,       /* Set when stopped or continued */
   PF_CHILD_STATE_CHANGED = 0x2, /* Child state changed, recheck children */
+  PF_VFORK = 0x4,               /* Uses address space borrowed from parent */
 } proc_flags_t;
 
 /*! \brief Process structure
@@ -97,7 +120,6 @@ struct proc {
   TAILQ_ENTRY(proc) p_zombie; /* (a) link on zombie process list */
   TAILQ_ENTRY(proc) p_child;  /* (a) link on parent's children list */
   TAILQ_ENTRY(proc) p_hash;   /* (a) link on pid hash chain */
-  thread_t *p_thread;         /* (@) the only thread running in this process */
   pid_t p_pid;                /* (!) Process ID */
   cred_t p_cred;              /* (@, *) Process credentials */
   char *p_elfpath;            /* (!) path of loaded elf file */
@@ -107,6 +129,10 @@ struct proc {
   volatile proc_state_t p_state;  /* (@) process state */
   proc_t *p_parent;               /* (@ + a) parent process */
   proc_list_t p_children;         /* (a) child processes, including zombies */
+  TAILQ_HEAD(, thread) p_threads; /* (@) threads running in this process */
+  int p_nthreads;                 /* (@) number of threads on p_threads */
+  thread_t *p_singlethread;       /* (@) if set, other threads must exit */
+  condvar_t p_singlecv;           /* (@) signalled when a thread leaves */
   vm_map_t *p_uspace;             /* ($) process' user space map */
   fdtab_t *p_fdtable;             /* ($) file descriptors table */
   sigaction_t p_sigactions[NSIG]; /* (@) description of signal actions */
@@ -114,13 +140,17 @@ struct proc {
   condvar_t p_waitcv;             /* (a) processes waiting for this one */
   int p_exitstatus;               /* (@) exit code to be returned to parent */
   volatile proc_flags_t p_flags;  /* (@) PF_* flags */
+  bool *p_vforkdone;              /* (@) parent waits in vfork until it's set */
   vnode_t *p_cwd;                 /* ($) current working directory */
   mode_t p_cmask;                 /* ($) mask for file creation */
   kitimer_t p_itimer;             /* (@) interval timer state  */
+  ptimer_t *p_timers[TIMER_MAX];  /* (@) POSIX timers by their IDs */
   /* program segments */
   vm_map_entry_t *p_sbrk; /* ($) The entry where brk segment resides in. */
   vaddr_t p_sbrk_end;     /* ($) Current end of brk segment. */
-  /* XXX: process resource usage stats */
+  /* resource usage stats */
+  struct rusage p_ru;  /* (@) usage of exited threads and past address spaces */
+  struct rusage p_cru; /* (a) total usage of reaped children */
 };
 
 /*! \brief Get a process that currently running thread belongs to. */
@@ -161,9 +191,29 @@ int proc_sendsig(pid_t pid, signo_t sig);
 int proc_getpgid(pid_t pid, pgid_t *pgidp);
 
 /*! \brief Called by a processes that wishes to terminate its life.
+ * All other threads of the process are terminated first.
  * \note Exit status shoud be created using MAKE_STATUS macros from wait.h */
 __noreturn void proc_exit(int exitstatus);
 
+/*! \brief Attaches thread \a td to process \a p.
+ *
+ * Must be called with p::p_lock held. */
+void proc_thread_add(proc_t *p, thread_t *td);
+
+/*! \brief Called by a thread that wishes to leave its process.
+ *
+ * If it's the last thread in the process, then the process exits with
+ * \a exitstatus. Must be called with the current process's p_lock held. */
+__noreturn void proc_thread_exit(int exitstatus);
+
+/*! \brief Terminates all threads of the process except the calling one.
+ *
+ * Other threads exit as soon as they're about to return to user space.
+ * Must be called with p::p_lock held, which may be released and reacquired.
+ *
+ * \returns EINTR if another thread has begun to terminate the process */
+int proc_singlethread(proc_t *p);
+
 /*! \brief Moves process with pid target to the process group with ID specified
  * by pgid. If such process group does not exist then it creates one. */
 int pgrp_enter(proc_t *curp, pid_t target, pgid_t pgid);
@@ -191,15 +241,48 @@ void proc_wakeup_parent(proc_t *parent);
 
 /*! \brief Stop the current process in response to the signal `sig`.
  *
+ * Other threads stop as soon as they're about to return to user space.
  * Must be called with the current process's p_lock held. */
 void proc_stop(signo_t sig);
 
+/*! \brief Stop the current thread until its process is continued.
+ *
+ * Must be called with the current process's p_lock held. */
+void proc_thread_stop(void);
+
 /*! \brief Continue a stopped process.
  *
  * Must be called with p::p_lock held. */
 void proc_continue(proc_t *p);
 
-int do_fork(void (*start)(void *), void *arg, pid_t *cldpidp);
+/*! \brief Wake up the parent waiting in `do_fork` for the child to enter
+ * a new program or exit. Returns borrowed address space to the parent.
+ *
+ * Must be called with p::p_lock held. */
+void proc_vfork_done(proc_t *p);
+
+/* Flags for `do_fork`. */
+#define FORK_SHAREVM 0x1 /* borrow parent's address space until exec or exit */
+#define FORK_WAIT 0x2    /* suspend the parent until the child execs or exits */
+#define FORK_SHAREFD 0x4 /* share descriptor table with the parent */
+#define FORK_CLEANFD 0x8 /* start the child with an empty descriptor table */
+
+/*! \brief Creates a child of the current process.
+ *
+ * If \a start is NULL, then the child returns to user space as a copy of the
+ * calling thread. Otherwise the child begins execution in `start(arg)` and
+ * it's expected to load a new program, so it gets an empty address space. */
+int do_fork(void (*start)(void *), void *arg, int flags, pid_t *cldpidp);
+
+/*! \brief Accounts memory usage of an address space \a p is done with.
+ *
+ * Must be called with p::p_lock held. */
+void proc_account_vmspace(proc_t *p, vm_map_t *map);
+
+/*! \brief Gathers resource usage of \a p and its running threads.
+ *
+ * Must be called with p::p_lock held. */
+void proc_rusage(proc_t *p, struct rusage *ru);
 
 /*! \brief Set login name associated with current session. */
 int do_setlogin(const char *name);
@@ -0,0 +1,84 @@
+#ifndef _SYS_PROCSTAT_H_
+#define _SYS_PROCSTAT_H_
+
+#include <sys/types.h>
+
+/*
+ * Process statistics.
+ *
+ * /dev/procstat takes a snapshot of all processes and their threads when it's
+ * opened. The snapshot consists of a kinfo_header_t followed by `kh_nproc`
+ * records of kinfo_proc_t and `kh_nthread` records of kinfo_thread_t. Threads
+ * of a process are stored contiguously starting at `kp_thread`.
+ *
+ * Tools should check `kh_version` and use `kh_procsize` and `kh_threadsize`
+ * to step over records, so that fields can be appended to the end of records
+ * without breaking them.
+ */
+
+#define PROCSTAT_VERSION 1
+
+#define KI_COMMLEN 128 /* command name with arguments */
+#define KI_TDNAMELEN 32
+
+typedef struct kinfo_header {
+  uint32_t kh_version;    /* PROCSTAT_VERSION */
+  uint32_t kh_nproc;      /* number of kinfo_proc_t records */
+  uint32_t kh_nthread;    /* number of kinfo_thread_t records */
+  uint32_t kh_procsize;   /* sizeof(kinfo_proc_t) */
+  uint32_t kh_threadsize; /* sizeof(kinfo_thread_t) */
+  uint32_t kh_pagesize;   /* unit of `kp_rss` */
+  uint64_t kh_uptime;     /* [ns] when the snapshot was taken */
+} kinfo_header_t;
+
+typedef struct kinfo_proc {
+  int32_t kp_pid;
+  int32_t kp_ppid;
+  uint32_t kp_uid; /* effective user id */
+  int32_t kp_pgrp;
+  int32_t kp_sid;
+  char kp_stat;        /* R: normal, S: stopped, D: dying, Z: zombie */
+  uint32_t kp_nthread; /* number of threads */
+  uint32_t kp_thread;  /* index of the first thread */
+  uint64_t kp_rss;     /* [pages] resident set size */
+  uint64_t kp_minflt;  /* faults resolved without I/O */
+  uint64_t kp_majflt;  /* faults that required I/O */
+  uint64_t kp_rtime;   /* [ns] running time including exited threads */
+  char kp_comm[KI_COMMLEN];
+} kinfo_proc_t;
+
+typedef struct kinfo_thread {
+  int32_t kt_tid;
+  int32_t kt_pid;
+  char kt_stat;         /* see below */
+  uint8_t kt_prio;      /* active priority */
+  uint8_t kt_base_prio; /* base priority */
+  uint32_t kt_nctxsw;   /* number of context switches */
+  uint64_t kt_rtime;    /* [ns] time spent running */
+  uint64_t kt_slptime;  /* [ns] time spent sleeping */
+  char kt_name[KI_TDNAMELEN];
+} kinfo_thread_t;
+
+/*
+ * Values of `kt_stat`:
+ *  I: created, but not run yet
+ *  R: ready to run
+ *  O: running on a processor
+ *  S: sleeping
+ *  L: waiting for a lock
+ *  T: stopped
+ *  Z: dead
+ */
+
+/* Returns `i`-th process record of the snapshot. */
+static inline kinfo_proc_t *kinfo_proc(kinfo_header_t *kh, unsigned i) {
+  return (void *)((char *)(kh + 1) + i * kh->kh_procsize);
+}
+
+/* Returns `i`-th thread record of the snapshot. */
+static inline kinfo_thread_t *kinfo_thread(kinfo_header_t *kh, unsigned i) {
+  return (void *)((char *)(kh + 1) + kh->kh_nproc * kh->kh_procsize +
+                  i * kh->kh_threadsize);
+}
+
+#endif /* !_SYS_PROCSTAT_H_ */
@@ -39,8 +39,11 @@
 /*
  * Process priority specifications to get/setpriority.
  */
+/* The kernel has its own notion of priority range, see sys/priority.h. */
+#ifndef _KERNEL
 #define PRIO_MIN -20
 #define PRIO_MAX 20
+#endif
 
 #define PRIO_PROCESS 0
 #define PRIO_PGRP 1
@@ -110,6 +113,11 @@ int setpriority(int, id_t, int);
 int setrlimit(int, const struct rlimit *);
 __END_DECLS
 
+#else /* _KERNEL */
+
+/*! \brief Gathers resource usage of the current process or its children. */
+int do_getrusage(int who, struct rusage *ru);
+
 #endif /* !_KERNEL */
 
 #endif /* !_SYS_RESOURCE_H_ */
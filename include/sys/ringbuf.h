@@ -25,7 +25,7 @@ static inline bool ringbuf_full(ringbuf_t *buf) {
 void ringbuf_init(ringbuf_t *rb, void *buf, size_t size);
 bool ringbuf_putb(ringbuf_t *buf, uint8_t byte);
 /*! \brief Put exactly n bytes into buf if there's enough space. */
-bool ringbuf_putnb(ringbuf_t *buf, uint8_t *data, size_t n);
+bool ringbuf_putnb(ringbuf_t *buf, const uint8_t *data, size_t n);
 bool ringbuf_getb(ringbuf_t *buf, uint8_t *byte_p);
 /*! \brief Get exactly n bytes from buf if there's enough data. */
 bool ringbuf_getnb(ringbuf_t *buf, uint8_t *data, size_t n);
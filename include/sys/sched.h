@@ -88,6 +88,18 @@ void sched_set_prio(thread_t *td, prio_t prio);
  */
 void sched_clock(void);
 
+/*! \brief Returns system time at which slice of the running thread ends.
+ *
+ * \note Must be called from interrupt context.
+ */
+systime_t sched_slice_end(void);
+
+/*! \brief Returns time spent running by \a td including its current slice.
+ *
+ * \note Must be called with \a td_lock acquired!
+ */
+bintime_t sched_rtime(thread_t *td);
+
 /*! \brief Switch out to another thread.
  *
  * Before you call this function, set thread's state to requested value, which
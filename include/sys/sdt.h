@@ -0,0 +1,91 @@
+#ifndef _SYS_SDT_H_
+#define _SYS_SDT_H_
+
+#include <sys/types.h>
+#include <sys/ioccom.h>
+#include <sys/time.h>
+
+/*
+ * Statically defined tracepoints.
+ *
+ * A probe is a named point in the kernel code that may pass up to
+ * SDT_NARGS arguments to a consumer. Probes are disabled by default and then
+ * they cost a single load and a not-taken branch. A consumer opens /dev/sdt,
+ * which attaches a buffer of records, enables selected probes with ioctls,
+ * and reads records produced by probes that fired.
+ */
+
+#define SDT_NARGS 5
+#define SDT_NAMELEN 16
+#define SDT_ARGSLEN 64
+
+/* Record produced each time an enabled probe fires. */
+typedef struct sdt_record {
+  bintime_t sr_timestamp;          /* time since boot */
+  uintptr_t sr_args[SDT_NARGS];    /* probe arguments */
+  tid_t sr_tid;                    /* thread that hit the probe */
+  unsigned sr_probe;               /* probe identifier */
+} sdt_record_t;
+
+/* Description of a probe, which is identified by `spi_id`. */
+typedef struct sdt_probe_info {
+  unsigned spi_id;
+  int spi_enabled;
+  char spi_provider[SDT_NAMELEN];
+  char spi_name[SDT_NAMELEN];
+  char spi_args[SDT_ARGSLEN]; /* names of arguments */
+} sdt_probe_info_t;
+
+#define SDT_IOC_MAGIC 'D'
+#define SDTIOCGPROBE _IOWR(SDT_IOC_MAGIC, 1, sdt_probe_info_t)
+#define SDTIOCENABLE _IOW(SDT_IOC_MAGIC, 2, unsigned)
+#define SDTIOCDISABLE _IOW(SDT_IOC_MAGIC, 3, unsigned)
+#define SDTIOCGDROPS _IOR(SDT_IOC_MAGIC, 4, unsigned)
+
+#ifdef _KERNEL
+
+#include <sys/linker_set.h>
+#include <stdatomic.h>
+
+typedef struct sdt_probe {
+  const char *sp_provider; /* subsystem the probe belongs to */
+  const char *sp_name;     /* name of the probe within the subsystem */
+  const char *sp_args;     /* names of arguments separated by commas */
+  atomic_bool sp_enabled;  /* fire the probe only if set */
+  unsigned sp_id;          /* index in the linker set */
+} sdt_probe_t;
+
+#define SDT_PROBE_NAME(prov, name) sdt_##prov##_##name
+
+#define _SDT_PROBE_DEFINE(sym, prov, name, args)                               \
+  sdt_probe_t sym = {                                                          \
+    .sp_provider = (prov), .sp_name = (name), .sp_args = (args)};              \
+  SET_ENTRY(sdt_probes, sym)
+
+/* Define a probe. All probes are gathered in `sdt_probes` linker set. */
+#define SDT_PROBE_DEFINE(prov, name, args)                                     \
+  _SDT_PROBE_DEFINE(SDT_PROBE_NAME(prov, name), #prov, #name, args)
+
+/* Declare a probe defined in another compilation unit. */
+#define SDT_PROBE_DECLARE(prov, name)                                          \
+  extern sdt_probe_t SDT_PROBE_NAME(prov, name)
+
+void sdt_probe_fire(sdt_probe_t *probe, uintptr_t arg0, uintptr_t arg1,
+                    uintptr_t arg2, uintptr_t arg3, uintptr_t arg4);
+
+#define _SDT_PROBE(prov, name, a0, a1, a2, a3, a4, ...)                        \
+  ({                                                                           \
+    sdt_probe_t *__probe = &SDT_PROBE_NAME(prov, name);                        \
+    if (__predict_false(                                                       \
+          atomic_load_explicit(&__probe->sp_enabled, memory_order_relaxed)))   \
+      sdt_probe_fire(__probe, (uintptr_t)(a0), (uintptr_t)(a1),                \
+                     (uintptr_t)(a2), (uintptr_t)(a3), (uintptr_t)(a4));       \
+  })
+
+/* Fire a probe passing it up to SDT_NARGS arguments. */
+#define SDT_PROBE(prov, name, ...)                                             \
+  _SDT_PROBE(prov, name, ##__VA_ARGS__, 0, 0, 0, 0, 0)
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_SDT_H_ */
@@ -37,12 +37,28 @@
 #include <sys/cdefs.h>
 #include <sys/fd_set.h>
 
+#ifdef _KERNEL
+
+typedef struct proc proc_t;
+typedef struct timespec timespec_t;
+
+/* Implemented with `do_poll`. Descriptor sets are updated in place and the
+ * total number of bits set is stored in `retval`. */
+int do_select(proc_t *p, int nfds, fd_set *readfds, fd_set *writefds,
+              fd_set *exceptfds, timespec_t *tsp, int *retval);
+
+#else /* !_KERNEL */
+
 #include <sys/sigtypes.h>
 #include <time.h>
 
 __BEGIN_DECLS
+int pselect(int, fd_set *__restrict, fd_set *__restrict, fd_set *__restrict,
+            const struct timespec *__restrict, const sigset_t *__restrict);
 int select(int, fd_set *__restrict, fd_set *__restrict, fd_set *__restrict,
            struct timeval *__restrict);
 __END_DECLS
 
+#endif /* !_KERNEL */
+
 #endif /* !_SYS_SELECT_H_ */
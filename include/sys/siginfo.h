@@ -3,6 +3,11 @@
 
 #include <sys/sigtypes.h>
 
+typedef union sigval {
+  int sival_int;   /* integer value */
+  void *sival_ptr; /* pointer value */
+} sigval_t;
+
 typedef struct siginfo {
   int si_signo;
   int si_code;
@@ -20,6 +25,12 @@ typedef struct siginfo {
       int si_trap2;
       int si_trap3;
     };
+    /* timer */
+    struct {
+      union sigval si_value; /* from timer's sigevent */
+      int si_timerid;        /* ID of the timer */
+      int si_overrun;        /* number of lost expirations */
+    };
   };
 } siginfo_t;
 
@@ -27,6 +38,7 @@ typedef struct siginfo {
 #define CLD_STOPPED 5
 #define CLD_CONTINUED 6
 
+#define SI_TIMER -2 /* from expiration of a POSIX timer */
 #define SI_NOINFO 32767
 
 #ifdef _KERNEL
@@ -83,6 +95,10 @@ void sigpend_destroy(sigpend_t *sp);
 #define ksi_trap2 ksi_info.si_trap2
 #define ksi_trap3 ksi_info.si_trap3
 
+#define ksi_value ksi_info.si_value
+#define ksi_timerid ksi_info.si_timerid
+#define ksi_overrun ksi_info.si_overrun
+
 #endif /* !_KERNEL */
 
 #endif /* !_SYS_SIGINFO_H_ */
@@ -57,6 +57,19 @@ typedef struct sigaction {
 #define SA_NOCLDWAIT 0x0020 /* do not generate zombies on unwaited child */
 #define SA_SIGINFO 0x0040   /* take sa_sigaction handler */
 
+/* Asynchronous event notification, used by timer_create(). */
+typedef struct sigevent {
+  int sigev_notify;                            /* SIGEV_* */
+  int sigev_signo;                             /* signal to be sent */
+  union sigval sigev_value;                    /* passed with the signal */
+  void (*sigev_notify_function)(union sigval); /* for SIGEV_THREAD */
+  void *sigev_notify_attributes;               /* for SIGEV_THREAD */
+} sigevent_t;
+
+#define SIGEV_NONE 0   /* no notification, unless watched with kqueue */
+#define SIGEV_SIGNAL 1 /* send sigev_signo */
+#define SIGEV_THREAD 2 /* call a function in a new thread (unsupported) */
+
 /* Flags for sigprocmask(): */
 #define SIG_BLOCK 1   /* block specified signal set */
 #define SIG_UNBLOCK 2 /* unblock specified signal set */
@@ -193,11 +206,26 @@ int do_sigreturn(ucontext_t *ucp);
 /*! \brief Deliver signals to a process on return to userspace. */
 void sig_userret(mcontext_t *ctx, syscall_result_t *result);
 
+/*! \brief Temporarily replace signal mask of the current thread.
+ *
+ * The old mask is restored when a signal handler returns (see `sig_post`),
+ * or explicitly with `sig_restoremask` if no signal was delivered. */
+void sig_savemask(proc_t *p, const sigset_t *mask);
+
+/*! \brief Restore signal mask saved with `sig_savemask` (if still saved). */
+void sig_restoremask(proc_t *p);
+
 /*! \brief Reset handlers for caught signals on process exec.
  *
  * \note Must be called with p::p_lock held. */
 void sig_onexec(proc_t *p);
 
+/*! \brief Pass signals pending for thread \a td, which has just left process
+ * \a p, to the remaining threads of the process.
+ *
+ * \note Must be called with p::p_lock held. */
+void sig_redirect(proc_t *p, thread_t *td);
+
 /* System calls implementation. */
 int do_sigaction(signo_t sig, const sigaction_t *act, sigaction_t *oldact);
 int do_sigprocmask(int how, const sigset_t *set, sigset_t *oset);
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <sys/types.h>
 #include <sys/queue.h>
+#include <sys/time.h>
 
 typedef struct mtx mtx_t;
 typedef struct thread thread_t;
@@ -44,6 +45,13 @@ void sleepq_wait(void *wchan, const void *waitpt, mtx_t *mtx);
 int sleepq_wait_timed(void *wchan, const void *waitpt, mtx_t *mtx,
                       systime_t timeout);
 
+/*! \brief Same as \a sleepq_wait_timed but with high-resolution timeout.
+ *
+ * \param deadline time since the start of system at which the sleep times out
+ * \returns how the thread was actually woken up */
+int sleepq_wait_until(void *wchan, const void *waitpt, mtx_t *mtx,
+                      bintime_t deadline);
+
 /*! \brief Wakes up highest priority thread waiting on \a wchan.
  *
  * \param wchan unique sleep queue identifier
@@ -0,0 +1,64 @@
+#ifndef _SYS_SPAWN_H_
+#define _SYS_SPAWN_H_
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+#include <sys/sigtypes.h>
+
+struct posix_spawnattr {
+  short sa_flags;         /* POSIX_SPAWN_* flags */
+  pid_t sa_pgroup;        /* process group to join (SETPGROUP) */
+  sigset_t sa_sigdefault; /* signals reset to default action (SETSIGDEF) */
+  sigset_t sa_sigmask;    /* initial signal mask (SETSIGMASK) */
+};
+
+typedef enum { FAE_OPEN, FAE_DUP2, FAE_CLOSE } fae_action_t;
+
+typedef struct posix_spawn_file_actions_entry {
+  fae_action_t fae_action;
+  int fae_fildes;
+  union {
+    struct {
+      char *path;
+      int oflag;
+      mode_t mode;
+    } open;
+    struct {
+      int newfildes;
+    } dup2;
+  } fae_data;
+} posix_spawn_file_actions_entry_t;
+
+struct posix_spawn_file_actions {
+  unsigned int size; /* size of fae array */
+  unsigned int len;  /* number of used entries in fae array */
+  posix_spawn_file_actions_entry_t *fae;
+};
+
+typedef struct posix_spawnattr posix_spawnattr_t;
+typedef struct posix_spawn_file_actions posix_spawn_file_actions_t;
+
+#define POSIX_SPAWN_RESETIDS 0x01
+#define POSIX_SPAWN_SETPGROUP 0x02
+#define POSIX_SPAWN_SETSIGDEF 0x10
+#define POSIX_SPAWN_SETSIGMASK 0x20
+#define POSIX_SPAWN_SETSID 0x40
+
+#ifdef _KERNEL
+
+typedef struct proc proc_t;
+
+/*! \brief Creates a child process that runs program given by \a u_path.
+ *
+ * Unlike fork followed by execve the parent's address space is not copied.
+ * The child applies file actions and attributes, and loads the program
+ * while the parent waits. If any of these steps fails, the child exits with
+ * status 127, and the parent reaps it and returns the error. */
+int do_posix_spawn(proc_t *p, pid_t *pidp, const char *u_path,
+                   const posix_spawn_file_actions_t *u_fa,
+                   const posix_spawnattr_t *u_attr, char *const *u_argp,
+                   char *const *u_envp);
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_SPAWN_H_ */
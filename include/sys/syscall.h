@@ -93,6 +93,22 @@
 #define SYS_kevent 85
 #define SYS_sigtimedwait 86
 #define SYS_clock_settime 87
-#define SYS_MAXSYSCALL 88
+#define SYS_ppoll 88
+#define SYS_pselect 89
+#define SYS_futex 90
+#define SYS_thr_new 91
+#define SYS_thr_exit 92
+#define SYS_thr_self 93
+#define SYS_thr_settls 94
+#define SYS_vfork 95
+#define SYS_posix_spawn 96
+#define SYS_rfork 97
+#define SYS_getrusage 98
+#define SYS_timer_create 99
+#define SYS_timer_delete 100
+#define SYS_timer_settime 101
+#define SYS_timer_gettime 102
+#define SYS_timer_getoverrun 103
+#define SYS_MAXSYSCALL 104
 
 #define SYS_MAXSYSARGS 6
@@ -9,6 +9,9 @@
 #include <sys/ucontext.h>
 #include <sys/sigtypes.h>
 #include <sys/siginfo.h>
+#include <sys/fd_set.h>
+#include <sys/thr.h>
+#include <sys/spawn.h>
 #define SCARG(p, x) ((p)->x.arg)
 #define SYSCALLARG(x) union { register_t _pad; x arg; }
 
@@ -447,3 +450,84 @@ typedef struct {
   SYSCALLARG(clockid_t) clock_id;
   SYSCALLARG(const struct timespec *) tp;
 } clock_settime_args_t;
+
+typedef struct {
+  SYSCALLARG(struct pollfd *) fds;
+  SYSCALLARG(u_int) nfds;
+  SYSCALLARG(const struct timespec *) ts;
+  SYSCALLARG(const sigset_t *) set;
+} ppoll_args_t;
+
+typedef struct {
+  SYSCALLARG(int) nfds;
+  SYSCALLARG(fd_set *) readfds;
+  SYSCALLARG(fd_set *) writefds;
+  SYSCALLARG(fd_set *) exceptfds;
+  SYSCALLARG(const struct timespec *) timeout;
+  SYSCALLARG(const sigset_t *) set;
+} pselect_args_t;
+
+typedef struct {
+  SYSCALLARG(int *) uaddr;
+  SYSCALLARG(int) op;
+  SYSCALLARG(int) val;
+  SYSCALLARG(const struct timespec *) timeout;
+  SYSCALLARG(int *) uaddr2;
+  SYSCALLARG(int) val2;
+} futex_args_t;
+
+typedef struct {
+  SYSCALLARG(struct thr_param *) param;
+} thr_new_args_t;
+
+typedef struct {
+  SYSCALLARG(int *) state;
+} thr_exit_args_t;
+
+typedef struct {
+  SYSCALLARG(void *) tls;
+} thr_settls_args_t;
+
+typedef struct {
+  SYSCALLARG(pid_t *) pid;
+  SYSCALLARG(const char *) path;
+  SYSCALLARG(const struct posix_spawn_file_actions *) file_actions;
+  SYSCALLARG(const struct posix_spawnattr *) attrp;
+  SYSCALLARG(char *const *) argv;
+  SYSCALLARG(char *const *) envp;
+} posix_spawn_args_t;
+
+typedef struct {
+  SYSCALLARG(int) flags;
+} rfork_args_t;
+
+typedef struct {
+  SYSCALLARG(int) who;
+  SYSCALLARG(struct rusage *) rusage;
+} getrusage_args_t;
+
+typedef struct {
+  SYSCALLARG(clockid_t) clock_id;
+  SYSCALLARG(struct sigevent *) evp;
+  SYSCALLARG(int *) timerid;
+} timer_create_args_t;
+
+typedef struct {
+  SYSCALLARG(int) timerid;
+} timer_delete_args_t;
+
+typedef struct {
+  SYSCALLARG(int) timerid;
+  SYSCALLARG(int) flags;
+  SYSCALLARG(const struct itimerspec *) value;
+  SYSCALLARG(struct itimerspec *) ovalue;
+} timer_settime_args_t;
+
+typedef struct {
+  SYSCALLARG(int) timerid;
+  SYSCALLARG(struct itimerspec *) value;
+} timer_gettime_args_t;
+
+typedef struct {
+  SYSCALLARG(int) timerid;
+} timer_getoverrun_args_t;
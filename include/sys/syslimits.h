@@ -56,6 +56,9 @@
 #define IOV_MAX 1024  /* max elements in i/o vector */
 #define PARGS_MAX 100 /* max length of stored process arguments */
 
+#define TIMER_MAX 32              /* max POSIX timers per process */
+#define DELAYTIMER_MAX 2147483647 /* max timer expiration overruns */
+
 #define BC_BASE_MAX 99     /* max ibase/obase values in bc(1) */
 #define BC_DIM_MAX 2048    /* max array elements in bc(1) */
 #define BC_SCALE_MAX 99    /* max scale value in bc(1) */
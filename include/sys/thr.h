@@ -0,0 +1,46 @@
+#ifndef _SYS_THR_H_
+#define _SYS_THR_H_
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+/* Parameters of a thread created with `thr_new`. */
+struct thr_param {
+  void (*start_func)(void *); /* thread entry point */
+  void *arg;                  /* argument passed to start_func */
+  void *stack_base;           /* lowest address of thread's stack */
+  size_t stack_size;          /* size of thread's stack in bytes */
+  void *tls_base;             /* initial value of thread pointer */
+};
+
+#ifdef _KERNEL
+
+typedef struct proc proc_t;
+typedef struct thr_param thr_param_t;
+
+/*! \brief Creates a new thread in process \a p.
+ *
+ * The thread calls `start_func(arg)` on the given stack. Its signal mask is
+ * inherited from the calling thread. Identifier of the thread is returned
+ * in \a tidp. */
+int do_thr_new(proc_t *p, thr_param_t *param, tid_t *tidp);
+
+/*! \brief Terminates the calling thread.
+ *
+ * If \a state is not NULL, then the kernel stores 1 under the address and
+ * wakes up threads waiting on it with FUTEX_WAKE. The last thread leaving
+ * the process makes it exit with status 0. */
+__noreturn void do_thr_exit(proc_t *p, int *state);
+
+#else /* !_KERNEL */
+
+__BEGIN_DECLS
+tid_t thr_new(struct thr_param *param);
+__noreturn void thr_exit(int *state);
+tid_t thr_self(void);
+int thr_settls(void *tls);
+__END_DECLS
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_THR_H_ */
@@ -5,6 +5,7 @@
 #include <sys/queue.h>
 #include <sys/context.h>
 #include <sys/callout.h>
+#include <sys/hrtimer.h>
 #include <sys/mutex.h>
 #include <sys/condvar.h>
 #include <sys/priority.h>
@@ -106,6 +107,7 @@ typedef struct thread {
   TAILQ_ENTRY(thread) td_sleepq;   /* ($) link on sleep queue */
   TAILQ_ENTRY(thread) td_blockedq; /* (#) link on turnstile blocked queue */
   TAILQ_ENTRY(thread) td_zombieq;  /* (a) link on zombie queue */
+  TAILQ_ENTRY(thread) td_procq;    /* (p) link on process' threads list */
   /* Properties */
   proc_t *td_proc; /*!< (t) parent process (NULL for kernel threads) */
   char *td_name;   /*!< (@) name of thread */
@@ -126,6 +128,7 @@ typedef struct thread {
   void *td_wchan;            /*!< (*) memory object on which thread awaits */
   const void *td_waitpt;     /*!< (*) PC where program waits */
   callout_t td_slpcallout;   /*!< (*) callout used to wakeup from sleep */
+  hrtimer_t td_slptimer;     /*!< (*) same as above for precise timeouts */
   sleepq_t *td_sleepqueue;   /*!< ($) thread's sleepqueue */
   turnstile_t *td_blocked;   /*!< (#) turnstile on which thread is blocked */
   turnstile_t *td_turnstile; /*!< (#) thread's turnstile */
@@ -61,11 +61,28 @@ static inline void bt2ts(const bintime_t *bt, timespec_t *ts) {
   ts->tv_nsec = (1000000000ULL * (uint32_t)(bt->frac >> 32)) >> 32;
 }
 
+static inline uint64_t bt2ns(const bintime_t *bt) {
+  return bt->sec * 1000000000ULL +
+         ((1000000000ULL * (uint32_t)(bt->frac >> 32)) >> 32);
+}
+
 static inline void bt2tv(const bintime_t *bt, timeval_t *tv) {
   tv->tv_sec = bt->sec;
   tv->tv_usec = (1000000ULL * (uint32_t)(bt->frac >> 32)) >> 32;
 }
 
+static inline void ts2bt(const timespec_t *ts, bintime_t *bt) {
+  bt->sec = ts->tv_sec;
+  /* 18446744073 = int(2^64 / 1000000000) */
+  bt->frac = ts->tv_nsec * (uint64_t)18446744073LL;
+}
+
+static inline void tv2bt(const timeval_t *tv, bintime_t *bt) {
+  bt->sec = tv->tv_sec;
+  /* 18446744073709 = int(2^64 / 1000000) */
+  bt->frac = tv->tv_usec * (uint64_t)18446744073709LL;
+}
+
 /* Operations on timevals. */
 #define timerclear(tvp) (tvp)->tv_sec = (tvp)->tv_usec = 0L
 #define timerisset(tvp) ((tvp)->tv_sec || (tvp)->tv_usec)
@@ -96,6 +113,11 @@ static inline void tv2ts(const timeval_t *tv, timespec_t *ts) {
   ts->tv_nsec = tv->tv_usec * 1000;
 }
 
+static inline void ts2tv(const timespec_t *ts, timeval_t *tv) {
+  tv->tv_sec = ts->tv_sec;
+  tv->tv_usec = ts->tv_nsec / 1000;
+}
+
 /* Operations on bintime. */
 #define bintime_cmp(a, b, cmp)                                                 \
   (((a)->sec == (b)->sec) ? (((a)->frac)cmp((b)->frac))                        \
@@ -116,6 +138,15 @@ static inline bintime_t bintime_mul(const bintime_t bt, uint32_t x) {
                      .frac = (p2 << 32) | (p1 & 0xffffffffULL)};
 }
 
+/* Used to convert value of a counter to time given its period. */
+static inline bintime_t bintime_mul64(const bintime_t bt, uint64_t x) {
+  bintime_t res = bintime_mul(bt, (uint32_t)x);
+  bintime_t high_bits = bintime_mul(bt, (uint32_t)(x >> 32));
+  bintime_add_frac(&res, high_bits.frac << 32);
+  res.sec += (high_bits.sec << 32) + (high_bits.frac >> 32);
+  return res;
+}
+
 static inline void bintime_add(bintime_t *bt, bintime_t *bt2) {
   bintime_add_frac(bt, bt2->frac);
   bt->sec += bt2->sec;
@@ -169,6 +200,12 @@ struct itimerval {
   struct timeval it_value;    /* current value */
 };
 
+/* Setting of a POSIX timer, see timer_settime(2). */
+struct itimerspec {
+  struct timespec it_interval; /* timer period */
+  struct timespec it_value;    /* timer expiration */
+};
+
 #define TIMER_RELTIME 0 /* relative timer */
 #define TIMER_ABSTIME 1 /* absolute timer */
 
@@ -178,14 +215,6 @@ struct itimerval {
 
 typedef struct proc proc_t;
 
-/* Kernel interval timer. */
-typedef struct {
-  /* absolute time of nearest expiration, 0 means inactive */
-  timeval_t kit_next;
-  timeval_t kit_interval; /* time between expirations, 0 means non-periodic */
-  callout_t kit_callout;
-} kitimer_t;
-
 /* Initialize a process's interval timer structure. */
 void kitimer_init(proc_t *p);
 
@@ -202,10 +231,25 @@ bintime_t binuptime(void);
 /* UTC/POSIX time */
 bintime_t bintime(void);
 
+/* Same as above, but cheaper and less precise: these return time at which
+ * system clock fired last, so they lag behind at most a tick or, in tickless
+ * mode, until the next clock event (see `clock_notify`). */
+bintime_t getbinuptime(void);
+bintime_t getbintime(void);
+
 /* System time is measured in ticks (1[ms] by default),
  * and is maintained by system clock. */
 systime_t getsystime(void);
 
+#define SYSTIME_MAX ((systime_t)-1)
+
+/* Makes sure system clock fires no later than at `when` tick.
+ * Needed only in tickless mode, where there's no periodic tick. */
+void clock_notify(systime_t when);
+
+/* Same as above, but `when` is given as time since the start of system. */
+void clock_notify_bintime(bintime_t when);
+
 timespec_t nanotime(void);
 
 systime_t ts2hz(const timespec_t *ts);
@@ -220,6 +264,37 @@ int do_getitimer(proc_t *p, int which, struct itimerval *tval);
 int do_setitimer(proc_t *p, int which, const struct itimerval *itval,
                  struct itimerval *oval);
 
+/*
+ * POSIX timers are kept in a per-process table indexed by timer ID. They're
+ * driven by hrtimers like the interval timer and notify the process with a
+ * signal (SIGEV_SIGNAL) and through EVFILT_TIMER knotes attached to them.
+ */
+typedef struct ptimer ptimer_t;
+typedef struct sigevent sigevent_t;
+typedef struct knote knote_t;
+
+int do_timer_create(proc_t *p, clockid_t clk, const sigevent_t *sev,
+                    int *timerid);
+int do_timer_delete(proc_t *p, int timerid);
+int do_timer_settime(proc_t *p, int timerid, int flags,
+                     const struct itimerspec *value,
+                     struct itimerspec *ovalue);
+int do_timer_gettime(proc_t *p, int timerid, struct itimerspec *value);
+int do_timer_getoverrun(proc_t *p, int timerid, int *overrun);
+
+/* Deletes all POSIX timers of a process, which happens on exec and exit.
+ * Must be called with p->p_lock held.
+ * NOTE: This function may release and re-acquire p->p_lock. */
+void ptimer_deleteall(proc_t *p);
+
+/* Looks up timer `timerid` of process `p` and takes a reference to it, so
+ * that it can be watched by a knote even after the timer gets deleted. */
+int ptimer_hold(proc_t *p, int timerid, ptimer_t **ptp);
+void ptimer_drop(ptimer_t *pt);
+
+/* Attaches EVFILT_TIMER knote to a timer. */
+int ptimer_kqfilter(ptimer_t *pt, knote_t *kn);
+
 void mdelay(systime_t ms);
 
 #else /* _KERNEL */
@@ -240,6 +315,16 @@ int getitimer(int, struct itimerval *);
 int setitimer(int, const struct itimerval *__restrict,
               struct itimerval *__restrict);
 
+typedef int timer_t;
+struct sigevent;
+
+int timer_create(clockid_t, struct sigevent *__restrict, timer_t *__restrict);
+int timer_delete(timer_t);
+int timer_settime(timer_t, int, const struct itimerspec *__restrict,
+                  struct itimerspec *__restrict);
+int timer_gettime(timer_t, struct itimerspec *);
+int timer_getoverrun(timer_t);
+
 #endif /* !_KERNEL */
 
 #endif /* !_SYS_TIME_H_ */
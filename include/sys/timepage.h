@@ -0,0 +1,50 @@
+#ifndef _SYS_TIMEPAGE_H_
+#define _SYS_TIMEPAGE_H_
+
+#include <sys/time.h>
+#include <machine/vm_param.h>
+
+/*
+ * Timekeeping data shared with user space.
+ *
+ * The kernel maps a read-only page at TIMEPAGE_ADDR into every process at
+ * exec. If the time source is a counter that user space can read, then
+ * libc computes current time from it with parameters found in the page,
+ * just like the kernel does, instead of calling clock_gettime(2).
+ *
+ * The page is updated only when the time source or boot time changes. Readers
+ * must fetch `tp_gen`, which is odd while an update is in progress, before and
+ * after reading other fields, and retry if the values differ.
+ */
+
+#define TIMEPAGE_ADDR USER_STACK_TOP
+
+/* Counters readable from user space. */
+#define TP_COUNTER_NONE 0   /* use clock_gettime(2) instead */
+#define TP_COUNTER_CNTPCT 1 /* AArch64 physical counter (CNTPCT_EL0) */
+#define TP_COUNTER_RDTIME 2 /* RISC-V time CSR (rdtime instruction) */
+
+typedef struct timepage {
+  volatile uint32_t tp_gen; /* generation number of the data below */
+  uint32_t tp_counter;      /* TP_COUNTER_* */
+  bintime_t tp_period;      /* time between counter increments */
+  bintime_t tp_boottime;    /* UTC time when the counter was zero */
+} timepage_t;
+
+#ifdef _KERNEL
+
+typedef struct timer timer_t;
+typedef struct vm_map vm_map_t;
+
+/*! \brief Called during kernel initialization. */
+void init_timepage(void);
+
+/*! \brief Publishes parameters of time source \a tm and \a boottime. */
+void timepage_update(timer_t *tm, bintime_t boottime);
+
+/*! \brief Maps the page read-only into \a map at TIMEPAGE_ADDR. */
+int timepage_map(vm_map_t *map);
+
+#endif /* !_KERNEL */
+
+#endif /* !_SYS_TIMEPAGE_H_ */
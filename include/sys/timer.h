@@ -45,12 +45,13 @@ typedef struct timer {
   unsigned tm_flags;          /*!< TMF_* flags */
   unsigned tm_quality;        /*!< how dependable the timer is */
   uint32_t tm_frequency;      /*!< base frequency of the timer */
-  bintime_t tm_min_period;    /*!< valid only for TMF_PERIODIC */
-  bintime_t tm_max_period;    /*!< same as above */
+  bintime_t tm_min_period;    /*!< resolution of the timer */
+  bintime_t tm_max_period;    /*!< longest period or one-shot delay */
   tm_start_t tm_start;        /*!< makes timer operational */
   tm_stop_t tm_stop;          /*!< ceases timer from generating new events */
   tm_event_cb_t tm_event_cb;  /*!< callback called when timer triggers */
   tm_gettime_t tm_gettime;    /*!< fetches current time from the timer */
+  unsigned tm_usercounter;    /*!< TP_COUNTER_* if user can read the counter */
   void *tm_arg;               /*!< an argument for callback */
   void *tm_priv;              /*!< private data (usually device_t *) */
 } timer_t;
@@ -73,7 +74,12 @@ int tm_release(timer_t *tm);
 
 /*! \brief Prepares timer to call event trigger callback. */
 int tm_init(timer_t *tm, tm_event_cb_t event, void *arg);
-/*! \brief Configures timer to trigger callback(s). */
+/*! \brief Configures timer to trigger callback(s).
+ *
+ * With TMF_PERIODIC the callback is triggered every \a period. With
+ * TMF_ONESHOT the callback is triggered once after \a start from now has
+ * elapsed. A one-shot timer can be started again while it's active, which
+ * cancels the event programmed previously. */
 int tm_start(timer_t *tm, unsigned flags, const bintime_t start,
              const bintime_t period);
 /*! \brief Stops timer from triggering a callback. */
@@ -84,6 +90,11 @@ void tm_trigger(timer_t *tm);
 /*! \brief Select timer used as a main time source (for binuptime, etc.) */
 void tm_select(timer_t *tm);
 
+/*! \brief Takes a snapshot of current uptime for getbinuptime, etc.
+ *
+ * Called by system clock each time it fires. */
+void tm_windup(void);
+
 #endif /* !_KERNEL */
 
 #endif /* !_SYS_TIMER_H_ */
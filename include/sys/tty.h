@@ -2,6 +2,7 @@
 #define _SYS_TTY_H_
 
 #include <sys/termios.h>
+#include <sys/event.h>
 #include <sys/vnode.h>
 #include <sys/ringbuf.h>
 #include <sys/condvar.h>
@@ -70,6 +71,7 @@ typedef struct tty {
   size_t t_column;           /* Cursor's column position */
   size_t t_rocol, t_rocount; /* See explanation below */
   condvar_t t_serialize_cv;  /* CV used to serialize write() calls */
+  knlist_t t_knlist;         /* Knotes attached to the tty */
   ttyops_t t_ops;            /* Serial device operations */
   struct termios t_termios;
   struct winsize t_winsize; /* Terminal window size */
@@ -143,6 +145,31 @@ void tty_free(tty_t *tty);
  */
 bool tty_input(tty_t *tty, uint8_t c);
 
+/*
+ * Put up to `len` characters from `buf` into the tty's input queue, stopping
+ * when it becomes full. Readers are woken up once for the whole chunk.
+ * Must be called with tty->t_lock held.
+ * Returns the number of characters consumed.
+ */
+size_t tty_input_bulk(tty_t *tty, const uint8_t *buf, size_t len);
+
+/*
+ * Same as above, but characters that don't fit are discarded and the rest of
+ * `buf` is still processed, so that a line break or a special character that
+ * follows them isn't lost. Meant for drivers that can't wait for readers.
+ * Must be called with tty->t_lock held.
+ * Returns the number of characters discarded.
+ */
+size_t tty_input_lossy(tty_t *tty, const uint8_t *buf, size_t len);
+
+/*
+ * Same as above, but characters are taken from `uio`. When neither input
+ * processing nor echo is needed, they're copied directly into the input queue.
+ * On return `uio->uio_resid` is non-zero if the input queue became full.
+ * Must be called with tty->t_lock held.
+ */
+int tty_input_uio(tty_t *tty, uio_t *uio);
+
 /*
  * Wake up threads waiting for space in the output queue.
  * Must be called by drivers after consuming one or more characters
@@ -1,7 +1,6 @@
 #ifndef _SYS_UART_TTY_H_
 #define _SYS_UART_TTY_H_
 
-#include <sys/condvar.h>
 #include <sys/device.h>
 #include <sys/tty.h>
 
@@ -10,18 +9,19 @@
 /* uart_state::u_rx_buf -> tty->t_inq */
 #define TTY_THREAD_RXRDY 0x2
 #define TTY_THREAD_WORK_MASK (TTY_THREAD_TXRDY | TTY_THREAD_RXRDY)
-/* If cleared, don't wake up worker thread from uart_intr. */
+/* If cleared, don't delegate work to interrupt thread from uart_intr. */
 #define TTY_THREAD_OUTQ_NONEMPTY 0x4
 
 typedef struct tty_thread {
-  thread_t *ttd_thread;
   tty_t *ttd_tty;
-  condvar_t ttd_cv; /* Use with uart_state::u_lock. */
-  uint8_t ttd_flags;
+  uint8_t ttd_flags; /* Use with uart_state::u_lock. */
 } tty_thread_t;
 
 void uart_tty_notify_out(tty_t *tty);
 
-void uart_tty_thread_create(const char *name, device_t *dev, tty_t *tty);
+/* Service routine run by the interrupt thread of UART device `data`. */
+void uart_tty_service(void *data /* device_t* */);
+
+void uart_tty_init(device_t *dev, tty_t *tty);
 
 #endif /* !_SYS_UART_TTY_H_ */
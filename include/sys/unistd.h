@@ -31,4 +31,9 @@
 #define _SC_PAGESIZE 28
 #define _SC_PAGE_SIZE _SC_PAGESIZE
 
+/* rfork() options */
+#define RFFDG (1 << 2)   /* copy fd table */
+#define RFPROC (1 << 4)  /* create a new process */
+#define RFCFDG (1 << 12) /* start with an empty fd table */
+
 #endif /* !_SYS_UNISTD_H_ */
@@ -10,9 +10,16 @@
 typedef struct vm_map vm_map_t;
 typedef struct vm_map_entry vm_map_entry_t;
 
+typedef struct vm_map_stats {
+  size_t vs_resident; /* number of pages mapped in the address space */
+  size_t vs_maxrss;   /* peak value of `vs_resident` */
+  uint64_t vs_minflt; /* page faults resolved without I/O */
+} vm_map_stats_t;
+
 typedef enum {
   VM_ENT_SHARED = 1,  /* shared memory */
   VM_ENT_PRIVATE = 2, /* private memory (default) */
+  VM_ENT_NOWRITE = 4, /* can't be made writable, e.g. kernel's own memory */
 } vm_entry_flags_t;
 
 /*! \brief Called during kernel initialization. */
@@ -65,6 +72,13 @@ vm_map_entry_t *vm_map_entry_next(vm_map_entry_t *ent);
  */
 int vm_map_findspace(vm_map_t *map, vaddr_t /*inout*/ *start_p, size_t length);
 
+/*! \brief Maps pages of \a amap at fixed address \a addr of \a map.
+ *
+ * The mapping is shared and protection of it cannot be raised to allow
+ * writes, so the kernel can expose its own memory to user space. */
+int vm_map_enter_amap(vm_map_t *map, vaddr_t addr, size_t length,
+                      vm_prot_t prot, vm_amap_t *amap);
+
 /*! \brief Allocates entry with given attributes. */
 int vm_map_alloc_entry(vm_map_t *map, vaddr_t addr, size_t length,
                        vm_prot_t prot, vm_flags_t flags,
@@ -80,4 +94,22 @@ vm_map_t *vm_map_clone(vm_map_t *map);
 
 int vm_page_fault(vm_map_t *map, vaddr_t fault_addr, vm_prot_t fault_type);
 
+/*! \brief Reports memory usage and fault counts of \a map.
+ *
+ * All memory is anonymous and gets copied eagerly on fork, so faults never
+ * need to read pages in or break copy-on-write sharing. Thus all faults are
+ * minor ones. */
+void vm_map_stats(vm_map_t *map, vm_map_stats_t *stats);
+
+/*! \brief Looks up shared memory backing given address.
+ *
+ * If \a addr lies within a shared mapping, then \a amap_p is set to the amap
+ * backing the mapping (with reference held) and \a offset_p to the offset of
+ * \a addr in the amap. Thus the same memory gets identical (amap, offset) pair
+ * in all address spaces it's mapped into. Otherwise \a amap_p is set to NULL.
+ *
+ * \returns EFAULT if \a addr is not mapped */
+int vm_map_lookup_shared(vm_map_t *map, vaddr_t addr, vm_amap_t **amap_p,
+                         size_t *offset_p);
+
 #endif /* !_SYS_VM_MAP_H_ */
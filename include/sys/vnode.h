@@ -9,6 +9,7 @@
 #include <sys/condvar.h>
 #include <sys/file.h>
 #include <sys/time.h>
+#include <sys/sdt.h>
 
 /* Forward declarations */
 typedef struct vnode vnode_t;
@@ -127,8 +128,12 @@ typedef struct vattr {
 void vattr_null(vattr_t *va);
 void vattr_convert(vattr_t *va, stat_t *sb);
 
+SDT_PROBE_DECLARE(vfs, vop);
+
+/* Operation is identified by index of its entry in vnodeops_t. */
 #define VOP_CALL(op, v, ...)                                                   \
-  ((v)->v_ops->v_##op) ? ((v)->v_ops->v_##op(v, ##__VA_ARGS__)) : ENOTSUP
+  (SDT_PROBE(vfs, vop, (v), offsetof(vnodeops_t, v_##op) / sizeof(void *)),   \
+   ((v)->v_ops->v_##op) ? ((v)->v_ops->v_##op(v, ##__VA_ARGS__)) : ENOTSUP)
 
 /* If a v-node is found, it's returned with usecnt incremented. */
 static inline int VOP_LOOKUP(vnode_t *dv, componentname_t *cn, vnode_t **vp) {
@@ -160,6 +160,7 @@ const char *getusershell(void);
 int initgroups(const char *, gid_t);
 int issetugid(void);
 int pipe2(int *, int);
+pid_t rfork(int) __returns_twice;
 int setlogin(const char *);
 void *setmode(const char *mode_str);
 void setusershell(void);
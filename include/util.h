@@ -4,6 +4,7 @@
 #include <sys/types.h>
 
 __BEGIN_DECLS
+struct kinfo_header;
 struct termios;
 struct winsize;
 
@@ -17,6 +18,10 @@ int openpty(int *, int *, char *, struct termios *, struct winsize *);
 
 int login_tty(int);
 
+/* Reads a snapshot from /dev/procstat into a buffer that should be freed.
+ * Fails with EFTYPE if the snapshot is in unsupported format. */
+struct kinfo_header *procstat_read(void);
+
 /* Error checked functions */
 void (*esetfunc(void (*)(int, const char *, ...)))(int, const char *, ...);
 size_t estrlcpy(char *, const char *, size_t);
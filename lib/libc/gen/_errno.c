@@ -37,7 +37,8 @@
 #undef errno
 extern int errno;
 
-int *__errno(void) {
+/* libpthread provides its own version that returns per-thread errno. */
+__attribute__((weak)) int *__errno(void) {
 #ifdef _REENTRANT
   if (__isthreaded == 0)
     return &errno;
@@ -36,6 +36,7 @@
 #include <signal.h>
 #include <string.h>
 #include <paths.h>
+#include <poll.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <termios.h>
@@ -65,8 +66,6 @@
  *	- GETPASS_FORCE_UPPER forces to uppercase
  *	- GETPASS_FORCE_LOWER forces to uppercase
  *	- GETPASS_ECHO_NL echo's a new line on success if echo was off.
- *
- * XXX the `tout` argument is ignored for now, since we don't have poll().
  */
 char *
 /*ARGSUSED*/
@@ -134,7 +133,21 @@ getpassfd(const char *prompt, char *buf, size_t len, int *fd, int flags,
   c = '\1';
   lnext = false;
   for (size_t l = 0; c != '\0';) {
-    /* TODO: add a poll() call with a timeout here once it's implemented. */
+    if (tout) {
+      struct pollfd pfd;
+      pfd.fd = fd[0];
+      pfd.events = POLLIN | POLLRDNORM;
+      pfd.revents = 0;
+      switch (poll(&pfd, 1, tout * 1000)) {
+        case 0:
+          errno = ETIMEDOUT;
+          /* FALLTHROUGH */
+        case -1:
+          goto restore;
+        default:
+          break;
+      }
+    }
     if (read(fd[0], &c, 1) != 1)
       goto restore;
 
@@ -0,0 +1,99 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_SIZE 16
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t *fa) {
+  fa->fae = malloc(MIN_SIZE * sizeof(posix_spawn_file_actions_entry_t));
+  if (fa->fae == NULL)
+    return ENOMEM;
+  fa->size = MIN_SIZE;
+  fa->len = 0;
+  return 0;
+}
+
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t *fa) {
+  for (unsigned i = 0; i < fa->len; i++)
+    if (fa->fae[i].fae_action == FAE_OPEN)
+      free(fa->fae[i].fae_data.open.path);
+  free(fa->fae);
+  return 0;
+}
+
+static posix_spawn_file_actions_entry_t *
+fae_append(posix_spawn_file_actions_t *fa) {
+  if (fa->len == fa->size) {
+    if (reallocarr(&fa->fae, fa->size * 2, sizeof(*fa->fae)))
+      return NULL;
+    fa->size *= 2;
+  }
+  return &fa->fae[fa->len];
+}
+
+/* Upper bound is checked by the kernel, when the actions are performed. */
+static int fae_check_fd(int fd) {
+  return (fd < 0) ? EBADF : 0;
+}
+
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t *fa, int fd,
+                                     const char *path, int oflag, mode_t mode) {
+  posix_spawn_file_actions_entry_t *fae;
+  char *pathcopy;
+  int error;
+
+  if ((error = fae_check_fd(fd)))
+    return error;
+
+  if ((pathcopy = strdup(path)) == NULL)
+    return ENOMEM;
+
+  if ((fae = fae_append(fa)) == NULL) {
+    free(pathcopy);
+    return ENOMEM;
+  }
+
+  fae->fae_action = FAE_OPEN;
+  fae->fae_fildes = fd;
+  fae->fae_data.open.path = pathcopy;
+  fae->fae_data.open.oflag = oflag;
+  fae->fae_data.open.mode = mode;
+  fa->len++;
+  return 0;
+}
+
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t *fa, int fd,
+                                     int newfd) {
+  posix_spawn_file_actions_entry_t *fae;
+  int error;
+
+  if ((error = fae_check_fd(fd)) || (error = fae_check_fd(newfd)))
+    return error;
+
+  if ((fae = fae_append(fa)) == NULL)
+    return ENOMEM;
+
+  fae->fae_action = FAE_DUP2;
+  fae->fae_fildes = fd;
+  fae->fae_data.dup2.newfildes = newfd;
+  fa->len++;
+  return 0;
+}
+
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t *fa, int fd) {
+  posix_spawn_file_actions_entry_t *fae;
+  int error;
+
+  if ((error = fae_check_fd(fd)))
+    return error;
+
+  if ((fae = fae_append(fa)) == NULL)
+    return ENOMEM;
+
+  fae->fae_action = FAE_CLOSE;
+  fae->fae_fildes = fd;
+  fa->len++;
+  return 0;
+}
@@ -0,0 +1,61 @@
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+
+#define POSIX_SPAWN_ALL                                                        \
+  (POSIX_SPAWN_RESETIDS | POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF |      \
+   POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSID)
+
+int posix_spawnattr_init(posix_spawnattr_t *sa) {
+  memset(sa, 0, sizeof(*sa));
+  return 0;
+}
+
+int posix_spawnattr_destroy(posix_spawnattr_t *sa) {
+  return 0;
+}
+
+int posix_spawnattr_getflags(const posix_spawnattr_t *sa, short *flags) {
+  *flags = sa->sa_flags;
+  return 0;
+}
+
+int posix_spawnattr_getpgroup(const posix_spawnattr_t *sa, pid_t *pgroup) {
+  *pgroup = sa->sa_pgroup;
+  return 0;
+}
+
+int posix_spawnattr_getsigdefault(const posix_spawnattr_t *sa,
+                                  sigset_t *sigdefault) {
+  *sigdefault = sa->sa_sigdefault;
+  return 0;
+}
+
+int posix_spawnattr_getsigmask(const posix_spawnattr_t *sa, sigset_t *sigmask) {
+  *sigmask = sa->sa_sigmask;
+  return 0;
+}
+
+int posix_spawnattr_setflags(posix_spawnattr_t *sa, short flags) {
+  if (flags & ~POSIX_SPAWN_ALL)
+    return EINVAL;
+  sa->sa_flags = flags;
+  return 0;
+}
+
+int posix_spawnattr_setpgroup(posix_spawnattr_t *sa, pid_t pgroup) {
+  sa->sa_pgroup = pgroup;
+  return 0;
+}
+
+int posix_spawnattr_setsigdefault(posix_spawnattr_t *sa,
+                                  const sigset_t *sigdefault) {
+  sa->sa_sigdefault = *sigdefault;
+  return 0;
+}
+
+int posix_spawnattr_setsigmask(posix_spawnattr_t *sa, const sigset_t *sigmask) {
+  sa->sa_sigmask = *sigmask;
+  return 0;
+}
@@ -26,6 +26,7 @@
 
 #include <stdarg.h>
 #include <ucontext.h>
+#include <sys/time.h>
 
 #ifndef __LOCALE_T_DECLARED
 typedef struct _locale *locale_t;
@@ -35,6 +36,7 @@ typedef struct _locale *locale_t;
 __BEGIN_DECLS
 extern char *__minbrk;
 int __getcwd(char *, size_t);
+int __clock_gettime(clockid_t, timespec_t *);
 int __getlogin(char *, size_t);
 int __setlogin(const char *);
 void _resumecontext(void) __noreturn;
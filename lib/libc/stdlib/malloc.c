@@ -48,8 +48,18 @@
 #include "extern.h"
 #include <reentrant.h>
 
-#define _MALLOC_LOCK()
-#define _MALLOC_UNLOCK()
+/* These are no-ops unless overridden by libpthread. */
+void __libc_malloc_lock(void);
+void __libc_malloc_unlock(void);
+
+__attribute__((weak)) void __libc_malloc_lock(void) {
+}
+
+__attribute__((weak)) void __libc_malloc_unlock(void) {
+}
+
+#define _MALLOC_LOCK() __libc_malloc_lock()
+#define _MALLOC_UNLOCK() __libc_malloc_unlock()
 
 #if defined(__sparc__) && defined(sun)
 #define malloc_minsize 16U
@@ -40,9 +40,6 @@
 
 #include "env.h"
 
-/* XXX: mimiker workaround for missing vfork */
-#define vfork fork
-
 int system(const char *command) {
   pid_t pid;
   struct sigaction intsa, quitsa, sa;
@@ -0,0 +1,74 @@
+#include <sys/time.h>
+#include <sys/timepage.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "extern.h"
+
+static bool read_counter(uint32_t counter, uint64_t *count_p) {
+  switch (counter) {
+#if defined(__aarch64__)
+    case TP_COUNTER_CNTPCT:
+      /* Counter reads can be speculated, see ARM ARM D11.2.2. */
+      __asm __volatile("isb; mrs %0, cntpct_el0" : "=r"(*count_p));
+      return true;
+#elif defined(__riscv)
+    case TP_COUNTER_RDTIME:
+#if __riscv_xlen == 64
+      __asm __volatile("rdtime %0" : "=r"(*count_p));
+#else
+    {
+      uint32_t lo, hi, tmp;
+      __asm __volatile("1: rdtimeh %0\n"
+                       "rdtime %1\n"
+                       "rdtimeh %2\n"
+                       "bne %0, %2, 1b"
+                       : "=&r"(hi), "=&r"(lo), "=&r"(tmp));
+      *count_p = ((uint64_t)hi << 32) | lo;
+    }
+#endif
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+/* Computes time like the kernel does, but without leaving user space. */
+static bool timepage_gettime(clockid_t clk, bintime_t *bt) {
+  const timepage_t *tp = (const timepage_t *)TIMEPAGE_ADDR;
+  bintime_t period, boottime;
+  uint32_t gen, counter;
+  uint64_t count;
+
+  do {
+    while ((gen = tp->tp_gen) & 1)
+      continue;
+    atomic_thread_fence(memory_order_acquire);
+
+    counter = tp->tp_counter;
+    period = tp->tp_period;
+    boottime = tp->tp_boottime;
+    if (!read_counter(counter, &count))
+      return false;
+
+    atomic_thread_fence(memory_order_acquire);
+  } while (gen != tp->tp_gen);
+
+  *bt = bintime_mul64(period, count);
+  if (clk == CLOCK_REALTIME)
+    bintime_add(bt, &boottime);
+  return true;
+}
+
+int clock_gettime(clockid_t clk, timespec_t *tp) {
+  bintime_t bt;
+
+  if ((clk == CLOCK_REALTIME || clk == CLOCK_MONOTONIC) &&
+      timepage_gettime(clk, &bt)) {
+    bt2ts(&bt, tp);
+    return 0;
+  }
+
+  return __clock_gettime(clk, tp);
+}
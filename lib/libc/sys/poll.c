@@ -0,0 +1,14 @@
+#include <poll.h>
+#include <time.h>
+
+int poll(struct pollfd *fds, nfds_t nfds, int timeout) {
+  struct timespec ts, *tsp = NULL;
+
+  if (timeout >= 0) {
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000L;
+    tsp = &ts;
+  }
+
+  return ppoll(fds, nfds, tsp, NULL);
+}
@@ -0,0 +1,76 @@
+#include <errno.h>
+#include <limits.h>
+#include <paths.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int __posix_spawn(pid_t *, const char *, const posix_spawn_file_actions_t *,
+                  const posix_spawnattr_t *, char *const *, char *const *);
+
+/* Unlike most system calls posix_spawn reports errors by return value. */
+int posix_spawn(pid_t *pid, const char *path,
+                const posix_spawn_file_actions_t *fa,
+                const posix_spawnattr_t *sa, char *const *argv,
+                char *const *envp) {
+  int saved_errno = errno;
+  int error = 0;
+
+  if (__posix_spawn(pid, path, fa, sa, argv, envp) < 0)
+    error = errno;
+
+  errno = saved_errno;
+  return error;
+}
+
+int posix_spawnp(pid_t *pid, const char *file,
+                 const posix_spawn_file_actions_t *fa,
+                 const posix_spawnattr_t *sa, char *const *argv,
+                 char *const *envp) {
+  char buf[PATH_MAX];
+  const char *path, *p;
+  size_t lp, ln;
+  int error, eacces = 0;
+
+  if (file[0] == '\0')
+    return ENOENT;
+
+  /* If it's an absolute or relative path name, it's easy. */
+  if (strchr(file, '/'))
+    return posix_spawn(pid, file, fa, sa, argv, envp);
+
+  if (!(path = getenv("PATH")))
+    path = _PATH_DEFPATH;
+
+  ln = strlen(file);
+
+  do {
+    /* Find the end of this path element. Empty element means the current
+     * directory. */
+    for (p = path; *path != 0 && *path != ':'; path++)
+      continue;
+    if (p == path) {
+      p = ".";
+      lp = 1;
+    } else {
+      lp = path - p;
+    }
+
+    if (lp + ln + 2 > sizeof(buf))
+      continue;
+
+    memcpy(buf, p, lp);
+    buf[lp] = '/';
+    memcpy(buf + lp + 1, file, ln);
+    buf[lp + ln + 1] = '\0';
+
+    error = posix_spawn(pid, buf, fa, sa, argv, envp);
+    if (error == EACCES)
+      eacces = 1;
+    else if (error != ENOENT && error != ENOTDIR)
+      return error;
+  } while (*path++ == ':');
+
+  return eacces ? EACCES : ENOENT;
+}
@@ -1,5 +0,0 @@
-#include <unistd.h>
-
-pid_t vfork(void) {
-  return fork();
-}
@@ -0,0 +1,147 @@
+#include <sys/param.h>
+#include <sys/futex.h>
+#include <sys/mman.h>
+#include <sys/thr.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "pthread_int.h"
+
+#undef errno
+extern int errno;
+
+/* Descriptor of the main thread. Thread pointer of the main thread is set
+ * when the first thread gets created. */
+static struct __pthread pthread_main;
+
+static pthread_mutex_t malloc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Following functions override weak definitions found in libc.
+ * Since libc is linked statically they must reside in the same object file
+ * as `pthread_create`, otherwise the linker would not pick them up.
+ */
+
+int *__errno(void) {
+  pthread_t self = __pthread_tp();
+  /* The main thread keeps using global errno. */
+  if (self == NULL || self == &pthread_main)
+    return &errno;
+  return &self->pt_errno;
+}
+
+void __libc_malloc_lock(void) {
+  pthread_mutex_lock(&malloc_lock);
+}
+
+void __libc_malloc_unlock(void) {
+  pthread_mutex_unlock(&malloc_lock);
+}
+
+pthread_t pthread_self(void) {
+  pthread_t self = __pthread_tp();
+  return self ? self : &pthread_main;
+}
+
+int pthread_equal(pthread_t t1, pthread_t t2) {
+  return t1 == t2;
+}
+
+static void pthread_start(void *arg) {
+  pthread_t self = arg;
+  pthread_exit(self->pt_func(self->pt_arg));
+}
+
+int pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+                   void *(*start_routine)(void *), void *arg) {
+  size_t stacksize = attr ? attr->pta_stacksize : PTHREAD_STACK_DEFAULT;
+  size_t mapsize = roundup(stacksize + sizeof(struct __pthread), getpagesize());
+
+  if (__pthread_tp() == NULL)
+    thr_settls(&pthread_main);
+
+  void *mapping = mmap(NULL, mapsize, PROT_READ | PROT_WRITE,
+                       MAP_ANON | MAP_PRIVATE, -1, 0);
+  if (mapping == MAP_FAILED)
+    return EAGAIN;
+
+  /* The descriptor is placed at the top of the mapping, just above the stack.
+   * Anonymous memory is zero-filled, so there's no need to clear it. */
+  pthread_t td =
+    (pthread_t)((char *)mapping + mapsize - sizeof(struct __pthread));
+  td->pt_func = start_routine;
+  td->pt_arg = arg;
+  td->pt_mapping = mapping;
+  td->pt_mapsize = mapsize;
+
+  struct thr_param param = {
+    .start_func = pthread_start,
+    .arg = td,
+    .stack_base = mapping,
+    .stack_size = (char *)td - (char *)mapping,
+    .tls_base = td,
+  };
+
+  if (thr_new(&param) == (tid_t)-1) {
+    int error = errno;
+    munmap(mapping, mapsize);
+    return error;
+  }
+
+  *thread = td;
+  return 0;
+}
+
+__noreturn void pthread_exit(void *retval) {
+  pthread_t self = pthread_self();
+  self->pt_retval = retval;
+  /* If this is the last thread, then the process exits with status 0. */
+  thr_exit(&self->pt_exited);
+}
+
+int pthread_join(pthread_t thread, void **retvalp) {
+  if (thread == pthread_self())
+    return EDEADLK;
+
+  while (!__atomic_load_n(&thread->pt_exited, __ATOMIC_ACQUIRE))
+    futex(&thread->pt_exited, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+
+  if (retvalp)
+    *retvalp = thread->pt_retval;
+
+  /* The thread won't touch its stack anymore, so it's safe to release it. */
+  if (thread->pt_mapping)
+    munmap(thread->pt_mapping, thread->pt_mapsize);
+
+  return 0;
+}
+
+int pthread_attr_init(pthread_attr_t *attr) {
+  attr->pta_stacksize = PTHREAD_STACK_DEFAULT;
+  return 0;
+}
+
+int pthread_attr_destroy(pthread_attr_t *attr) {
+  return 0;
+}
+
+int pthread_attr_getstacksize(const pthread_attr_t *attr, size_t *sizep) {
+  *sizep = attr->pta_stacksize;
+  return 0;
+}
+
+int pthread_attr_setstacksize(pthread_attr_t *attr, size_t size) {
+  if (size < PTHREAD_STACK_MIN)
+    return EINVAL;
+  attr->pta_stacksize = size;
+  return 0;
+}
+
+int pthread_sigmask(int how, const sigset_t *set, sigset_t *oset) {
+  /* Signal masks are maintained by the kernel for each thread. */
+  if (sigprocmask(how, set, oset) < 0)
+    return errno;
+  return 0;
+}
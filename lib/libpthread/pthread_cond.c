@@ -0,0 +1,61 @@
+#include <sys/futex.h>
+#include <sys/time.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "pthread_int.h"
+
+/*
+ * A waiter samples the sequence number before releasing the mutex and sleeps
+ * on the futex only if the number hasn't changed since, hence a wakeup that
+ * happened in between is never lost. Spurious wakeups are allowed by POSIX.
+ */
+
+int pthread_cond_init(pthread_cond_t *c, const pthread_condattr_t *attr) {
+  c->ptc_seq = 0;
+  return 0;
+}
+
+int pthread_cond_destroy(pthread_cond_t *c) {
+  return 0;
+}
+
+int pthread_cond_timedwait(pthread_cond_t *c, pthread_mutex_t *m,
+                           const struct timespec *abstime) {
+  int seq = __atomic_load_n(&c->ptc_seq, __ATOMIC_RELAXED);
+  struct timespec now, ts, *tsp = NULL;
+  int error = 0;
+
+  if (abstime) {
+    clock_gettime(CLOCK_REALTIME, &now);
+    if (timespeccmp(abstime, &now, <=))
+      return ETIMEDOUT;
+    timespecsub(abstime, &now, &ts);
+    tsp = &ts;
+  }
+
+  pthread_mutex_unlock(m);
+  if (futex(&c->ptc_seq, FUTEX_WAIT_PRIVATE, seq, tsp, NULL, 0) < 0 &&
+      errno == ETIMEDOUT)
+    error = ETIMEDOUT;
+  pthread_mutex_lock(m);
+
+  return error;
+}
+
+int pthread_cond_wait(pthread_cond_t *c, pthread_mutex_t *m) {
+  return pthread_cond_timedwait(c, m, NULL);
+}
+
+int pthread_cond_signal(pthread_cond_t *c) {
+  __atomic_fetch_add(&c->ptc_seq, 1, __ATOMIC_RELAXED);
+  futex(&c->ptc_seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+  return 0;
+}
+
+int pthread_cond_broadcast(pthread_cond_t *c) {
+  __atomic_fetch_add(&c->ptc_seq, 1, __ATOMIC_RELAXED);
+  futex(&c->ptc_seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+  return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef _PTHREAD_INT_H_
+#define _PTHREAD_INT_H_
+
+#include <pthread.h>
+
+#define PTHREAD_STACK_DEFAULT (64 * 1024)
+
+/* Thread descriptor. Thread pointer register of each thread points to its
+ * descriptor. The descriptor and thread's stack are allocated together. */
+struct __pthread {
+  int pt_exited;            /* set to 1 by the kernel when thread exits */
+  void *(*pt_func)(void *); /* start routine */
+  void *pt_arg;             /* argument of start routine */
+  void *pt_retval;          /* value returned by start routine */
+  void *pt_mapping;         /* memory holding stack and the descriptor */
+  size_t pt_mapsize;        /* size of the memory above */
+  int pt_errno;             /* per-thread errno */
+};
+
+/* Read thread pointer register of the calling thread. */
+static inline pthread_t __pthread_tp(void) {
+  pthread_t tp;
+#if defined(__mips__)
+  /* Emulated by the kernel on CPUs that do not implement UserLocal. */
+  __asm__ volatile(".set push\n"
+                   ".set mips32r2\n"
+                   "rdhwr $3, $29\n"
+                   "move %0, $3\n"
+                   ".set pop"
+                   : "=r"(tp)
+                   :
+                   : "$3");
+#elif defined(__aarch64__)
+  __asm__ volatile("mrs %0, tpidr_el0" : "=r"(tp));
+#elif defined(__riscv)
+  __asm__ volatile("mv %0, tp" : "=r"(tp));
+#else
+#error "Unsupported architecture!"
+#endif
+  return tp;
+}
+
+#endif /* !_PTHREAD_INT_H_ */
@@ -0,0 +1,52 @@
+#include <sys/futex.h>
+#include <errno.h>
+#include <stdbool.h>
+
+#include "pthread_int.h"
+
+/*
+ * Mutex implementation based on "Futexes Are Tricky" by Ulrich Drepper.
+ * Uncontended lock and unlock operations don't enter the kernel. The value of
+ * 2 tells the owner that it has to wake up a waiter when it unlocks the mutex.
+ */
+
+int pthread_mutex_init(pthread_mutex_t *m, const pthread_mutexattr_t *attr) {
+  m->ptm_lock = 0;
+  return 0;
+}
+
+int pthread_mutex_destroy(pthread_mutex_t *m) {
+  return m->ptm_lock ? EBUSY : 0;
+}
+
+int pthread_mutex_trylock(pthread_mutex_t *m) {
+  int c = 0;
+  if (__atomic_compare_exchange_n(&m->ptm_lock, &c, 1, false, __ATOMIC_ACQUIRE,
+                                  __ATOMIC_RELAXED))
+    return 0;
+  return EBUSY;
+}
+
+int pthread_mutex_lock(pthread_mutex_t *m) {
+  int c = 0;
+
+  if (__atomic_compare_exchange_n(&m->ptm_lock, &c, 1, false, __ATOMIC_ACQUIRE,
+                                  __ATOMIC_RELAXED))
+    return 0;
+
+  if (c != 2)
+    c = __atomic_exchange_n(&m->ptm_lock, 2, __ATOMIC_ACQUIRE);
+
+  while (c != 0) {
+    futex(&m->ptm_lock, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+    c = __atomic_exchange_n(&m->ptm_lock, 2, __ATOMIC_ACQUIRE);
+  }
+
+  return 0;
+}
+
+int pthread_mutex_unlock(pthread_mutex_t *m) {
+  if (__atomic_exchange_n(&m->ptm_lock, 0, __ATOMIC_RELEASE) == 2)
+    futex(&m->ptm_lock, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+  return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * Reading process statistics snapshots from /dev/procstat.
+ */
+#include <sys/types.h>
+#include <sys/procstat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <util.h>
+
+#define PROCSTAT_DEV "/dev/procstat"
+
+kinfo_header_t *procstat_read(void) {
+  size_t size = 0, len = 0;
+  char *buf = NULL, *newbuf;
+  ssize_t nread;
+  int error;
+
+  int fd = open(PROCSTAT_DEV, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  do {
+    if (len == size) {
+      size = size ? size * 2 : 32768;
+      if (!(newbuf = realloc(buf, size)))
+        goto fail;
+      buf = newbuf;
+    }
+    if ((nread = read(fd, buf + len, size - len)) < 0)
+      goto fail;
+    len += nread;
+  } while (nread > 0);
+
+  close(fd);
+
+  kinfo_header_t *kh = (kinfo_header_t *)buf;
+  if (len < sizeof(kinfo_header_t) || kh->kh_version != PROCSTAT_VERSION) {
+    free(buf);
+    errno = EFTYPE;
+    return NULL;
+  }
+  return kh;
+
+fail:
+  error = errno;
+  free(buf);
+  close(fd);
+  errno = error;
+  return NULL;
+}
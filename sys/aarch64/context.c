@@ -41,6 +41,19 @@ void mcontext_init(mcontext_t *ctx, void *pc, void *sp) {
   _REG(ctx, SP) = (register_t)sp;
 }
 
+void mcontext_setup_thread(mcontext_t *ctx, void *pc, void *sp,
+                           register_t arg) {
+  _REG(ctx, PC) = (register_t)pc;
+  _REG(ctx, SP) = (register_t)sp;
+  _REG(ctx, X0) = arg;
+  _REG(ctx, FP) = 0;
+  _REG(ctx, LR) = 0;
+}
+
+void mcontext_set_tls(mcontext_t *ctx, void *tls) {
+  _REG(ctx, TPIDR) = (register_t)tls;
+}
+
 void mcontext_set_retval(mcontext_t *ctx, register_t value, register_t error) {
   _REG(ctx, X0) = value;
   _REG(ctx, X1) = error;
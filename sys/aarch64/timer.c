@@ -1,6 +1,7 @@
 #define KL_LOG KL_TIME
 #include <sys/klog.h>
 #include <sys/timer.h>
+#include <sys/timepage.h>
 #include <aarch64/armreg.h>
 #include <sys/interrupt.h>
 #include <sys/bus.h>
@@ -14,17 +15,25 @@ typedef struct arm_timer_state {
   resource_t *irq_res;
   timer_t timer;
   uint64_t step;
+  bool oneshot;
 } arm_timer_state_t;
 
-static int arm_timer_start(timer_t *tm, unsigned flags __unused,
-                           const bintime_t start __unused,
+static int arm_timer_start(timer_t *tm, unsigned flags, const bintime_t start,
                            const bintime_t period) {
   arm_timer_state_t *state = ((device_t *)tm->tm_priv)->state;
-  state->step = bintime_mul(period, tm->tm_frequency).sec;
+  uint64_t delay;
+
+  state->oneshot = flags & TMF_ONESHOT;
+  if (state->oneshot) {
+    delay = bintime_mul(start, tm->tm_frequency).sec;
+  } else {
+    state->step = bintime_mul(period, tm->tm_frequency).sec;
+    delay = state->step;
+  }
 
   WITH_INTR_DISABLED {
     uint64_t count = READ_SPECIALREG(cntpct_el0);
-    WRITE_SPECIALREG(cntp_cval_el0, count + state->step);
+    WRITE_SPECIALREG(cntp_cval_el0, count + delay);
     WRITE_SPECIALREG(cntp_ctl_el0, CNTCTL_ENABLE);
   }
 
@@ -38,16 +47,20 @@ static int arm_timer_stop(timer_t *tm) {
 
 static bintime_t arm_timer_gettime(timer_t *tm) {
   uint64_t count = READ_SPECIALREG(cntpct_el0);
-  bintime_t res = bintime_mul(tm->tm_min_period, (uint32_t)count);
-  bintime_t high_bits = bintime_mul(tm->tm_min_period, (uint32_t)(count >> 32));
-  bintime_add_frac(&res, (high_bits.frac << 32));
-  res.sec += (high_bits.sec << 32) + (high_bits.frac >> 32);
-  return res;
+  return bintime_mul64(tm->tm_min_period, count);
 }
 
 static intr_filter_t arm_timer_intr(void *data /* device_t* */) {
   arm_timer_state_t *state = ((device_t *)data)->state;
 
+  if (state->oneshot) {
+    /* Deassert the interrupt, the callback is going to program the next event
+     * if it needs one. */
+    WRITE_SPECIALREG(cntp_cval_el0, UINT64_MAX);
+    tm_trigger(&state->timer);
+    return IF_FILTERED;
+  }
+
   tm_trigger(&state->timer);
 
   /*
@@ -71,17 +84,22 @@ static int arm_timer_attach(device_t *dev) {
   /* Save link to timer device. */
   state->timer = (timer_t){
     .tm_name = "arm-cpu-timer",
-    .tm_flags = TMF_PERIODIC,
+    .tm_flags = TMF_PERIODIC | TMF_ONESHOT,
     .tm_quality = 0,
     .tm_start = arm_timer_start,
     .tm_stop = arm_timer_stop,
     .tm_gettime = arm_timer_gettime,
+    .tm_usercounter = TP_COUNTER_CNTPCT,
     .tm_priv = dev,
     .tm_frequency = freq,
     .tm_min_period = HZ2BT(freq),
     .tm_max_period = bintime_mul(HZ2BT(freq), 1LL << 30),
   };
 
+  /* Let user space read the counter, see <sys/timepage.h>. */
+  WRITE_SPECIALREG(cntkctl_el1,
+                   READ_SPECIALREG(cntkctl_el1) | CNTKCTL_EL0PCTEN);
+
   state->irq_res = device_take_irq(dev, 1);
 
   tm_register(&state->timer);
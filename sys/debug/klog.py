@@ -37,25 +37,38 @@ class LogEntry(metaclass=GdbStructMeta):
             return printf
 
 
-class LogBuffer(metaclass=GdbStructMeta):
-    __ctype__ = 'struct klog'
-    __cast__ = {'first': int, 'last': int}
+class LogRing(metaclass=GdbStructMeta):
+    __ctype__ = 'struct klog_ring'
+    __cast__ = {'head': int, 'tail': int}
 
     @property
     def size(self):
         return int(self.array.type.range()[1]) + 1
 
     def __iter__(self):
-        first, last = self.first, self.last
-        while first != last:
-            yield LogEntry(self.array[first])
-            first = (first + 1) % self.size
+        # Skip entries that were overwritten or are being written.
+        head = self.head
+        for i in range(max(self.tail, head - self.size), head):
+            entry = self.array[i % self.size]
+            if int(entry['kl_seq']) == i + 1:
+                yield LogEntry(entry)
+
+
+class LogBuffer(metaclass=GdbStructMeta):
+    __ctype__ = 'struct klog'
+
+    @property
+    def rings(self):
+        nrings = int(self.ring.type.range()[1]) + 1
+        return [LogRing(self.ring[i]) for i in range(nrings)]
+
+    def __iter__(self):
+        entries = [entry for ring in self.rings for entry in ring]
+        return iter(sorted(entries,
+                           key=lambda e: e.kl_timestamp.as_float()))
 
     def __len__(self):
-        n = self.last - self.first
-        if n < 0:
-            n += self.size
-        return n
+        return sum(1 for ring in self.rings for _ in ring)
 
 
 class Klog(SimpleCommand):
@@ -6,6 +6,7 @@
 #include <sys/klog.h>
 #include <sys/libkern.h>
 #include <sys/timer.h>
+#include <sys/timepage.h>
 #include <riscv/cpufunc.h>
 #include <riscv/sbi.h>
 
@@ -14,6 +15,8 @@ typedef struct clint_state {
   resource_t *mswi_irq;
   resource_t *mtimer_irq;
   uint64_t mtimer_step;
+  bool mtimer_running; /* interrupt handler is set up */
+  bool mtimer_oneshot;
 } clint_state_t;
 
 /*
@@ -25,6 +28,14 @@ static intr_filter_t mtimer_intr(void *data) {
   register_t sip = csr_read(sip);
 
   if (sip & SIP_STIP) {
+    if (clint->mtimer_oneshot) {
+      /* Deassert the interrupt, the callback is going to program the next
+       * event if it needs one. */
+      sbi_set_timer(UINT64_MAX);
+      tm_trigger(&clint->mtimer);
+      return IF_FILTERED;
+    }
+
     tm_trigger(&clint->mtimer);
 
     uint64_t prev = rdtime();
@@ -40,13 +51,25 @@ static int mtimer_start(timer_t *tm, unsigned flags, const bintime_t start,
                         const bintime_t period) {
   device_t *dev = tm->tm_priv;
   clint_state_t *clint = dev->state;
-  clint->mtimer_step = bintime_mul(period, tm->tm_frequency).sec;
+  uint64_t delay;
+
+  clint->mtimer_oneshot = flags & TMF_ONESHOT;
+  if (clint->mtimer_oneshot) {
+    delay = bintime_mul(start, tm->tm_frequency).sec;
+  } else {
+    clint->mtimer_step = bintime_mul(period, tm->tm_frequency).sec;
+    delay = clint->mtimer_step;
+  }
 
-  pic_setup_intr(dev, clint->mtimer_irq, mtimer_intr, NULL, clint, "MTIMER");
+  if (!clint->mtimer_running) {
+    pic_setup_intr(dev, clint->mtimer_irq, mtimer_intr, NULL, clint,
+                   "MTIMER");
+    clint->mtimer_running = true;
+  }
 
   WITH_INTR_DISABLED {
     uint64_t count = rdtime();
-    sbi_set_timer(count + clint->mtimer_step);
+    sbi_set_timer(count + delay);
   }
 
   return 0;
@@ -56,16 +79,13 @@ static int mtimer_stop(timer_t *tm) {
   device_t *dev = tm->tm_priv;
   clint_state_t *clint = dev->state;
   pic_teardown_intr(dev, clint->mtimer_irq);
+  clint->mtimer_running = false;
   return 0;
 }
 
 static bintime_t mtimer_gettime(timer_t *tm) {
   uint64_t count = rdtime();
-  bintime_t res = bintime_mul(tm->tm_min_period, (uint32_t)count);
-  bintime_t high_bits = bintime_mul(tm->tm_min_period, (uint32_t)(count >> 32));
-  bintime_add_frac(&res, high_bits.frac << 32);
-  res.sec += (high_bits.sec << 32) + (high_bits.frac >> 32);
-  return res;
+  return bintime_mul64(tm->tm_min_period, count);
 }
 
 /*
@@ -106,16 +126,20 @@ static int clint_attach(device_t *dev) {
 
   clint->mtimer = (timer_t){
     .tm_name = "RISC-V CLINT",
-    .tm_flags = TMF_PERIODIC,
+    .tm_flags = TMF_PERIODIC | TMF_ONESHOT,
     .tm_frequency = freq,
     .tm_min_period = HZ2BT(freq),
     .tm_max_period = bintime_mul(HZ2BT(freq), (1LL << 32) - 1),
     .tm_start = mtimer_start,
     .tm_stop = mtimer_stop,
     .tm_gettime = mtimer_gettime,
+    .tm_usercounter = TP_COUNTER_RDTIME,
     .tm_priv = dev,
   };
 
+  /* Let user space read the counter, see <sys/timepage.h>. */
+  csr_set(scounteren, SCOUNTEREN_TM);
+
   tm_register(&clint->mtimer);
 
   return 0;
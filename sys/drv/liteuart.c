@@ -106,7 +106,7 @@ static int liteuart_attach(device_t *dev) {
   if ((err = bus_map_resource(dev, liteuart->csrs)))
     return err;
 
-  uart_init(dev, "liteuart", LITEUART_BUFSIZE, liteuart, tty);
+  uart_init(dev, LITEUART_BUFSIZE, liteuart, tty);
 
   /* Clear pending events. */
   csr_write(LITEUART_CSR_EV_PENDING, LITEUART_EV_TX | LITEUART_EV_RX);
@@ -117,7 +117,7 @@ static int liteuart_attach(device_t *dev) {
   liteuart->irq = device_take_irq(dev, 0);
   assert(liteuart->irq);
 
-  pic_setup_intr(dev, liteuart->irq, liteuart_intr, NULL, dev, "liteuart");
+  uart_setup_intr(dev, liteuart->irq, liteuart_intr, "liteuart");
 
   /* Prepare /dev/uart interface. */
   tty_makedev(NULL, "uart", tty);
@@ -91,10 +91,10 @@ static int ns16550_attach(device_t *dev) {
   if ((err = bus_map_resource(dev, ns16550->regs)))
     return err;
 
-  uart_init(dev, "ns16550", UART_BUFSIZE, ns16550, tty);
+  uart_init(dev, UART_BUFSIZE, ns16550, tty);
 
   ns16550->irq_res = device_take_irq(dev, 0);
-  pic_setup_intr(dev, ns16550->irq_res, uart_intr, NULL, dev, "NS16550 UART");
+  uart_setup_intr(dev, ns16550->irq_res, uart_intr, "NS16550 UART");
 
   /* Setup UART and enable interrupts */
   setup(ns16550->regs);
@@ -83,7 +83,7 @@ static int pl011_attach(device_t *dev) {
   if ((err = bus_map_resource(dev, pl011->regs)))
     return err;
 
-  uart_init(dev, "pl011", UART_BUFSIZE, pl011, tty);
+  uart_init(dev, UART_BUFSIZE, pl011, tty);
 
   resource_t *r = pl011->regs;
 
@@ -120,7 +120,7 @@ static int pl011_attach(device_t *dev) {
   bus_write_4(r, PL011COM_IMSC, PL011_INT_RX);
 
   pl011->irq = device_take_irq(dev, 0);
-  pic_setup_intr(dev, pl011->irq, uart_intr, NULL, dev, "PL011 UART");
+  uart_setup_intr(dev, pl011->irq, uart_intr, "PL011 UART");
 
   /* Prepare /dev/uart interface. */
   tty_makedev(NULL, "uart", tty);
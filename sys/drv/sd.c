@@ -10,6 +10,7 @@
  */
 
 #include <sys/mimiker.h>
+#include <sys/bio.h>
 #include <dev/emmc.h>
 #include <sys/device.h>
 #include <sys/devclass.h>
@@ -21,9 +22,9 @@
 
 typedef struct sd_state {
   sd_props_t props; /* SD Card's flags */
-  void *block_buf;  /* A buffer for reading data into */
   uint64_t csd[2];  /* Card-Specific Data register's content */
   uint16_t rca;     /* Relative Card Address */
+  bio_queue_t bioq; /* block I/O request queue */
 } sd_state_t;
 
 static int sd_probe(device_t *dev) {
@@ -350,62 +351,19 @@ static int sd_write_blk(device_t *dev, uint32_t lba, void *buffer, uint32_t num,
   return err;
 }
 
-static inline int sd_check_uio(device_t *dev, uio_t *uio) {
-  sd_state_t *state = (sd_state_t *)dev->state;
-  if ((uint64_t)uio->uio_offset >= sd_capacity(state))
-    return EINVAL;
-  return 0;
+/* Block transfer routine for the request queue, see <sys/bio.h>. */
+static int sd_rw(void *arg, bio_cmd_t cmd, uint64_t blkno, void *data,
+                 size_t nblks) {
+  device_t *dev = arg;
+  if (cmd == BIO_READ)
+    return sd_read_blk(dev, blkno, data, nblks, NULL);
+  return sd_write_blk(dev, blkno, data, nblks, NULL);
 }
 
 static int sd_dop_uio(devnode_t *d, uio_t *uio) {
   device_t *dev = d->data;
   sd_state_t *state = (sd_state_t *)dev->state;
-  int err;
-
-  if ((err = sd_check_uio(dev, uio)))
-    return err;
-
-  uint32_t lba = uio->uio_offset / DEFAULT_BLKSIZE;
-  uint32_t read_offset = lba * DEFAULT_BLKSIZE;
-  uint32_t copy_offset = uio->uio_offset - read_offset;
-  uint32_t blk_cnt = (uio->uio_resid) / DEFAULT_BLKSIZE;
-  /* XXX: If there's a offset that causes the transfer to overlap with next
-   * block, we need to read that extra block as well. */
-  if (blk_cnt * DEFAULT_BLKSIZE < copy_offset + uio->uio_resid)
-    blk_cnt++;
-
-  uint32_t blocks_left = blk_cnt;
-  while (uio->uio_resid) {
-    /* We move from internal buffer, soe we need to change the offset to reflect
-     * that from our internal buffer */
-    uio->uio_offset = copy_offset;
-    uint32_t num = min(blocks_left, (uint32_t)SD_KERNEL_BLOCKS);
-    uint32_t bytes_to_transfer =
-      min(uio->uio_resid, num * DEFAULT_BLKSIZE - copy_offset);
-
-    if (uio->uio_op == UIO_READ) {
-      if ((err = sd_read_blk(dev, lba, state->block_buf, num, NULL)))
-        return err;
-      if ((err = uiomove_frombuf(state->block_buf,
-                                 SD_KERNEL_BLOCKS * DEFAULT_BLKSIZE, uio)))
-        return err;
-    } else {
-      if (bytes_to_transfer % DEFAULT_BLKSIZE != 0) {
-        if ((err = sd_read_blk(dev, lba, state->block_buf, num, NULL)))
-          return err;
-      }
-      if ((err = uiomove_frombuf(state->block_buf,
-                                 SD_KERNEL_BLOCKS * DEFAULT_BLKSIZE, uio)))
-        return err;
-      if ((err = sd_write_blk(dev, lba, state->block_buf, num, NULL)))
-        return err;
-    }
-    copy_offset = 0;
-    blocks_left -= num;
-    lba += num;
-  }
-
-  return 0;
+  return bioq_uio(&state->bioq, uio);
 }
 
 static int sd_open(devnode_t *d, file_t *fp, int oflags) {
@@ -428,18 +386,14 @@ static int sd_attach(device_t *dev) {
   int err = 0;
   sd_state_t *state = (sd_state_t *)dev->state;
 
-  state->block_buf = kmalloc(M_DEV, SD_KERNEL_BLOCKS * DEFAULT_BLKSIZE, 0);
-
   if ((err = sd_init(dev)))
-    goto sd_attach_fail;
-
-  if ((err = devfs_makedev_new(NULL, "sd_card", &sd_devops, dev, NULL)))
-    goto sd_attach_fail;
+    return err;
 
-  return err;
+  bioq_init(&state->bioq, "sd", DEFAULT_BLKSIZE,
+            sd_capacity(state) / DEFAULT_BLKSIZE, sd_rw, dev);
 
-sd_attach_fail:
-  kfree(M_DEV, state->block_buf);
+  if ((err = devfs_makedev_new(NULL, "sd_card", &sd_devops, dev, NULL)))
+    bioq_destroy(&state->bioq);
 
   return err;
 }
@@ -109,7 +109,7 @@ static int sfuart_attach(device_t *dev) {
   if ((err = bus_map_resource(dev, sfuart->regs)))
     return err;
 
-  uart_init(dev, "SiFive UART", SFUART_BUFSIZE, sfuart, tty);
+  uart_init(dev, SFUART_BUFSIZE, sfuart, tty);
 
   out(SFUART_IRQ_ENABLE, 0);
 
@@ -121,7 +121,7 @@ static int sfuart_attach(device_t *dev) {
   sfuart->irq = device_take_irq(dev, 0);
   assert(sfuart->irq);
 
-  pic_setup_intr(dev, sfuart->irq, uart_intr, NULL, dev, "SiFive UART");
+  uart_setup_intr(dev, sfuart->irq, uart_intr, "SiFive UART");
 
   /* Prepare /dev/uart interface. */
   tty_makedev(NULL, "uart", tty);
@@ -3,8 +3,7 @@
 #include <dev/uart.h>
 #include <sys/uart_tty.h>
 
-void uart_init(device_t *dev, const char *name, size_t buf_size, void *state,
-               tty_t *tty) {
+void uart_init(device_t *dev, size_t buf_size, void *state, tty_t *tty) {
   uart_state_t *uart = dev->state;
   uart->u_state = state;
 
@@ -12,7 +11,15 @@ void uart_init(device_t *dev, const char *name, size_t buf_size, void *state,
   ringbuf_init(&uart->u_tx_buf, kmalloc(M_DEV, buf_size, M_ZERO), buf_size);
 
   mtx_init(&uart->u_lock, MTX_SPIN);
-  uart_tty_thread_create(name, dev, tty);
+  uart_tty_init(dev, tty);
+}
+
+void uart_setup_intr(device_t *dev, resource_t *irq, ih_filter_t *filter,
+                     const char *name) {
+  pic_setup_intr(dev, irq, filter, uart_tty_service, dev, name);
+  /* The filter must keep draining receiver FIFO while characters are being
+   * passed to the tty, otherwise they would be lost. */
+  intr_setup_service(irq, PI_TTY, INTR_COALESCE);
 }
 
 intr_filter_t uart_intr(void *data /* device_t* */) {
@@ -22,12 +29,13 @@ intr_filter_t uart_intr(void *data /* device_t* */) {
   intr_filter_t res = IF_STRAY;
 
   WITH_MTX_LOCK (&uart->u_lock) {
-    /* data ready to be received? */
+    /* data ready to be received? drain the receiver FIFO */
     if (uart_rx_ready(dev)) {
-      (void)ringbuf_putb(&uart->u_rx_buf, uart_getc(dev));
+      do {
+        (void)ringbuf_putb(&uart->u_rx_buf, uart_getc(dev));
+      } while (uart_rx_ready(dev));
       ttd->ttd_flags |= TTY_THREAD_RXRDY;
-      cv_signal(&ttd->ttd_cv);
-      res = IF_FILTERED;
+      res = IF_DELEGATE;
     }
 
     /* transmit register empty? */
@@ -40,13 +48,14 @@ intr_filter_t uart_intr(void *data /* device_t* */) {
          * in the tty's output queue, signal the tty thread to refill. */
         if (ttd->ttd_flags & TTY_THREAD_OUTQ_NONEMPTY) {
           ttd->ttd_flags |= TTY_THREAD_TXRDY;
-          cv_signal(&ttd->ttd_cv);
+          res = IF_DELEGATE;
         }
-        /* Disable TXRDY interrupts - the tty thread will re-enable them
+        /* Disable TXRDY interrupts - the interrupt thread will re-enable them
          * after filling tx_buf. */
         uart_tx_disable(dev);
       }
-      res = IF_FILTERED;
+      if (res == IF_STRAY)
+        res = IF_FILTERED;
     }
   }
 
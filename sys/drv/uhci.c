@@ -850,6 +850,7 @@ static int uhci_attach(device_t *dev) {
   uhci->irq = device_take_irq(dev, 0);
   assert(uhci->irq);
   pic_setup_intr(dev, uhci->irq, uhci_isr, uhci_service, uhci, "UHCI");
+  intr_setup_service(uhci->irq, PI_USB, 0);
 
   /* Turn on the IOC and error interrupts. */
   set16(UHCI_INTR, UHCI_INTR_TOCRCIE | UHCI_INTR_IOCE);
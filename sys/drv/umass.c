@@ -12,6 +12,7 @@
  *     https://manuals.plus/wp-content/sideloads/seagate-scsi-commands-reference-manual-optimized.pdf
  */
 #define KL_LOG KL_DEV
+#include <sys/bio.h>
 #include <sys/devclass.h>
 #include <sys/devfs.h>
 #include <sys/device.h>
@@ -33,6 +34,7 @@ typedef struct umass_state {
   char vendor[SID_VENDOR_SIZE + 1];     /* vandor string */
   char product[SID_PRODUCT_SIZE + 1];   /* product string */
   char revision[SID_REVISION_SIZE + 1]; /* revision string */
+  bio_queue_t bioq;                     /* block I/O request queue */
 } umass_state_t;
 
 /*
@@ -325,59 +327,30 @@ static int umass_read_capacity(device_t *dev) {
  * Device node interface.
  */
 
-static inline usb_direction_t uioop_to_usbdir(uio_op_t op) {
-  switch (op) {
-    case UIO_READ:
-      return USB_DIR_INPUT;
-    case UIO_WRITE:
-      return USB_DIR_OUTPUT;
-    default:
-      panic("Invalid UIO operation!");
-  }
-}
-
-static int umass_op(devnode_t *node, uio_t *uio) {
-  device_t *dev = node->data;
+/* Block transfer routine for the request queue, see <sys/bio.h>. */
+static int umass_rw(void *arg, bio_cmd_t cmd, uint64_t blkno, void *data,
+                    size_t nblks) {
+  device_t *dev = arg;
   umass_state_t *umass = dev->state;
-  usb_direction_t dir = uioop_to_usbdir(uio->uio_op);
-  uint32_t block_size = umass->block_size;
-  int error = 0;
-
-  if (!is_aligned(uio->uio_offset, block_size))
-    return EINVAL;
-  if (!is_aligned(uio->uio_resid, block_size))
-    return EINVAL;
-
-  uint32_t start = uio->uio_offset / block_size;
-  uint32_t nblocks = uio->uio_resid / block_size;
-  uint32_t size = nblocks * block_size;
+  usb_direction_t dir = (cmd == BIO_READ) ? USB_DIR_INPUT : USB_DIR_OUTPUT;
 
-  /* NOTE: we assume that number of blocks to read is <= `UINT16_MAX`. */
-  if (nblocks > UINT16_MAX)
-    return EINVAL;
-
-  void *buf = kmalloc(M_DEV, size, M_WAITOK);
-
-  if (dir == USB_DIR_OUTPUT) {
-    if ((error = uiomove(buf, uio->uio_resid, uio)))
-      goto end;
-  }
+  /* Requests are no longer than BIO_MAXIO, so the number of blocks
+   * fits into 16 bits of READ_10 / WRITE_10 commands. */
+  assert(nblks <= UINT16_MAX);
 
   scsi_rw_10_t rw10 = (scsi_rw_10_t){
     .opcode = (dir == USB_DIR_INPUT) ? READ_10 : WRITE_10,
-    .addr = htobe32(start),
-    .length = htobe16(nblocks),
+    .addr = htobe32(blkno),
+    .length = htobe16(nblks),
   };
-  error = umass_transfer(dev, &rw10, sizeof(scsi_rw_10_t), dir, buf, size);
-  if (error)
-    goto end;
-
-  if (dir == USB_DIR_INPUT)
-    error = uiomove_frombuf(buf, size, uio);
+  return umass_transfer(dev, &rw10, sizeof(scsi_rw_10_t), dir, data,
+                        nblks * umass->block_size);
+}
 
-end:
-  kfree(M_DEV, buf);
-  return error;
+static int umass_op(devnode_t *node, uio_t *uio) {
+  device_t *dev = node->data;
+  umass_state_t *umass = dev->state;
+  return bioq_uio(&umass->bioq, uio);
 }
 
 static devops_t umass_devops = {
@@ -436,6 +409,9 @@ static int umass_attach(device_t *dev) {
 
   umass_print(dev);
 
+  bioq_init(&umass->bioq, "umass", umass->block_size, umass->nblocks, umass_rw,
+            dev);
+
   /* Prepare /dev/umass interface. */
   devfs_makedev_new(NULL, "umass", &umass_devops, dev, NULL);
 
@@ -2,6 +2,7 @@
 #include <bitstring.h>
 #include <sys/context.h>
 #include <sys/errno.h>
+#include <sys/evcnt.h>
 #include <sys/kasan.h>
 #include <sys/klog.h>
 #include <sys/libkern.h>
@@ -14,6 +15,11 @@
 #include <sys/_pmap.h>
 #include <sys/_tlb.h>
 
+static EVCNT_DEFINE(tlb_inval_page, "pmap", "tlb page invalidate");
+static EVCNT_DEFINE(tlb_inval_asid, "pmap", "tlb asid invalidate");
+static EVCNT_DEFINE(fault_refmod, "vm", "fault refmod");
+static EVCNT_DEFINE(fault_onfault, "vm", "fault copyin/out");
+
 static_assert(PAGE_TABLE_DEPTH, "Page table depth defined to 0!");
 
 static POOL_DEFINE(P_PMAP, "pmap", sizeof(pmap_t));
@@ -117,6 +123,7 @@ static void free_asid(asid_t asid) {
   SCOPED_MTX_LOCK(&asid_lock);
   bit_clear(asid_used, (unsigned)asid);
   tlb_invalidate_asid(asid);
+  evcnt_inc(&tlb_inval_asid);
 }
 
 /*
@@ -130,6 +137,7 @@ static void pv_add(pmap_t *pmap, vaddr_t va, vm_page_t *pg) {
   pv->va = va;
   TAILQ_INSERT_TAIL(&pg->pv_list, pv, page_link);
   TAILQ_INSERT_TAIL(&pmap->pv_list, pv, pmap_link);
+  pmap->resident++;
 }
 
 static pv_entry_t *pv_find(pmap_t *pmap, vaddr_t va, vm_page_t *pg) {
@@ -148,6 +156,7 @@ static void pv_remove(pmap_t *pmap, vaddr_t va, vm_page_t *pg) {
   assert(pv != NULL);
   TAILQ_REMOVE(&pg->pv_list, pv, page_link);
   TAILQ_REMOVE(&pmap->pv_list, pv, pmap_link);
+  pmap->resident--;
   pool_free(P_PV, pv);
 }
 
@@ -181,6 +190,7 @@ static pte_t *pmap_lookup_pte(pmap_t *pmap, vaddr_t va) {
 static void pmap_write_pte(pmap_t *pmap, pte_t *ptep, pte_t pte, vaddr_t va) {
   *ptep = pte;
   tlb_invalidate(va, pmap->asid);
+  evcnt_inc(&tlb_inval_page);
 }
 
 /* Return PTE pointer for `va`. Allocate page table if needed. */
@@ -314,6 +324,11 @@ bool pmap_extract(pmap_t *pmap, vaddr_t va, paddr_t *pap) {
   return pmap_extract_nolock(pmap, va, pap);
 }
 
+size_t pmap_resident_count(pmap_t *pmap) {
+  SCOPED_MTX_LOCK(&pmap->mtx);
+  return pmap->resident;
+}
+
 void pmap_protect(pmap_t *pmap, vaddr_t start, vaddr_t end, vm_prot_t prot) {
   assert(pmap != pmap_kernel());
   assert(page_aligned_p(start) && page_aligned_p(end));
@@ -344,6 +359,7 @@ void pmap_page_remove(vm_page_t *pg) {
     WITH_MTX_LOCK (&pmap->mtx) {
       TAILQ_REMOVE(&pg->pv_list, pv, page_link);
       TAILQ_REMOVE(&pmap->pv_list, pv, pmap_link);
+      pmap->resident--;
       pte_t *ptep = pmap_lookup_pte(pmap, va);
       assert(ptep);
       pmap_write_pte(pmap, ptep, PTE_EMPTY_USER, va);
@@ -454,8 +470,11 @@ int pmap_fault_handler(ctx_t *ctx, vaddr_t vaddr, vm_prot_t access) {
   pmap_t *pmap = pmap_user();
   assert(pmap);
 
-  if (!(error = pmap_emulate_bits(pmap, vaddr, access)))
+  /* Referenced & modified bits are emulated by the first access. */
+  if (!(error = pmap_emulate_bits(pmap, vaddr, access))) {
+    evcnt_inc(&fault_refmod);
     return 0;
+  }
 
   if (error == EACCES)
     goto fault;
@@ -468,6 +487,7 @@ int pmap_fault_handler(ctx_t *ctx, vaddr_t vaddr, vm_prot_t access) {
 fault:
   if (td->td_onfault) {
     /* Handle copyin/copyout faults. */
+    evcnt_inc(&fault_onfault);
     ctx_set_pc(ctx, td->td_onfault);
     td->td_onfault = 0;
     return 0;
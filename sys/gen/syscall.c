@@ -1,11 +1,26 @@
 #define KL_LOG KL_SYSCALL
 #include <sys/klog.h>
 #include <sys/errno.h>
+#include <sys/evcnt.h>
 #include <sys/thread.h>
 #include <sys/proc.h>
+#include <sys/sdt.h>
 #include <sys/sysent.h>
 #include <machine/syscall.h>
 
+SDT_PROBE_DEFINE(syscall, entry, "code, arg0, arg1, arg2, arg3");
+SDT_PROBE_DEFINE(syscall, return, "code, error, retval");
+
+static evcnt_t syscall_evcnt[SYS_MAXSYSCALL + 1];
+
+static void syscall_evcnt_attach(void) {
+  for (int i = 0; i <= SYS_MAXSYSCALL; i++)
+    if (sysent[i].name)
+      evcnt_attach(&syscall_evcnt[i], "syscall", sysent[i].name);
+}
+
+EVCNT_ATTACH_INIT(syscall_evcnt_attach);
+
 void syscall_handler(int code, ctx_t *ctx, syscall_result_t *result) {
   register_t args[SYS_MAXSYSARGS];
   const size_t nregs = min(SYS_MAXSYSARGS, FUNC_MAXREGARGS);
@@ -23,6 +38,7 @@ void syscall_handler(int code, ctx_t *ctx, syscall_result_t *result) {
   }
 
   sysent_t *se = &sysent[code];
+  evcnt_inc(&syscall_evcnt[code]);
 
 #if SYS_MAXSYSARGS > FUNC_MAXREGARGS
   size_t nargs = se->nargs;
@@ -39,9 +55,13 @@ void syscall_handler(int code, ctx_t *ctx, syscall_result_t *result) {
 
   assert(td->td_proc != NULL);
 
+  SDT_PROBE(syscall, entry, code, args[0], args[1], args[2], args[3]);
+
   if (!error)
     error = se->call(td->td_proc, (void *)args, &retval);
 
+  SDT_PROBE(syscall, return, code, error, retval);
+
   if (error && error < EJUSTRETURN)
     klog("%s(...) = %d", se->name, error);
 
@@ -0,0 +1,310 @@
+#define KL_LOG KL_DEV
+#include <sys/bio.h>
+#include <sys/errno.h>
+#include <sys/klog.h>
+#include <sys/libkern.h>
+#include <sys/malloc.h>
+#include <sys/mimiker.h>
+#include <sys/sched.h>
+#include <sys/thread.h>
+#include <sys/uio.h>
+
+static KMALLOC_DEFINE(M_BIO, "block I/O requests & buffers");
+
+/* Largest chunk of data copied to a temporary buffer by `bioq_uio`. */
+#define BIO_UIO_MAX (4 * BIO_MAXIO)
+
+/* Number of requests `bioq_rw` keeps on stack, enough for `bioq_uio`. */
+#define BIO_RW_NBIOS (BIO_UIO_MAX / BIO_MAXIO)
+
+static size_t bio_nblks(bio_queue_t *bq, bio_t *bp) {
+  return bp->bio_bcount / bq->bq_blksize;
+}
+
+static bool bio_adjacent(bio_queue_t *bq, bio_t *prev, bio_t *next) {
+  return prev->bio_cmd == next->bio_cmd &&
+         prev->bio_blkno + bio_nblks(bq, prev) == next->bio_blkno;
+}
+
+/* Moves the request at the elevator position and requests adjacent to it
+ * to `batch`. Returns the number of blocks to transfer. */
+static size_t bioq_take(bio_queue_t *bq, bio_list_t *batch) {
+  assert(mtx_owned(&bq->bq_lock));
+
+  bio_t *bp;
+  TAILQ_FOREACH (bp, &bq->bq_queue, bio_link)
+    if (bp->bio_blkno >= bq->bq_nextblk)
+      break;
+  /* Nothing past the elevator position, so start over from the beginning. */
+  if (bp == NULL)
+    bp = TAILQ_FIRST(&bq->bq_queue);
+
+  size_t nblks = 0;
+  bio_t *prev = NULL;
+
+  while (bp != NULL) {
+    if (prev && !(bio_adjacent(bq, prev, bp) &&
+                  (nblks + bio_nblks(bq, bp)) * bq->bq_blksize <= BIO_MAXIO))
+      break;
+    if (prev)
+      bq->bq_nmerged++;
+    bio_t *next = TAILQ_NEXT(bp, bio_link);
+    TAILQ_REMOVE(&bq->bq_queue, bp, bio_link);
+    TAILQ_INSERT_TAIL(batch, bp, bio_link);
+    nblks += bio_nblks(bq, bp);
+    prev = bp;
+    bp = next;
+  }
+
+  bq->bq_nextblk = prev->bio_blkno + bio_nblks(bq, prev);
+  bq->bq_ntransfers++;
+  return nblks;
+}
+
+static void biodone(bio_queue_t *bq, bio_t *bp) {
+  /* The callback takes over the request, so it mustn't be touched later. */
+  if (bp->bio_done) {
+    bp->bio_done(bp);
+    return;
+  }
+
+  SCOPED_MTX_LOCK(&bq->bq_lock);
+  bp->bio_flags |= BIO_DONE;
+  cv_broadcast(&bq->bq_done);
+}
+
+/* Performs a single transfer for all requests from `batch`. If more than one
+ * request is involved, their data is gathered in a temporary buffer. */
+static void bioq_dispatch(bio_queue_t *bq, bio_list_t *batch, size_t nblks) {
+  bio_t *first = TAILQ_FIRST(batch);
+  bio_t *bp;
+  void *data = first->bio_data;
+  bool merged = TAILQ_NEXT(first, bio_link) != NULL;
+  int error;
+
+  if (merged) {
+    data = kmalloc(M_BIO, nblks * bq->bq_blksize, M_WAITOK);
+    if (first->bio_cmd == BIO_WRITE) {
+      void *ptr = data;
+      TAILQ_FOREACH (bp, batch, bio_link) {
+        memcpy(ptr, bp->bio_data, bp->bio_bcount);
+        ptr += bp->bio_bcount;
+      }
+    }
+  }
+
+  error =
+    bq->bq_transfer(bq->bq_arg, first->bio_cmd, first->bio_blkno, data, nblks);
+
+  if (merged) {
+    if (first->bio_cmd == BIO_READ && !error) {
+      void *ptr = data;
+      TAILQ_FOREACH (bp, batch, bio_link) {
+        memcpy(bp->bio_data, ptr, bp->bio_bcount);
+        ptr += bp->bio_bcount;
+      }
+    }
+    kfree(M_BIO, data);
+  }
+
+  while ((bp = TAILQ_FIRST(batch))) {
+    TAILQ_REMOVE(batch, bp, bio_link);
+    bp->bio_error = error;
+    biodone(bq, bp);
+  }
+}
+
+static void bioq_worker(void *arg) {
+  bio_queue_t *bq = arg;
+
+  while (true) {
+    bio_list_t batch = TAILQ_HEAD_INITIALIZER(batch);
+    size_t nblks;
+
+    WITH_MTX_LOCK (&bq->bq_lock) {
+      while ((TAILQ_EMPTY(&bq->bq_queue) && !bq->bq_dying) || bq->bq_plugged)
+        cv_wait(&bq->bq_nonempty, &bq->bq_lock);
+      nblks = TAILQ_EMPTY(&bq->bq_queue) ? 0 : bioq_take(bq, &batch);
+    }
+
+    if (nblks == 0)
+      thread_exit();
+
+    bioq_dispatch(bq, &batch, nblks);
+  }
+}
+
+void bioq_init(bio_queue_t *bq, const char *name, size_t blksize,
+               uint64_t nblks, bio_transfer_t transfer, void *arg) {
+  assert(blksize > 0 && blksize <= BIO_MAXIO);
+
+  mtx_init(&bq->bq_lock, 0);
+  mtx_init(&bq->bq_write_lock, 0);
+  TAILQ_INIT(&bq->bq_queue);
+  cv_init(&bq->bq_nonempty, "bio queue nonempty");
+  cv_init(&bq->bq_done, "bio done");
+  bq->bq_nextblk = 0;
+  bq->bq_plugged = 0;
+  bq->bq_dying = false;
+  bq->bq_blksize = blksize;
+  bq->bq_nblks = nblks;
+  bq->bq_transfer = transfer;
+  bq->bq_arg = arg;
+  bq->bq_ntransfers = 0;
+  bq->bq_nmerged = 0;
+  bq->bq_thread = thread_create(name, bioq_worker, bq, prio_kthread(0));
+  sched_add(bq->bq_thread);
+}
+
+void bioq_destroy(bio_queue_t *bq) {
+  WITH_MTX_LOCK (&bq->bq_lock) {
+    assert(bq->bq_plugged == 0);
+    bq->bq_dying = true;
+    cv_signal(&bq->bq_nonempty);
+  }
+  thread_join(bq->bq_thread);
+  cv_destroy(&bq->bq_nonempty);
+  cv_destroy(&bq->bq_done);
+  mtx_destroy(&bq->bq_write_lock);
+  mtx_destroy(&bq->bq_lock);
+}
+
+void bioq_plug(bio_queue_t *bq) {
+  SCOPED_MTX_LOCK(&bq->bq_lock);
+  bq->bq_plugged++;
+}
+
+void bioq_unplug(bio_queue_t *bq) {
+  SCOPED_MTX_LOCK(&bq->bq_lock);
+  assert(bq->bq_plugged > 0);
+  if (--bq->bq_plugged == 0 && !TAILQ_EMPTY(&bq->bq_queue))
+    cv_signal(&bq->bq_nonempty);
+}
+
+void bio_submit(bio_queue_t *bq, bio_t *bp) {
+  assert(bp->bio_bcount > 0);
+  assert(bp->bio_bcount % bq->bq_blksize == 0);
+  assert(bp->bio_blkno + bio_nblks(bq, bp) <= bq->bq_nblks);
+
+  SCOPED_MTX_LOCK(&bq->bq_lock);
+
+  bp->bio_flags = 0;
+  bp->bio_error = 0;
+
+  /* Insertion sort keeps requests ordered by block number. Among requests for
+   * the same block, the order of submission is preserved. */
+  bio_t *it;
+  TAILQ_FOREACH (it, &bq->bq_queue, bio_link)
+    if (it->bio_blkno > bp->bio_blkno)
+      break;
+  if (it)
+    TAILQ_INSERT_BEFORE(it, bp, bio_link);
+  else
+    TAILQ_INSERT_TAIL(&bq->bq_queue, bp, bio_link);
+
+  if (!bq->bq_plugged)
+    cv_signal(&bq->bq_nonempty);
+}
+
+int bio_wait(bio_queue_t *bq, bio_t *bp) {
+  assert(bp->bio_done == NULL);
+
+  SCOPED_MTX_LOCK(&bq->bq_lock);
+  while (!(bp->bio_flags & BIO_DONE))
+    cv_wait(&bq->bq_done, &bq->bq_lock);
+  return bp->bio_error;
+}
+
+int bioq_rw(bio_queue_t *bq, bio_cmd_t cmd, uint64_t blkno, void *data,
+            size_t nblks) {
+  size_t maxblks = BIO_MAXIO / bq->bq_blksize;
+  size_t nbios = howmany(nblks, maxblks);
+  bio_t stack_bios[BIO_RW_NBIOS];
+  bio_t *bios = stack_bios;
+  int error = 0;
+
+  if (nbios > BIO_RW_NBIOS)
+    bios = kmalloc(M_BIO, nbios * sizeof(bio_t), M_WAITOK | M_ZERO);
+  else
+    bzero(bios, nbios * sizeof(bio_t));
+
+  bioq_plug(bq);
+  for (size_t i = 0; i < nbios; i++) {
+    size_t n = min(nblks - i * maxblks, maxblks);
+    bios[i].bio_cmd = cmd;
+    bios[i].bio_blkno = blkno + i * maxblks;
+    bios[i].bio_bcount = n * bq->bq_blksize;
+    bios[i].bio_data = data + i * maxblks * bq->bq_blksize;
+    bio_submit(bq, &bios[i]);
+  }
+  bioq_unplug(bq);
+
+  for (size_t i = 0; i < nbios; i++) {
+    int err = bio_wait(bq, &bios[i]);
+    if (!error)
+      error = err;
+  }
+
+  if (bios != stack_bios)
+    kfree(M_BIO, bios);
+  return error;
+}
+
+int bioq_uio(bio_queue_t *bq, uio_t *uio) {
+  size_t bsize = bq->bq_blksize;
+  off_t end = bq->bq_nblks * bsize;
+  int error = 0;
+
+  if (uio->uio_offset < 0)
+    return EINVAL;
+  if (uio->uio_offset >= end)
+    return (uio->uio_op == UIO_READ) ? 0 : EINVAL;
+
+  if (uio->uio_resid == 0)
+    return 0;
+
+  /* Don't allocate more than it takes to serve the whole request. */
+  size_t bufsize = min(uio->uio_resid, (size_t)(end - uio->uio_offset));
+  bufsize = roundup(uio->uio_offset % bsize + bufsize, bsize);
+  bufsize = min(bufsize, (size_t)BIO_UIO_MAX);
+  void *buf = kmalloc(M_BIO, bufsize, M_WAITOK);
+
+  /* Partially written blocks are read, modified and written back in separate
+   * requests. Writers are serialized, so they can't overwrite each other's
+   * changes to a block with stale data. */
+  if (uio->uio_op == UIO_WRITE)
+    mtx_lock(&bq->bq_write_lock);
+
+  while (uio->uio_resid > 0 && uio->uio_offset < end) {
+    uint64_t first = uio->uio_offset / bsize;
+    size_t skip = uio->uio_offset % bsize;
+    size_t len = min(uio->uio_resid, (size_t)(end - uio->uio_offset));
+    len = min(len, bufsize - skip);
+    size_t nblks = howmany(skip + len, bsize);
+
+    if (uio->uio_op == UIO_READ) {
+      if ((error = bioq_rw(bq, BIO_READ, first, buf, nblks)))
+        break;
+      if ((error = uiomove(buf + skip, len, uio)))
+        break;
+    } else {
+      /* Blocks written partially must be read first. */
+      if (skip && (error = bioq_rw(bq, BIO_READ, first, buf, 1)))
+        break;
+      if ((skip + len) % bsize && (nblks > 1 || !skip) &&
+          (error = bioq_rw(bq, BIO_READ, first + nblks - 1,
+                           buf + (nblks - 1) * bsize, 1)))
+        break;
+      if ((error = uiomove(buf + skip, len, uio)))
+        break;
+      if ((error = bioq_rw(bq, BIO_WRITE, first, buf, nblks)))
+        break;
+    }
+  }
+
+  if (uio->uio_op == UIO_WRITE)
+    mtx_unlock(&bq->bq_write_lock);
+
+  kfree(M_BIO, buf);
+  return error;
+}
@@ -8,11 +8,26 @@
 #include <sys/thread.h>
 #include <sys/sched.h>
 #include <sys/interrupt.h>
+#include <sys/pcpu.h>
 #include <sys/time.h>
 
-/* Note: If the difference in time between ticks is greater than the number of
-   buckets, some callouts may be called out-of-order! */
-#define CALLOUT_BUCKETS 64
+/*
+ * Pending callouts are kept in a hierarchical timing wheel. Each level is
+ * a cyclic array of WHEEL_SIZE slots, where a slot at level `l` spans
+ * WHEEL_SIZE^l ticks. A callout is put on the lowest level that covers its
+ * distance from the current time. When lower levels wrap around, the callouts
+ * from the next slot of the level above are redistributed (cascaded) to lower
+ * levels. Thus inserting, removing and expiring a callout takes constant time
+ * and so does a tick, regardless of the number of pending callouts.
+ *
+ * WHEEL_LEVELS are chosen so that the wheel covers the whole range of
+ * systime_t. Non-empty slots are marked in a bitmap for each level, which lets
+ * us skip over ticks without expiring callouts and quickly find the next one.
+ */
+#define WHEEL_BITS 5
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 7
 
 #define callout_is_active(c) ((c)->c_flags & CALLOUT_ACTIVE)
 #define callout_set_active(c) ((c)->c_flags |= CALLOUT_ACTIVE)
@@ -26,40 +41,97 @@
 #define callout_set_stopped(c) ((c)->c_flags |= CALLOUT_STOPPED)
 #define callout_clear_stopped(c) ((c)->c_flags &= ~CALLOUT_STOPPED)
 
-/*
-  Every event is inside one of CALLOUT_BUCKETS buckets.
-  The buckets is a cyclic list, but we implement it as an array,
-  allowing us to access random elements in constant time.
-*/
+#define callout_is_direct(c) ((c)->c_flags & CALLOUT_DIRECT)
 
 typedef TAILQ_HEAD(callout_list, callout) callout_list_t;
 
-static struct {
-  callout_list_t heads[CALLOUT_BUCKETS];
-  /* Stores the value of the argument callout_process was previously
-     called with. All callouts up to this timestamp have already been
-     processed. */
-  systime_t last;
+/* Each processor has its own wheel and callout thread. */
+typedef struct callout_wheel {
   mtx_t lock;
-} ci;
+  /* All callouts up to this tick (exclusive) have already been processed. */
+  systime_t next;
+  uint32_t nonempty[WHEEL_LEVELS]; /* bitmaps of non-empty slots */
+  callout_list_t slots[WHEEL_LEVELS * WHEEL_SIZE];
+  callout_list_t delegated; /* callouts to be run by callout thread */
+} callout_wheel_t;
+
+static callout_wheel_t wheels[MAXCPU];
+
+static inline unsigned wheel_slot(systime_t tm, unsigned level) {
+  return (tm >> (level * WHEEL_BITS)) & WHEEL_MASK;
+}
+
+static void wheel_insert(callout_wheel_t *cw, callout_t *co) {
+  /* Callouts that are already due are run on the next processed tick. */
+  systime_t tm = max(co->c_time, cw->next);
+  uint64_t delta = tm - cw->next;
+  unsigned level = 0;
+
+  while (level < WHEEL_LEVELS - 1 &&
+         delta >= (1ULL << ((level + 1) * WHEEL_BITS)))
+    level++;
+
+  unsigned slot = wheel_slot(tm, level);
+  co->c_index = level * WHEEL_SIZE + slot;
+  cw->nonempty[level] |= 1U << slot;
+  TAILQ_INSERT_TAIL(&cw->slots[co->c_index], co, c_link);
+}
+
+static void wheel_remove(callout_wheel_t *cw, callout_t *co) {
+  unsigned level = co->c_index / WHEEL_SIZE, slot = co->c_index % WHEEL_SIZE;
+  callout_list_t *head = &cw->slots[co->c_index];
+  TAILQ_REMOVE(head, co, c_link);
+  if (TAILQ_EMPTY(head))
+    cw->nonempty[level] &= ~(1U << slot);
+}
+
+/* Redistributes callouts from slots of upper levels that begin at `tm`. */
+static void wheel_cascade(callout_wheel_t *cw, systime_t tm) {
+  for (unsigned level = 1; level < WHEEL_LEVELS; level++) {
+    unsigned slot = wheel_slot(tm, level);
+    callout_list_t *head = &cw->slots[level * WHEEL_SIZE + slot];
+    callout_list_t cascaded;
+
+    TAILQ_INIT(&cascaded);
+    TAILQ_CONCAT(&cascaded, head, c_link);
+    cw->nonempty[level] &= ~(1U << slot);
+
+    callout_t *co;
+    while ((co = TAILQ_FIRST(&cascaded))) {
+      TAILQ_REMOVE(&cascaded, co, c_link);
+      wheel_insert(cw, co);
+    }
 
-static inline callout_list_t *ci_list(int i) {
-  return &ci.heads[i];
+    /* Upper levels are due only if this level has wrapped around as well. */
+    if (slot != 0)
+      break;
+  }
 }
 
-static callout_list_t delegated;
+/* Returns the first tick since `cw->next` when some slot needs attention:
+ * either a callout in level 0 expires or lower levels wrap around. */
+static systime_t wheel_skip(callout_wheel_t *cw) {
+  unsigned slot = wheel_slot(cw->next, 0);
+  uint32_t pending = cw->nonempty[0] >> slot;
+
+  if (pending)
+    return cw->next + ctz(pending);
+  return cw->next + (WHEEL_SIZE - slot);
+}
 
 static void callout_thread(void *arg) {
+  callout_wheel_t *cw = arg;
+
   while (true) {
     callout_t *elem;
 
     WITH_INTR_DISABLED {
-      while (TAILQ_EMPTY(&delegated)) {
-        sleepq_wait(&delegated, NULL, NULL);
+      while (TAILQ_EMPTY(&cw->delegated)) {
+        sleepq_wait(&cw->delegated, NULL, NULL);
       }
 
-      elem = TAILQ_FIRST(&delegated);
-      TAILQ_REMOVE(&delegated, elem, c_link);
+      elem = TAILQ_FIRST(&cw->delegated);
+      TAILQ_REMOVE(&cw->delegated, elem, c_link);
     }
 
     assert(callout_is_active(elem));
@@ -68,7 +140,7 @@ static void callout_thread(void *arg) {
     /* Execute callout's function. */
     elem->c_func(elem->c_arg);
 
-    WITH_MTX_LOCK (&ci.lock) {
+    WITH_MTX_LOCK (&cw->lock) {
       callout_clear_active(elem);
       /* Only notify waiters if the callout isn't already pending
        * due to a reschedule. */
@@ -79,18 +151,22 @@ static void callout_thread(void *arg) {
 }
 
 void init_callout(void) {
-  bzero(&ci, sizeof(ci));
+  for (int cpu = 0; cpu < MAXCPU; cpu++) {
+    callout_wheel_t *cw = &wheels[cpu];
+    char name[TD_NAME_MAX];
 
-  mtx_init(&ci.lock, MTX_SPIN);
+    bzero(cw, sizeof(callout_wheel_t));
+    mtx_init(&cw->lock, MTX_SPIN);
 
-  for (int i = 0; i < CALLOUT_BUCKETS; i++)
-    TAILQ_INIT(ci_list(i));
+    for (int i = 0; i < WHEEL_LEVELS * WHEEL_SIZE; i++)
+      TAILQ_INIT(&cw->slots[i]);
 
-  TAILQ_INIT(&delegated);
+    TAILQ_INIT(&cw->delegated);
 
-  thread_t *td =
-    thread_create("callout", callout_thread, NULL, prio_kthread(0));
-  sched_add(td);
+    snprintf(name, sizeof(name), "callout-%d", cpu);
+    thread_t *td = thread_create(name, callout_thread, cw, prio_kthread(0));
+    sched_add(td);
+  }
 }
 
 void callout_setup(callout_t *co, timeout_t fn, void *arg) {
@@ -99,48 +175,69 @@ void callout_setup(callout_t *co, timeout_t fn, void *arg) {
   co->c_arg = arg;
 }
 
-static void _callout_schedule(callout_t *co, systime_t tm) {
-  assert(mtx_owned(&ci.lock));
+void callout_setup_direct(callout_t *co, timeout_t fn, void *arg) {
+  callout_setup(co, fn, arg);
+  co->c_flags |= CALLOUT_DIRECT;
+}
+
+static void _callout_schedule(callout_wheel_t *cw, callout_t *co,
+                              systime_t tm) {
+  assert(mtx_owned(&cw->lock));
   assert(!callout_is_pending(co));
 
   callout_set_pending(co);
 
-  int idx = tm % CALLOUT_BUCKETS;
-
   co->c_time = tm;
-  co->c_index = idx;
 
   klog("Add callout {%p} with wakeup at %ld.", co, tm);
-  TAILQ_INSERT_TAIL(ci_list(idx), co, c_link);
+  wheel_insert(cw, co);
+
+  /* In tickless mode the clock may be programmed to fire too late. */
+  clock_notify(tm);
+}
+
+/* Callouts are scheduled on the current processor, unless they're running.
+ * Then they stay on processor they have been running on, so that they don't
+ * run concurrently with themselves. */
+static callout_wheel_t *callout_wheel(callout_t *co) {
+  if (!callout_is_active(co))
+    co->c_cpu = curcpu;
+  return &wheels[co->c_cpu];
 }
 
 void callout_schedule_abs(callout_t *co, systime_t tm) {
-  SCOPED_MTX_LOCK(&ci.lock);
+  SCOPED_NO_PREEMPTION();
+  callout_wheel_t *cw = callout_wheel(co);
+  SCOPED_MTX_LOCK(&cw->lock);
   assert(!callout_is_active(co));
   callout_clear_stopped(co);
 
-  _callout_schedule(co, tm);
+  _callout_schedule(cw, co, tm);
 }
 
 void callout_schedule(callout_t *co, systime_t tm) {
-  SCOPED_MTX_LOCK(&ci.lock);
+  SCOPED_NO_PREEMPTION();
+  callout_wheel_t *cw = callout_wheel(co);
+  SCOPED_MTX_LOCK(&cw->lock);
   assert(!callout_is_active(co));
   callout_clear_stopped(co);
 
-  _callout_schedule(co, getsystime() + tm);
+  _callout_schedule(cw, co, getsystime() + tm);
 }
 
 bool callout_reschedule(callout_t *c, systime_t tm) {
-  SCOPED_MTX_LOCK(&ci.lock);
+  callout_wheel_t *cw = &wheels[c->c_cpu];
+  SCOPED_MTX_LOCK(&cw->lock);
   assert(callout_is_active(c));
   if (callout_is_stopped(c))
     return false;
-  _callout_schedule(c, tm);
+  _callout_schedule(cw, c, tm);
   return true;
 }
 
 bool callout_stop(callout_t *handle) {
-  SCOPED_MTX_LOCK(&ci.lock);
+  callout_wheel_t *cw = &wheels[handle->c_cpu];
+  SCOPED_MTX_LOCK(&cw->lock);
 
   klog("Remove callout {%p} at %ld.", handle, handle->c_time);
 
@@ -148,7 +245,7 @@ bool callout_stop(callout_t *handle) {
 
   if (callout_is_pending(handle)) {
     callout_clear_pending(handle);
-    TAILQ_REMOVE(ci_list(handle->c_index), handle, c_link);
+    wheel_remove(cw, handle);
     /* A callout may be observed to be both active and pending if it rescheduled
      * itself but hasn't finished executing yet.
      * If that's the case, we must make the caller wait for its completion in
@@ -158,52 +255,112 @@ bool callout_stop(callout_t *handle) {
   return !callout_is_active(handle);
 }
 
+bool callout_run(callout_t *co) {
+  SCOPED_NO_PREEMPTION();
+  callout_wheel_t *cw = callout_wheel(co);
+  SCOPED_MTX_LOCK(&cw->lock);
+
+  if (callout_is_pending(co) || callout_is_active(co))
+    return false;
+
+  callout_clear_stopped(co);
+  callout_set_active(co);
+  TAILQ_INSERT_TAIL(&cw->delegated, co, c_link);
+  sleepq_signal(&cw->delegated);
+  return true;
+}
+
+/* Runs a callout marked with CALLOUT_DIRECT in interrupt context. */
+static void callout_direct(callout_wheel_t *cw, callout_t *co) {
+  assert(mtx_owned(&cw->lock));
+
+  /* The lock is released, so that the function can reschedule or stop
+   * the callout. */
+  mtx_unlock(&cw->lock);
+  co->c_func(co->c_arg);
+  mtx_lock(&cw->lock);
+
+  callout_clear_active(co);
+  if (!callout_is_pending(co))
+    sleepq_broadcast(co);
+}
+
 /*
- * Process all timeouted callouts from queues between last position and
- * current position and delegate them to callout thread.
+ * Process all timeouted callouts from slots between last position and
+ * current position and delegate them to callout thread, unless they're to be
+ * executed directly.
  */
 void callout_process(systime_t time) {
-  unsigned int last_bucket;
-  unsigned int current_bucket = ci.last % CALLOUT_BUCKETS;
-
-  if (time - ci.last > CALLOUT_BUCKETS) {
-    /* Process all buckets */
-    last_bucket = (ci.last - 1) % CALLOUT_BUCKETS;
-  } else {
-    /* Process only buckets in time range ci.last to time */
-    last_bucket = time % CALLOUT_BUCKETS;
-  }
+  callout_wheel_t *cw = &wheels[curcpu];
 
   /* We are in kernel's bottom half. */
   assert(intr_disabled());
 
-  while (true) {
-    callout_list_t *head = ci_list(current_bucket);
-    callout_t *elem, *next;
-
-    /* Detach triggered callouts from ci_list queue. */
-    TAILQ_FOREACH_SAFE (elem, head, c_link, next) {
-      if (elem->c_time <= time) {
-        callout_set_active(elem);
-        callout_clear_pending(elem);
-        TAILQ_REMOVE(head, elem, c_link);
+  SCOPED_MTX_LOCK(&cw->lock);
+
+  while (cw->next <= time) {
+    systime_t tick = cw->next;
+
+    if (wheel_slot(tick, 0) == 0)
+      wheel_cascade(cw, tick);
+
+    /* Callouts scheduled by direct callouts for the current tick or earlier
+     * will be run on the next tick. */
+    cw->next = tick + 1;
+
+    callout_list_t *head = &cw->slots[wheel_slot(tick, 0)];
+    callout_t *elem;
+
+    /* Detach triggered callouts from the slot. */
+    while ((elem = TAILQ_FIRST(head))) {
+      assert(elem->c_time <= tick);
+      callout_set_active(elem);
+      callout_clear_pending(elem);
+      wheel_remove(cw, elem);
+      if (callout_is_direct(elem)) {
+        callout_direct(cw, elem);
+      } else {
         /* Attach elem to callout thread's queue. */
-        TAILQ_INSERT_TAIL(&delegated, elem, c_link);
+        TAILQ_INSERT_TAIL(&cw->delegated, elem, c_link);
       }
     }
 
-    if (current_bucket == last_bucket)
-      break;
-
-    current_bucket = (current_bucket + 1) % CALLOUT_BUCKETS;
+    cw->next = min(wheel_skip(cw), time + 1);
   }
 
-  ci.last = time;
-
   /* Wake callout thread. */
-  if (!TAILQ_EMPTY(&delegated)) {
-    sleepq_signal(&delegated);
+  if (!TAILQ_EMPTY(&cw->delegated)) {
+    sleepq_signal(&cw->delegated);
+  }
+}
+
+systime_t callout_next(systime_t limit) {
+  callout_wheel_t *cw = &wheels[curcpu];
+  SCOPED_MTX_LOCK(&cw->lock);
+
+  systime_t next = limit;
+
+  /* For upper levels this yields the time when the first non-empty slot gets
+   * cascaded, which is no later than the earliest callout in it. */
+  for (unsigned level = 0; level < WHEEL_LEVELS; level++) {
+    uint32_t nonempty = cw->nonempty[level];
+    if (nonempty == 0)
+      continue;
+
+    unsigned shift = level * WHEEL_BITS;
+    /* First tick at or after `cw->next` that begins a slot at this level. */
+    uint64_t base = ((uint64_t)cw->next + (1ULL << shift) - 1) >> shift;
+    unsigned first = base & WHEEL_MASK;
+    uint32_t rotated =
+      first ? (nonempty >> first) | (nonempty << (WHEEL_SIZE - first))
+            : nonempty;
+    uint64_t when = (base + ctz(rotated)) << shift;
+
+    if (when < next)
+      next = when;
   }
+
+  return next;
 }
 
 bool callout_drain(callout_t *handle) {
@@ -1,30 +1,125 @@
 #define KL_LOG KL_TIME
 #include <sys/callout.h>
+#include <sys/hrtimer.h>
 #include <sys/sched.h>
 #include <sys/mimiker.h>
 #include <sys/klog.h>
+#include <sys/kenv.h>
+#include <sys/libkern.h>
+#include <sys/interrupt.h>
 #include <sys/timer.h>
 #include <sys/kgprof.h>
 
+/* Longest time [ticks] the clock may not fire in tickless mode. */
+#define CLK_MAXIDLE CLK_TCK
+
 static systime_t now = 0;
 static timer_t *clock = NULL;
 static timer_t *profclock = NULL;
 
+/*
+ * In tickless mode the clock is a one-shot timer programmed to fire at the
+ * earliest of the next callout deadline, the end of the running thread's
+ * slice and expiration of the first hrtimer. The idle thread has no slice,
+ * so an idle CPU wakes up only when there's work to be done.
+ */
+static bool tickless = false;
+static bintime_t deadline; /* when the clock is going to fire next */
+static systime_t maxidle;  /* limited by the longest delay the timer handles */
+
 systime_t getsystime(void) {
+  /* Without periodic tick `now` is updated only when the clock fires. */
+  if (tickless) {
+    bintime_t bin = binuptime();
+    return bt2st(&bin);
+  }
   return now;
 }
 
+/* Returns the moment `when` tick begins, but no earlier than the next tick
+ * and no later than `maxidle` ticks from now. */
+static bintime_t tick_time(systime_t when) {
+  systime_t cur = getsystime();
+  when = min(max(when, cur + 1), cur + maxidle);
+
+  /* Timer frequency doesn't have to be a multiple of CLK_TCK, so aim slightly
+   * past the beginning of the tick to make sure it has already started once
+   * the timer fires. */
+  bintime_t bt = bintime_mul(HZ2BT(CLK_TCK), when);
+  bintime_t margin = HZ2BT(1000000);
+  bintime_add(&bt, &margin);
+  return bt;
+}
+
+/* Programs the clock to fire at `when` or right away if it has passed. */
+static void clock_arm(bintime_t when) {
+  assert(intr_disabled());
+
+  deadline = when;
+
+  /* Conversion to timer ticks rounds down, so add one timer tick to make sure
+   * the clock doesn't fire before `when`. */
+  bintime_add(&when, &clock->tm_min_period);
+
+  bintime_t start = BINTIME(0);
+  bintime_t bin = binuptime();
+  if (bintime_cmp(&when, &bin, >)) {
+    start = when;
+    bintime_sub(&start, &bin);
+  }
+
+  if (tm_start(clock, TMF_ONESHOT, start, BINTIME(0)))
+    panic("Failed to program system clock!");
+}
+
+void clock_notify_bintime(bintime_t when) {
+  if (!tickless)
+    return;
+
+  SCOPED_INTR_DISABLED();
+  if (bintime_cmp(&when, &deadline, <))
+    clock_arm(when);
+}
+
+void clock_notify(systime_t when) {
+  if (tickless)
+    clock_notify_bintime(tick_time(when));
+}
+
 static void prof_clock(timer_t *tm, void *arg) {
   kgprof_tick();
 }
 
 static void clock_cb(timer_t *tm, void *arg) {
-  bintime_t bin = binuptime();
+  tm_windup();
+  bintime_t bin = getbinuptime();
   now = bt2st(&bin);
   if (profclock == NULL)
     prof_clock(tm, arg);
+  hrtimer_process(bin);
   callout_process(now);
   sched_clock();
+
+  if (tickless) {
+    systime_t next = min(callout_next(now + maxidle), sched_slice_end());
+    bintime_t when = tick_time(next);
+    bintime_t hrnext;
+    if (hrtimer_next(&hrnext) && bintime_cmp(&hrnext, &when, <))
+      when = hrnext;
+    clock_arm(when);
+  }
+}
+
+static bool tickless_enabled(void) {
+  /* Profiling relies on the clock ticking at regular intervals. */
+  if (KGPROF && profclock == NULL)
+    return false;
+  if (!(clock->tm_flags & TMF_ONESHOT))
+    return false;
+  /* Tickless mode can be turned off with "tickless=0" on kernel command
+   * line. */
+  const char *s = kenv_get("tickless");
+  return s == NULL || strcmp(s, "0");
 }
 
 void init_clock(void) {
@@ -35,10 +130,20 @@ void init_clock(void) {
 
   set_kgprof_profrate(CLK_TCK);
   tm_init(clock, clock_cb, NULL);
-  if (tm_start(clock, TMF_PERIODIC | TMF_TIMESOURCE, (bintime_t){},
-               HZ2BT(CLK_TCK)))
+
+  if (tickless_enabled()) {
+    maxidle = bt2st(&clock->tm_max_period);
+    maxidle = min(max(maxidle, 1U), (systime_t)CLK_MAXIDLE);
+    tickless = true;
+    if (tm_start(clock, TMF_ONESHOT | TMF_TIMESOURCE, HZ2BT(CLK_TCK),
+                 BINTIME(0)))
+      panic("Failed to start system clock!");
+  } else if (tm_start(clock, TMF_PERIODIC | TMF_TIMESOURCE, (bintime_t){},
+                      HZ2BT(CLK_TCK))) {
     panic("Failed to start system clock!");
-  klog("System clock uses \'%s\' hardware timer.", clock->tm_name);
+  }
+  klog("System clock uses \'%s\' hardware timer%s.", clock->tm_name,
+       tickless ? " in tickless mode" : "");
 
   if (profclock != NULL) {
     tm_init(profclock, prof_clock, NULL);
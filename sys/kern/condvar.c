@@ -31,6 +31,17 @@ int cv_wait_timed(condvar_t *cv, mtx_t *m, systime_t timeout) {
   return status;
 }
 
+int cv_wait_until(condvar_t *cv, mtx_t *m, bintime_t deadline) {
+  int status;
+  WITH_INTR_DISABLED {
+    cv->waiters++;
+    mtx_unlock(m);
+    status = sleepq_wait_until(cv, __caller(0), NULL, deadline);
+  }
+  _mtx_lock(m, __caller(0));
+  return status;
+}
+
 void cv_signal(condvar_t *cv) {
   SCOPED_NO_PREEMPTION();
   if (cv->waiters > 0) {
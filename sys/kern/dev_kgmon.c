@@ -0,0 +1,188 @@
+#include <sys/devfs.h>
+#include <sys/errno.h>
+#include <sys/gmon.h>
+#include <sys/interrupt.h>
+#include <sys/libkern.h>
+#include <sys/linker_set.h>
+#include <sys/uio.h>
+#include <stdatomic.h>
+
+/*
+ * /dev/kgmon exposes kernel profiling data as a gmon.out file, i.e. header,
+ * followed by histogram of clock ticks, followed by call graph arcs. Arcs are
+ * not stored anywhere in that form, so they're produced on the fly by walking
+ * `froms` and `tos` arrays. To make sequential reads cheap we remember where
+ * the last read has stopped.
+ */
+typedef struct kgmon_cursor {
+  size_t arcno;   /* number of arc that will be returned next */
+  size_t fromidx; /* index into `froms` array */
+  u_short toidx;  /* index into `tos` array or 0 if not in a chain */
+} kgmon_cursor_t;
+
+static atomic_int kgmon_usecnt;
+static kgmon_cursor_t kgmon_cursor;
+
+static void kgmon_rewind(void) {
+  kgmon_cursor = (kgmon_cursor_t){};
+}
+
+static bool kgmon_next_arc(gmonparam_t *p, rawarc_t *arc) {
+  kgmon_cursor_t *cur = &kgmon_cursor;
+  size_t nfroms = p->fromssize / sizeof(*p->froms);
+
+  while (cur->toidx == 0) {
+    if (cur->fromidx >= nfroms)
+      return false;
+    cur->toidx = p->froms[cur->fromidx];
+    if (cur->toidx == 0)
+      cur->fromidx++;
+  }
+
+  /* Each arc occupies a distinct `tos` entry, so it's an upper bound. */
+  if (cur->toidx >= p->tolimit || cur->arcno >= (size_t)p->tolimit)
+    return false;
+
+  tostruct_t *top = &p->tos[cur->toidx];
+  arc->raw_frompc =
+    p->lowpc + cur->fromidx * sizeof(*p->froms) * p->hashfraction;
+  arc->raw_selfpc = top->selfpc;
+  arc->raw_count = top->count;
+
+  cur->toidx = top->link;
+  if (cur->toidx == 0)
+    cur->fromidx++;
+  cur->arcno++;
+  return true;
+}
+
+static bool kgmon_seek_arc(gmonparam_t *p, size_t arcno) {
+  rawarc_t arc;
+
+  if (kgmon_cursor.arcno == arcno)
+    return true;
+
+  kgmon_rewind();
+  while (kgmon_cursor.arcno < arcno)
+    if (!kgmon_next_arc(p, &arc))
+      return false;
+  return true;
+}
+
+static int kgmon_read(devnode_t *dev, uio_t *uio) {
+  gmonparam_t *p = &_gmonparam;
+  size_t hdrsize = sizeof(gmonhdr_t);
+  size_t datasize = hdrsize + p->kcountsize;
+  int error = 0;
+
+  if (p->state == GMON_PROF_NOT_INIT)
+    return ENXIO;
+
+  /* Data is consistent only if mcount doesn't modify it while we read. */
+  if (p->state == GMON_PROF_ON || p->state == GMON_PROF_BUSY)
+    return EBUSY;
+
+  while (uio->uio_resid > 0 && !error) {
+    size_t off = uio->uio_offset;
+
+    if (off < hdrsize) {
+      error = uiomove_frombuf(&_gmonhdr, hdrsize, uio);
+    } else if (off < datasize) {
+      off -= hdrsize;
+      error = uiomove((char *)p->kcount + off, p->kcountsize - off, uio);
+    } else {
+      off -= datasize;
+      size_t skip = off % sizeof(rawarc_t);
+      rawarc_t arc;
+
+      if (!kgmon_seek_arc(p, off / sizeof(rawarc_t)) ||
+          !kgmon_next_arc(p, &arc))
+        break;
+      error = uiomove((char *)&arc + skip, sizeof(rawarc_t) - skip, uio);
+    }
+  }
+
+  return error;
+}
+
+static int kgmon_set_state(gmonparam_t *p, int state) {
+  if (state != GMON_PROF_ON && state != GMON_PROF_OFF)
+    return EINVAL;
+
+  /* No more arcs can be recorded, hence profiling data must be reset. */
+  if (state == GMON_PROF_ON && p->state == GMON_PROF_ERROR)
+    return ENOSPC;
+
+  /* mcount runs with interrupts disabled and the kernel is uniprocessor,
+   * so the state cannot change under our feet. */
+  WITH_INTR_DISABLED {
+    p->state = state;
+  }
+  kgmon_rewind();
+  return 0;
+}
+
+static void kgmon_reset(gmonparam_t *p) {
+  int state;
+
+  WITH_INTR_DISABLED {
+    state = p->state;
+    p->state = GMON_PROF_OFF;
+  }
+
+  bzero(p->kcount, p->kcountsize);
+  bzero(p->froms, p->fromssize);
+  bzero(p->tos, p->tossize);
+  kgmon_rewind();
+
+  /* Profiling that was stopped by running out of arcs can continue now. */
+  p->state = (state == GMON_PROF_ERROR) ? GMON_PROF_ON : state;
+}
+
+static int kgmon_ioctl(devnode_t *dev, u_long cmd, void *data, int fflags) {
+  gmonparam_t *p = &_gmonparam;
+
+  if (p->state == GMON_PROF_NOT_INIT)
+    return ENXIO;
+
+  if (cmd == GMONIOCGSTATE) {
+    *(int *)data = p->state;
+    return 0;
+  }
+  if (cmd == GMONIOCSSTATE)
+    return kgmon_set_state(p, *(int *)data);
+  if (cmd == GMONIOCRESET) {
+    kgmon_reset(p);
+    return 0;
+  }
+  return EINVAL;
+}
+
+static int kgmon_open(devnode_t *dev, file_t *fp, int oflags) {
+  /* The device keeps a single read cursor, so allow only one user. */
+  int expected = 0;
+  if (!atomic_compare_exchange_strong(&kgmon_usecnt, &expected, 1))
+    return EBUSY;
+
+  kgmon_rewind();
+  return 0;
+}
+
+static int kgmon_close(devnode_t *dev, file_t *fp) {
+  atomic_store(&kgmon_usecnt, 0);
+  return 0;
+}
+
+static devops_t kgmon_devops = {
+  .d_type = DT_SEEKABLE,
+  .d_open = kgmon_open,
+  .d_close = kgmon_close,
+  .d_read = kgmon_read,
+  .d_ioctl = kgmon_ioctl,
+};
+
+static void init_dev_kgmon(void) {
+  devfs_makedev_new(NULL, "kgmon", &kgmon_devops, NULL, NULL);
+}
+
+SET_ENTRY(devfs_init, init_dev_kgmon);
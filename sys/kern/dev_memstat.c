@@ -0,0 +1,43 @@
+#include <sys/devfs.h>
+#include <sys/errno.h>
+#include <sys/libkern.h>
+#include <sys/linker_set.h>
+#include <sys/malloc.h>
+#include <sys/memstat.h>
+#include <sys/uio.h>
+
+/* Pools may be created between counting records and filling them in. */
+#define MEMSTAT_SLACK 8
+
+static int memstat_read(devnode_t *dev, uio_t *uio) {
+  size_t npools = pool_memstat(NULL, 0) + MEMSTAT_SLACK;
+  size_t ntypes = kmalloc_memstat(NULL, 0);
+  size_t norders = vm_physmem_memstat(NULL, 0);
+  size_t nrecs = npools + ntypes + norders;
+  int error = 0;
+
+  memstat_record_t *recs =
+    kmalloc(M_TEMP, nrecs * sizeof(memstat_record_t), M_WAITOK | M_ZERO);
+
+  size_t n = min(pool_memstat(recs, npools), npools);
+  n += kmalloc_memstat(recs + n, ntypes);
+  n += vm_physmem_memstat(recs + n, norders);
+
+  size_t len = n * sizeof(memstat_record_t);
+  if ((size_t)uio->uio_offset < len)
+    error = uiomove_frombuf(recs, len, uio);
+
+  kfree(M_TEMP, recs);
+  return error;
+}
+
+static devops_t memstat_devops = {
+  .d_type = DT_SEEKABLE,
+  .d_read = memstat_read,
+};
+
+static void init_dev_memstat(void) {
+  devfs_makedev_new(NULL, "memstat", &memstat_devops, NULL, NULL);
+}
+
+SET_ENTRY(devfs_init, init_dev_memstat);
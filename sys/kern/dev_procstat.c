@@ -5,31 +5,24 @@
 #include <sys/proc.h>
 #include <sys/thread.h>
 #include <sys/malloc.h>
-#include <stdio.h>
+#include <sys/procstat.h>
+#include <sys/sched.h>
+#include <sys/time.h>
+#include <sys/vm.h>
 
 /* Implementation of /dev/procstat
  *
  * When /dev/procstat is opened it takes a snapshot of info of all existing
- * processes.
- *
- * During read calls to /dev/procstat this info can be read.
- *
- * Example:
- * euid   pid    ppid    pgrp   session  state    command
- * 0       1       0       1       1       R      ls -l
+ * processes and their threads. The snapshot is laid out as described in
+ * <sys/procstat.h>, so a tool can fetch it in a single read call.
  */
 
-/* length of displayed command of process (includes terminating null byte) */
-#define PROC_COMM_MAX 128
-
-/* maximum size of output string of proc info
- * command + state (1 character)+ spaces (10 characters) +
- *  + 5 * max length of uint32 (10 characters)*/
-#define MAX_P_STRING (PROC_COMM_MAX + 1 + 10 + 5 * 10)
-
 /* maximum amount of processes that procstat can handle */
 #define MAX_PROC 40
 
+/* maximum amount of threads that procstat can handle */
+#define MAX_THREAD 128
+
 /* we want to have at most 10 instances of procstat */
 #define MAX_PROCSTAT 10
 
@@ -43,24 +36,22 @@ static char proc_state[4] = {
   [PS_ZOMBIE] = 'Z',
 };
 
-typedef struct ps_entry {
-  pid_t pid;
-  pid_t ppid;
-  uid_t uid;
-  pgid_t pgrp;
-  sid_t sid;
-  proc_state_t proc_state;
-  char *command;
-} ps_entry_t;
+static char thread_state[] = {
+  [TDS_INACTIVE] = 'I',
+  [TDS_READY] = 'R',
+  [TDS_RUNNING] = 'O',
+  [TDS_SLEEPING] = 'S',
+  [TDS_BLOCKED] = 'L',
+  [TDS_STOPPED] = 'T',
+  [TDS_DEAD] = 'Z',
+};
 
 typedef struct ps_buf {
   mtx_t lock;
-  int nproc;
-  int cur_proc;
-  size_t offset; /* offset in buffer of current proc string */
-  size_t psize;  /* size of current proc string */
-  char buf[MAX_P_STRING];
-  ps_entry_t ps[];
+  size_t size; /* size of snapshot */
+  kinfo_header_t *hdr;
+  kinfo_proc_t *procs;
+  kinfo_thread_t *threads;
 } ps_buf_t;
 
 static int ps_opencnt = 0;
@@ -84,9 +75,8 @@ static vnodeops_t dev_procstat_vnodeops = {
   .v_close = dev_procstat_close,
 };
 
-static char *get_command(proc_t *p) {
-  char *buf = kmalloc(M_TEMP, PROC_COMM_MAX, M_ZERO);
-  ssize_t left = PROC_COMM_MAX, used = 0;
+static void get_command(proc_t *p, char *buf) {
+  ssize_t left = KI_COMMLEN, used = 0;
   char *command;
 
   /* copy program's name from elfpath */
@@ -103,7 +93,7 @@ static char *get_command(proc_t *p) {
 
   ssize_t wanted = strlcpy(buf, command, left);
   used += min(wanted, left - 1);
-  left = PROC_COMM_MAX - used;
+  left = KI_COMMLEN - used;
 
   /* if there is enough space append space after program name */
   if (left > 1) {
@@ -113,30 +103,60 @@ static char *get_command(proc_t *p) {
 
   char *args = p->p_args ? p->p_args : NONAME;
   strlcpy(buf + used, args, left);
+}
+
+static void kinfo_thread_fill(kinfo_thread_t *kt, thread_t *td) {
+  SCOPED_MTX_LOCK(td->td_lock);
+
+  bintime_t rtime = sched_rtime(td);
 
-  return buf;
+  kt->kt_tid = td->td_tid;
+  kt->kt_pid = td->td_proc->p_pid;
+  kt->kt_stat = thread_state[td->td_state];
+  kt->kt_prio = td->td_prio;
+  kt->kt_base_prio = td->td_base_prio;
+  kt->kt_nctxsw = td->td_nctxsw;
+  kt->kt_rtime = bt2ns(&rtime);
+  kt->kt_slptime = bt2ns(&td->td_slptime);
+  strlcpy(kt->kt_name, td->td_name, KI_TDNAMELEN);
 }
 
-static void ps_entry_fill(ps_entry_t *pe, proc_t *p) {
+static void kinfo_proc_fill(ps_buf_t *ps, kinfo_proc_t *kp, proc_t *p) {
+  kinfo_header_t *hdr = ps->hdr;
+  thread_t *td;
+
   SCOPED_MTX_LOCK(&p->p_lock);
-  pe->uid = p->p_cred.cr_euid;
-  pe->pid = p->p_pid;
-  pe->ppid = p->p_parent->p_pid;
-  pe->pgrp = p->p_pgrp->pg_id;
-  pe->sid = p->p_pgrp->pg_session->s_sid;
-  pe->proc_state = p->p_state;
-  pe->command = get_command(p);
-}
 
-/* buf must be at least MAX_P_STRING long
- * returns length of written string
- */
-static int ps_entry_tostring(char *buf, ps_entry_t *pe) {
-  int r = snprintf(buf, MAX_P_STRING, "%d\t%d\t%d\t%d\t%d\t%c\t%s\n", pe->uid,
-                   pe->pid, pe->ppid, pe->pgrp, pe->sid,
-                   proc_state[pe->proc_state], pe->command);
+  kp->kp_uid = p->p_cred.cr_euid;
+  kp->kp_pid = p->p_pid;
+  kp->kp_ppid = p->p_parent->p_pid;
+  kp->kp_pgrp = p->p_pgrp->pg_id;
+  kp->kp_sid = p->p_pgrp->pg_session->s_sid;
+  kp->kp_stat = proc_state[p->p_state];
+  kp->kp_thread = hdr->kh_nthread;
+  get_command(p, kp->kp_comm);
+
+  struct rusage ru;
+  proc_rusage(p, &ru);
+  kp->kp_minflt = ru.ru_minflt;
+  kp->kp_majflt = ru.ru_majflt;
+  kp->kp_rtime =
+    ru.ru_utime.tv_sec * 1000000000ULL + ru.ru_utime.tv_usec * 1000ULL;
+
+  /* Borrowed address space is accounted to the parent. */
+  if (p->p_uspace && !(p->p_flags & PF_VFORK)) {
+    vm_map_stats_t stats;
+    vm_map_stats(p->p_uspace, &stats);
+    kp->kp_rss = stats.vs_resident;
+  }
 
-  return min(r, MAX_P_STRING);
+  TAILQ_FOREACH (td, &p->p_threads, td_procq) {
+    if (hdr->kh_nthread >= MAX_THREAD)
+      break;
+    kinfo_thread_t *kt = &ps->threads[hdr->kh_nthread++];
+    kinfo_thread_fill(kt, td);
+    kp->kp_nthread++;
+  }
 }
 
 static int dev_procstat_open(vnode_t *v, int mode, file_t *fp) {
@@ -159,31 +179,45 @@ static int dev_procstat_open(vnode_t *v, int mode, file_t *fp) {
     return error;
   }
 
-  ps = kmalloc(M_TEMP, MAX_PROC * sizeof(ps_entry_t) + sizeof(ps_buf_t), 0);
-
-  ps->nproc = 0;
+  ps = kmalloc(M_TEMP, sizeof(ps_buf_t), M_ZERO);
   mtx_init(&ps->lock, 0);
+  ps->hdr = kmalloc(M_TEMP,
+                    sizeof(kinfo_header_t) + MAX_PROC * sizeof(kinfo_proc_t) +
+                      MAX_THREAD * sizeof(kinfo_thread_t),
+                    M_ZERO);
+  ps->procs = (kinfo_proc_t *)(ps->hdr + 1);
+  ps->threads = (kinfo_thread_t *)(ps->procs + MAX_PROC);
+
+  kinfo_header_t *hdr = ps->hdr;
+  hdr->kh_version = PROCSTAT_VERSION;
+  hdr->kh_procsize = sizeof(kinfo_proc_t);
+  hdr->kh_threadsize = sizeof(kinfo_thread_t);
+  hdr->kh_pagesize = PAGESIZE;
+
+  bintime_t now = binuptime();
+  hdr->kh_uptime = bt2ns(&now);
 
   WITH_MTX_LOCK (&all_proc_mtx) {
     TAILQ_FOREACH (p, &proc_list, p_all) {
       if (p->p_pid == 0)
         continue; /* we don't want to show proc0 to user */
-      if (ps->nproc >= MAX_PROC)
+      if (hdr->kh_nproc >= MAX_PROC)
         goto out;
-      ps_entry_fill(&ps->ps[ps->nproc++], p);
+      kinfo_proc_fill(ps, &ps->procs[hdr->kh_nproc++], p);
     }
     TAILQ_FOREACH (p, &zombie_list, p_zombie) {
-      if (ps->nproc >= MAX_PROC)
+      if (hdr->kh_nproc >= MAX_PROC)
         goto out;
-      ps_entry_fill(&ps->ps[ps->nproc++], p);
+      kinfo_proc_fill(ps, &ps->procs[hdr->kh_nproc++], p);
     }
   }
 
 out:
-  /* get first proc into buffer */
-  ps->psize = ps_entry_tostring(ps->buf, &ps->ps[0]);
-  ps->offset = 0;
-  ps->cur_proc = 0;
+  /* Move thread records right after the last process record. */
+  kinfo_thread_t *threads = (kinfo_thread_t *)(ps->procs + hdr->kh_nproc);
+  memmove(threads, ps->threads, hdr->kh_nthread * sizeof(kinfo_thread_t));
+  ps->threads = threads;
+  ps->size = (char *)(threads + hdr->kh_nthread) - (char *)hdr;
 
   fp->f_ops = &dev_procstat_fileops;
   fp->f_data = ps;
@@ -192,39 +226,22 @@ out:
 
 static int dev_procstat_read(file_t *f, uio_t *uio) {
   ps_buf_t *ps = f->f_data;
-  int error = 0;
+  int error;
 
   SCOPED_MTX_LOCK(&ps->lock);
 
-  if (ps->cur_proc >= ps->nproc)
+  if (f->f_offset >= (off_t)ps->size)
     return 0;
 
   uio->uio_offset = f->f_offset;
-  while (uio->uio_resid > 0) {
-    size_t len = min(uio->uio_resid, ps->psize - ps->offset);
-    if ((error = uiomove(ps->buf, len, uio)))
-      break;
-
-    ps->offset += len;
-
-    /* have to jump to next process info string */
-    if (ps->offset >= ps->psize) {
-      if (++ps->cur_proc >= ps->nproc)
-        break;
-      ps->psize = ps_entry_tostring(ps->buf, &ps->ps[ps->cur_proc]);
-      ps->offset = 0;
-    }
-  }
-
+  error = uiomove_frombuf(ps->hdr, ps->size, uio);
   f->f_offset = uio->uio_offset;
   return error;
 }
 
 static int dev_procstat_close(vnode_t *v, file_t *fp) {
   ps_buf_t *ps = fp->f_data;
-  for (int i = 0; i < ps->nproc; ++i) {
-    kfree(M_TEMP, ps->ps[i].command);
-  }
+  kfree(M_TEMP, ps->hdr);
   kfree(M_TEMP, ps);
 
   WITH_MTX_LOCK (&procstat_lock) {
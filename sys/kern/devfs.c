@@ -443,6 +443,10 @@ static int dev_noioctl(devnode_t *dev, u_long cmd, void *data, int flags) {
   return EOPNOTSUPP;
 }
 
+static int dev_nokqfilter(devnode_t *dev, knote_t *kn) {
+  return EOPNOTSUPP;
+}
+
 static int _devfs_makedev(devfs_node_t *parent, const char *name, void *data,
                           devfs_node_t **dn_p) {
   int error;
@@ -475,6 +479,8 @@ int devfs_makedev_new(devfs_node_t *parent, const char *name, devops_t *devops,
       devops->d_write = dev_nowrite;
     if (devops->d_ioctl == NULL)
       devops->d_ioctl = dev_noioctl;
+    if (devops->d_kqfilter == NULL)
+      devops->d_kqfilter = dev_nokqfilter;
 
     dn->dn_device.ops = devops;
   }
@@ -0,0 +1,78 @@
+#include <sys/devfs.h>
+#include <sys/errno.h>
+#include <sys/evcnt.h>
+#include <sys/libkern.h>
+#include <sys/linker_set.h>
+#include <sys/mutex.h>
+#include <sys/uio.h>
+
+static TAILQ_HEAD(, evcnt) evcnt_list = TAILQ_HEAD_INITIALIZER(evcnt_list);
+static MTX_DEFINE(evcnt_lock, 0);
+
+SET_DECLARE(evcnt_static, evcnt_t);
+
+uint64_t evcnt_value(evcnt_t *ev) {
+  uint64_t count = 0;
+  for (int i = 0; i < MAXCPU; i++)
+    count += ev->ev_count[i];
+  return count;
+}
+
+void evcnt_attach(evcnt_t *ev, const char *group, const char *name) {
+  ev->ev_group = group;
+  ev->ev_name = name;
+  WITH_MTX_LOCK (&evcnt_lock)
+    TAILQ_INSERT_TAIL(&evcnt_list, ev, ev_link);
+}
+
+void evcnt_detach(evcnt_t *ev) {
+  WITH_MTX_LOCK (&evcnt_lock)
+    TAILQ_REMOVE(&evcnt_list, ev, ev_link);
+}
+
+void init_evcnt(void) {
+  evcnt_t **ev_p;
+
+  SET_FOREACH (ev_p, evcnt_static)
+    evcnt_attach(*ev_p, (*ev_p)->ev_group, (*ev_p)->ev_name);
+
+  INVOKE_CTORS(evcnt_ctor_table);
+}
+
+static int evcnt_read(devnode_t *dev, uio_t *uio) {
+  size_t idx = uio->uio_offset / sizeof(evcnt_record_t);
+  size_t skip = uio->uio_offset % sizeof(evcnt_record_t);
+  int error = 0;
+  evcnt_t *ev;
+
+  SCOPED_MTX_LOCK(&evcnt_lock);
+
+  TAILQ_FOREACH (ev, &evcnt_list, ev_link) {
+    if (uio->uio_resid == 0 || error)
+      break;
+    if (idx > 0) {
+      idx--;
+      continue;
+    }
+
+    evcnt_record_t er = {.er_count = evcnt_value(ev)};
+    strlcpy(er.er_group, ev->ev_group, EVCNT_GROUPLEN);
+    strlcpy(er.er_name, ev->ev_name, EVCNT_NAMELEN);
+
+    error = uiomove((char *)&er + skip, sizeof(er) - skip, uio);
+    skip = 0;
+  }
+
+  return error;
+}
+
+static devops_t evcnt_devops = {
+  .d_type = DT_SEEKABLE,
+  .d_read = evcnt_read,
+};
+
+static void init_dev_evcnt(void) {
+  devfs_makedev_new(NULL, "evcnt", &evcnt_devops, NULL, NULL);
+}
+
+SET_ENTRY(devfs_init, init_dev_evcnt);
@@ -9,6 +9,8 @@
 #include <sys/device.h>
 #include <sys/proc.h>
 #include <sys/pool.h>
+#include <sys/poll.h>
+#include <sys/select.h>
 #include <sys/time.h>
 
 #define KN_HASHSIZE 8
@@ -77,6 +79,9 @@ static void kqueue_destroy(kqueue_t *kq) {
 
 static int filt_fileattach(knote_t *kn) {
   file_t *fp = kn->kn_obj;
+  /* Files that cannot be monitored (e.g. regular files) are always ready. */
+  if (fp->f_ops->fo_kqfilter == NULL)
+    return EOPNOTSUPP;
   return fp->f_ops->fo_kqfilter(fp, kn);
 }
 
@@ -87,9 +92,19 @@ static filterops_t file_filtops = {
   .filt_attach = filt_fileattach,
 };
 
+static int filt_timerattach(knote_t *kn) {
+  return ptimer_kqfilter(kn->kn_obj, kn);
+}
+
+/* As above, the rest is specified by the timer. */
+static filterops_t timer_filtops = {
+  .filt_attach = filt_timerattach,
+};
+
 static filterops_t *sys_kfilters[EVFILT_SYSCOUNT] = {
   [EVFILT_READ] = &file_filtops,
   [EVFILT_WRITE] = &file_filtops,
+  [EVFILT_TIMER] = &timer_filtops,
 };
 
 static filterops_t *filt_getops(uint32_t filter) {
@@ -136,17 +151,30 @@ static fileops_t kqueueops = {
 };
 
 static int kqueue_get_obj(proc_t *p, kevent_t *kev, void **obj) {
-  if (kev->filter == EVFILT_READ || kev->filter == EVFILT_WRITE)
+  if (kev->filter == EVFILT_READ)
     return fdtab_get_file(p->p_fdtable, kev->ident, FF_READ, (file_t **)obj);
+  if (kev->filter == EVFILT_WRITE)
+    return fdtab_get_file(p->p_fdtable, kev->ident, FF_WRITE, (file_t **)obj);
+  if (kev->filter == EVFILT_TIMER) {
+    if (kev->ident >= TIMER_MAX)
+      return EINVAL;
+    return ptimer_hold(p, kev->ident, (ptimer_t **)obj);
+  }
 
   return EINVAL;
 }
 
+/* Drops a reference to the object obtained with `kqueue_get_obj`. */
+static void kqueue_drop_obj(uint32_t filter, void *obj) {
+  if (filter == EVFILT_READ || filter == EVFILT_WRITE)
+    file_drop(obj);
+  else if (filter == EVFILT_TIMER)
+    ptimer_drop(obj);
+}
+
 /* Drops the object connected to the knote. */
 static void knote_drop_obj(knote_t *kn) {
-  uint32_t filter = kn->kn_kevent.filter;
-  if (filter == EVFILT_READ || filter == EVFILT_WRITE)
-    file_drop(kn->kn_obj);
+  kqueue_drop_obj(kn->kn_kevent.filter, kn->kn_obj);
 }
 
 /* Drops an already detached knote. */
@@ -172,7 +200,7 @@ static void knote_drop(knote_t *kn) {
 }
 
 /* Modifies the knote based on the flags in the kevent (or creates
- * a new one if necessary).
+ * a new one if necessary). Consumes the reference to `obj`.
  */
 static int kqueue_register(kqueue_t *kq, kevent_t *kev, void *obj) {
   knote_t *kn = NULL;
@@ -187,15 +215,21 @@ static int kqueue_register(kqueue_t *kq, kevent_t *kev, void *obj) {
   /* Find an existing knote to use for this kevent. */
   knlist_t *knote_list = kq_get_hashbucket(kq, obj);
   SLIST_FOREACH(kn, knote_list, kn_hashlink) {
-    if (kev->filter == kn->kn_kevent.filter && kn->kn_obj == obj)
+    if (kev->filter == kn->kn_kevent.filter && kn->kn_obj == obj &&
+        kev->ident == kn->kn_kevent.ident)
       break;
   }
 
-  /* There isn't the matching knote. Create a new one. */
-  if (kn == NULL) {
-    /* We weren't asked to create a new knote, so just return an error. */
-    if ((kev->flags & EV_ADD) == 0)
+  if (kn != NULL) {
+    /* The knote already holds its own reference to the object. */
+    kqueue_drop_obj(kev->filter, obj);
+  } else {
+    /* There isn't the matching knote. Create a new one. */
+    if ((kev->flags & EV_ADD) == 0) {
+      /* We weren't asked to create a new knote, so just return an error. */
+      kqueue_drop_obj(kev->filter, obj);
       return ENOENT;
+    }
 
     kn = pool_alloc(P_KNOTE, M_ZERO);
     kn->kn_kq = kq;
@@ -245,40 +279,48 @@ static int kqueue_register(kqueue_t *kq, kevent_t *kev, void *obj) {
  */
 static int kqueue_scan(kqueue_t *kq, kevent_t *eventlist, size_t nevents,
                        timespec_t *tsp, int *retval) {
-  int error, event, timeout;
+  int error, event;
   size_t count = 0;
-  systime_t sleepts;
+  bool nonblock = false;
+  bintime_t deadline;
   knote_tailq_t knqueue;
   knote_t *kn;
+  kevent_t kev;
 
   TAILQ_INIT(&knqueue);
 
   if (tsp) {
-    timeout = ts2hz(tsp);
-    sleepts = getsystime() + timeout;
-    if (timeout <= 0)
-      timeout = -1; /* don't block */
-  } else {
-    timeout = 0; /* no timeout, wait forever */
+    if (tsp->tv_sec < 0 || (tsp->tv_sec == 0 && tsp->tv_nsec == 0)) {
+      nonblock = true; /* don't block */
+    } else {
+      /* Without timeout wait forever, otherwise until the deadline. */
+      bintime_t now = binuptime();
+      ts2bt(tsp, &deadline);
+      bintime_add(&deadline, &now);
+    }
   }
 
   mtx_lock(&kq->kq_lock);
 
+retry:
   /* Block until there are no events or we time out. */
   while (kq->kq_count == 0) {
-    if (timeout < 0) {
+    if (nonblock) {
       error = 0;
       goto done;
     }
 
-    error = cv_wait_timed(&kq->kq_cv, &kq->kq_lock, timeout);
+    if (tsp)
+      error = cv_wait_until(&kq->kq_cv, &kq->kq_lock, deadline);
+    else
+      error = cv_wait_timed(&kq->kq_cv, &kq->kq_lock, 0);
     if (error == EINTR) {
       mtx_unlock(&kq->kq_lock);
       return EINTR;
     }
 
-    if (tsp)
-      timeout = sleepts - getsystime();
+    if (error == ETIMEDOUT)
+      nonblock = true;
   }
 
   /* To ensure the correctness of the iteration over pending events,
@@ -303,6 +345,17 @@ static int kqueue_scan(kqueue_t *kq, kevent_t *eventlist, size_t nevents,
     mtx_unlock(&kq->kq_lock);
     WITH_MTX_LOCK (kn->kn_objlock) {
       event = kn->kn_filtops->filt_event(kn, 0);
+      kev = kn->kn_kevent;
+      /* With EV_CLEAR the event is reported once and the knote leaves the
+       * queue, so that the object can activate it again. */
+      if (event && (kev.flags & EV_CLEAR)) {
+        kn->kn_kevent.data = 0;
+        kn->kn_kevent.fflags = 0;
+        WITH_MTX_LOCK (&kq->kq_lock) {
+          kn->kn_status &= ~KN_QUEUED;
+          kq->kq_count--;
+        }
+      }
     }
     mtx_lock(&kq->kq_lock);
 
@@ -313,13 +366,26 @@ static int kqueue_scan(kqueue_t *kq, kevent_t *eventlist, size_t nevents,
       continue;
     }
 
-    TAILQ_INSERT_HEAD(&knqueue, kn, kn_penlink);
+    if ((kev.flags & EV_CLEAR) == 0)
+      TAILQ_INSERT_HEAD(&knqueue, kn, kn_penlink);
 
-    eventlist[count++] = kn->kn_kevent;
+    eventlist[count++] = kev;
   }
 
   TAILQ_CONCAT(&kq->kq_head, &knqueue, kn_penlink);
 
+  /* All pending events turned out to be stale, so go back to sleep instead of
+   * reporting a spurious timeout. */
+  if (count == 0 && nevents > 0) {
+    if (tsp && !nonblock) {
+      /* Coarse time is enough, we'd just time out on the next iteration. */
+      bintime_t now = getbinuptime();
+      if (bintime_cmp(&now, &deadline, >=))
+        nonblock = true;
+    }
+    goto retry;
+  }
+
 done:
   mtx_unlock(&kq->kq_lock);
   *retval = count;
@@ -452,3 +518,164 @@ void knote(knlist_t *list, long hint) {
     }
   }
 }
+
+/*
+ * poll(2) and select(2) are implemented on top of a transient kqueue that is
+ * never installed in the descriptor table. Each polled descriptor gets a knote
+ * per requested filter with `ident` set to the index of its entry in `fds`, so
+ * duplicate descriptors do not collapse into a single knote. Files that cannot
+ * be monitored with knotes (e.g. regular files) are always reported as ready.
+ */
+
+#define POLLREAD (POLLIN | POLLRDNORM)
+#define POLLWRITE (POLLOUT | POLLWRNORM)
+
+static void poll_register(kqueue_t *kq, nfds_t idx, pollfd_t *pfd, file_t *fp,
+                          uint32_t filter, size_t *nknotes) {
+  short mask = (filter == EVFILT_READ) ? POLLREAD : POLLWRITE;
+  kevent_t kev;
+  int error;
+
+  EV_SET(&kev, idx, filter, EV_ADD, 0, 0, NULL);
+
+  file_hold(fp);
+  if ((error = kqueue_register(kq, &kev, fp)) == 0)
+    (*nknotes)++;
+  else if (error == EOPNOTSUPP)
+    pfd->revents |= pfd->events & mask;
+  /* Otherwise the file will never report events of this kind. */
+}
+
+int do_poll(proc_t *p, pollfd_t *fds, nfds_t nfds, timespec_t *tsp,
+            int *retval) {
+  timespec_t nowait = {.tv_sec = 0, .tv_nsec = 0};
+  kevent_t *events = NULL;
+  size_t nknotes = 0;
+  bool ready = false;
+  int error, nevents;
+
+  if (tsp && (tsp->tv_sec < 0 || tsp->tv_nsec < 0 ||
+              tsp->tv_nsec >= 1000000000L))
+    return EINVAL;
+
+  kqueue_t *kq = kqueue_create();
+
+  for (nfds_t i = 0; i < nfds; i++) {
+    pollfd_t *pfd = &fds[i];
+    file_t *fp;
+
+    pfd->revents = 0;
+
+    if (pfd->fd < 0)
+      continue;
+
+    if (fdtab_get_file(p->p_fdtable, pfd->fd, 0, &fp)) {
+      pfd->revents = POLLNVAL;
+      ready = true;
+      continue;
+    }
+
+    if (pfd->events & POLLREAD)
+      poll_register(kq, i, pfd, fp, EVFILT_READ, &nknotes);
+    if (pfd->events & POLLWRITE)
+      poll_register(kq, i, pfd, fp, EVFILT_WRITE, &nknotes);
+
+    file_drop(fp);
+
+    if (pfd->revents)
+      ready = true;
+  }
+
+  if (nknotes > 0)
+    events = kmalloc(M_TEMP, nknotes * sizeof(kevent_t), 0);
+
+  /* Sleep only once and only if none of the descriptors is ready yet. */
+  if ((error = kqueue_scan(kq, events, nknotes, ready ? &nowait : tsp,
+                           &nevents)))
+    goto end;
+
+  for (int i = 0; i < nevents; i++) {
+    kevent_t *kev = &events[i];
+    pollfd_t *pfd = &fds[kev->ident];
+
+    if (kev->filter == EVFILT_READ) {
+      pfd->revents |= pfd->events & POLLREAD;
+      if (kev->flags & EV_EOF)
+        pfd->revents |= POLLHUP;
+    } else if (kev->flags & EV_EOF) {
+      /* POLLHUP and POLLOUT are mutually exclusive. */
+      pfd->revents = (pfd->revents & ~POLLWRITE) | POLLHUP;
+    } else {
+      pfd->revents |= pfd->events & POLLWRITE;
+    }
+  }
+
+  *retval = 0;
+  for (nfds_t i = 0; i < nfds; i++)
+    if (fds[i].revents)
+      (*retval)++;
+
+end:
+  kqueue_destroy(kq);
+  kfree(M_TEMP, events);
+  return error;
+}
+
+int do_select(proc_t *p, int nfds, fd_set *readfds, fd_set *writefds,
+              fd_set *exceptfds, timespec_t *tsp, int *retval) {
+  pollfd_t *fds;
+  int error, nready;
+
+  if (nfds < 0 || nfds > FD_SETSIZE)
+    return EINVAL;
+
+  fds = kmalloc(M_TEMP, nfds * sizeof(pollfd_t), M_ZERO);
+
+  for (int fd = 0; fd < nfds; fd++) {
+    pollfd_t *pfd = &fds[fd];
+    if (readfds && FD_ISSET(fd, readfds))
+      pfd->events |= POLLIN;
+    if (writefds && FD_ISSET(fd, writefds))
+      pfd->events |= POLLOUT;
+    if (exceptfds && FD_ISSET(fd, exceptfds))
+      pfd->events |= POLLPRI;
+    pfd->fd = pfd->events ? fd : -1;
+  }
+
+  if ((error = do_poll(p, fds, nfds, tsp, &nready)))
+    goto end;
+
+  if (readfds)
+    FD_ZERO(readfds);
+  if (writefds)
+    FD_ZERO(writefds);
+  if (exceptfds)
+    FD_ZERO(exceptfds);
+
+  *retval = 0;
+  for (int fd = 0; fd < nfds && nready > 0; fd++) {
+    pollfd_t *pfd = &fds[fd];
+    if (pfd->revents == 0)
+      continue;
+    nready--;
+    if (pfd->revents & POLLNVAL) {
+      error = EBADF;
+      goto end;
+    }
+    /* Errors and hangups make both reads and writes return immediately. */
+    if ((pfd->events & POLLIN) &&
+        (pfd->revents & (POLLIN | POLLHUP | POLLERR))) {
+      FD_SET(fd, readfds);
+      (*retval)++;
+    }
+    if ((pfd->events & POLLOUT) &&
+        (pfd->revents & (POLLOUT | POLLHUP | POLLERR))) {
+      FD_SET(fd, writefds);
+      (*retval)++;
+    }
+  }
+
+end:
+  kfree(M_TEMP, fds);
+  return error;
+}
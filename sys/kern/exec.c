@@ -17,12 +17,13 @@
 #include <sys/malloc.h>
 #include <sys/signal.h>
 #include <sys/stat.h>
+#include <sys/timepage.h>
 
 typedef int (*copy_ptr_t)(exec_args_t *args, char *const *ptr_p);
 typedef int (*copy_str_t)(exec_args_t *args, const char *str, size_t *copied_p);
 
 /* Adds working buffers to exec_args structure. */
-static void exec_args_init(exec_args_t *args) {
+void exec_args_init(exec_args_t *args) {
   args->path = kmalloc(M_TEMP, PATH_MAX, 0);
   args->data = kmalloc(M_TEMP, ARG_MAX, 0);
   args->end = args->data;
@@ -37,7 +38,7 @@ static void exec_args_init(exec_args_t *args) {
 }
 
 /* Frees dynamically allocated memory from exec_args structure */
-static void exec_args_destroy(exec_args_t *args) {
+void exec_args_destroy(exec_args_t *args) {
   kfree(M_TEMP, args->path);
   kfree(M_TEMP, args->data);
 }
@@ -289,12 +290,19 @@ static void enter_new_vmspace(proc_t *p, exec_vmspace_t *saved,
   int error = vm_map_insert(p->p_uspace, stack_ent, VM_FIXED);
   assert(error == 0);
 
+  /* Let libc read the clock without entering the kernel. */
+  error = timepage_map(p->p_uspace);
+  assert(error == 0);
+
   vm_map_activate(p->p_uspace);
 }
 
 /* Return to the previous map, unmodified by exec. */
 static void restore_vmspace(proc_t *p, exec_vmspace_t *saved) {
+  vm_map_t *uspace = p->p_uspace;
   p->p_uspace = saved->uspace;
+  /* The vm_map we began preparing is to be destroyed instead. */
+  saved->uspace = uspace;
   p->p_sbrk = saved->sbrk;
   p->p_sbrk_end = saved->sbrk_end;
   vm_map_activate(p->p_uspace);
@@ -343,10 +351,15 @@ static char *pargs_create(exec_args_t *args) {
   return pargs;
 }
 
-/* XXX We assume process may only have a single thread. But if there were more
- * than one thread in the process that called exec, all other threads must be
- * forcefully terminated. */
-static int _do_execve(exec_args_t *args) {
+int exec_args_copyin(exec_args_t *args, const char *u_path,
+                     char *const *u_argp, char *const *u_envp) {
+  int error;
+  if ((error = user_copy_path(args, u_path)))
+    return error;
+  return user_copy_args(args, u_argp, u_envp);
+}
+
+int exec_program(exec_args_t *args) {
   thread_t *td = thread_self();
   proc_t *p = td->td_proc;
   vnode_t *vn;
@@ -406,6 +419,11 @@ static int _do_execve(exec_args_t *args) {
   kfree(M_STR, p->p_args);
   p->p_args = pargs_create(args);
 
+  kfree(M_STR, p->p_elfpath);
+  p->p_elfpath = kstrndup(M_STR, prog, PATH_MAX);
+
+  /* Descriptors closed on exec must not disappear from other processes. */
+  p->p_fdtable = fdtab_unshare(p->p_fdtable);
   fdtab_onexec(p->p_fdtable);
 
   /* Set up user context. */
@@ -414,23 +432,33 @@ static int _do_execve(exec_args_t *args) {
   /* All thread pflags that should not be inherited should be cleared */
   td->td_pflags = 0;
 
+  bool borrowed;
+
   WITH_PROC_LOCK(p) {
     sig_onexec(p);
+    /* POSIX timers aren't preserved across exec, unlike the interval timer. */
+    ptimer_deleteall(p);
     /* Set new credentials if needed */
     if (setid)
       cred_exec_setid(p, uid, gid);
+    /* Let the parent continue, if it waits for us in vfork. Note that `args`
+     * may belong to the parent, so they must not be touched afterwards. */
+    borrowed = p->p_flags & PF_VFORK;
+    proc_vfork_done(p);
+    /* Faults taken before exec still count as the process's own. */
+    if (!borrowed)
+      proc_account_vmspace(p, saved.uspace);
   }
 
   /* At this point we are certain that exec succeeds.  We can safely destroy the
-   * previous vm_map, and permanently assign this one to the current process. */
-  destroy_vmspace(&saved);
+   * previous vm_map (unless it belongs to the parent), and permanently assign
+   * this one to the current process. */
+  if (!borrowed)
+    destroy_vmspace(&saved);
 
   vm_map_activate(p->p_uspace);
   vm_map_dump(p->p_uspace);
 
-  kfree(M_STR, p->p_elfpath);
-  p->p_elfpath = kstrndup(M_STR, prog, PATH_MAX);
-
   klog("Enter userspace with: pc=%p, sp=%p", eh.e_entry, stack_top);
   return EJUSTRETURN;
 
@@ -441,13 +469,25 @@ fail:
 }
 
 int do_execve(const char *u_path, char *const *u_argp, char *const *u_envp) {
+  thread_t *td = thread_self();
+  proc_t *p = td->td_proc;
   int result;
   exec_args_t args;
   exec_args_init(&args);
-  if ((result = user_copy_path(&args, u_path)) ||
-      (result = user_copy_args(&args, u_argp, u_envp)))
+  if ((result = exec_args_copyin(&args, u_path, u_argp, u_envp)))
+    goto end;
+
+  WITH_PROC_LOCK(p) {
+    result = proc_singlethread(p);
+  }
+  if (result)
     goto end;
-  result = _do_execve(&args);
+
+  result = exec_program(&args);
+
+  WITH_PROC_LOCK(p) {
+    p->p_singlethread = NULL;
+  }
 end:
   exec_args_destroy(&args);
   return result;
@@ -463,7 +503,7 @@ __noreturn void kern_execve(const char *path, char *const *argv,
   exec_args_init(&args);
 
   if (kern_copy_path(&args, path) || kern_copy_args(&args, argv, envv) ||
-      _do_execve(&args) != EJUSTRETURN)
+      exec_program(&args) != EJUSTRETURN)
     panic("Failed to start '%s' program.", path);
 
   exec_args_destroy(&args);
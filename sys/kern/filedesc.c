@@ -5,6 +5,7 @@
 #include <sys/errno.h>
 #include <sys/mutex.h>
 #include <sys/refcnt.h>
+#include <sys/sched.h>
 #include <bitstring.h>
 
 static KMALLOC_DEFINE(M_FD, "filedesc");
@@ -17,6 +18,18 @@ static KMALLOC_DEFINE(M_FD, "filedesc");
 /* Separate macro defining a hard limit on open files. */
 #define MAXFILES 1024
 
+/*
+ * Descriptor table may be shared by many processes (see FORK_SHAREFD),
+ * so lookups in `fdtab_get_file` don't take `fdt_mtx`. Instead they run
+ * with preemption disabled, which on a uniprocessor means that the lookup
+ * cannot interleave with any modification. Modifications are still
+ * serialized by `fdt_mtx`, but since they may sleep while holding it, they
+ * must never leave the table in a state that's inconsistent from reader's
+ * point of view, i.e.:
+ *  - a file is removed from an entry before it gets dropped,
+ *  - a new array of entries is published before the old one is freed.
+ */
+
 typedef struct fdent {
   file_t *fde_file;
   bool fde_cloexec;
@@ -47,7 +60,7 @@ static void fd_mark_unused(fdtab_t *fdt, int fd) {
 }
 
 static inline bool is_bad_fd(fdtab_t *fdt, int fd) {
-  return (fd < 0 || fd > (int)fdt->fdt_nfiles);
+  return (fd < 0 || fd >= (int)fdt->fdt_nfiles);
 }
 
 void fdtab_hold(fdtab_t *fdt) {
@@ -68,12 +81,13 @@ static void fd_growtable(fdtab_t *fdt, int new_size) {
 
   memcpy(new_fdt_entries, old_fdt_entries, sizeof(fdent_t) * fdt->fdt_nfiles);
   memcpy(new_fdt_map, old_fdt_map, bitstr_size(fdt->fdt_nfiles));
-  kfree(M_FD, old_fdt_entries);
-  kfree(M_FD, old_fdt_map);
 
   fdt->fdt_entries = new_fdt_entries;
   fdt->fdt_map = new_fdt_map;
   fdt->fdt_nfiles = new_size;
+
+  kfree(M_FD, old_fdt_entries);
+  kfree(M_FD, old_fdt_map);
 }
 
 /* Allocates a new file descriptor in a file descriptor table.
@@ -106,11 +120,13 @@ static int fd_alloc(fdtab_t *fdt, int minfd, int *fdp) {
 
 static void fd_free(fdtab_t *fdt, int fd) {
   fdent_t *fde = &fdt->fdt_entries[fd];
-  assert(fde->fde_file != NULL);
-  file_drop(fde->fde_file);
+  file_t *f = fde->fde_file;
+  assert(f != NULL);
   fde->fde_file = NULL;
   fde->fde_cloexec = false;
   fd_mark_unused(fdt, fd);
+  /* Closing the file may sleep, but the entry is not reachable anymore. */
+  file_drop(f);
 }
 
 /* Create empty file descriptor table. */
@@ -124,7 +140,7 @@ fdtab_t *fdtab_create(void) {
   return fdt;
 }
 
-fdtab_t *fdtab_copy(fdtab_t *fdt) {
+fdtab_t *fdtab_copy(fdtab_t *fdt, bool onfork) {
   fdtab_t *newfdt = fdtab_create();
 
   if (fdt == NULL)
@@ -137,17 +153,27 @@ fdtab_t *fdtab_copy(fdtab_t *fdt) {
     fd_growtable(newfdt, fdt->fdt_nfiles);
   }
 
-  for (int i = 0; i < fdt->fdt_nfiles; i++) {
-    if (fd_is_used(fdt, i)) {
-      fdent_t *f = &fdt->fdt_entries[i];
-      newfdt->fdt_entries[i] = *f;
-      file_hold(f->fde_file);
-    }
+  for (int fd = 0; fd < fdt->fdt_nfiles; fd++) {
+    if (!fd_is_used(fdt, fd))
+      continue;
+    fdent_t *fde = &fdt->fdt_entries[fd];
+    /* Kqueues aren't inherited by a child created with fork. */
+    if (onfork && fde->fde_file->f_type == FT_KQUEUE)
+      continue;
+    newfdt->fdt_entries[fd] = *fde;
+    file_hold(fde->fde_file);
+    fd_mark_used(newfdt, fd);
   }
 
-  memcpy(newfdt->fdt_map, fdt->fdt_map,
-         sizeof(bitstr_t) * bitstr_size(fdt->fdt_nfiles));
+  return newfdt;
+}
+
+fdtab_t *fdtab_unshare(fdtab_t *fdt) {
+  if (fdt->fdt_count == 1)
+    return fdt;
 
+  fdtab_t *newfdt = fdtab_copy(fdt, false);
+  fdtab_drop(fdt);
   return newfdt;
 }
 
@@ -213,26 +239,23 @@ int fdtab_get_file(fdtab_t *fdt, int fd, int flags, file_t **fp) {
   if (!fdt)
     return EBADF;
 
-  file_t *f = NULL;
+  file_t *f;
 
-  WITH_MTX_LOCK (&fdt->fdt_mtx) {
-    if (is_bad_fd(fdt, fd) || !fd_is_used(fdt, fd))
+  /* Lockless lookup, see the comment at the top of the file. */
+  WITH_NO_PREEMPTION {
+    if (is_bad_fd(fdt, fd) || !(f = fdt->fdt_entries[fd].fde_file))
       return EBADF;
-
-    f = fdt->fdt_entries[fd].fde_file;
     file_hold(f);
+  }
 
-    if ((flags & FF_READ) && !(f->f_flags & FF_READ))
-      break;
-    if ((flags & FF_WRITE) && !(f->f_flags & FF_WRITE))
-      break;
-
-    *fp = f;
-    return 0;
+  if (((flags & FF_READ) && !(f->f_flags & FF_READ)) ||
+      ((flags & FF_WRITE) && !(f->f_flags & FF_WRITE))) {
+    file_drop(f);
+    return EBADF;
   }
 
-  file_drop(f);
-  return EBADF;
+  *fp = f;
+  return 0;
 }
 
 /* Closes a file descriptor. If it was the last reference to a file, the file is
@@ -276,14 +299,3 @@ int fdtab_onexec(fdtab_t *fdt) {
   return 0;
 }
 
-int fdtab_onfork(fdtab_t *fdt) {
-  int error;
-  for (int fd = 0; fd < fdt->fdt_nfiles; ++fd) {
-    /* Kqueues aren't inherited by a child created with fork. */
-    if (fd_is_used(fdt, fd) &&
-        fdt->fdt_entries[fd].fde_file->f_type == FT_KQUEUE)
-      if ((error = fdtab_close_fd(fdt, fd)))
-        return error;
-  }
-  return 0;
-}
@@ -12,25 +12,36 @@
 #include <sys/mutex.h>
 #include <sys/queue.h>
 
-int do_fork(void (*start)(void *), void *arg, pid_t *cldpidp) {
+int do_fork(void (*start)(void *), void *arg, int flags, pid_t *cldpidp) {
   thread_t *td = thread_self();
   proc_t *parent = td->td_proc;
   vm_map_t *new_map;
   char *name = td->td_name;
+  bool done = false;
   int error = 0;
 
   /* Cannot fork non-user threads. */
   assert(parent);
+  /* Parent must not touch its address space while the child is using it. */
+  assert(!(flags & FORK_SHAREVM) || (flags & FORK_WAIT));
+
+  if (flags & FORK_SHAREVM) {
+    new_map = parent->p_uspace;
+  } else if (start != NULL) {
+    /* The child is going to load a new program before it enters user space,
+     * so there's no point in copying parent's address space. */
+    new_map = vm_map_new();
+  } else {
+    new_map = vm_map_clone(parent->p_uspace);
+    if (!new_map)
+      return ENOMEM;
+  }
 
   if (start == NULL)
     start = (entry_fn_t)user_exc_leave;
-  else
+  else if (parent == &proc0)
     name = "init";
 
-  new_map = vm_map_clone(parent->p_uspace);
-  if (!new_map)
-    return ENOMEM;
-
   /* The new thread will get a new kernel stack. There is no need to copy
    * it from the old one as its contents will get discarded anyway.
    * We just prepare the thread's kernel context to a fresh one so that it will
@@ -69,21 +80,35 @@ int do_fork(void (*start)(void *), void *arg, pid_t *cldpidp) {
     cred_fork(child, parent);
   }
 
-  /* Clone the entire process memory space. */
+  /* Clone the entire process memory space (or borrow parent's one). */
   child->p_uspace = new_map;
 
-  /* Find copied brk segment. */
-  WITH_VM_MAP_LOCK (child->p_uspace) {
-    child->p_sbrk = vm_map_find_entry(child->p_uspace, SBRK_START);
+  if (flags & FORK_SHAREVM) {
+    child->p_flags |= PF_VFORK;
+    child->p_sbrk = parent->p_sbrk;
     child->p_sbrk_end = parent->p_sbrk_end;
+  } else {
+    /* Find copied brk segment. */
+    WITH_VM_MAP_LOCK (child->p_uspace) {
+      child->p_sbrk = vm_map_find_entry(child->p_uspace, SBRK_START);
+      child->p_sbrk_end = parent->p_sbrk_end;
+    }
   }
 
-  /* Copy the parent descriptor table. */
-  /* TODO: Optionally share the descriptor table between processes. */
-  child->p_fdtable = fdtab_copy(parent->p_fdtable);
-
-  /* Close files that aren't inherited via fork .*/
-  fdtab_onfork(child->p_fdtable);
+  if (flags & FORK_WAIT)
+    child->p_vforkdone = &done;
+
+  if (flags & FORK_SHAREFD) {
+    /* Share the parent descriptor table, which takes constant time. */
+    fdtab_hold(parent->p_fdtable);
+    child->p_fdtable = parent->p_fdtable;
+  } else if (flags & FORK_CLEANFD) {
+    child->p_fdtable = fdtab_create();
+  } else {
+    /* Copy the parent descriptor table, except files that aren't inherited
+     * via fork. */
+    child->p_fdtable = fdtab_copy(parent->p_fdtable, true);
+  }
 
   vnode_hold(parent->p_cwd);
   child->p_cwd = parent->p_cwd;
@@ -111,5 +136,13 @@ int do_fork(void (*start)(void *), void *arg, pid_t *cldpidp) {
   /* After this point you cannot access child process without a lock. */
   sched_add(newtd);
 
+  /* Wait until the child calls `proc_vfork_done`. */
+  if (flags & FORK_WAIT) {
+    WITH_PROC_LOCK(parent) {
+      while (!done)
+        cv_wait(&parent->p_waitcv, &parent->p_lock);
+    }
+  }
+
   return error;
 }
@@ -0,0 +1,293 @@
+#define KL_LOG KL_PROC
+#include <sys/klog.h>
+#include <sys/mimiker.h>
+#include <sys/errno.h>
+#include <sys/futex.h>
+#include <sys/hash.h>
+#include <sys/interrupt.h>
+#include <sys/mutex.h>
+#include <sys/proc.h>
+#include <sys/queue.h>
+#include <sys/sleepq.h>
+#include <sys/time.h>
+#include <sys/vm_amap.h>
+#include <sys/vm_map.h>
+
+/*
+ * Futexes are identified by a key which is either:
+ *  - (vm_map, virtual address) for memory private to an address space,
+ *  - (amap, offset) for shared memory, which is the same in every address
+ *    space the memory is mapped into.
+ *
+ * Waiting threads are kept on lists in a hash table indexed by the key.
+ * Each waiter sleeps on its own wait channel (i.e. its `futex_waiter_t`),
+ * hence a requeue operation only needs to move the waiter between lists
+ * without touching the sleep queue the thread is blocked on.
+ */
+
+#define FUTEX_TABLESIZE 64 /* Must be power of 2. */
+#define FUTEX_MASK (FUTEX_TABLESIZE - 1)
+
+typedef struct futex_key {
+  void *fk_object;  /* vm_map or amap */
+  size_t fk_offset; /* virtual address or offset within amap */
+  bool fk_shared;   /* true if `fk_object` is an amap */
+} futex_key_t;
+
+typedef struct futex_bucket futex_bucket_t;
+
+/*! \brief Thread waiting on a futex.
+ *
+ * All fields are protected by `fb_lock` of the bucket `fw_bucket`. */
+typedef struct futex_waiter {
+  TAILQ_ENTRY(futex_waiter) fw_link; /*!< link on bucket's list of waiters */
+  futex_key_t fw_key;                /*!< futex the thread waits on */
+  futex_bucket_t *fw_bucket;         /*!< bucket the waiter is linked on */
+  bool fw_woken;                     /*!< set by the thread that woke us up */
+} futex_waiter_t;
+
+struct futex_bucket {
+  mtx_t fb_lock;
+  TAILQ_HEAD(, futex_waiter) fb_waiters;
+};
+
+static futex_bucket_t futex_table[FUTEX_TABLESIZE];
+
+void init_futex(void) {
+  for (int i = 0; i < FUTEX_TABLESIZE; i++) {
+    futex_bucket_t *fb = &futex_table[i];
+    mtx_init(&fb->fb_lock, 0);
+    TAILQ_INIT(&fb->fb_waiters);
+  }
+}
+
+static int futex_key_get(proc_t *p, int *uaddr, bool private,
+                         futex_key_t *key) {
+  vaddr_t addr = (vaddr_t)uaddr;
+  vm_amap_t *amap = NULL;
+  size_t offset;
+  int error;
+
+  if (addr & (sizeof(int) - 1))
+    return EINVAL;
+
+  if (!private &&
+      (error = vm_map_lookup_shared(p->p_uspace, addr, &amap, &offset)))
+    return error;
+
+  if (amap) {
+    key->fk_object = amap;
+    key->fk_offset = offset;
+    key->fk_shared = true;
+  } else {
+    key->fk_object = p->p_uspace;
+    key->fk_offset = addr;
+    key->fk_shared = false;
+  }
+
+  return 0;
+}
+
+static void futex_key_hold(futex_key_t *key) {
+  if (key->fk_shared)
+    vm_amap_hold(key->fk_object);
+}
+
+static void futex_key_put(futex_key_t *key) {
+  if (key->fk_shared)
+    vm_amap_drop(key->fk_object);
+}
+
+static bool futex_key_equal(futex_key_t *k1, futex_key_t *k2) {
+  return k1->fk_object == k2->fk_object && k1->fk_offset == k2->fk_offset;
+}
+
+static futex_bucket_t *futex_bucket(futex_key_t *key) {
+  uint32_t hash = hash32_buf(&key->fk_object, sizeof(void *), HASH32_BUF_INIT);
+  hash = hash32_buf(&key->fk_offset, sizeof(size_t), hash);
+  return &futex_table[hash & FUTEX_MASK];
+}
+
+/* Waiter may be moved to another bucket while it's not holding a lock,
+ * so look up and lock the bucket until it doesn't change. */
+static futex_bucket_t *futex_waiter_lock(futex_waiter_t *fw) {
+  for (;;) {
+    futex_bucket_t *fb = fw->fw_bucket;
+    mtx_lock(&fb->fb_lock);
+    if (fw->fw_bucket == fb)
+      return fb;
+    mtx_unlock(&fb->fb_lock);
+  }
+}
+
+static void futex_bucket_lock2(futex_bucket_t *fb1, futex_bucket_t *fb2) {
+  if (fb1 == fb2) {
+    mtx_lock(&fb1->fb_lock);
+  } else if (fb1 < fb2) {
+    mtx_lock(&fb1->fb_lock);
+    mtx_lock(&fb2->fb_lock);
+  } else {
+    mtx_lock(&fb2->fb_lock);
+    mtx_lock(&fb1->fb_lock);
+  }
+}
+
+static void futex_bucket_unlock2(futex_bucket_t *fb1, futex_bucket_t *fb2) {
+  mtx_unlock(&fb1->fb_lock);
+  if (fb1 != fb2)
+    mtx_unlock(&fb2->fb_lock);
+}
+
+/* Consumes the reference to `key`. */
+static int futex_wait(futex_key_t *key, int *uaddr, int val,
+                      const timespec_t *tsp) {
+  futex_waiter_t fw = {.fw_key = *key, .fw_bucket = futex_bucket(key)};
+  futex_bucket_t *fb = fw.fw_bucket;
+  systime_t timeout = 0;
+  int error, cval;
+
+  if (tsp) {
+    if (tsp->tv_sec < 0 || tsp->tv_nsec < 0 || tsp->tv_nsec >= 1000000000L) {
+      futex_key_put(key);
+      return EINVAL;
+    }
+    timeout = ts2hz(tsp);
+  }
+
+  mtx_lock(&fb->fb_lock);
+
+  /* The waker changes the futex value before calling FUTEX_WAKE, which has
+   * to take the bucket lock. So if the value is read with the lock held,
+   * then the wakeup cannot be missed. */
+  if ((error = copyin_s(uaddr, cval)))
+    goto leave;
+
+  if (cval != val) {
+    error = EAGAIN;
+    goto leave;
+  }
+
+  /* Zero timeout means we should not block at all. */
+  if (tsp && timeout == 0) {
+    error = ETIMEDOUT;
+    goto leave;
+  }
+
+  TAILQ_INSERT_TAIL(&fb->fb_waiters, &fw, fw_link);
+
+  WITH_INTR_DISABLED {
+    mtx_unlock(&fb->fb_lock);
+    error = sleepq_wait_timed(&fw, __caller(0), NULL, timeout);
+  }
+
+  fb = futex_waiter_lock(&fw);
+
+  /* Woken up by FUTEX_WAKE even if there was a signal or timeout as well. */
+  if (fw.fw_woken)
+    error = 0;
+  else
+    TAILQ_REMOVE(&fb->fb_waiters, &fw, fw_link);
+
+leave:
+  mtx_unlock(&fb->fb_lock);
+  futex_key_put(&fw.fw_key);
+  return error;
+}
+
+static int futex_wake_locked(futex_bucket_t *fb, futex_key_t *key, int n) {
+  assert(mtx_owned(&fb->fb_lock));
+
+  futex_waiter_t *fw, *next;
+  int count = 0;
+
+  TAILQ_FOREACH_SAFE (fw, &fb->fb_waiters, fw_link, next) {
+    if (count >= n)
+      break;
+    if (!futex_key_equal(&fw->fw_key, key))
+      continue;
+    TAILQ_REMOVE(&fb->fb_waiters, fw, fw_link);
+    fw->fw_woken = true;
+    sleepq_signal(fw);
+    count++;
+  }
+
+  return count;
+}
+
+static int futex_wake(futex_key_t *key, int n) {
+  futex_bucket_t *fb = futex_bucket(key);
+  SCOPED_MTX_LOCK(&fb->fb_lock);
+  return futex_wake_locked(fb, key, n);
+}
+
+static int futex_requeue(futex_key_t *key, futex_key_t *key2, int nwake,
+                         int nrequeue) {
+  futex_bucket_t *fb = futex_bucket(key);
+  futex_bucket_t *fb2 = futex_bucket(key2);
+  futex_waiter_t *fw, *next;
+  int count, moved = 0;
+
+  futex_bucket_lock2(fb, fb2);
+
+  count = futex_wake_locked(fb, key, nwake);
+
+  /* Requeueing onto the same futex leaves waiters where they are. Moving them
+   * would append them to the list we're walking, so we'd visit them again. */
+  if (futex_key_equal(key, key2))
+    nrequeue = 0;
+
+  TAILQ_FOREACH_SAFE (fw, &fb->fb_waiters, fw_link, next) {
+    if (moved >= nrequeue)
+      break;
+    if (!futex_key_equal(&fw->fw_key, key))
+      continue;
+    TAILQ_REMOVE(&fb->fb_waiters, fw, fw_link);
+    /* We hold references to both keys, so these cannot be the last ones. */
+    futex_key_hold(key2);
+    futex_key_put(&fw->fw_key);
+    fw->fw_key = *key2;
+    fw->fw_bucket = fb2;
+    TAILQ_INSERT_TAIL(&fb2->fb_waiters, fw, fw_link);
+    moved++;
+  }
+
+  futex_bucket_unlock2(fb, fb2);
+
+  return count;
+}
+
+int do_futex(proc_t *p, int *uaddr, int op, int val, timespec_t *tsp,
+             int *uaddr2, int val2, int *retval) {
+  bool private = op & FUTEX_PRIVATE_FLAG;
+  futex_key_t key, key2;
+  int error;
+
+  *retval = 0;
+
+  op &= FUTEX_CMD_MASK;
+
+  if (op != FUTEX_WAIT && op != FUTEX_WAKE && op != FUTEX_REQUEUE)
+    return ENOSYS;
+
+  if ((error = futex_key_get(p, uaddr, private, &key)))
+    return error;
+
+  switch (op) {
+    case FUTEX_WAIT:
+      return futex_wait(&key, uaddr, val, tsp);
+
+    case FUTEX_WAKE:
+      *retval = futex_wake(&key, val);
+      break;
+
+    case FUTEX_REQUEUE:
+      if ((error = futex_key_get(p, uaddr2, private, &key2)))
+        break;
+      *retval = futex_requeue(&key, &key2, val, val2);
+      futex_key_put(&key2);
+      break;
+  }
+
+  futex_key_put(&key);
+  return error;
+}
@@ -0,0 +1,122 @@
+#include <sys/hrtimer.h>
+#include <sys/interrupt.h>
+#include <sys/klog.h>
+#include <sys/mimiker.h>
+#include <sys/libkern.h>
+#include <sys/mutex.h>
+#include <sys/pcpu.h>
+
+/*
+ * Pending timers are kept in a red-black tree ordered by expiration time, one
+ * for each processor. Timers with equal expiration time are ordered by their
+ * addresses, as the tree doesn't allow duplicate keys.
+ */
+typedef RB_HEAD(hrtimer_tree, hrtimer) hrtimer_tree_t;
+
+typedef struct hrtimer_queue {
+  mtx_t lock;             /* guards fields below and pending timers */
+  hrtimer_tree_t pending; /* timers waiting to expire */
+} hrtimer_queue_t;
+
+static hrtimer_queue_t queues[MAXCPU] = {
+  [0 ... MAXCPU - 1] = {.lock = MTX_INITIALIZER(hrtimer_queue, MTX_SPIN),
+                        .pending = RB_INITIALIZER(&pending)},
+};
+
+static int hrtimer_cmp(hrtimer_t *a, hrtimer_t *b) {
+  if (bintime_cmp(&a->hrt_time, &b->hrt_time, !=))
+    return bintime_cmp(&a->hrt_time, &b->hrt_time, <) ? -1 : 1;
+  if (a != b)
+    return a < b ? -1 : 1;
+  return 0;
+}
+
+RB_GENERATE_STATIC(hrtimer_tree, hrtimer, hrt_link, hrtimer_cmp);
+
+void hrtimer_setup(hrtimer_t *hrt, hrtimer_func_t func, void *arg) {
+  bzero(hrt, sizeof(hrtimer_t));
+  hrt->hrt_func = func;
+  hrt->hrt_arg = arg;
+}
+
+static void hrtimer_remove(hrtimer_queue_t *hq, hrtimer_t *hrt) {
+  assert(mtx_owned(&hq->lock));
+  assert(hrt->hrt_pending);
+
+  RB_REMOVE(hrtimer_tree, &hq->pending, hrt);
+  hrt->hrt_pending = false;
+}
+
+void hrtimer_start(hrtimer_t *hrt, bintime_t when) {
+  hrtimer_queue_t *hq;
+
+  if (hrt->hrt_pending) {
+    hq = &queues[hrt->hrt_cpu];
+    WITH_MTX_LOCK (&hq->lock)
+      if (hrt->hrt_pending)
+        hrtimer_remove(hq, hrt);
+  }
+
+  hrt->hrt_cpu = curcpu;
+  hq = &queues[hrt->hrt_cpu];
+
+  WITH_MTX_LOCK (&hq->lock) {
+    hrt->hrt_time = when;
+    hrt->hrt_pending = true;
+    RB_INSERT(hrtimer_tree, &hq->pending, hrt);
+
+    /* Make sure system clock fires on time if this timer is the first one to
+     * expire. */
+    if (RB_MIN(hrtimer_tree, &hq->pending) == hrt)
+      clock_notify_bintime(when);
+  }
+}
+
+bool hrtimer_stop(hrtimer_t *hrt) {
+  hrtimer_queue_t *hq = &queues[hrt->hrt_cpu];
+
+  SCOPED_MTX_LOCK(&hq->lock);
+
+  if (!hrt->hrt_pending)
+    return false;
+
+  hrtimer_remove(hq, hrt);
+  return true;
+}
+
+/* Dequeues the earliest timer if it expired by `now`. */
+static hrtimer_t *hrtimer_expired(hrtimer_queue_t *hq, bintime_t now) {
+  SCOPED_MTX_LOCK(&hq->lock);
+
+  hrtimer_t *hrt = RB_MIN(hrtimer_tree, &hq->pending);
+  if (hrt == NULL || bintime_cmp(&hrt->hrt_time, &now, >))
+    return NULL;
+
+  hrtimer_remove(hq, hrt);
+  return hrt;
+}
+
+void hrtimer_process(bintime_t now) {
+  hrtimer_queue_t *hq = &queues[curcpu];
+  hrtimer_t *hrt;
+
+  assert(intr_disabled());
+
+  /* The function is called without the lock, so it may start the timer
+   * again. */
+  while ((hrt = hrtimer_expired(hq, now)))
+    hrt->hrt_func(hrt->hrt_arg);
+}
+
+bool hrtimer_next(bintime_t *when) {
+  hrtimer_queue_t *hq = &queues[curcpu];
+
+  SCOPED_MTX_LOCK(&hq->lock);
+
+  hrtimer_t *hrt = RB_MIN(hrtimer_tree, &hq->pending);
+  if (hrt == NULL)
+    return false;
+
+  *when = hrt->hrt_time;
+  return true;
+}
@@ -4,9 +4,11 @@
 #include <sys/malloc.h>
 #include <sys/interrupt.h>
 #include <sys/cpu.h>
+#include <sys/latency.h>
 #include <sys/pcpu.h>
 #include <sys/sleepq.h>
 #include <sys/sched.h>
+#include <sys/sdt.h>
 #include <sys/device.h>
 #include <sys/fdt.h>
 
@@ -24,10 +26,14 @@ static ie_list_t all_ievents_list = TAILQ_HEAD_INITIALIZER(all_ievents_list);
  *
  * IH_DELEGATE: set when ih_service function was delegated to an interrupt
  * thread for execution.
+ *
+ * IH_RUNNING: set while ih_service function is being executed by an interrupt
+ * thread.
  */
 typedef enum {
   IH_REMOVE = 1,
   IH_DELEGATE = 2,
+  IH_RUNNING = 4,
 } ih_flags_t;
 
 typedef struct intr_handler {
@@ -38,8 +44,15 @@ typedef struct intr_handler {
   void *ih_argument;        /* argument to pass to filter/service routines */
   const char *ih_name;      /* name of the handler */
   ih_flags_t ih_flags;      /* refer to IH_* flags description above */
+  prio_t ih_prio;           /* priority of the service routine */
 } intr_handler_t;
 
+/* Maximum number of times an interrupt thread may be woken up within a second
+ * before the interrupt event is considered to be storming. */
+#define INTR_STORM_THRESHOLD 1000
+
+unsigned intr_storm_threshold = INTR_STORM_THRESHOLD;
+
 static void intr_thread(void *arg);
 
 __no_profile bool intr_disabled(void) {
@@ -47,19 +60,31 @@ __no_profile bool intr_disabled(void) {
   return (td->td_idnest > 0) && cpu_intr_disabled();
 }
 
-__no_profile void intr_disable(void) {
+__no_profile void _intr_disable(const void *pc) {
   cpu_intr_disable();
-  thread_self()->td_idnest++;
+  thread_t *td = thread_self();
+  if (td->td_idnest++ == 0 && lat_active())
+    lat_section_begin(LAT_IRQSOFF, pc);
 }
 
-void intr_enable(void) {
+void _intr_enable(const void *pc) {
   assert(intr_disabled());
   thread_t *td = thread_self();
+  if (td->td_idnest == 1 && lat_active())
+    lat_section_end(LAT_IRQSOFF, pc);
   td->td_idnest--;
   if (td->td_idnest == 0)
     cpu_intr_enable();
 }
 
+__no_profile void intr_disable(void) {
+  _intr_disable(__caller(0));
+}
+
+void intr_enable(void) {
+  _intr_enable(__caller(0));
+}
+
 intr_event_t *intr_event_create(void *source, int irq, ie_action_t *disable,
                                 ie_action_t *enable, const char *name) {
   intr_event_t *ie = kmalloc(M_INTR, sizeof(intr_event_t), M_WAITOK | M_ZERO);
@@ -68,10 +93,12 @@ intr_event_t *intr_event_create(void *source, int irq, ie_action_t *disable,
   ie->ie_enable = enable;
   ie->ie_disable = disable;
   ie->ie_source = source;
+  ie->ie_prio = PI_DULL;
   ie->ie_ithread = NULL;
   TAILQ_INIT(&ie->ie_handlers);
 
   strlcpy(ie->ie_name, name, IENAMELEN);
+  evcnt_attach(&ie->ie_evcnt, "intr", ie->ie_name);
 
   WITH_MTX_LOCK (&all_ievents_mtx)
     TAILQ_INSERT_TAIL(&all_ievents_list, ie, ie_link);
@@ -109,10 +136,36 @@ static void intr_thread_maybe_attach(intr_event_t *ie, intr_handler_t *ih) {
     ie->ie_ithread = (thread_t *)1L;
   }
 
-  ie->ie_ithread = thread_create(ie->ie_name, intr_thread, ie, prio_ithread(0));
+  ie->ie_ithread = thread_create(ie->ie_name, intr_thread, ie, ie->ie_prio);
   sched_add(ie->ie_ithread);
 }
 
+void intr_setup_service(resource_t *r, prio_t prio, unsigned flags) {
+  assert(r->r_type == RT_IRQ);
+  assert(r->r_handler);
+
+  intr_handler_t *ih = r->r_handler;
+  intr_event_t *ie = ih->ih_event;
+  thread_t *td = ie->ie_ithread;
+  assert(ih->ih_service);
+
+  WITH_MTX_LOCK (&ie->ie_lock) {
+    ih->ih_prio = prio;
+    ie->ie_flags |= flags;
+
+    /* The interrupt thread serves the most urgent of the handlers. */
+    prio = PI_DULL;
+    intr_handler_t *it;
+    TAILQ_FOREACH (it, &ie->ie_handlers, ih_link)
+      if (it->ih_service && prio_gt(it->ih_prio, prio))
+        prio = it->ih_prio;
+    ie->ie_prio = prio;
+  }
+
+  WITH_MTX_LOCK (td->td_lock)
+    sched_set_prio(td, prio);
+}
+
 intr_handler_t *intr_event_add_handler(intr_event_t *ie, ih_filter_t *filter,
                                        ih_service_t *service, void *arg,
                                        const char *name) {
@@ -124,6 +177,7 @@ intr_handler_t *intr_event_add_handler(intr_event_t *ie, ih_filter_t *filter,
   ih->ih_argument = arg;
   ih->ih_name = name;
   ih->ih_flags = 0;
+  ih->ih_prio = PI_DULL;
   intr_event_insert_handler(ie, ih);
   intr_thread_maybe_attach(ie, ih);
   return ih;
@@ -132,7 +186,7 @@ intr_handler_t *intr_event_add_handler(intr_event_t *ie, ih_filter_t *filter,
 void intr_event_remove_handler(intr_handler_t *ih) {
   intr_event_t *ie = ih->ih_event;
   WITH_MTX_LOCK (&ie->ie_lock) {
-    if (ih->ih_flags & IH_DELEGATE) {
+    if (ih->ih_flags & (IH_DELEGATE | IH_RUNNING)) {
       ih->ih_flags |= IH_REMOVE;
       return;
     }
@@ -165,6 +219,9 @@ __no_profile void intr_root_handler(ctx_t *ctx) {
    * routines to accidentaly enable interrupts. */
   td->td_idnest++;
 
+  if (lat_active())
+    lat_section_begin(LAT_IRQSOFF, intr_root_handler);
+
   /* Explicitely disallow switching out to another thread. */
   PCPU_SET(no_switch, true);
   if (ir_filter != NULL)
@@ -179,20 +236,27 @@ __no_profile void intr_root_handler(ctx_t *ctx) {
    * If we came from user mode, then we need to configure the context
    * to perform signal processing, which can be interrupted and that's ok. */
   if (user_mode_p(ctx)) {
-    intr_enable();
+    _intr_enable(intr_root_handler);
     sig_userret((mcontext_t *)ctx, NULL);
     return;
   }
 
+  if (lat_active())
+    lat_section_end(LAT_IRQSOFF, intr_root_handler);
   td->td_idnest--;
 }
 
+SDT_PROBE_DEFINE(intr, dispatch, "irq, event");
+
 void intr_event_run_handlers(intr_event_t *ie) {
   intr_handler_t *ih, *next;
 
   assert(intr_disabled());
   assert(ie != NULL);
 
+  SDT_PROBE(intr, dispatch, ie->ie_irq, ie);
+  evcnt_inc(&ie->ie_evcnt);
+
   /* Do we wake up an ithread */
   intr_filter_t ie_status = IF_STRAY;
 
@@ -203,13 +267,19 @@ void intr_event_run_handlers(intr_event_t *ie) {
 
     if (status == IF_DELEGATE) {
       assert(ih->ih_service);
-      ih->ih_flags = IH_DELEGATE;
+      ih->ih_flags |= IH_DELEGATE;
     }
   }
 
   if (ie_status & IF_DELEGATE) {
-    ie_disable(ie);
-    sleepq_signal(ie);
+    if (!(ie->ie_flags & INTR_COALESCE))
+      ie_disable(ie);
+    /* If the interrupt thread hasn't picked up previous delegation yet,
+     * it will run service routines for this one as well. */
+    if (!ie->ie_pending) {
+      ie->ie_pending = true;
+      sleepq_signal(ie);
+    }
   }
 
   if (ie_status == IF_STRAY)
@@ -247,35 +317,65 @@ int pic_map_intr(device_t *dev, fdt_intr_t *intr) {
 static void intr_thread(void *arg) {
   intr_event_t *ie = (intr_event_t *)arg;
 
-  /* When we enter intr_thread `ie`-specific interrupt may not have been
-   * disabled, but we execute the loop with that assumption. Fix that. */
-  ie_disable(ie);
-
   while (true) {
     intr_handler_t *ih, *ih_next;
 
-    /* The interrupt associated with `ie` was disabled by
-     * `intr_event_run_handlers`, so it's safe to use `ie` now. */
+    /* Wait for delegation of service routines. Unless they're coalesced, the
+     * interrupt has been disabled by `intr_event_run_handlers`, so enable it
+     * first if there are still handlers assigned to the interrupt event. */
+    WITH_MTX_LOCK (&ie->ie_lock) {
+      while (!ie->ie_pending) {
+        if (!(ie->ie_flags & INTR_COALESCE) && !TAILQ_EMPTY(&ie->ie_handlers))
+          ie_enable(ie);
+        sleepq_wait(ie, NULL, &ie->ie_lock);
+      }
+      ie->ie_pending = false;
+    }
+
+    /* A device that keeps interrupting would starve lower priority threads.
+     * Throttle it by pausing till the end of current one second window. In the
+     * meantime its interrupt stays disabled, or further delegations are
+     * coalesced. */
+    systime_t now = getsystime();
+    if (now - ie->ie_window >= CLK_TCK) {
+      ie->ie_storming =
+        ie->ie_storming && ie->ie_wakeups > intr_storm_threshold;
+      ie->ie_window = now;
+      ie->ie_wakeups = 0;
+    }
+    if (++ie->ie_wakeups > intr_storm_threshold) {
+      if (!ie->ie_storming)
+        klog("Interrupt storm detected on %s, throttling!", ie->ie_name);
+      ie->ie_storming = true;
+      sleepq_wait_timed(&ie->ie_window, NULL, NULL,
+                        ie->ie_window + CLK_TCK - now);
+    }
+
     TAILQ_FOREACH_SAFE (ih, &ie->ie_handlers, ih_link, ih_next) {
-      if (ih->ih_flags & IH_DELEGATE) {
-        ih->ih_service(ih->ih_argument);
-        ih->ih_flags &= ~IH_DELEGATE;
+      bool delegated, removed;
+
+      /* Clear the flag before running the service routine, so that a
+       * coalesced delegation arriving in the meantime isn't lost. */
+      WITH_MTX_LOCK (&ie->ie_lock) {
+        delegated = ih->ih_flags & IH_DELEGATE;
+        if (delegated)
+          ih->ih_flags ^= IH_DELEGATE | IH_RUNNING;
+      }
 
-        if (ih->ih_flags & IH_REMOVE) {
+      if (!delegated)
+        continue;
+
+      ih->ih_service(ih->ih_argument);
+
+      WITH_MTX_LOCK (&ie->ie_lock) {
+        ih->ih_flags &= ~IH_RUNNING;
+        removed = ih->ih_flags & IH_REMOVE;
+        if (removed)
           TAILQ_REMOVE(&ie->ie_handlers, ih, ih_link);
-          kfree(M_INTR, ih);
-        }
       }
-    }
-
-    /* If there are still handlers assigned to the interrupt event, enable
-     * interrupts and wait for a wakeup. We do it with interrupts disabled
-     * to prevent the wakeup from being lost. */
-    WITH_INTR_DISABLED {
-      if (!TAILQ_EMPTY(&ie->ie_handlers))
-        ie_enable(ie);
 
-      sleepq_wait(ie, NULL, NULL);
+      if (removed)
+        kfree(M_INTR, ih);
     }
   }
 }
@@ -1,17 +1,37 @@
-#include <sys/mutex.h>
+#include <sys/devfs.h>
+#include <sys/errno.h>
+#include <sys/fcntl.h>
 #include <sys/kenv.h>
 #include <sys/time.h>
 #include <sys/libkern.h>
+#include <sys/linker_set.h>
+#include <sys/pcpu.h>
+#include <sys/sched.h>
 #include <sys/thread.h>
 #include <sys/klog.h>
 #include <sys/ktest.h>
 #include <sys/interrupt.h>
+#include <sys/uio.h>
+#include <stdatomic.h>
 
-#define KL_SIZE 1024
+/*
+ * Messages are stored in per-CPU rings of fixed-size entries. A writer
+ * reserves an entry by atomically incrementing ring's head, fills it in and
+ * publishes it by storing its sequence number. Interrupt handlers can thus log
+ * messages while the interrupted thread is in the middle of writing its own.
+ *
+ * The reader checks the sequence number before and after copying the entry
+ * out, so it never returns an entry that was overwritten in the meantime.
+ * If writers lap the reader, the oldest messages are lost. Entries from all
+ * rings are merged by their timestamps.
+ */
+
+#define KL_SIZE 1024 /* entries in each ring, must be a power of 2 */
 
 typedef struct klog_entry {
-  bintime_t kl_timestamp;
+  atomic_uint kl_seq; /* index of the entry plus one or 0 if being written */
   tid_t kl_tid;
+  bintime_t kl_timestamp;
   unsigned kl_line;
   const char *kl_file;
   klog_origin_t kl_origin;
@@ -19,42 +39,28 @@ typedef struct klog_entry {
   uintptr_t kl_params[6];
 } klog_entry_t;
 
-typedef struct klog {
+typedef struct klog_ring {
   klog_entry_t array[KL_SIZE];
+  atomic_uint head; /* number of entries reserved by writers */
+  unsigned tail;    /* number of entries consumed by the reader */
+} klog_ring_t;
+
+typedef struct klog {
+  klog_ring_t ring[MAXCPU];
   atomic_uint mask;
-  volatile unsigned first;
-  volatile unsigned last;
-  bool repeated;
-  int prev;
 } klog_t;
 
 static klog_t klog = (klog_t){
   .mask = KL_DEFAULT_MASK,
-  .prev = -1,
 };
 
-static MTX_DEFINE(klog_lock, MTX_SPIN);
-
-static const char *subsystems[] = {
-  [KL_SLEEPQ] = "sleepq",   [KL_CALLOUT] = "callout", [KL_INIT] = "init",
-  [KL_PMAP] = "pmap",       [KL_VM] = "vm",           [KL_KMEM] = "kmem",
-  [KL_VMEM] = "vmem",       [KL_LOCK] = "lock",       [KL_SCHED] = "sched",
-  [KL_THREAD] = "thread",   [KL_INTR] = "intr",       [KL_DEV] = "dev",
-  [KL_VFS] = "vfs",         [KL_PROC] = "proc",       [KL_SYSCALL] = "syscall",
-  [KL_USER] = "user",       [KL_TEST] = "test",       [KL_SIGNAL] = "signal",
-  [KL_FILESYS] = "filesys", [KL_TIME] = "time",       [KL_FILE] = "file",
-  [KL_TTY] = "tty",         [KL_UNDEF] = "???",
-};
+static const char *subsystems[] = KL_ORIGIN_NAMES;
 
 void init_klog(void) {
   const char *mask = kenv_get("klog-mask");
   klog.mask = mask ? (unsigned)strtol(mask, NULL, 16) : KL_DEFAULT_MASK;
 }
 
-static inline unsigned next(unsigned i) {
-  return (i + 1) % KL_SIZE;
-}
-
 static void klog_entry_dump(klog_entry_t *entry) {
   if (entry->kl_origin == KL_UNDEF)
     kprintf("[%s:%d] ", entry->kl_file, entry->kl_line);
@@ -66,71 +72,41 @@ static void klog_entry_dump(klog_entry_t *entry) {
   kprintf("\n");
 }
 
-static void klog_entry_add(klog_entry_t *newentry) {
-  klog_entry_t *entry = &klog.array[klog.last];
-  memcpy(entry, newentry, sizeof(klog_entry_t));
-
-  klog.prev = klog.last;
-  klog.last = next(klog.last);
-  if (klog.first == klog.last)
-    klog.first = next(klog.first);
-}
-
 void klog_append(klog_origin_t origin, const char *file, unsigned line,
                  const char *format, uintptr_t arg1, uintptr_t arg2,
                  uintptr_t arg3, uintptr_t arg4, uintptr_t arg5,
                  uintptr_t arg6) {
-  if (!(KL_MASK(origin) & atomic_load(&klog.mask)))
+  if (!(KL_MASK(origin) & atomic_load_explicit(&klog.mask,
+                                               memory_order_relaxed)))
     return;
 
-  tid_t tid = thread_self()->td_tid;
-
-  WITH_MTX_LOCK (&klog_lock) {
-    bintime_t now = binuptime();
-
-    /* Do not store repeating log messages, just count them. */
-    if (klog.prev >= 0) {
-      klog_entry_t *prev = &klog.array[klog.prev];
-
-      bool repeats =
-        (prev->kl_params[0] == arg1) && (prev->kl_params[1] == arg2) &&
-        (prev->kl_params[2] == arg3) && (prev->kl_params[3] == arg4) &&
-        (prev->kl_params[4] == arg5) && (prev->kl_params[5] == arg6) &&
-        (prev->kl_origin == origin) && (prev->kl_file == file) &&
-        (prev->kl_line == line) && (prev->kl_tid = tid);
-
-      if (repeats) {
-        if (!klog.repeated) {
-          int old_prev = klog.prev;
-          klog_entry_add(
-            &(klog_entry_t){.kl_timestamp = now,
-                            .kl_tid = prev->kl_tid,
-                            .kl_line = prev->kl_line,
-                            .kl_file = prev->kl_file,
-                            .kl_origin = prev->kl_origin,
-                            .kl_format = "Last message repeated %d times.",
-                            .kl_params = {0, 0, 0, 0, 0, 0}});
-          klog.prev = old_prev;
-          klog.repeated = true;
-        }
-
-        prev = &klog.array[next(klog.prev)];
-        prev->kl_timestamp = now;
-        prev->kl_params[0]++;
-        return;
-      }
-
-      klog.repeated = false;
-    }
+  thread_t *td = thread_self();
+
+  /* Keep the window between reservation and publication short, and make sure
+   * we stay on the same CPU. */
+  WITH_NO_PREEMPTION {
+    klog_ring_t *ring = &klog.ring[curcpu];
+    unsigned seq =
+      atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+    klog_entry_t *entry = &ring->array[seq & (KL_SIZE - 1)];
 
-    klog_entry_add(
-      &(klog_entry_t){.kl_timestamp = now,
-                      .kl_tid = tid,
-                      .kl_line = line,
-                      .kl_file = file,
-                      .kl_origin = origin,
-                      .kl_format = format,
-                      .kl_params = {arg1, arg2, arg3, arg4, arg5, arg6}});
+    atomic_store_explicit(&entry->kl_seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    entry->kl_tid = td->td_tid;
+    entry->kl_timestamp = binuptime();
+    entry->kl_line = line;
+    entry->kl_file = file;
+    entry->kl_origin = origin;
+    entry->kl_format = format;
+    entry->kl_params[0] = arg1;
+    entry->kl_params[1] = arg2;
+    entry->kl_params[2] = arg3;
+    entry->kl_params[3] = arg4;
+    entry->kl_params[4] = arg5;
+    entry->kl_params[5] = arg6;
+
+    atomic_store_explicit(&entry->kl_seq, seq + 1, memory_order_release);
   }
 }
 
@@ -138,23 +114,187 @@ unsigned klog_setmask(unsigned newmask) {
   return atomic_exchange(&klog.mask, newmask);
 }
 
+/* Copies out the oldest unread entry of the ring without consuming it. */
+static bool klog_ring_peek(klog_ring_t *ring, klog_entry_t *entry) {
+  for (;;) {
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (ring->tail == head)
+      return false;
+
+    /* Writers have lapped us, so skip entries that were overwritten. */
+    if (head - ring->tail > KL_SIZE)
+      ring->tail = head - KL_SIZE;
+
+    klog_entry_t *src = &ring->array[ring->tail & (KL_SIZE - 1)];
+    unsigned seq = atomic_load_explicit(&src->kl_seq, memory_order_acquire);
+    int diff = (int)(seq - (ring->tail + 1));
+
+    /* The entry is being written, so it's not visible to the reader yet. */
+    if (seq == 0 || diff < 0)
+      return false;
+
+    /* The entry has already been reused by a writer. */
+    if (diff > 0) {
+      ring->tail++;
+      continue;
+    }
+
+    entry->kl_tid = src->kl_tid;
+    entry->kl_timestamp = src->kl_timestamp;
+    entry->kl_line = src->kl_line;
+    entry->kl_file = src->kl_file;
+    entry->kl_origin = src->kl_origin;
+    entry->kl_format = src->kl_format;
+    memcpy(entry->kl_params, src->kl_params, sizeof(entry->kl_params));
+
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&src->kl_seq, memory_order_relaxed) == seq)
+      return true;
+  }
+}
+
+/* Finds the oldest unread entry among all rings. Returns the ring it belongs
+ * to, so the caller can consume the entry by advancing ring's tail. */
+static klog_ring_t *klog_peek(klog_entry_t *entry) {
+  klog_ring_t *oldest = NULL;
+  klog_entry_t candidate;
+
+  for (unsigned i = 0; i < MAXCPU; i++) {
+    klog_ring_t *ring = &klog.ring[i];
+    if (!klog_ring_peek(ring, &candidate))
+      continue;
+    if (oldest == NULL ||
+        bintime_cmp(&candidate.kl_timestamp, &entry->kl_timestamp, <)) {
+      memcpy(entry, &candidate, sizeof(klog_entry_t));
+      oldest = ring;
+    }
+  }
+
+  return oldest;
+}
+
+static bool klog_entry_repeats(klog_entry_t *prev, klog_entry_t *entry) {
+  return prev->kl_tid == entry->kl_tid && prev->kl_file == entry->kl_file &&
+         prev->kl_line == entry->kl_line &&
+         prev->kl_origin == entry->kl_origin &&
+         !memcmp(prev->kl_params, entry->kl_params, sizeof(prev->kl_params));
+}
+
 void klog_dump(void) {
-  klog_entry_t entry;
+  klog_entry_t prev, entry;
+  klog_ring_t *ring;
+  bool first = true;
+  int repeated = 0;
 
-  while (klog.first != klog.last) {
-    WITH_MTX_LOCK (&klog_lock) {
-      entry = klog.array[klog.first];
-      klog.first = next(klog.first);
+  /* Repeating messages are detected here rather than when they're logged,
+   * so that writers don't have to synchronize with each other. */
+  while ((ring = klog_peek(&entry))) {
+    ring->tail++;
+    if (!first && klog_entry_repeats(&prev, &entry)) {
+      repeated++;
+      continue;
     }
+    if (repeated > 0)
+      kprintf("Last message repeated %d times.\n", repeated);
     klog_entry_dump(&entry);
+    memcpy(&prev, &entry, sizeof(klog_entry_t));
+    first = false;
+    repeated = 0;
   }
+
+  if (repeated > 0)
+    kprintf("Last message repeated %d times.\n", repeated);
 }
 
 void klog_clear(void) {
-  klog.first = 0;
-  klog.last = 0;
+  for (unsigned i = 0; i < MAXCPU; i++) {
+    klog_ring_t *ring = &klog.ring[i];
+    ring->tail = atomic_load(&ring->head);
+  }
 }
 
+/* Longest file name or format string passed to user space. */
+#define KL_STRMAX 128
+#define KL_RECMAX (sizeof(klog_record_t) + 2 * KL_STRMAX)
+
+static atomic_int dev_klog_usecnt;
+
+/* Returns number of bytes used by the copy including terminating NUL. */
+static size_t klog_strcpy(char *dst, const char *src) {
+  size_t len = strlcpy(dst, src, KL_STRMAX);
+  return min(len + 1, (size_t)KL_STRMAX);
+}
+
+static size_t klog_record_fill(klog_record_t *rec, klog_entry_t *entry) {
+  char *str = (char *)(rec + 1);
+  size_t filelen = klog_strcpy(str, entry->kl_file);
+  size_t fmtlen = klog_strcpy(str + filelen, entry->kl_format);
+
+  rec->kr_timestamp = entry->kl_timestamp;
+  memcpy(rec->kr_params, entry->kl_params, sizeof(rec->kr_params));
+  rec->kr_tid = entry->kl_tid;
+  rec->kr_line = entry->kl_line;
+  rec->kr_origin = entry->kl_origin;
+  rec->kr_size =
+    roundup(sizeof(klog_record_t) + filelen + fmtlen, alignof(klog_record_t));
+  return rec->kr_size;
+}
+
+static int dev_klog_read(devnode_t *dev, uio_t *uio) {
+  uint8_t buf[KL_RECMAX] __aligned(alignof(klog_record_t));
+  klog_record_t *rec = (klog_record_t *)buf;
+  klog_entry_t entry;
+  klog_ring_t *ring;
+  size_t resid = uio->uio_resid;
+  int error = 0;
+
+  /* Only whole records are returned. */
+  while ((ring = klog_peek(&entry))) {
+    size_t size = klog_record_fill(rec, &entry);
+    if (uio->uio_resid < size) {
+      if (uio->uio_resid == resid)
+        error = EINVAL;
+      break;
+    }
+    if ((error = uiomove(rec, size, uio)))
+      break;
+    ring->tail++;
+  }
+
+  return error;
+}
+
+static int dev_klog_open(devnode_t *dev, file_t *fp, int oflags) {
+  if ((oflags & O_ACCMODE) != O_RDONLY)
+    return EACCES;
+
+  /* Reading consumes messages, so there can be only one reader. */
+  int expected = 0;
+  if (!atomic_compare_exchange_strong(&dev_klog_usecnt, &expected, 1))
+    return EBUSY;
+
+  return 0;
+}
+
+static int dev_klog_close(devnode_t *dev, file_t *fp) {
+  atomic_store(&dev_klog_usecnt, 0);
+  return 0;
+}
+
+static devops_t dev_klog_ops = {
+  .d_type = DT_OTHER,
+  .d_open = dev_klog_open,
+  .d_close = dev_klog_close,
+  .d_read = dev_klog_read,
+};
+
+static void init_dev_klog(void) {
+  devfs_makedev_new(NULL, "klog", &dev_klog_ops, NULL, NULL);
+}
+
+SET_ENTRY(devfs_init, init_dev_klog);
+
 /*
  * @brief Permanently lock the kernel.
  *
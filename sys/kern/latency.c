@@ -0,0 +1,165 @@
+#include <sys/cpu.h>
+#include <sys/devfs.h>
+#include <sys/errno.h>
+#include <sys/latency.h>
+#include <sys/libkern.h>
+#include <sys/linker_set.h>
+#include <sys/pcpu.h>
+#include <sys/thread.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+
+/*
+ * The tracer is called from `intr_disable` and `preempt_disable`, so it must
+ * not use them itself, otherwise it would measure its own sections. Hence
+ * tables are guarded by disabling interrupts directly on the processor, which
+ * is enough as long as the kernel is uniprocessor.
+ *
+ * `binuptime` may call `intr_disable` as well. Preemption-off sections usually
+ * begin and end with interrupts enabled, so its calls would open and close
+ * a bogus interrupts-off section. Hence the tracer does its work between
+ * `lat_enter` and `lat_leave`, which make such calls nested.
+ */
+
+typedef struct lat_section {
+  bintime_t start;      /* zero if there's no open section */
+  const void *start_pc; /* where the section was opened */
+} lat_section_t;
+
+atomic_int lat_enabled;
+
+static lat_section_t lat_open[MAXCPU][LAT_NTYPES];
+static latency_record_t lat_worst[LAT_NTYPES][LAT_NWORST];
+
+/* Disables interrupts unless they're disabled already and raises `td_idnest`,
+ * so that `intr_disable` and `intr_enable` calls don't reach the tracer.
+ * Returns whether interrupts were disabled before. */
+static __no_profile bool lat_enter(void) {
+  bool disabled = cpu_intr_disabled();
+  if (!disabled)
+    cpu_intr_disable();
+  thread_self()->td_idnest++;
+  return disabled;
+}
+
+static __no_profile void lat_leave(bool disabled) {
+  thread_self()->td_idnest--;
+  if (!disabled)
+    cpu_intr_enable();
+}
+
+/* Must be called between `lat_enter` and `lat_leave`. */
+static void lat_record(lat_type_t type, const void *start_pc,
+                       const void *end_pc, uint64_t duration) {
+  latency_record_t *worst = lat_worst[type];
+  latency_record_t *lr = NULL;
+
+  /* Find entry for the same pair of places or the shortest one to replace. */
+  for (int i = 0; i < LAT_NWORST; i++) {
+    latency_record_t *r = &worst[i];
+    if (r->lr_start_pc == (uintptr_t)start_pc &&
+        r->lr_end_pc == (uintptr_t)end_pc) {
+      lr = r;
+      break;
+    }
+    if (lr == NULL || r->lr_max < lr->lr_max)
+      lr = r;
+  }
+
+  if (lr->lr_start_pc != (uintptr_t)start_pc ||
+      lr->lr_end_pc != (uintptr_t)end_pc) {
+    if (lr->lr_count && lr->lr_max >= duration)
+      return;
+    *lr = (latency_record_t){.lr_type = type,
+                             .lr_start_pc = (uintptr_t)start_pc,
+                             .lr_end_pc = (uintptr_t)end_pc};
+  }
+
+  lr->lr_count++;
+  if (duration > lr->lr_max) {
+    lr->lr_max = duration;
+    lr->lr_tid = thread_self()->td_tid;
+  }
+}
+
+void lat_section_begin(lat_type_t type, const void *pc) {
+  bool disabled = lat_enter();
+  lat_section_t *ls = &lat_open[curcpu][type];
+  ls->start = binuptime();
+  ls->start_pc = pc;
+  lat_leave(disabled);
+}
+
+void lat_section_end(lat_type_t type, const void *pc) {
+  bool disabled = lat_enter();
+  lat_section_t *ls = &lat_open[curcpu][type];
+
+  /* The section might have been opened before the tracer was enabled. */
+  if (bintime_isset(&ls->start)) {
+    bintime_t now = binuptime();
+    bintime_sub(&now, &ls->start);
+    ls->start = BINTIME(0);
+    lat_record(type, ls->start_pc, pc, bt2ns(&now));
+  }
+
+  lat_leave(disabled);
+}
+
+void lat_switch(thread_t *newtd) {
+  lat_section_t *open = lat_open[curcpu];
+
+  /* Preemption is disabled per thread, so the section is over. */
+  open[LAT_PREEMPTOFF].start = BINTIME(0);
+
+  /* A thread that has never run enters its code with interrupts enabled. */
+  if (newtd->td_idnest == 0)
+    open[LAT_IRQSOFF].start = BINTIME(0);
+}
+
+static int latency_read(devnode_t *dev, uio_t *uio) {
+  latency_record_t worst[LAT_NTYPES][LAT_NWORST];
+
+  cpu_intr_disable();
+  memcpy(worst, lat_worst, sizeof(worst));
+  cpu_intr_enable();
+
+  return uiomove_frombuf(worst, sizeof(worst), uio);
+}
+
+static void latency_reset(void) {
+  cpu_intr_disable();
+  bzero(lat_worst, sizeof(lat_worst));
+  cpu_intr_enable();
+}
+
+static int latency_ioctl(devnode_t *dev, u_long cmd, void *data, int fflags) {
+  if (cmd == LATIOCGSTATE) {
+    *(int *)data = atomic_load(&lat_enabled);
+    return 0;
+  }
+  if (cmd == LATIOCSSTATE) {
+    /* Sections opened before the tracer was enabled are unknown. */
+    cpu_intr_disable();
+    bzero(lat_open, sizeof(lat_open));
+    atomic_store(&lat_enabled, *(int *)data != 0);
+    cpu_intr_enable();
+    return 0;
+  }
+  if (cmd == LATIOCRESET) {
+    latency_reset();
+    return 0;
+  }
+  return EINVAL;
+}
+
+static devops_t latency_devops = {
+  .d_type = DT_SEEKABLE,
+  .d_read = latency_read,
+  .d_ioctl = latency_ioctl,
+};
+
+static void init_dev_latency(void) {
+  devfs_makedev_new(NULL, "latency", &latency_devops, NULL, NULL);
+}
+
+SET_ENTRY(devfs_init, init_dev_latency);
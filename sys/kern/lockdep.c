@@ -45,9 +45,8 @@ static_assert(
 
 static SIMPLEQ_HEAD(, lock_class) lock_hashtbl[CLASSHASH_SIZE];
 
-#define MAX_CLASSES 64
-static lock_class_t lock_classes[MAX_CLASSES];
-static int class_cnt = 0;
+static lock_class_t lock_classes[LOCKDEP_MAX_CLASSES];
+static atomic_int class_cnt = 0;
 
 #define MAX_EDGES 256
 static lock_class_edge_t lock_edges[MAX_EDGES];
@@ -161,15 +160,19 @@ static lock_class_t *look_up_lock_class(lock_class_mapping_t *lock) {
 }
 
 static lock_class_t *alloc_class(lock_class_key_t *key, const char *name) {
-  if (class_cnt >= MAX_CLASSES)
+  if (class_cnt >= LOCKDEP_MAX_CLASSES)
     panic("lockdep: no more classes");
 
-  lock_class_t *class = &lock_classes[class_cnt++];
+  lock_class_t *class = &lock_classes[class_cnt];
   class->key = key;
   class->name = name;
   SIMPLEQ_INIT(&class->locked_after);
   class->bfs_gen_id = 0;
 
+  /* Publish the class only after it has been filled in, since readers of
+   * `lockdep_class_name` don't take `main_lock`. */
+  atomic_store_explicit(&class_cnt, class_cnt + 1, memory_order_release);
+
   return class;
 }
 
@@ -287,3 +290,17 @@ void lockdep_release(lock_class_mapping_t *lock) {
 
   lockdep_unlock();
 }
+
+int lockdep_class_count(void) {
+  return atomic_load_explicit(&class_cnt, memory_order_acquire);
+}
+
+int lockdep_class_index(lock_class_mapping_t *lock) {
+  lock_class_t *class = lock->lock_class;
+  return class ? class - lock_classes : -1;
+}
+
+const char *lockdep_class_name(int idx) {
+  assert(idx >= 0 && idx < lockdep_class_count());
+  return lock_classes[idx].name;
+}
@@ -0,0 +1,147 @@
+#include <sys/devfs.h>
+#include <sys/errno.h>
+#include <sys/libkern.h>
+#include <sys/linker_set.h>
+#include <sys/lockstat.h>
+#include <sys/mutex.h>
+#include <sys/uio.h>
+
+/*
+ * Statistics of all locks that belong to the same lock class are gathered in
+ * a single entry, so for instance all proc_t::p_lock instances are accounted
+ * together. Entries are indexed with lockdep class numbers. Each entry keeps
+ * a few call sites that waited for the lock longest. When there's no room
+ * for a new site, the one with the shortest total wait is replaced, hence
+ * the list is only an approximation of the real top contenders.
+ *
+ * `lockstat_lock` is not visible to lockdep, hence it doesn't recurse into
+ * lockstat either.
+ */
+
+atomic_int lockstat_enabled;
+
+static MTX_DEFINE(lockstat_lock, MTX_SPIN | MTX_NODEBUG);
+static lockstat_record_t lockstat[LOCKDEP_MAX_CLASSES];
+
+static uint64_t elapsed_ns(const bintime_t *since, const bintime_t *now) {
+  bintime_t bt = *now;
+  bintime_sub(&bt, (bintime_t *)since);
+  return bt2ns(&bt);
+}
+
+static void lockstat_add_site(lockstat_record_t *lr, const void *waitpt,
+                              uint64_t wait) {
+  lockstat_site_t *site = NULL;
+
+  for (int i = 0; i < LOCKSTAT_NSITES; i++) {
+    lockstat_site_t *ls = &lr->lr_sites[i];
+    if (ls->ls_waitpt == (uintptr_t)waitpt) {
+      site = ls;
+      break;
+    }
+    if (site == NULL || ls->ls_wait < site->ls_wait)
+      site = ls;
+  }
+
+  if (site->ls_waitpt != (uintptr_t)waitpt)
+    *site = (lockstat_site_t){.ls_waitpt = (uintptr_t)waitpt};
+
+  site->ls_count++;
+  site->ls_wait += wait;
+}
+
+void lockstat_acquire(lock_class_mapping_t *lock, const void *waitpt,
+                      const bintime_t *wait_start) {
+  int idx = lockdep_class_index(lock);
+  if (idx < 0)
+    return;
+
+  bintime_t now = binuptime();
+  bool contended = bintime_isset(wait_start);
+  uint64_t wait = contended ? elapsed_ns(wait_start, &now) : 0;
+  lockstat_record_t *lr = &lockstat[idx];
+
+  /* Only the owner of the lock accesses this field. */
+  lock->acquired = now;
+
+  WITH_MTX_LOCK (&lockstat_lock) {
+    lr->lr_acquired++;
+    if (contended) {
+      lr->lr_contended++;
+      lr->lr_wait_total += wait;
+      lr->lr_wait_max = max(lr->lr_wait_max, wait);
+      lockstat_add_site(lr, waitpt, wait);
+    }
+  }
+}
+
+void lockstat_release(lock_class_mapping_t *lock) {
+  int idx = lockdep_class_index(lock);
+
+  /* The lock might have been taken when statistics were off. */
+  if (idx < 0 || !bintime_isset(&lock->acquired))
+    return;
+
+  bintime_t now = binuptime();
+  uint64_t hold = elapsed_ns(&lock->acquired, &now);
+  lockstat_record_t *lr = &lockstat[idx];
+
+  lock->acquired = BINTIME(0);
+
+  WITH_MTX_LOCK (&lockstat_lock) {
+    lr->lr_hold_total += hold;
+    lr->lr_hold_max = max(lr->lr_hold_max, hold);
+  }
+}
+
+static int lockstat_read(devnode_t *dev, uio_t *uio) {
+  size_t nclasses = lockdep_class_count();
+  int error = 0;
+
+  while (uio->uio_resid > 0 && !error) {
+    size_t idx = uio->uio_offset / sizeof(lockstat_record_t);
+    size_t skip = uio->uio_offset % sizeof(lockstat_record_t);
+    lockstat_record_t lr;
+
+    if (idx >= nclasses)
+      break;
+
+    WITH_MTX_LOCK (&lockstat_lock)
+      lr = lockstat[idx];
+    strlcpy(lr.lr_name, lockdep_class_name(idx), LOCKSTAT_NAMELEN);
+
+    error = uiomove((char *)&lr + skip, sizeof(lr) - skip, uio);
+  }
+
+  return error;
+}
+
+static int lockstat_ioctl(devnode_t *dev, u_long cmd, void *data,
+                          int fflags) {
+  if (cmd == LOCKSTATIOCGSTATE) {
+    *(int *)data = atomic_load(&lockstat_enabled);
+    return 0;
+  }
+  if (cmd == LOCKSTATIOCSSTATE) {
+    atomic_store(&lockstat_enabled, *(int *)data != 0);
+    return 0;
+  }
+  if (cmd == LOCKSTATIOCRESET) {
+    WITH_MTX_LOCK (&lockstat_lock)
+      bzero(lockstat, sizeof(lockstat));
+    return 0;
+  }
+  return EINVAL;
+}
+
+static devops_t lockstat_devops = {
+  .d_type = DT_SEEKABLE,
+  .d_read = lockstat_read,
+  .d_ioctl = lockstat_ioctl,
+};
+
+static void init_dev_lockstat(void) {
+  devfs_makedev_new(NULL, "lockstat", &lockstat_devops, NULL, NULL);
+}
+
+SET_ENTRY(devfs_init, init_dev_lockstat);
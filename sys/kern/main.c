@@ -5,12 +5,14 @@
 #include <sys/vmem.h>
 #include <sys/pool.h>
 #include <sys/malloc.h>
+#include <sys/evcnt.h>
 #include <sys/device.h>
 #include <sys/bus.h>
 #include <sys/kenv.h>
 #include <sys/sched.h>
 #include <sys/interrupt.h>
 #include <sys/sleepq.h>
+#include <sys/futex.h>
 #include <sys/turnstile.h>
 #include <sys/thread.h>
 #include <sys/proc.h>
@@ -29,6 +31,7 @@
 #include <sys/lockdep.h>
 #include <sys/kcsan.h>
 #include <sys/kgprof.h>
+#include <sys/timepage.h>
 
 /* This function mounts some initial filesystems. Normally this would be done by
    userspace init program. */
@@ -88,6 +91,8 @@ __noreturn void kernel_init(void) {
   init_vmem();
   init_kmem();
   init_kmalloc();
+  init_evcnt();
+  init_timepage();
 
   init_cons();
 
@@ -108,6 +113,7 @@ __noreturn void kernel_init(void) {
   init_vfs();
   init_proc();
   init_proc0();
+  init_futex();
 
   /* Mount filesystems (including devfs). */
   mount_fs();
@@ -123,7 +129,7 @@ __noreturn void kernel_init(void) {
   init_kcsan();
 
   pid_t init_pid;
-  do_fork(start_init, NULL, &init_pid);
+  do_fork(start_init, NULL, 0, &init_pid);
   assert(init_pid == 1);
 
   sched_run();
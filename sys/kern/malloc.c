@@ -4,6 +4,7 @@
 #include <sys/kmem.h>
 #include <sys/libkern.h>
 #include <sys/malloc.h>
+#include <sys/memstat.h>
 #include <sys/mimiker.h>
 #include <sys/pool.h>
 #include <sys/vm.h>
@@ -133,6 +134,31 @@ char *kstrndup(kmalloc_pool_t *mp, const char *s, size_t maxlen) {
   return copy;
 }
 
+SET_DECLARE(kmalloc_pool, kmalloc_pool_t);
+
+size_t kmalloc_memstat(memstat_record_t *recs, size_t n) {
+  kmalloc_pool_t **mp_p;
+  size_t i = 0;
+
+  SET_FOREACH (mp_p, kmalloc_pool) {
+    kmalloc_pool_t *mp = *mp_p;
+    if (i < n) {
+      memstat_record_t *mr = &recs[i];
+      mr->mr_kind = MS_KMALLOC;
+      strlcpy(mr->mr_name, mp->desc, MEMSTAT_NAMELEN);
+
+      SCOPED_MTX_LOCK(&mp->lock);
+      mr->mr_kmalloc.nrequests = mp->nrequests;
+      mr->mr_kmalloc.active = mp->active;
+      mr->mr_kmalloc.used = mp->used;
+      mr->mr_kmalloc.maxused = mp->maxused;
+    }
+    i++;
+  }
+
+  return i;
+}
+
 void init_kmalloc(void) {
   for (size_t i = 0; i < KM_NPOOLS; i++) {
     pool_t *pool = &km_pools[i];
@@ -69,7 +69,7 @@
 #include <sys/mutex.h>
 #include <sys/types.h>
 
-static SPIN_DEFINE(mcount_lock, 0);
+static MTX_DEFINE(mcount_lock, MTX_SPIN);
 
 /*
  *
@@ -105,7 +105,7 @@ __no_profile void __cyg_profile_func_enter(void *self, void *from) {
   if (p->state != GMON_PROF_ON)
     return;
 
-  WITH_SPIN_LOCK (&mcount_lock) {
+  WITH_MTX_LOCK (&mcount_lock) {
     /*
      * To ensure consistent data in kgmon - this function can move
      * a node from the middle of the list to the beginning and
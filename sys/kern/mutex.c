@@ -1,4 +1,5 @@
 #include <sys/klog.h>
+#include <sys/lockstat.h>
 #include <sys/mutex.h>
 #include <sys/interrupt.h>
 #include <sys/turnstile.h>
@@ -24,7 +25,7 @@ void _mtx_lock(mtx_t *m, const void *waitpt) {
   intptr_t flags = m->m_owner & (MTX_SPIN | MTX_NODEBUG);
 
   if (flags & MTX_SPIN) {
-    intr_disable();
+    _intr_disable(waitpt);
   } else {
     if (__unlikely(intr_disabled()))
       panic("Cannot acquire sleep mutex in interrupt context!");
@@ -40,6 +41,11 @@ void _mtx_lock(mtx_t *m, const void *waitpt) {
 
   thread_t *td = thread_self();
 
+#if LOCKDEP
+  bool stat = !(flags & MTX_NODEBUG) && lockstat_active();
+  bintime_t wait_start = BINTIME(0);
+#endif
+
   for (;;) {
     intptr_t expected = flags;
     intptr_t value = (intptr_t)td | flags;
@@ -48,6 +54,11 @@ void _mtx_lock(mtx_t *m, const void *waitpt) {
     if (atomic_compare_exchange_strong(&m->m_owner, &expected, value))
       break;
 
+#if LOCKDEP
+    if (stat && !bintime_isset(&wait_start))
+      wait_start = binuptime();
+#endif
+
     if (flags & MTX_SPIN)
       continue;
 
@@ -69,6 +80,11 @@ void _mtx_lock(mtx_t *m, const void *waitpt) {
       }
     }
   }
+
+#if LOCKDEP
+  if (stat)
+    lockstat_acquire(&m->m_lockmap, waitpt, &wait_start);
+#endif
 }
 
 void mtx_unlock(mtx_t *m) {
@@ -77,8 +93,10 @@ void mtx_unlock(mtx_t *m) {
   assert(mtx_owned(m));
 
 #if LOCKDEP
-  if (!(flags & MTX_NODEBUG))
+  if (!(flags & MTX_NODEBUG)) {
+    lockstat_release(&m->m_lockmap);
     lockdep_release(&m->m_lockmap);
+  }
 #endif
 
   /* Fast path: if lock is not contested then drop ownership. */
@@ -103,5 +121,5 @@ void mtx_unlock(mtx_t *m) {
 
 done:
   if (flags & MTX_SPIN)
-    intr_enable();
+    _intr_enable(__caller(0));
 }
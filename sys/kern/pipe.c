@@ -5,6 +5,7 @@
 #include <sys/kmem.h>
 #include <sys/pool.h>
 #include <sys/errno.h>
+#include <sys/event.h>
 #include <sys/pipe.h>
 #include <sys/libkern.h>
 #include <sys/stat.h>
@@ -28,6 +29,7 @@ struct pipe {
   condvar_t nonempty; /*!< used to wait data to appear in the buffer */
   condvar_t nonfull;  /*!< used to wait for free space in the buffer */
   ringbuf_t buf;      /*!< buffer with pipe data */
+  knlist_t knotes;    /*!< notes attached to both ends of the pipe */
 };
 
 static POOL_DEFINE(P_PIPE, "pipe", sizeof(pipe_t));
@@ -41,6 +43,7 @@ static pipe_t *pipe_alloc(void) {
   cv_init(&pipe->nonfull, "pipe_nonfull");
   pipe->buf.data = kmem_alloc(PIPE_SIZE, M_ZERO);
   pipe->buf.size = PIPE_SIZE;
+  SLIST_INIT(&pipe->knotes);
   return pipe;
 }
 
@@ -61,12 +64,13 @@ static int pipe_read(file_t *f, uio_t *uio) {
 
   /* no read atomicity for now! */
   WITH_MTX_LOCK (&pipe->mtx) {
-    if (f->f_flags & IO_NONBLOCK)
-      return EAGAIN;
     while (ringbuf_empty(&pipe->buf)) {
       /* pipe empty & no writers => return end-of-file */
       if (pipe->writer_closed)
         return 0;
+      /* pipe empty & reading in NONBLOCK => return with error */
+      if (f->f_flags & IO_NONBLOCK)
+        return EAGAIN;
       /* restart the syscall if we were interrupted by a signal */
       if (cv_wait_intr(&pipe->nonempty, &pipe->mtx))
         return ERESTARTSYS;
@@ -76,6 +80,7 @@ static int pipe_read(file_t *f, uio_t *uio) {
       return error;
     /* notify writer that free space is available */
     cv_broadcast(&pipe->nonfull);
+    knote(&pipe->knotes, 0);
   }
 
   return 0;
@@ -103,6 +108,7 @@ static int pipe_write(file_t *f, uio_t *uio) {
         break;
       /* notify reader that new data is available */
       cv_broadcast(&pipe->nonempty);
+      knote(&pipe->knotes, 0);
       /* nothing left to write? */
       if (uio->uio_resid == 0)
         return 0;
@@ -139,6 +145,7 @@ static int pipe_close(file_t *f) {
       /* Wake up readers so that they exit. */
       cv_broadcast(&pipe->nonempty);
     }
+    knote(&pipe->knotes, 0);
     closed = pipe->reader_closed && pipe->writer_closed;
   }
 
@@ -161,6 +168,67 @@ static int pipe_seek(file_t *f, off_t offset, int whence, off_t *newoffp) {
   return EOPNOTSUPP;
 }
 
+static void filt_pipedetach(knote_t *kn) {
+  pipe_t *pipe = kn->kn_hook;
+
+  WITH_MTX_LOCK (&pipe->mtx)
+    SLIST_REMOVE(&pipe->knotes, kn, knote, kn_objlink);
+}
+
+static int filt_piperead(knote_t *kn, long hint) {
+  pipe_t *pipe = kn->kn_hook;
+  assert(mtx_owned(&pipe->mtx));
+
+  kn->kn_kevent.data = pipe->buf.count;
+  if (pipe->writer_closed) {
+    kn->kn_kevent.flags |= EV_EOF;
+    return 1;
+  }
+  return !ringbuf_empty(&pipe->buf);
+}
+
+static int filt_pipewrite(knote_t *kn, long hint) {
+  pipe_t *pipe = kn->kn_hook;
+  assert(mtx_owned(&pipe->mtx));
+
+  kn->kn_kevent.data = pipe->buf.size - pipe->buf.count;
+  if (pipe->reader_closed) {
+    kn->kn_kevent.flags |= EV_EOF;
+    return 1;
+  }
+  return !ringbuf_full(&pipe->buf);
+}
+
+static filterops_t pipe_read_filtops = {
+  .filt_detach = filt_pipedetach,
+  .filt_event = filt_piperead,
+};
+
+static filterops_t pipe_write_filtops = {
+  .filt_detach = filt_pipedetach,
+  .filt_event = filt_pipewrite,
+};
+
+static int pipe_kqfilter(file_t *f, knote_t *kn) {
+  pipe_t *pipe = f->f_data;
+
+  /* Each end of a pipe can be monitored only in its own direction. */
+  if (kn->kn_kevent.filter == EVFILT_READ && (f->f_flags & FF_READ))
+    kn->kn_filtops = &pipe_read_filtops;
+  else if (kn->kn_kevent.filter == EVFILT_WRITE && (f->f_flags & FF_WRITE))
+    kn->kn_filtops = &pipe_write_filtops;
+  else
+    return EINVAL;
+
+  kn->kn_hook = pipe;
+  kn->kn_objlock = &pipe->mtx;
+
+  WITH_MTX_LOCK (&pipe->mtx)
+    SLIST_INSERT_HEAD(&pipe->knotes, kn, kn_objlink);
+
+  return 0;
+}
+
 static fileops_t pipeops = {
   .fo_read = pipe_read,
   .fo_write = pipe_write,
@@ -168,6 +236,7 @@ static fileops_t pipeops = {
   .fo_seek = pipe_seek,
   .fo_stat = pipe_stat,
   .fo_ioctl = pipe_ioctl,
+  .fo_kqfilter = pipe_kqfilter,
 };
 
 static file_t *make_pipe_file(pipe_t *pipe, unsigned flags) {
@@ -3,9 +3,12 @@
 #include <sys/mimiker.h>
 #include <sys/klog.h>
 #include <sys/linker_set.h>
+#include <sys/evcnt.h>
 #include <sys/sched.h>
 #include <sys/malloc.h>
+#include <sys/memstat.h>
 #include <sys/pool.h>
+#include <sys/sdt.h>
 #include <sys/kmem.h>
 #include <sys/vm.h>
 #include <machine/vm_param.h>
@@ -23,6 +26,7 @@
 static TAILQ_HEAD(, pool) pool_list = TAILQ_HEAD_INITIALIZER(pool_list);
 static MTX_DEFINE(pool_list_lock, 0);
 static KMALLOC_DEFINE(M_POOL, "pool allocators");
+static EVCNT_DEFINE(pool_refill, "pool", "slab refill");
 
 static void *slab_item_at(slab_t *slab, unsigned i) {
   return slab->ph_items + i * slab->ph_itemsize;
@@ -79,6 +83,8 @@ static void add_slab(pool_t *pool, slab_t *slab, size_t slabsize) {
   }
 }
 
+SDT_PROBE_DEFINE(pool, alloc, "pool, item");
+
 void *pool_alloc(pool_t *pool, kmem_flags_t flags) {
   void *ptr;
 
@@ -93,6 +99,7 @@ void *pool_alloc(pool_t *pool, kmem_flags_t flags) {
         slab = kmem_alloc(slabsize, flags);
         assert(slab != NULL);
         add_slab(pool, slab, slabsize);
+        evcnt_inc(&pool_refill);
       }
       /* We're going to allocate from empty slab
        * -> move it to the list of non-empty slabs. */
@@ -125,6 +132,7 @@ void *pool_alloc(pool_t *pool, kmem_flags_t flags) {
   if (flags & M_ZERO)
     bzero(ptr, pool->pp_itemsize);
 
+  SDT_PROBE(pool, alloc, pool, ptr);
   return ptr;
 }
 
@@ -249,6 +257,43 @@ void pool_add_page(pool_t *pool, void *page, size_t size) {
   add_slab(pool, page, size);
 }
 
+static size_t count_slabs(slab_list_t *slabs) {
+  size_t n = 0;
+  slab_t *slab;
+  LIST_FOREACH (slab, slabs, ph_link)
+    n++;
+  return n;
+}
+
+size_t pool_memstat(memstat_record_t *recs, size_t n) {
+  size_t i = 0;
+  pool_t *pool;
+
+  SCOPED_MTX_LOCK(&pool_list_lock);
+
+  TAILQ_FOREACH (pool, &pool_list, pp_link) {
+    if (i < n) {
+      memstat_record_t *mr = &recs[i];
+      mr->mr_kind = MS_POOL;
+      strlcpy(mr->mr_name, pool->pp_desc, MEMSTAT_NAMELEN);
+
+      SCOPED_MTX_LOCK(&pool->pp_mtx);
+      size_t nempty = count_slabs(&pool->pp_empty_slabs);
+      mr->mr_pool.itemsize = pool->pp_itemsize;
+      mr->mr_pool.nused = pool->pp_nused;
+      mr->mr_pool.nmaxused = pool->pp_nmaxused;
+      mr->mr_pool.ntotal = pool->pp_ntotal;
+      mr->mr_pool.nbytes = pool->pp_npages;
+      mr->mr_pool.nslabs = nempty + count_slabs(&pool->pp_part_slabs) +
+                           count_slabs(&pool->pp_full_slabs);
+      mr->mr_pool.nempty = nempty;
+    }
+    i++;
+  }
+
+  return i;
+}
+
 pool_t *_pool_create(pool_init_t *args) {
   pool_t *pool = kmalloc(M_POOL, sizeof(pool_t), M_ZERO | M_NOWAIT);
   _pool_init(pool, args);
@@ -78,7 +78,8 @@ static pgrp_t pgrp0 = {
 
 proc_t proc0 = {
   .p_lock = MTX_INITIALIZER(proc0.p_lock, 0),
-  .p_thread = &thread0,
+  .p_threads = TAILQ_HEAD_INITIALIZER(proc0.p_threads),
+  .p_nthreads = 1,
   .p_pid = 0,
   .p_pgrp = &pgrp0,
   .p_state = PS_NORMAL,
@@ -100,6 +101,7 @@ void init_proc0(void) {
   p->p_cwd = vfs_root_vnode;
   p->p_cmask = CMASK;
 
+  TAILQ_INSERT_TAIL(&p->p_threads, &thread0, td_procq);
   TAILQ_INSERT_TAIL(&proc_list, p, p_all);
   TAILQ_INSERT_TAIL(PROC_HASH_CHAIN(0), p, p_hash);
   TAILQ_INSERT_HEAD(PGRP_HASH_CHAIN(0), &pgrp0, pg_hash);
@@ -450,7 +452,7 @@ proc_t *proc_create(thread_t *td, proc_t *parent) {
 
   mtx_init(&p->p_lock, 0);
   p->p_state = PS_NORMAL;
-  p->p_thread = td;
+  TAILQ_INIT(&p->p_threads);
   p->p_parent = parent;
 
   if (parent->p_elfpath)
@@ -461,10 +463,168 @@ proc_t *proc_create(thread_t *td, proc_t *parent) {
   TAILQ_INIT(CHILDREN(p));
   kitimer_init(p);
 
+  WITH_PROC_LOCK(p) {
+    proc_thread_add(p, td);
+  }
+
+  return p;
+}
+
+void proc_thread_add(proc_t *p, thread_t *td) {
+  assert(mtx_owned(&p->p_lock));
+
+  TAILQ_INSERT_TAIL(&p->p_threads, td, td_procq);
+  p->p_nthreads++;
+
   WITH_MTX_LOCK (td->td_lock)
     td->td_proc = p;
+}
 
-  return p;
+/* Make the thread check the state of its process before it returns to user
+ * space. If it's sleeping interruptibly, wake it up, so it gets there soon. */
+static void proc_thread_notify(thread_t *td) {
+  WITH_MTX_LOCK (td->td_lock) {
+    td->td_flags |= TDF_NEEDSIGCHK;
+    if (td_is_interruptible(td)) {
+      mtx_unlock(td->td_lock);
+      sleepq_abort(td); /* Locks & unlocks td_lock */
+      mtx_lock(td->td_lock);
+    }
+  }
+}
+
+int proc_singlethread(proc_t *p) {
+  thread_t *td = thread_self();
+
+  assert(mtx_owned(&p->p_lock));
+  assert(td->td_proc == p);
+
+  if (p->p_singlethread != NULL && p->p_singlethread != td)
+    return EINTR;
+
+  p->p_singlethread = td;
+
+  thread_t *otd;
+  TAILQ_FOREACH (otd, &p->p_threads, td_procq) {
+    if (otd == td)
+      continue;
+    /* Stopped threads must be resumed, so they can exit. */
+    WITH_MTX_LOCK (otd->td_lock) {
+      if (td_is_stopped(otd) || (otd->td_flags & TDF_STOPPING))
+        thread_continue(otd);
+    }
+    proc_thread_notify(otd);
+  }
+
+  /* Other threads leave the process in sig_check(). */
+  while (p->p_nthreads > 1) {
+    cv_wait(&p->p_singlecv, &p->p_lock);
+    /* Another thread has begun to terminate the process. */
+    if (p->p_singlethread != td)
+      return EINTR;
+  }
+
+  return 0;
+}
+
+/* Adds up resource usage of \a ru2 to \a ru. */
+static void ruadd(struct rusage *ru, const struct rusage *ru2) {
+  timeradd(&ru->ru_utime, &ru2->ru_utime, &ru->ru_utime);
+  timeradd(&ru->ru_stime, &ru2->ru_stime, &ru->ru_stime);
+  ru->ru_maxrss = max(ru->ru_maxrss, ru2->ru_maxrss);
+
+  long *ip = &ru->ru_first;
+  const long *jp = &ru2->ru_first;
+  for (int i = &ru->ru_last - &ru->ru_first; i >= 0; i--)
+    *ip++ += *jp++;
+}
+
+/* Adds running time of \a td to \a ru. */
+static void thread_ruadd(struct rusage *ru, thread_t *td) {
+  bintime_t rtime;
+  timeval_t tv;
+
+  WITH_MTX_LOCK (td->td_lock)
+    rtime = sched_rtime(td);
+
+  /* Time spent in kernel is not measured separately. */
+  bt2tv(&rtime, &tv);
+  timeradd(&ru->ru_utime, &tv, &ru->ru_utime);
+}
+
+/* Adds memory usage of \a map to \a ru. */
+static void vmspace_ruadd(struct rusage *ru, vm_map_t *map) {
+  vm_map_stats_t stats;
+
+  vm_map_stats(map, &stats);
+  /* Maximum resident set size is expressed in kilobytes. */
+  ru->ru_maxrss = max(ru->ru_maxrss, (long)(stats.vs_maxrss * PAGESIZE / 1024));
+  ru->ru_minflt += stats.vs_minflt;
+}
+
+void proc_account_vmspace(proc_t *p, vm_map_t *map) {
+  assert(mtx_owned(&p->p_lock));
+  vmspace_ruadd(&p->p_ru, map);
+}
+
+void proc_rusage(proc_t *p, struct rusage *ru) {
+  assert(mtx_owned(&p->p_lock));
+
+  *ru = p->p_ru;
+
+  thread_t *td;
+  TAILQ_FOREACH (td, &p->p_threads, td_procq)
+    thread_ruadd(ru, td);
+
+  /* Borrowed address space is accounted to the parent. */
+  if (p->p_uspace && !(p->p_flags & PF_VFORK))
+    vmspace_ruadd(ru, p->p_uspace);
+}
+
+int do_getrusage(int who, struct rusage *ru) {
+  proc_t *p = proc_self();
+
+  if (who == RUSAGE_SELF) {
+    WITH_PROC_LOCK(p) {
+      proc_rusage(p, ru);
+    }
+    return 0;
+  }
+
+  if (who == RUSAGE_CHILDREN) {
+    WITH_MTX_LOCK (&all_proc_mtx)
+      *ru = p->p_cru;
+    return 0;
+  }
+
+  return EINVAL;
+}
+
+__noreturn void proc_thread_exit(int exitstatus) {
+  thread_t *td = thread_self();
+  proc_t *p = td->td_proc;
+
+  assert(mtx_owned(&p->p_lock));
+
+  if (p->p_nthreads == 1)
+    proc_exit(exitstatus);
+
+  klog("Thread %u leaves process PID(%d)", td->td_tid, p->p_pid);
+
+  thread_ruadd(&p->p_ru, td);
+  TAILQ_REMOVE(&p->p_threads, td, td_procq);
+  p->p_nthreads--;
+  cv_broadcast(&p->p_singlecv);
+
+  /* Signals sent to the process must not get lost with the thread. */
+  sig_redirect(p, td);
+
+  WITH_MTX_LOCK (td->td_lock)
+    td->td_proc = NULL;
+
+  proc_unlock(p);
+
+  thread_exit();
 }
 
 void proc_add(proc_t *p) {
@@ -527,6 +687,10 @@ static void proc_reap(proc_t *p) {
 
   klog("Recycling process PID(%d) {%p}", p->p_pid, p);
 
+  /* Resource usage of a zombie doesn't change anymore. */
+  ruadd(&p->p_parent->p_cru, &p->p_ru);
+  ruadd(&p->p_parent->p_cru, &p->p_cru);
+
   pgrp_leave(p);
   TAILQ_REMOVE(CHILDREN(p->p_parent), p, p_child);
   TAILQ_REMOVE(&zombie_list, p, p_zombie);
@@ -557,6 +721,21 @@ static void proc_reparent(proc_t *old_parent, proc_t *new_parent) {
   }
 }
 
+void proc_vfork_done(proc_t *p) {
+  assert(mtx_owned(&p->p_lock));
+
+  if (p->p_vforkdone == NULL)
+    return;
+
+  WITH_PROC_LOCK(p->p_parent) {
+    *p->p_vforkdone = true;
+    cv_broadcast(&p->p_parent->p_waitcv);
+  }
+
+  p->p_vforkdone = NULL;
+  p->p_flags &= ~PF_VFORK;
+}
+
 void proc_wakeup_parent(proc_t *parent) {
   assert(mtx_owned(&parent->p_lock));
 
@@ -570,18 +749,35 @@ __noreturn void proc_exit(int exitstatus) {
 
   assert(mtx_owned(&p->p_lock));
 
+  /* Another thread is already terminating the process, so just leave. */
+  if (p->p_state == PS_DYING)
+    proc_thread_exit(exitstatus);
+
   /* Mark this process as dying, so others don't attempt to disturb it. */
   p->p_state = PS_DYING;
 
+  /* Take over from a thread that is executing a new program (if any), and
+   * wait for other threads to exit. */
+  if (p->p_singlethread != td) {
+    p->p_singlethread = NULL;
+    cv_broadcast(&p->p_singlecv);
+  }
+  int error = proc_singlethread(p);
+  assert(error == 0);
+  p->p_singlethread = NULL;
+
   /* Clean up process resources. */
   klog("Freeing process PID(%d) {%p} resources", p->p_pid, p);
 
-  /* Stop per-process interval timer.
-   * NOTE: this function may release and re-acquire p->p_lock. */
+  /* Stop per-process interval timer and delete POSIX timers.
+   * NOTE: these functions may release and re-acquire p->p_lock. */
   kitimer_stop(p);
+  ptimer_deleteall(p);
 
-  /* Detach main thread from the process. */
-  p->p_thread = NULL;
+  /* Detach the last thread from the process. */
+  thread_ruadd(&p->p_ru, td);
+  TAILQ_REMOVE(&p->p_threads, td, td_procq);
+  p->p_nthreads--;
   td->td_proc = NULL;
 
   /* Make sure address space won't get activated by context switch while it's
@@ -589,12 +785,20 @@ __noreturn void proc_exit(int exitstatus) {
   vm_map_t *uspace = p->p_uspace;
   p->p_uspace = NULL;
 
+  /* Borrowed address space goes back to the parent intact. */
+  if (p->p_flags & PF_VFORK)
+    uspace = NULL;
+  proc_vfork_done(p);
+
   /* Record process statistics that will stay maintained in zombie state. */
   p->p_exitstatus = exitstatus;
+  if (uspace)
+    proc_account_vmspace(p, uspace);
 
   proc_unlock(p);
 
-  vm_map_delete(uspace);
+  if (uspace)
+    vm_map_delete(uspace);
   fdtab_drop(p->p_fdtable);
 
   WITH_MTX_LOCK (&all_proc_mtx) {
@@ -827,7 +1031,7 @@ void proc_stop(signo_t sig) {
   assert(mtx_owned(&p->p_lock));
   assert(p->p_state == PS_NORMAL);
 
-  klog("Stopping thread %u in process PID(%d)", td->td_tid, p->p_pid);
+  klog("Stopping process PID(%d)", p->p_pid);
   p->p_stopsig = sig;
   p->p_state = PS_STOPPED;
   p->p_flags |= PF_STATE_CHANGED;
@@ -835,6 +1039,25 @@ void proc_stop(signo_t sig) {
     proc_wakeup_parent(p->p_parent);
     sig_child(p, CLD_STOPPED);
   }
+
+  /* Other threads stop themselves in sig_check(). */
+  thread_t *otd;
+  TAILQ_FOREACH (otd, &p->p_threads, td_procq) {
+    if (otd != td)
+      proc_thread_notify(otd);
+  }
+
+  proc_thread_stop();
+}
+
+void proc_thread_stop(void) {
+  thread_t *td = thread_self();
+  proc_t *p = td->td_proc;
+
+  assert(mtx_owned(&p->p_lock));
+  assert(p->p_state == PS_STOPPED);
+
+  klog("Stopping thread %u in process PID(%d)", td->td_tid, p->p_pid);
   WITH_MTX_LOCK (td->td_lock) {
     td->td_flags |= TDF_STOPPING;
   }
@@ -850,23 +1073,26 @@ void proc_stop(signo_t sig) {
     mtx_unlock(td->td_lock);
   }
   proc_lock(p);
-  return;
 }
 
 void proc_continue(proc_t *p) {
-  thread_t *td = p->p_thread;
-
   assert(mtx_owned(&p->p_lock));
   assert(p->p_state == PS_STOPPED);
 
-  klog("Continuing thread %u in process PID(%d)", td->td_tid, p->p_pid);
+  klog("Continuing process PID(%d)", p->p_pid);
 
   p->p_state = PS_NORMAL;
   p->p_flags |= PF_STATE_CHANGED;
   WITH_PROC_LOCK(p->p_parent) {
     proc_wakeup_parent(p->p_parent);
   }
-  WITH_MTX_LOCK (td->td_lock) {
-    thread_continue(td);
+
+  /* Some threads may not have managed to stop yet. */
+  thread_t *td;
+  TAILQ_FOREACH (td, &p->p_threads, td_procq) {
+    WITH_MTX_LOCK (td->td_lock) {
+      if (td_is_stopped(td) || (td->td_flags & TDF_STOPPING))
+        thread_continue(td);
+    }
   }
 }
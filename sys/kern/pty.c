@@ -27,6 +27,7 @@ typedef struct {
   atomic_int pt_number; /* PTY number, if allocated. -1 means free. */
   condvar_t pt_incv;    /* CV for readers */
   condvar_t pt_outcv;   /* CV for writers */
+  knlist_t pt_knlist;   /* Knotes attached to the master side */
 } pty_t;
 
 static pty_t pty_array[MAX_PTYS];
@@ -77,40 +78,32 @@ static int pty_read(file_t *f, uio_t *uio) {
   return error;
 }
 
-/* Write at single character to the master side of a pseudoterminal,
- * i.e. to the input queue of the slave tty.
- * If the input queue is full, sleep only if the slave tty has users. */
-static int pty_putc_sleep(tty_t *tty, pty_t *pty, uint8_t c) {
-  while (!tty_input(tty, c)) {
-    if (!tty_opened(tty))
-      return EIO;
-    if (cv_wait_intr(&pty->pt_outcv, &tty->t_lock))
-      return ERESTARTSYS;
-  }
-  return 0;
-}
-
+/* Write to the master side of a pseudoterminal, i.e. to the input queue
+ * of the slave tty. If the input queue is full, sleep only if the slave tty
+ * has users. */
 static int pty_write(file_t *f, uio_t *uio) {
   tty_t *tty = f->f_data;
   pty_t *pty = tty->t_data;
   int error = 0;
-  uint8_t c;
 
   if (uio->uio_resid == 0)
     return 0;
 
   size_t start_resid = uio->uio_resid;
-  uiostate_t save;
 
   SCOPED_MTX_LOCK(&tty->t_lock);
 
   while (uio->uio_resid > 0) {
-    uio_save(uio, &save);
-    if ((error = uiomove(&c, 1, uio)))
+    if ((error = tty_input_uio(tty, uio)))
+      break;
+    if (uio->uio_resid == 0)
       break;
-    if ((error = pty_putc_sleep(tty, pty, c))) {
-      /* Undo the last uiomove(). */
-      uio_restore(uio, &save);
+    if (!tty_opened(tty)) {
+      error = EIO;
+      break;
+    }
+    if (cv_wait_intr(&pty->pt_outcv, &tty->t_lock)) {
+      error = ERESTARTSYS;
       break;
     }
   }
@@ -188,6 +181,74 @@ static int pty_ioctl(file_t *f, u_long cmd, void *data) {
   return tty_ioctl(f, cmd, data);
 }
 
+static void filt_ptydetach(knote_t *kn) {
+  tty_t *tty = kn->kn_hook;
+  pty_t *pty = tty->t_data;
+
+  WITH_MTX_LOCK (&tty->t_lock)
+    SLIST_REMOVE(&pty->pt_knlist, kn, knote, kn_objlink);
+}
+
+/* Master side is readable when there is output from the slave tty. */
+static int filt_ptyread(knote_t *kn, long hint) {
+  tty_t *tty = kn->kn_hook;
+  assert(mtx_owned(&tty->t_lock));
+
+  kn->kn_kevent.data = tty->t_outq.count;
+  if (!tty_opened(tty)) {
+    kn->kn_kevent.flags |= EV_EOF;
+    return 1;
+  }
+  /* The slave tty may have been opened again. */
+  kn->kn_kevent.flags &= ~EV_EOF;
+  return !ringbuf_empty(&tty->t_outq);
+}
+
+/* Master side is writable when the slave tty can accept more input. */
+static int filt_ptywrite(knote_t *kn, long hint) {
+  tty_t *tty = kn->kn_hook;
+  assert(mtx_owned(&tty->t_lock));
+
+  kn->kn_kevent.data = tty->t_inq.size - tty->t_inq.count;
+  if (!tty_opened(tty)) {
+    kn->kn_kevent.flags |= EV_EOF;
+    return 1;
+  }
+  /* The slave tty may have been opened again. */
+  kn->kn_kevent.flags &= ~EV_EOF;
+  return !(tty->t_flags & TF_IN_HIWAT);
+}
+
+static filterops_t pty_read_filtops = {
+  .filt_detach = filt_ptydetach,
+  .filt_event = filt_ptyread,
+};
+
+static filterops_t pty_write_filtops = {
+  .filt_detach = filt_ptydetach,
+  .filt_event = filt_ptywrite,
+};
+
+static int pty_kqfilter(file_t *f, knote_t *kn) {
+  tty_t *tty = f->f_data;
+  pty_t *pty = tty->t_data;
+
+  if (kn->kn_kevent.filter == EVFILT_READ)
+    kn->kn_filtops = &pty_read_filtops;
+  else if (kn->kn_kevent.filter == EVFILT_WRITE)
+    kn->kn_filtops = &pty_write_filtops;
+  else
+    return EINVAL;
+
+  kn->kn_hook = tty;
+  kn->kn_objlock = &tty->t_lock;
+
+  WITH_MTX_LOCK (&tty->t_lock)
+    SLIST_INSERT_HEAD(&pty->pt_knlist, kn, kn_objlink);
+
+  return 0;
+}
+
 static fileops_t pty_fileops = {
   .fo_read = pty_read,
   .fo_write = pty_write,
@@ -195,18 +256,21 @@ static fileops_t pty_fileops = {
   .fo_seek = noseek,
   .fo_stat = pty_stat,
   .fo_ioctl = pty_ioctl,
+  .fo_kqfilter = pty_kqfilter,
 };
 
 static void pty_notify_out(tty_t *tty) {
   pty_t *pty = tty->t_data;
   /* Notify PTY readers: input is available. */
   cv_broadcast(&pty->pt_incv);
+  knote(&pty->pt_knlist, 0);
 }
 
 static void pty_notify_in(tty_t *tty) {
   pty_t *pty = tty->t_data;
   /* Notify PTY writers: there is space in the slave TTY's input buffer. */
   cv_broadcast(&pty->pt_outcv);
+  knote(&pty->pt_knlist, 0);
 }
 
 static void pty_notify_inactive(tty_t *tty) {
@@ -214,6 +278,7 @@ static void pty_notify_inactive(tty_t *tty) {
   /* Notify PTY readers and writers so that they abort. */
   cv_broadcast(&pty->pt_incv);
   cv_broadcast(&pty->pt_outcv);
+  knote(&pty->pt_knlist, 0);
 }
 
 static ttyops_t pty_ttyops = {.t_notify_out = pty_notify_out,
@@ -278,6 +343,7 @@ static void init_pty(void) {
     pty->pt_number = -1;
     cv_init(&pty->pt_incv, "pt_incv");
     cv_init(&pty->pt_outcv, "pt_outcv");
+    SLIST_INIT(&pty->pt_knlist);
   }
 }
 
@@ -1,4 +1,6 @@
 #include <sys/klog.h>
+#include <sys/libkern.h>
+#include <sys/mimiker.h>
 #include <sys/ringbuf.h>
 #include <sys/uio.h>
 
@@ -36,11 +38,17 @@ bool ringbuf_putb(ringbuf_t *buf, uint8_t byte) {
   return true;
 }
 
-bool ringbuf_putnb(ringbuf_t *buf, uint8_t *data, size_t n) {
+bool ringbuf_putnb(ringbuf_t *buf, const uint8_t *data, size_t n) {
   if (buf->count + n > buf->size)
     return false;
-  for (size_t i = 0; i < n; i++)
-    ringbuf_putb(buf, data[i]);
+  /* repeat when free space wraps around the end of the buffer */
+  while (n > 0) {
+    size_t size = min(n, buf->size - buf->head);
+    memcpy(buf->data + buf->head, data, size);
+    produce(buf, size);
+    data += size;
+    n -= size;
+  }
   return true;
 }
 
@@ -55,8 +63,14 @@ bool ringbuf_getb(ringbuf_t *buf, uint8_t *byte_p) {
 bool ringbuf_getnb(ringbuf_t *buf, uint8_t *data, size_t n) {
   if (buf->count < n)
     return false;
-  for (size_t i = 0; i < n; i++)
-    ringbuf_getb(buf, &data[i]);
+  /* repeat when used space wraps around the end of the buffer */
+  while (n > 0) {
+    size_t size = min(n, buf->size - buf->tail);
+    memcpy(data, buf->data + buf->tail, size);
+    consume(buf, size);
+    data += size;
+    n -= size;
+  }
   return true;
 }
 
@@ -72,8 +86,12 @@ bool ringbuf_moveb(ringbuf_t *src, ringbuf_t *dst) {
 bool ringbuf_movenb(ringbuf_t *src, ringbuf_t *dst, size_t n) {
   if (src->count < n || dst->count + n > dst->size)
     return false;
-  for (size_t i = 0; i < n; i++)
-    ringbuf_moveb(src, dst);
+  while (n > 0) {
+    size_t size = min(n, src->size - src->tail);
+    ringbuf_putnb(dst, src->data + src->tail, size);
+    consume(src, size);
+    n -= size;
+  }
   return true;
 }
 
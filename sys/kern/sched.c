@@ -5,12 +5,27 @@
 #include <sys/sched.h>
 #include <sys/runq.h>
 #include <sys/interrupt.h>
+#include <sys/evcnt.h>
+#include <sys/latency.h>
 #include <sys/time.h>
 #include <sys/thread.h>
 #include <sys/mutex.h>
 #include <sys/pcpu.h>
+#include <sys/sdt.h>
 #include <sys/turnstile.h>
 
+/* Scheduler events, which can be turned into a timeline by
+ * sys/script/sched2perfetto.py. `state` is the state of the thread that is
+ * switched out, i.e. the reason of the switch. */
+SDT_PROBE_DEFINE(sched, switch, "tid, prio, state, newtid, newprio");
+SDT_PROBE_DEFINE(sched, block, "tid, prio, state, wchan, waitpt");
+SDT_PROBE_DEFINE(sched, wakeup, "tid, prio, waker, sleep flags");
+SDT_PROBE_DEFINE(sched, prio, "tid, oldprio, newprio, borrowing");
+
+/* A switch is voluntary if the thread went to sleep or blocked. */
+static EVCNT_DEFINE(cs_voluntary, "sched", "voluntary switch");
+static EVCNT_DEFINE(cs_involuntary, "sched", "involuntary switch");
+
 static MTX_DEFINE(sched_lock, MTX_SPIN);
 static runq_t runq;
 static bool sched_active = false;
@@ -39,6 +54,10 @@ void sched_wakeup(thread_t *td) {
   bintime_sub(&now, &td->td_last_slptime);
   bintime_add(&td->td_slptime, &now);
 
+  /* TDF_SLP* flags tell whether the sleep was interrupted or timed out. */
+  SDT_PROBE(sched, wakeup, td->td_tid, td->td_prio, thread_self()->td_tid,
+            td->td_flags & (TDF_SLPINTR | TDF_SLPTIMED));
+
   td->td_state = TDS_READY;
   td->td_slice = SLICE;
 
@@ -60,6 +79,9 @@ static void sched_set_active_prio(thread_t *td, prio_t prio) {
   if (prio_eq(td->td_prio, prio))
     return;
 
+  SDT_PROBE(sched, prio, td->td_tid, td->td_prio, prio,
+            td_is_borrowing(td));
+
   if (td_is_ready(td)) {
     /* Thread is on a run queue. */
     runq_remove(&runq, td);
@@ -120,6 +142,11 @@ static thread_t *sched_choose(void) {
   return td;
 }
 
+/* System time at which the slice of a running thread ends. */
+static systime_t slice_end(thread_t *td) {
+  return bt2st(&td->td_last_rtime) + td->td_slice;
+}
+
 void sched_switch(void) {
   thread_t *td = thread_self();
 
@@ -133,8 +160,15 @@ void sched_switch(void) {
 
   /* Update running time, */
   bintime_t now = binuptime();
-  bintime_sub(&now, &td->td_last_rtime);
-  bintime_add(&td->td_rtime, &now);
+  bintime_t ran = now;
+  bintime_sub(&ran, &td->td_last_rtime);
+  bintime_add(&td->td_rtime, &ran);
+
+  /* ... and the remaining part of its slice. */
+  if (td != PCPU_GET(idle_thread)) {
+    int ticks = bt2st(&now) - bt2st(&td->td_last_rtime);
+    td->td_slice = max(td->td_slice - ticks, 0);
+  }
 
   if (td_is_ready(td)) {
     /* Idle threads need not to be inserted into the run queue. */
@@ -147,19 +181,33 @@ void sched_switch(void) {
     /* Don't add dead or stopped threads to run queue. */
   }
 
+  if (td_is_sleeping(td) || td_is_blocked(td))
+    SDT_PROBE(sched, block, td->td_tid, td->td_prio, td->td_state,
+              td->td_wchan, td->td_waitpt);
+
   thread_t *newtd = sched_choose();
 
+  /* Make sure the clock interrupts the thread when its slice ends. */
+  if (newtd != PCPU_GET(idle_thread))
+    clock_notify(slice_end(newtd));
+
   if (td == newtd)
     goto noswitch;
 
   /* If we got here then a context switch is required. */
   td->td_nctxsw++;
+  evcnt_inc(td_is_ready(td) ? &cs_involuntary : &cs_voluntary);
+
+  SDT_PROBE(sched, switch, td->td_tid, td->td_prio, td->td_state,
+            newtd->td_tid, newtd->td_prio);
 
   if (PCPU_GET(no_switch))
     panic("Switching context while interrupts are disabled is forbidden!");
 
   WITH_INTR_DISABLED {
     mtx_unlock(td->td_lock);
+    if (lat_active())
+      lat_switch(newtd);
     ctx_switch(td, newtd);
     return;
     /* XXX Right now all local variables belong to thread we switched to! */
@@ -176,12 +224,42 @@ void sched_clock(void) {
 
   if (td != PCPU_GET(idle_thread)) {
     WITH_MTX_LOCK (td->td_lock) {
-      if (--td->td_slice <= 0)
+      if (getsystime() >= slice_end(td))
         td->td_flags |= TDF_NEEDSWITCH | TDF_SLICEEND;
     }
   }
 }
 
+systime_t sched_slice_end(void) {
+  assert(intr_disabled());
+
+  thread_t *td = thread_self();
+
+  /* Idle thread doesn't need the clock to tell when to switch out, and the
+   * thread that is about to be switched out will be taken care of by
+   * sched_switch. */
+  if (td == PCPU_GET(idle_thread) || (td->td_flags & TDF_NEEDSWITCH))
+    return SYSTIME_MAX;
+
+  SCOPED_MTX_LOCK(td->td_lock);
+  return slice_end(td);
+}
+
+bintime_t sched_rtime(thread_t *td) {
+  assert(mtx_owned(td->td_lock));
+
+  bintime_t rtime = td->td_rtime;
+
+  /* Running time is accounted on context switch, so add the current slice. */
+  if (td_is_running(td)) {
+    bintime_t now = binuptime();
+    bintime_sub(&now, &td->td_last_rtime);
+    bintime_add(&rtime, &now);
+  }
+
+  return rtime;
+}
+
 __noreturn void sched_run(void) {
   thread_t *td = thread_self();
 
@@ -239,12 +317,15 @@ __no_kcsan_sanitize bool preempt_disabled(void) {
 
 void preempt_disable(void) {
   thread_t *td = thread_self();
-  td->td_pdnest++;
+  if (td->td_pdnest++ == 0 && lat_active())
+    lat_section_begin(LAT_PREEMPTOFF, __caller(0));
 }
 
 void preempt_enable(void) {
   thread_t *td = thread_self();
   assert(td->td_pdnest > 0);
+  if (td->td_pdnest == 1 && lat_active())
+    lat_section_end(LAT_PREEMPTOFF, __caller(0));
   td->td_pdnest--;
   sched_maybe_preempt();
 }
@@ -0,0 +1,193 @@
+#define KL_LOG KL_DEV
+#include <sys/klog.h>
+#include <sys/devfs.h>
+#include <sys/errno.h>
+#include <sys/fcntl.h>
+#include <sys/kmem.h>
+#include <sys/libkern.h>
+#include <sys/linker_set.h>
+#include <sys/mutex.h>
+#include <sys/sdt.h>
+#include <sys/thread.h>
+#include <sys/uio.h>
+
+SET_DECLARE(sdt_probes, sdt_probe_t);
+
+/* Number of records in the buffer attached by the consumer. */
+#define SDT_BUFSIZE 4096
+
+/* Circular buffer of records. If the consumer doesn't keep up, records of
+ * probes that fire when the buffer is full are dropped and counted. */
+typedef struct sdt_buf {
+  sdt_record_t records[SDT_BUFSIZE];
+  unsigned first;   /* index of the oldest record */
+  unsigned count;   /* number of records in the buffer */
+  unsigned dropped; /* number of records that didn't fit into the buffer */
+} sdt_buf_t;
+
+/* Probes may fire in interrupt context, so the buffer is protected by
+ * a spin lock. `sdt_buf` is NULL if there's no consumer attached. */
+static MTX_DEFINE(sdt_lock, MTX_SPIN);
+static sdt_buf_t *sdt_buf;
+static atomic_int sdt_usecnt;
+
+void sdt_probe_fire(sdt_probe_t *probe, uintptr_t arg0, uintptr_t arg1,
+                    uintptr_t arg2, uintptr_t arg3, uintptr_t arg4) {
+  tid_t tid = thread_self()->td_tid;
+  bintime_t now = binuptime();
+
+  SCOPED_MTX_LOCK(&sdt_lock);
+
+  sdt_buf_t *buf = sdt_buf;
+  if (buf == NULL)
+    return;
+
+  if (buf->count == SDT_BUFSIZE) {
+    buf->dropped++;
+    return;
+  }
+
+  sdt_record_t *rec = &buf->records[(buf->first + buf->count) % SDT_BUFSIZE];
+  rec->sr_timestamp = now;
+  rec->sr_args[0] = arg0;
+  rec->sr_args[1] = arg1;
+  rec->sr_args[2] = arg2;
+  rec->sr_args[3] = arg3;
+  rec->sr_args[4] = arg4;
+  rec->sr_tid = tid;
+  rec->sr_probe = probe->sp_id;
+  buf->count++;
+}
+
+static sdt_probe_t *sdt_probe_find(unsigned id) {
+  if (id >= (size_t)SET_COUNT(sdt_probes))
+    return NULL;
+  return SET_ITEM(sdt_probes, id);
+}
+
+static void sdt_disable_all(void) {
+  sdt_probe_t **probe_p;
+  SET_FOREACH (probe_p, sdt_probes)
+    atomic_store(&(*probe_p)->sp_enabled, false);
+}
+
+/* Number of records copied out of the buffer at once. */
+#define SDT_READ_BATCH 16
+
+static int sdt_read(devnode_t *dev, uio_t *uio) {
+  sdt_record_t batch[SDT_READ_BATCH];
+  int error = 0;
+
+  /* Only whole records are returned. */
+  if (uio->uio_resid < sizeof(sdt_record_t))
+    return EINVAL;
+
+  while (uio->uio_resid >= sizeof(sdt_record_t) && !error) {
+    size_t n = uio->uio_resid / sizeof(sdt_record_t);
+    n = min(n, (size_t)SDT_READ_BATCH);
+
+    WITH_MTX_LOCK (&sdt_lock) {
+      sdt_buf_t *buf = sdt_buf;
+      n = min(n, buf->count);
+      for (size_t i = 0; i < n; i++)
+        batch[i] = buf->records[(buf->first + i) % SDT_BUFSIZE];
+      buf->first = (buf->first + n) % SDT_BUFSIZE;
+      buf->count -= n;
+    }
+
+    if (n == 0)
+      break;
+
+    error = uiomove(batch, n * sizeof(sdt_record_t), uio);
+  }
+
+  return error;
+}
+
+static int sdt_ioctl(devnode_t *dev, u_long cmd, void *data, int fflags) {
+  sdt_probe_t *probe;
+
+  if (cmd == SDTIOCGPROBE) {
+    sdt_probe_info_t *info = data;
+    if (!(probe = sdt_probe_find(info->spi_id)))
+      return ENOENT;
+    info->spi_enabled = atomic_load(&probe->sp_enabled);
+    strlcpy(info->spi_provider, probe->sp_provider, SDT_NAMELEN);
+    strlcpy(info->spi_name, probe->sp_name, SDT_NAMELEN);
+    strlcpy(info->spi_args, probe->sp_args, SDT_ARGSLEN);
+    return 0;
+  }
+  if (cmd == SDTIOCENABLE || cmd == SDTIOCDISABLE) {
+    if (!(probe = sdt_probe_find(*(unsigned *)data)))
+      return ENOENT;
+    atomic_store(&probe->sp_enabled, cmd == SDTIOCENABLE);
+    return 0;
+  }
+  if (cmd == SDTIOCGDROPS) {
+    WITH_MTX_LOCK (&sdt_lock) {
+      *(unsigned *)data = sdt_buf->dropped;
+    }
+    return 0;
+  }
+  return EINVAL;
+}
+
+static int sdt_open(devnode_t *dev, file_t *fp, int oflags) {
+  if ((oflags & O_ACCMODE) != O_RDONLY)
+    return EACCES;
+
+  /* There's only one buffer, so there can be only one consumer. */
+  int expected = 0;
+  if (!atomic_compare_exchange_strong(&sdt_usecnt, &expected, 1))
+    return EBUSY;
+
+  sdt_buf_t *buf = kmem_alloc(sizeof(sdt_buf_t), M_ZERO);
+  if (buf == NULL) {
+    atomic_store(&sdt_usecnt, 0);
+    return ENOMEM;
+  }
+
+  WITH_MTX_LOCK (&sdt_lock) {
+    sdt_buf = buf;
+  }
+
+  return 0;
+}
+
+static int sdt_close(devnode_t *dev, file_t *fp) {
+  sdt_buf_t *buf;
+
+  sdt_disable_all();
+
+  /* Probes that are firing right now either see the buffer or not. */
+  WITH_MTX_LOCK (&sdt_lock) {
+    buf = sdt_buf;
+    sdt_buf = NULL;
+  }
+
+  kmem_free(buf, sizeof(sdt_buf_t));
+  atomic_store(&sdt_usecnt, 0);
+  return 0;
+}
+
+static devops_t sdt_devops = {
+  .d_type = DT_OTHER,
+  .d_open = sdt_open,
+  .d_close = sdt_close,
+  .d_read = sdt_read,
+  .d_ioctl = sdt_ioctl,
+};
+
+static void init_dev_sdt(void) {
+  sdt_probe_t **probe_p;
+  unsigned id = 0;
+
+  SET_FOREACH (probe_p, sdt_probes)
+    (*probe_p)->sp_id = id++;
+
+  klog("Found %u static tracepoints", id);
+
+  devfs_makedev_new(NULL, "sdt", &sdt_devops, NULL, NULL);
+}
+
+SET_ENTRY(devfs_init, init_dev_sdt);
@@ -109,8 +109,8 @@ static inline bool sig_ignore_ttystop(proc_t *p, signo_t sig) {
 }
 
 int do_sigaction(signo_t sig, const sigaction_t *act, sigaction_t *oldact) {
-  thread_t *td = thread_self();
-  proc_t *p = td->td_proc;
+  proc_t *p = proc_self();
+  thread_t *td;
 
   if (sig >= NSIG)
     return EINVAL;
@@ -124,8 +124,10 @@ int do_sigaction(signo_t sig, const sigaction_t *act, sigaction_t *oldact) {
     if (act != NULL)
       memcpy(&p->p_sigactions[sig], act, sizeof(sigaction_t));
     /* If ignoring a pending signal, discard it. */
-    if (sig_ignored(p->p_sigactions, sig))
-      sigpend_get(&td->td_sigpend, sig, NULL);
+    if (sig_ignored(p->p_sigactions, sig)) {
+      TAILQ_FOREACH (td, &p->p_threads, td_procq)
+        sigpend_get(&td->td_sigpend, sig, NULL);
+    }
   }
 
   return 0;
@@ -146,9 +148,8 @@ static signo_t sig_pending(thread_t *td) {
 }
 
 int do_sigprocmask(int how, const sigset_t *set, sigset_t *oset) {
-  proc_t *proc = proc_self();
-  thread_t *td = proc->p_thread;
-  assert(mtx_owned(&proc->p_lock));
+  thread_t *td = thread_self();
+  assert(mtx_owned(&td->td_proc->p_lock));
 
   sigset_t *const mask = &td->td_sigmask;
 
@@ -182,7 +183,7 @@ int do_sigprocmask(int how, const sigset_t *set, sigset_t *oset) {
   return 0;
 }
 
-int do_sigsuspend(proc_t *p, const sigset_t *mask) {
+void sig_savemask(proc_t *p, const sigset_t *mask) {
   thread_t *td = thread_self();
   assert(td->td_proc == p);
 
@@ -193,6 +194,26 @@ int do_sigsuspend(proc_t *p, const sigset_t *mask) {
   WITH_PROC_LOCK(p) {
     do_sigprocmask(SIG_SETMASK, mask, NULL);
   }
+}
+
+void sig_restoremask(proc_t *p) {
+  thread_t *td = thread_self();
+  assert(td->td_proc == p);
+
+  if (!(td->td_pflags & TDP_OLDSIGMASK))
+    return;
+
+  td->td_pflags &= ~TDP_OLDSIGMASK;
+
+  WITH_PROC_LOCK(p) {
+    do_sigprocmask(SIG_SETMASK, &td->td_oldsigmask, NULL);
+  }
+}
+
+int do_sigsuspend(proc_t *p, const sigset_t *mask) {
+  thread_t *td = thread_self();
+
+  sig_savemask(p, mask);
 
   int error;
   error = sleepq_wait_intr(&td->td_sigmask, "sigsuspend()", NULL);
@@ -203,7 +224,7 @@ int do_sigsuspend(proc_t *p, const sigset_t *mask) {
 
 int do_sigpending(proc_t *p, sigset_t *set) {
   SCOPED_MTX_LOCK(&p->p_lock);
-  thread_t *td = p->p_thread;
+  thread_t *td = thread_self();
 
   *set = td->td_sigpend.sp_set;
   /* Only blocked pending signals are reported. */
@@ -343,10 +364,30 @@ void sig_child(proc_t *p, int code) {
   sig_kill(parent, &ksi);
 }
 
+/* Signals generated by a trap are delivered to the thread that caused it.
+ * Others are delivered to the first thread that doesn't block the signal,
+ * or become pending for the first thread if all threads block it. */
+static thread_t *sig_select_thread(proc_t *p, ksiginfo_t *ksi) {
+  thread_t *td;
+
+  if (ksi->ksi_flags & KSI_TRAP) {
+    td = thread_self();
+    assert(td->td_proc == p);
+    return td;
+  }
+
+  TAILQ_FOREACH (td, &p->p_threads, td_procq) {
+    if (!__sigismember(&td->td_sigmask, ksi->ksi_signo))
+      return td;
+  }
+
+  return TAILQ_FIRST(&p->p_threads);
+}
+
 /*
  * NOTE: This is a very simple implementation! Unimplemented features:
  * - Thread tracing and debugging
- * - Multiple threads in a process
+ * - Process-wide pending signals (a signal becomes pending for one thread)
  * These limitations (plus the fact that we currently have very little thread
  * states) make the logic of sending a signal very simple!
  */
@@ -362,7 +403,7 @@ void sig_kill(proc_t *p, ksiginfo_t *ksi) {
   if (!proc_is_alive(p))
     return;
 
-  thread_t *td = p->p_thread;
+  thread_t *td;
   bool ignored = sig_ignored(p->p_sigactions, sig);
 
   if (ignored && !sigprop_cont(sig))
@@ -376,15 +417,19 @@ void sig_kill(proc_t *p, ksiginfo_t *ksi) {
   /* If sending a stop or continue signal,
    * remove pending signals with the opposite effect. */
   if (defact_stop(sig)) {
-    sigpend_get(&td->td_sigpend, SIGCONT, NULL);
+    TAILQ_FOREACH (td, &p->p_threads, td_procq)
+      sigpend_get(&td->td_sigpend, SIGCONT, NULL);
   } else if (sigprop_cont(sig)) {
-    sigpend_delete_set(&td->td_sigpend, &stopmask);
+    TAILQ_FOREACH (td, &p->p_threads, td_procq)
+      sigpend_delete_set(&td->td_sigpend, &stopmask);
     if (p->p_state == PS_STOPPED)
       proc_continue(p);
     if (ignored)
       return;
   }
 
+  td = sig_select_thread(p, ksi);
+
   /* At this point we know the signal isn't ignored, so make it pending. */
   sigpend_put(&td->td_sigpend, ksiginfo_copy(ksi));
 
@@ -417,9 +462,23 @@ void sig_pgkill(pgrp_t *pg, ksiginfo_t *ksi) {
   }
 }
 
+void sig_redirect(proc_t *p, thread_t *td) {
+  assert(mtx_owned(&p->p_lock));
+
+  signo_t sig;
+  ksiginfo_t ksi;
+
+  while ((sig = __sigfindset(&td->td_sigpend.sp_set))) {
+    sigpend_get(&td->td_sigpend, sig, &ksi);
+    ksi.ksi_flags &= ~KSI_TRAP;
+    sig_kill(p, &ksi);
+  }
+}
+
 void sig_onexec(proc_t *p) {
   assert(mtx_owned(&p->p_lock));
-  thread_t *td = p->p_thread;
+  assert(p->p_nthreads == 1);
+  thread_t *td = TAILQ_FIRST(&p->p_threads);
 
   /* The signal mask, pending and ignored signals remain unchanged.
    * Caught signals have their action reset to SIG_DFL.
@@ -460,7 +519,20 @@ int sig_check(thread_t *td, ksiginfo_t *out) {
   assert(p != NULL);
   assert(mtx_owned(&p->p_lock));
 
-  while ((sig = sig_pending(td))) {
+  for (;;) {
+    /* Another thread terminates the process or executes a new program. */
+    if (p->p_singlethread != NULL && p->p_singlethread != td)
+      proc_thread_exit(0);
+
+    /* Another thread has stopped the process. */
+    if (p->p_state == PS_STOPPED) {
+      proc_thread_stop();
+      continue;
+    }
+
+    if (!(sig = sig_pending(td)))
+      break;
+
     sigpend_get(&td->td_sigpend, sig, out);
 
     /* We should never get a pending signal that's ignored,
@@ -11,6 +11,7 @@
 #include <sys/interrupt.h>
 #include <sys/errno.h>
 #include <sys/callout.h>
+#include <sys/hrtimer.h>
 
 #define SC_TABLESIZE 256 /* Must be power of 2. */
 #define SC_MASK (SC_TABLESIZE - 1)
@@ -298,33 +299,36 @@ static void sq_timeout(thread_t *td) {
   _sleepq_abort(td, ETIMEDOUT);
 }
 
-int sleepq_wait_timed(void *wchan, const void *waitpt, mtx_t *mtx,
-                      systime_t timeout) {
+/* Timeout is given either in system ticks or as absolute time if `deadline`
+ * is not NULL. The latter is handled by a high-resolution timer. */
+static int sq_wait_timed(void *wchan, const void *waitpt, mtx_t *mtx,
+                         systime_t timeout, const bintime_t *deadline) {
   thread_t *td = thread_self();
+  bool timed = (timeout > 0) || deadline;
   int error = 0;
 
-  if (waitpt == NULL)
-    waitpt = __caller(0);
-
   sleepq_chain_t *sc = sc_acquire(wchan);
   if (mtx)
     mtx_unlock(mtx);
   mtx_lock(td->td_lock);
 
   /* If there are pending signals, interrupt the sleep immediately. */
-  if ((td->td_flags & TDF_NEEDSIGCHK) && (timeout == 0)) {
+  if ((td->td_flags & TDF_NEEDSIGCHK) && !timed) {
     mtx_unlock(td->td_lock);
     sc_release(sc);
     error = EINTR;
     goto end;
   }
 
-  if (timeout > 0) {
-    callout_setup(&td->td_slpcallout, (timeout_t)sq_timeout, td);
+  if (deadline) {
+    hrtimer_setup(&td->td_slptimer, (hrtimer_func_t)sq_timeout, td);
+    hrtimer_start(&td->td_slptimer, *deadline);
+  } else if (timeout > 0) {
+    callout_setup_direct(&td->td_slpcallout, (timeout_t)sq_timeout, td);
     callout_schedule(&td->td_slpcallout, timeout);
   }
 
-  td->td_flags |= (timeout > 0) ? TDF_SLPTIMED : TDF_SLPINTR;
+  td->td_flags |= timed ? TDF_SLPTIMED : TDF_SLPINTR;
   sq_enter(td, sc, wchan, waitpt);
 
   /* After wakeup, only one of the following flags may be set:
@@ -339,7 +343,9 @@ int sleepq_wait_timed(void *wchan, const void *waitpt, mtx_t *mtx,
     td->td_flags &= ~(TDF_SLPINTR | TDF_SLPTIMED);
   }
 
-  if (timeout > 0)
+  if (deadline)
+    hrtimer_stop(&td->td_slptimer);
+  else if (timeout > 0)
     callout_stop(&td->td_slpcallout);
 
 end:
@@ -347,3 +353,19 @@ end:
     mtx_lock(mtx);
   return error;
 }
+
+int sleepq_wait_timed(void *wchan, const void *waitpt, mtx_t *mtx,
+                      systime_t timeout) {
+  if (waitpt == NULL)
+    waitpt = __caller(0);
+
+  return sq_wait_timed(wchan, waitpt, mtx, timeout, NULL);
+}
+
+int sleepq_wait_until(void *wchan, const void *waitpt, mtx_t *mtx,
+                      bintime_t deadline) {
+  if (waitpt == NULL)
+    waitpt = __caller(0);
+
+  return sq_wait_timed(wchan, waitpt, mtx, 0, &deadline);
+}
@@ -0,0 +1,217 @@
+#define KL_LOG KL_PROC
+#include <sys/klog.h>
+#define _EXEC_IMPL
+#include <sys/exec.h>
+#include <sys/mimiker.h>
+#include <sys/context.h>
+#include <sys/cred.h>
+#include <sys/errno.h>
+#include <sys/fcntl.h>
+#include <sys/file.h>
+#include <sys/malloc.h>
+#include <sys/proc.h>
+#include <sys/signal.h>
+#include <sys/spawn.h>
+#include <sys/syslimits.h>
+#include <sys/thread.h>
+#include <sys/vfs.h>
+#include <sys/wait.h>
+
+/* Upper limit on number of file actions passed to posix_spawn. */
+#define SPAWN_FAE_MAX 64
+
+/* Everything the child needs to start a new program. The structure lives on
+ * the parent's kernel stack, which is safe since the parent waits in `do_fork`
+ * until the child either enters a new program or exits. */
+typedef struct spawn_data {
+  exec_args_t sd_args;
+  posix_spawnattr_t sd_attr;
+  bool sd_has_attr;
+  posix_spawn_file_actions_entry_t *sd_fae;
+  unsigned sd_nfae;
+  int sd_error; /* set by the child if it failed to start the program */
+} spawn_data_t;
+
+static void spawn_fae_destroy(spawn_data_t *sd) {
+  for (unsigned i = 0; i < sd->sd_nfae; i++)
+    if (sd->sd_fae[i].fae_action == FAE_OPEN)
+      kfree(M_TEMP, sd->sd_fae[i].fae_data.open.path);
+  kfree(M_TEMP, sd->sd_fae);
+}
+
+static int spawn_fae_copyin(spawn_data_t *sd,
+                            const posix_spawn_file_actions_t *u_fa) {
+  posix_spawn_file_actions_t fa;
+  int error;
+
+  if ((error = copyin_s(u_fa, fa)))
+    return error;
+
+  if (fa.len == 0)
+    return 0;
+
+  if (fa.len > SPAWN_FAE_MAX)
+    return EINVAL;
+
+  size_t size = fa.len * sizeof(posix_spawn_file_actions_entry_t);
+  sd->sd_fae = kmalloc(M_TEMP, size, 0);
+
+  if ((error = copyin(fa.fae, sd->sd_fae, size)))
+    return error;
+
+  for (unsigned i = 0; i < fa.len; i++) {
+    posix_spawn_file_actions_entry_t *fae = &sd->sd_fae[i];
+
+    if (fae->fae_action != FAE_OPEN)
+      continue;
+
+    const char *u_path = fae->fae_data.open.path;
+    fae->fae_data.open.path = kmalloc(M_TEMP, PATH_MAX, 0);
+    /* Let spawn_fae_destroy free paths copied so far. */
+    sd->sd_nfae = i + 1;
+
+    if ((error = copyinstr(u_path, fae->fae_data.open.path, PATH_MAX, NULL)))
+      return error;
+  }
+
+  sd->sd_nfae = fa.len;
+  return 0;
+}
+
+static int spawn_apply_attr(proc_t *p, posix_spawnattr_t *attr) {
+  int error;
+
+  if (attr->sa_flags & POSIX_SPAWN_SETSID)
+    if ((error = session_enter(p)))
+      return error;
+
+  if (attr->sa_flags & POSIX_SPAWN_SETPGROUP) {
+    pgid_t pgid = attr->sa_pgroup ? attr->sa_pgroup : p->p_pid;
+    if ((error = pgrp_enter(p, p->p_pid, pgid)))
+      return error;
+  }
+
+  if (attr->sa_flags & POSIX_SPAWN_RESETIDS) {
+    if ((error = do_setresuid(p, -1, p->p_cred.cr_ruid, -1)) ||
+        (error = do_setresgid(p, -1, p->p_cred.cr_rgid, -1)))
+      return error;
+  }
+
+  if (attr->sa_flags & POSIX_SPAWN_SETSIGMASK) {
+    WITH_PROC_LOCK(p) {
+      do_sigprocmask(SIG_SETMASK, &attr->sa_sigmask, NULL);
+    }
+  }
+
+  if (attr->sa_flags & POSIX_SPAWN_SETSIGDEF) {
+    sigaction_t sa = {.sa_handler = SIG_DFL};
+    /* Signals that cannot be caught are always handled by default action,
+     * hence it's fine to ignore errors here. */
+    for (signo_t sig = 1; sig < NSIG; sig++)
+      if (__sigismember(&attr->sa_sigdefault, sig))
+        do_sigaction(sig, &sa, NULL);
+  }
+
+  return 0;
+}
+
+static int spawn_apply_fae(proc_t *p, posix_spawn_file_actions_entry_t *fae) {
+  int error, fd, res;
+
+  switch (fae->fae_action) {
+    case FAE_OPEN:
+      if ((error = do_open(p, fae->fae_data.open.path, fae->fae_data.open.oflag,
+                           fae->fae_data.open.mode, &fd)))
+        return error;
+      if (fd == fae->fae_fildes)
+        return 0;
+      error = do_dup2(p, fd, fae->fae_fildes);
+      do_close(p, fd);
+      return error;
+
+    case FAE_DUP2:
+      /* Descriptor duplicated onto itself must survive exec. */
+      if (fae->fae_fildes == fae->fae_data.dup2.newfildes)
+        return do_fcntl(p, fae->fae_fildes, F_SETFD, 0, &res);
+      return do_dup2(p, fae->fae_fildes, fae->fae_data.dup2.newfildes);
+
+    case FAE_CLOSE:
+      return do_close(p, fae->fae_fildes);
+
+    default:
+      return EINVAL;
+  }
+}
+
+/* Runs in the context of the child process that has an empty address space,
+ * so the only way back to user space leads through a successful exec. */
+static __noreturn void spawn_start(void *arg) {
+  spawn_data_t *sd = arg;
+  thread_t *td = thread_self();
+  proc_t *p = td->td_proc;
+  int error = 0;
+
+  if (sd->sd_has_attr)
+    error = spawn_apply_attr(p, &sd->sd_attr);
+
+  for (unsigned i = 0; i < sd->sd_nfae && !error; i++)
+    error = spawn_apply_fae(p, &sd->sd_fae[i]);
+
+  if (!error)
+    error = exec_program(&sd->sd_args);
+
+  if (error == EJUSTRETURN) {
+    /* `sd` may be already gone, since the parent was woken up by exec. */
+    sig_userret(td->td_uctx, NULL);
+    user_exc_leave();
+  }
+
+  klog("Failed to spawn a program with error %d", error);
+
+  /* Parent is still waiting for us, so it's safe to report the error. */
+  sd->sd_error = error;
+  proc_lock(p);
+  proc_exit(MAKE_STATUS_EXIT(127));
+}
+
+int do_posix_spawn(proc_t *p, pid_t *pidp, const char *u_path,
+                   const posix_spawn_file_actions_t *u_fa,
+                   const posix_spawnattr_t *u_attr, char *const *u_argp,
+                   char *const *u_envp) {
+  spawn_data_t sd = {};
+  int error, status;
+  pid_t pid;
+
+  exec_args_init(&sd.sd_args);
+
+  if ((error = exec_args_copyin(&sd.sd_args, u_path, u_argp, u_envp)))
+    goto end;
+
+  if (u_attr) {
+    if ((error = copyin_s(u_attr, sd.sd_attr)))
+      goto end;
+    sd.sd_has_attr = true;
+  }
+
+  if (u_fa && (error = spawn_fae_copyin(&sd, u_fa)))
+    goto end;
+
+  /* Returns when the child has entered the new program or has exited. */
+  if ((error = do_fork(spawn_start, &sd, FORK_WAIT, &pid)))
+    goto end;
+
+  if (sd.sd_error) {
+    /* The child has failed, so there's no point in leaving it as a zombie. */
+    do_waitpid(pid, &status, 0, &pid);
+    error = sd.sd_error;
+    goto end;
+  }
+
+  *pidp = pid;
+
+end:
+  if (sd.sd_fae)
+    spawn_fae_destroy(&sd);
+  exec_args_destroy(&sd.sd_args);
+  return error;
+}
@@ -10,6 +10,7 @@
 #include <sys/sbrk.h>
 #include <sys/signal.h>
 #include <sys/proc.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/exec.h>
@@ -25,6 +26,12 @@
 #include <sys/statvfs.h>
 #include <sys/pty.h>
 #include <sys/event.h>
+#include <sys/poll.h>
+#include <sys/select.h>
+#include <sys/futex.h>
+#include <sys/thr.h>
+#include <sys/spawn.h>
+#include <sys/unistd.h>
 
 #include "sysent.h"
 
@@ -55,7 +62,47 @@ static int sys_fork(proc_t *p, void *args, register_t *res) {
 
   klog("fork()");
 
-  if ((error = do_fork(NULL, NULL, &pid)))
+  if ((error = do_fork(NULL, NULL, 0, &pid)))
+    return error;
+
+  *res = pid;
+  return 0;
+}
+
+/* https://pubs.opengroup.org/onlinepubs/7908799/xsh/vfork.html */
+static int sys_vfork(proc_t *p, void *args, register_t *res) {
+  int error;
+  pid_t pid;
+
+  klog("vfork()");
+
+  if ((error = do_fork(NULL, NULL, FORK_SHAREVM | FORK_WAIT, &pid)))
+    return error;
+
+  *res = pid;
+  return 0;
+}
+
+/* https://man.freebsd.org/cgi/man.cgi?query=rfork */
+static int sys_rfork(proc_t *p, rfork_args_t *args, register_t *res) {
+  int flags = SCARG(args, flags);
+  int fork_flags = 0;
+  int error;
+  pid_t pid;
+
+  klog("rfork(0x%x)", flags);
+
+  /* Only creation of a new process is supported. */
+  if (!(flags & RFPROC) || (flags & ~(RFPROC | RFFDG | RFCFDG)) ||
+      ((flags & RFFDG) && (flags & RFCFDG)))
+    return EINVAL;
+
+  if (flags & RFCFDG)
+    fork_flags |= FORK_CLEANFD;
+  else if (!(flags & RFFDG))
+    fork_flags |= FORK_SHAREFD;
+
+  if ((error = do_fork(NULL, NULL, fork_flags, &pid)))
     return error;
 
   *res = pid;
@@ -625,7 +672,7 @@ static int sys_setcontext(proc_t *p, setcontext_args_t *args, register_t *res) {
   ucontext_t uc;
   copyin_s(ucp, uc);
 
-  return do_setcontext(p->p_thread, &uc);
+  return do_setcontext(thread_self(), &uc);
 }
 
 static int sys_ioctl(proc_t *p, ioctl_args_t *args, register_t *res) {
@@ -1249,6 +1296,21 @@ static int sys_getitimer(proc_t *p, getitimer_args_t *args, register_t *res) {
   return copyout_s(tval, u_tval);
 }
 
+static int sys_getrusage(proc_t *p, getrusage_args_t *args, register_t *res) {
+  int who = SCARG(args, who);
+  struct rusage *u_rusage = SCARG(args, rusage);
+  int error;
+
+  klog("getrusage(%d, %p)", who, u_rusage);
+
+  struct rusage ru;
+
+  if ((error = do_getrusage(who, &ru)))
+    return error;
+
+  return copyout_s(ru, u_rusage);
+}
+
 static int sys_setitimer(proc_t *p, setitimer_args_t *args, register_t *res) {
   int which = SCARG(args, which);
   struct itimerval *u_tval = SCARG(args, val);
@@ -1270,6 +1332,90 @@ static int sys_setitimer(proc_t *p, setitimer_args_t *args, register_t *res) {
   return error;
 }
 
+static int sys_timer_create(proc_t *p, timer_create_args_t *args,
+                            register_t *res) {
+  clockid_t clock_id = SCARG(args, clock_id);
+  struct sigevent *u_evp = SCARG(args, evp);
+  int *u_timerid = SCARG(args, timerid);
+  int error, timerid;
+
+  klog("timer_create(%d, %p, %p)", clock_id, u_evp, u_timerid);
+
+  sigevent_t ev;
+  if (u_evp && (error = copyin_s(u_evp, ev)))
+    return error;
+
+  if ((error = do_timer_create(p, clock_id, u_evp ? &ev : NULL, &timerid)))
+    return error;
+
+  if ((error = copyout_s(timerid, u_timerid)))
+    do_timer_delete(p, timerid);
+
+  return error;
+}
+
+static int sys_timer_delete(proc_t *p, timer_delete_args_t *args,
+                            register_t *res) {
+  int timerid = SCARG(args, timerid);
+
+  klog("timer_delete(%d)", timerid);
+
+  return do_timer_delete(p, timerid);
+}
+
+static int sys_timer_settime(proc_t *p, timer_settime_args_t *args,
+                             register_t *res) {
+  int timerid = SCARG(args, timerid);
+  int flags = SCARG(args, flags);
+  const struct itimerspec *u_value = SCARG(args, value);
+  struct itimerspec *u_ovalue = SCARG(args, ovalue);
+  int error;
+
+  klog("timer_settime(%d, %d, %p, %p)", timerid, flags, u_value, u_ovalue);
+
+  struct itimerspec value, ovalue;
+  if ((error = copyin_s(u_value, value)))
+    return error;
+
+  if ((error = do_timer_settime(p, timerid, flags, &value,
+                                u_ovalue ? &ovalue : NULL)))
+    return error;
+
+  if (u_ovalue)
+    error = copyout_s(ovalue, u_ovalue);
+
+  return error;
+}
+
+static int sys_timer_gettime(proc_t *p, timer_gettime_args_t *args,
+                             register_t *res) {
+  int timerid = SCARG(args, timerid);
+  struct itimerspec *u_value = SCARG(args, value);
+  int error;
+
+  klog("timer_gettime(%d, %p)", timerid, u_value);
+
+  struct itimerspec value;
+  if ((error = do_timer_gettime(p, timerid, &value)))
+    return error;
+
+  return copyout_s(value, u_value);
+}
+
+static int sys_timer_getoverrun(proc_t *p, timer_getoverrun_args_t *args,
+                                register_t *res) {
+  int timerid = SCARG(args, timerid);
+  int error, overrun;
+
+  klog("timer_getoverrun(%d)", timerid);
+
+  if ((error = do_timer_getoverrun(p, timerid, &overrun)))
+    return error;
+
+  *res = overrun;
+  return 0;
+}
+
 static int sys_sync(proc_t *p, void *args, register_t *res) {
   /* TODO(mohrcore): implement buffering */
   return 0;
@@ -1331,6 +1477,205 @@ end:
   return error;
 }
 
+static int sys_ppoll(proc_t *p, ppoll_args_t *args, register_t *res) {
+  struct pollfd *u_fds = SCARG(args, fds);
+  nfds_t nfds = SCARG(args, nfds);
+  const struct timespec *u_ts = SCARG(args, ts);
+  const sigset_t *u_set = SCARG(args, set);
+  pollfd_t *fds = NULL;
+  timespec_t ts;
+  sigset_t set;
+  int error, nready;
+
+  klog("ppoll(%p, %u, %p, %p)", u_fds, nfds, u_ts, u_set);
+
+  if (nfds > FD_SETSIZE)
+    return EINVAL;
+
+  fds = kmalloc(M_TEMP, nfds * sizeof(pollfd_t), 0);
+
+  if ((error = copyin(u_fds, fds, nfds * sizeof(pollfd_t))))
+    goto end;
+
+  if (u_ts && (error = copyin_s(u_ts, ts)))
+    goto end;
+
+  if (u_set && (error = copyin_s(u_set, set)))
+    goto end;
+
+  if (u_set)
+    sig_savemask(p, &set);
+
+  error = do_poll(p, fds, nfds, u_ts ? &ts : NULL, &nready);
+
+  /* If interrupted, the mask will be restored once the handler returns. */
+  if (u_set && error != EINTR)
+    sig_restoremask(p);
+
+  if (error)
+    goto end;
+
+  if ((error = copyout(fds, u_fds, nfds * sizeof(pollfd_t))))
+    goto end;
+
+  *res = nready;
+
+end:
+  kfree(M_TEMP, fds);
+  return error;
+}
+
+static int sys_pselect(proc_t *p, pselect_args_t *args, register_t *res) {
+  int nfds = SCARG(args, nfds);
+  fd_set *u_readfds = SCARG(args, readfds);
+  fd_set *u_writefds = SCARG(args, writefds);
+  fd_set *u_exceptfds = SCARG(args, exceptfds);
+  const struct timespec *u_timeout = SCARG(args, timeout);
+  const sigset_t *u_set = SCARG(args, set);
+  fd_set readfds, writefds, exceptfds;
+  timespec_t timeout;
+  sigset_t set;
+  int error, nready;
+
+  klog("pselect(%d, %p, %p, %p, %p, %p)", nfds, u_readfds, u_writefds,
+       u_exceptfds, u_timeout, u_set);
+
+  if (nfds < 0 || nfds > FD_SETSIZE)
+    return EINVAL;
+
+  /* Only the first `nfds` bits of each set are passed in and out. */
+  size_t nbytes = __NFD_BYTES(nfds);
+
+  FD_ZERO(&readfds);
+  FD_ZERO(&writefds);
+  FD_ZERO(&exceptfds);
+
+  if (u_readfds && (error = copyin(u_readfds, &readfds, nbytes)))
+    return error;
+  if (u_writefds && (error = copyin(u_writefds, &writefds, nbytes)))
+    return error;
+  if (u_exceptfds && (error = copyin(u_exceptfds, &exceptfds, nbytes)))
+    return error;
+
+  if (u_timeout && (error = copyin_s(u_timeout, timeout)))
+    return error;
+
+  if (u_set && (error = copyin_s(u_set, set)))
+    return error;
+
+  if (u_set)
+    sig_savemask(p, &set);
+
+  error = do_select(p, nfds, u_readfds ? &readfds : NULL,
+                    u_writefds ? &writefds : NULL,
+                    u_exceptfds ? &exceptfds : NULL,
+                    u_timeout ? &timeout : NULL, &nready);
+
+  /* If interrupted, the mask will be restored once the handler returns. */
+  if (u_set && error != EINTR)
+    sig_restoremask(p);
+
+  if (error)
+    return error;
+
+  if (u_readfds && (error = copyout(&readfds, u_readfds, nbytes)))
+    return error;
+  if (u_writefds && (error = copyout(&writefds, u_writefds, nbytes)))
+    return error;
+  if (u_exceptfds && (error = copyout(&exceptfds, u_exceptfds, nbytes)))
+    return error;
+
+  *res = nready;
+  return 0;
+}
+
+static int sys_futex(proc_t *p, futex_args_t *args, register_t *res) {
+  int *uaddr = SCARG(args, uaddr);
+  int op = SCARG(args, op);
+  int val = SCARG(args, val);
+  const struct timespec *u_timeout = SCARG(args, timeout);
+  int *uaddr2 = SCARG(args, uaddr2);
+  int val2 = SCARG(args, val2);
+  timespec_t timeout;
+  int error, count;
+
+  klog("futex(%p, %d, %d, %p, %p, %d)", uaddr, op, val, u_timeout, uaddr2,
+       val2);
+
+  if (u_timeout && (error = copyin_s(u_timeout, timeout)))
+    return error;
+
+  if ((error = do_futex(p, uaddr, op, val, u_timeout ? &timeout : NULL, uaddr2,
+                        val2, &count)))
+    return error;
+
+  *res = count;
+  return 0;
+}
+
+static int sys_thr_new(proc_t *p, thr_new_args_t *args, register_t *res) {
+  struct thr_param *u_param = SCARG(args, param);
+  thr_param_t param;
+  tid_t tid;
+  int error;
+
+  klog("thr_new(%p)", u_param);
+
+  if ((error = copyin_s(u_param, param)))
+    return error;
+
+  if ((error = do_thr_new(p, &param, &tid)))
+    return error;
+
+  *res = tid;
+  return 0;
+}
+
+static int sys_thr_exit(proc_t *p, thr_exit_args_t *args, register_t *res) {
+  int *state = SCARG(args, state);
+  klog("thr_exit(%p)", state);
+  do_thr_exit(p, state);
+  __unreachable();
+}
+
+static int sys_thr_self(proc_t *p, void *args, register_t *res) {
+  klog("thr_self()");
+  *res = thread_self()->td_tid;
+  return 0;
+}
+
+static int sys_thr_settls(proc_t *p, thr_settls_args_t *args,
+                          register_t *res) {
+  void *tls = SCARG(args, tls);
+  klog("thr_settls(%p)", tls);
+  mcontext_set_tls(thread_self()->td_uctx, tls);
+  return 0;
+}
+
+static int sys_posix_spawn(proc_t *p, posix_spawn_args_t *args,
+                           register_t *res) {
+  pid_t *u_pid = SCARG(args, pid);
+  const char *u_path = SCARG(args, path);
+  const posix_spawn_file_actions_t *u_fa = SCARG(args, file_actions);
+  const posix_spawnattr_t *u_attr = SCARG(args, attrp);
+  char *const *u_argp = SCARG(args, argv);
+  char *const *u_envp = SCARG(args, envp);
+  pid_t pid;
+  int error;
+
+  klog("posix_spawn(%p, %p, %p, %p, %p, %p)", u_pid, u_path, u_fa, u_attr,
+       u_argp, u_envp);
+
+  /* do_posix_spawn handles copying data from user-space */
+  if ((error = do_posix_spawn(p, &pid, u_path, u_fa, u_attr, u_argp, u_envp)))
+    return error;
+
+  if (u_pid)
+    error = copyout_s(pid, u_pid);
+
+  return error;
+}
+
 static int sys_sigtimedwait(proc_t *p, sigtimedwait_args_t *args,
                             register_t *res) {
   return ENOTSUP;
@@ -93,6 +93,22 @@ static int sys_kqueue1(proc_t *, kqueue1_args_t *, register_t *);
 static int sys_kevent(proc_t *, kevent_args_t *, register_t *);
 static int sys_sigtimedwait(proc_t *, sigtimedwait_args_t *, register_t *);
 static int sys_clock_settime(proc_t *, clock_settime_args_t *, register_t *);
+static int sys_ppoll(proc_t *, ppoll_args_t *, register_t *);
+static int sys_pselect(proc_t *, pselect_args_t *, register_t *);
+static int sys_futex(proc_t *, futex_args_t *, register_t *);
+static int sys_thr_new(proc_t *, thr_new_args_t *, register_t *);
+static int sys_thr_exit(proc_t *, thr_exit_args_t *, register_t *);
+static int sys_thr_self(proc_t *, void *, register_t *);
+static int sys_thr_settls(proc_t *, thr_settls_args_t *, register_t *);
+static int sys_vfork(proc_t *, void *, register_t *);
+static int sys_posix_spawn(proc_t *, posix_spawn_args_t *, register_t *);
+static int sys_rfork(proc_t *, rfork_args_t *, register_t *);
+static int sys_getrusage(proc_t *, getrusage_args_t *, register_t *);
+static int sys_timer_create(proc_t *, timer_create_args_t *, register_t *);
+static int sys_timer_delete(proc_t *, timer_delete_args_t *, register_t *);
+static int sys_timer_settime(proc_t *, timer_settime_args_t *, register_t *);
+static int sys_timer_gettime(proc_t *, timer_gettime_args_t *, register_t *);
+static int sys_timer_getoverrun(proc_t *, timer_getoverrun_args_t *, register_t *);
 
 struct sysent sysent[] = {
   [SYS_syscall] = { .name = "syscall", .nargs = 1, .call = (syscall_t *)sys_syscall },
@@ -183,5 +199,21 @@ struct sysent sysent[] = {
   [SYS_kevent] = { .name = "kevent", .nargs = 6, .call = (syscall_t *)sys_kevent },
   [SYS_sigtimedwait] = { .name = "sigtimedwait", .nargs = 3, .call = (syscall_t *)sys_sigtimedwait },
   [SYS_clock_settime] = { .name = "clock_settime", .nargs = 2, .call = (syscall_t *)sys_clock_settime },
+  [SYS_ppoll] = { .name = "ppoll", .nargs = 4, .call = (syscall_t *)sys_ppoll },
+  [SYS_pselect] = { .name = "pselect", .nargs = 6, .call = (syscall_t *)sys_pselect },
+  [SYS_futex] = { .name = "futex", .nargs = 6, .call = (syscall_t *)sys_futex },
+  [SYS_thr_new] = { .name = "thr_new", .nargs = 1, .call = (syscall_t *)sys_thr_new },
+  [SYS_thr_exit] = { .name = "thr_exit", .nargs = 1, .call = (syscall_t *)sys_thr_exit },
+  [SYS_thr_self] = { .name = "thr_self", .nargs = 0, .call = (syscall_t *)sys_thr_self },
+  [SYS_thr_settls] = { .name = "thr_settls", .nargs = 1, .call = (syscall_t *)sys_thr_settls },
+  [SYS_vfork] = { .name = "vfork", .nargs = 0, .call = (syscall_t *)sys_vfork },
+  [SYS_posix_spawn] = { .name = "posix_spawn", .nargs = 6, .call = (syscall_t *)sys_posix_spawn },
+  [SYS_rfork] = { .name = "rfork", .nargs = 1, .call = (syscall_t *)sys_rfork },
+  [SYS_getrusage] = { .name = "getrusage", .nargs = 2, .call = (syscall_t *)sys_getrusage },
+  [SYS_timer_create] = { .name = "timer_create", .nargs = 3, .call = (syscall_t *)sys_timer_create },
+  [SYS_timer_delete] = { .name = "timer_delete", .nargs = 1, .call = (syscall_t *)sys_timer_delete },
+  [SYS_timer_settime] = { .name = "timer_settime", .nargs = 4, .call = (syscall_t *)sys_timer_settime },
+  [SYS_timer_gettime] = { .name = "timer_gettime", .nargs = 2, .call = (syscall_t *)sys_timer_gettime },
+  [SYS_timer_getoverrun] = { .name = "timer_getoverrun", .nargs = 1, .call = (syscall_t *)sys_timer_getoverrun },
 };
 
@@ -0,0 +1,67 @@
+#define KL_LOG KL_PROC
+#include <sys/klog.h>
+#include <sys/mimiker.h>
+#include <sys/context.h>
+#include <sys/errno.h>
+#include <sys/futex.h>
+#include <sys/param.h>
+#include <sys/proc.h>
+#include <sys/sched.h>
+#include <sys/signal.h>
+#include <sys/thr.h>
+#include <sys/thread.h>
+#include <sys/wait.h>
+#include <machine/abi.h>
+
+/* Before entering user space for the first time a new thread has to check
+ * whether it should exit, stop or handle a signal. */
+static void thr_start(void *arg) {
+  thread_t *td = thread_self();
+  sig_userret(td->td_uctx, NULL);
+  user_exc_leave();
+}
+
+int do_thr_new(proc_t *p, thr_param_t *param, tid_t *tidp) {
+  thread_t *td = thread_self();
+  vaddr_t stack_top = (vaddr_t)param->stack_base + param->stack_size;
+
+  if (param->start_func == NULL || param->stack_size == 0 ||
+      stack_top < (vaddr_t)param->stack_base)
+    return EINVAL;
+
+  thread_t *newtd =
+    thread_create(td->td_name, thr_start, NULL, td->td_base_prio);
+
+  /* New thread inherits user context of the creator, except for registers
+   * that take part in calling the entry point. */
+  mcontext_copy(newtd->td_uctx, td->td_uctx);
+  mcontext_setup_thread(newtd->td_uctx, param->start_func,
+                        (void *)rounddown2(stack_top, STACK_ALIGN),
+                        (register_t)param->arg);
+  mcontext_set_tls(newtd->td_uctx, param->tls_base);
+
+  WITH_PROC_LOCK(p) {
+    newtd->td_sigmask = td->td_sigmask;
+    proc_thread_add(p, newtd);
+  }
+
+  klog("Thread %u created in process PID(%d)", newtd->td_tid, p->p_pid);
+
+  *tidp = newtd->td_tid;
+
+  /* After this point you cannot access the thread without a lock. */
+  sched_add(newtd);
+
+  return 0;
+}
+
+__noreturn void do_thr_exit(proc_t *p, int *state) {
+  int one = 1, count;
+
+  /* Errors are ignored, as there's nobody we could report them to. */
+  if (state != NULL && !copyout_s(one, state))
+    do_futex(p, state, FUTEX_WAKE, INT_MAX, NULL, NULL, 0, &count);
+
+  proc_lock(p);
+  proc_thread_exit(MAKE_STATUS_EXIT(0));
+}
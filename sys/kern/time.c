@@ -6,6 +6,10 @@
 #include <sys/callout.h>
 #include <sys/proc.h>
 #include <sys/klog.h>
+#include <sys/interrupt.h>
+#include <sys/event.h>
+#include <sys/pool.h>
+#include <sys/refcnt.h>
 #include <limits.h>
 
 int do_clock_gettime(clockid_t clk, timespec_t *tp) {
@@ -53,67 +57,48 @@ static bool timeval_invalid(const timeval_t *tv) {
   return tv->tv_usec < 0 || tv->tv_usec >= 1000000 || tv->tv_sec < 0;
 }
 
-static int ts2timo(clockid_t clock_id, int flags, timespec_t *ts,
-                   systime_t *timo, timespec_t *start) {
+int do_clock_nanosleep(clockid_t clk, int flags, timespec_t *rqtp,
+                       timespec_t *rmtp) {
+  timespec_t now, rqt = *rqtp;
+  bintime_t deadline, left;
   int error;
-  *timo = 0;
 
-  if (timespec_invalid(ts) || (flags & ~TIMER_ABSTIME))
+  if (timespec_invalid(rqtp) || (flags & ~TIMER_ABSTIME))
     return EINVAL;
 
-  if ((error = do_clock_gettime(clock_id, start)))
+  if ((error = do_clock_gettime(clk, &now)))
     return error;
 
+  /* Sleep is measured with uptime clock, so make the time relative first. */
   if (flags & TIMER_ABSTIME)
-    timespecsub(ts, start, ts);
-
-  if ((ts->tv_sec == 0 && ts->tv_nsec == 0) || ts->tv_sec < 0)
-    return ETIMEDOUT;
+    timespecsub(&rqt, &now, &rqt);
 
-  *timo = ts2hz(ts);
+  if ((rqt.tv_sec == 0 && rqt.tv_nsec == 0) || rqt.tv_sec < 0)
+    goto timedout;
 
-  return 0;
-}
-
-int do_clock_nanosleep(clockid_t clk, int flags, timespec_t *rqtp,
-                       timespec_t *rmtp) {
-  /* rmt - remaining time, rqt - requested time, p - pointer */
-  timespec_t rmt_start, rmt_end, rmt;
-  systime_t timo;
-  int error, error2;
-
-  if ((error = ts2timo(clk, flags, rqtp, &timo, &rmt_start))) {
-    if (error == ETIMEDOUT)
-      goto timedout;
-    return error;
-  }
+  ts2bt(&rqt, &left);
+  deadline = binuptime();
+  bintime_add(&deadline, &left);
 
+  /* Go back to sleep on spurious wakeups. */
   do {
-    error = sleepq_wait_timed((void *)(&rmt_start), __caller(0), NULL, timo);
-    if (error == ETIMEDOUT)
-      goto timedout;
-
-    if ((error2 = do_clock_gettime(clk, &rmt_end)))
-      return error2;
-
-    if (flags == TIMER_ABSTIME) {
-      timespecsub(rqtp, &rmt_end, &rmt);
-    } else {
-      timespecsub(&rmt_end, &rmt_start, &rmt);
-      timespecsub(rqtp, &rmt, &rmt);
+    error = sleepq_wait_until(&deadline, __caller(0), NULL, deadline);
+  } while (error == 0);
+
+  if (error == ETIMEDOUT)
+    goto timedout;
+
+  /* Sleep has been interrupted, so report how much time is left. */
+  if (rmtp) {
+    bintime_t bin = binuptime();
+    left = BINTIME(0);
+    if (bintime_cmp(&deadline, &bin, >)) {
+      left = deadline;
+      bintime_sub(&left, &bin);
     }
-    if (rmt.tv_sec < 0)
-      timespecclear(&rmt);
-
-    if (rmtp)
-      *rmtp = rmt;
-    if (error)
-      return error;
-
-    timo = ts2hz(&rmt);
-  } while (timo > 0);
-
-  return 0;
+    bt2ts(&left, rmtp);
+  }
+  return error;
 
 timedout:
   if (rmtp)
@@ -161,25 +146,124 @@ static systime_t tv2hz(const timeval_t *tv) {
   return ts2hz(&ts);
 }
 
-static timeval_t microuptime(void) {
-  timeval_t now;
-  bintime_t btnow = binuptime();
-  bt2tv(&btnow, &now);
-  return now;
+/* Intervals shorter than that would make the timer interrupt storm. */
+#define KITIMER_MININTERVAL HZ2BT(10000)
+
+/* Returns time left until the timer expires or zero if it's inactive. */
+static bintime_t kitimer_left(kitimer_t *it) {
+  assert(mtx_owned(&it->kit_proc->p_lock));
+
+  bintime_t next = BINTIME(0);
+
+  WITH_INTR_DISABLED {
+    if (it->kit_timer.hrt_pending)
+      next = it->kit_timer.hrt_time;
+  }
+
+  bintime_t now = binuptime();
+  if (bintime_cmp(&next, &now, <=))
+    return BINTIME(0);
+  bintime_sub(&next, &now);
+  return next;
 }
 
-static void kitimer_get(proc_t *p, struct itimerval *tval) {
+/* Stops the timer and discards expirations that weren't notified about yet.
+ * Returns false if p_lock had to be released to wait for the callout. */
+static bool kitimer_halt(kitimer_t *it) {
+  proc_t *p = it->kit_proc;
   assert(mtx_owned(&p->p_lock));
 
-  timeval_t now = microuptime();
-  kitimer_t *it = &p->p_itimer;
+  /* Once the hrtimer is stopped nothing can delegate the callout again. */
+  hrtimer_stop(&it->kit_timer);
 
-  if (timercmp(&it->kit_next, &now, <=))
-    timerclear(&tval->it_value);
-  else
-    timersub(&it->kit_next, &now, &tval->it_value);
+  bool stopped = callout_stop(&it->kit_callout);
+  if (!stopped) {
+    mtx_unlock(&p->p_lock);
+    callout_drain(&it->kit_callout);
+    mtx_lock(&p->p_lock);
+  }
+
+  atomic_store(&it->kit_count, 0);
+  return stopped;
+}
 
-  tval->it_interval = it->kit_interval;
+/* Called in interrupt context. */
+static void kitimer_expire(void *arg) {
+  kitimer_t *it = arg;
+  unsigned count = 1;
+
+  if (timespecisset(&it->kit_interval)) {
+    bintime_t interval, next = it->kit_timer.hrt_time;
+    ts2bt(&it->kit_interval, &interval);
+    if (bintime_cmp(&interval, &KITIMER_MININTERVAL, <))
+      interval = KITIMER_MININTERVAL;
+
+    /* Skip missed periods, but count them as expirations. */
+    bintime_t now = binuptime();
+    bintime_add(&next, &interval);
+    while (bintime_cmp(&next, &now, <=)) {
+      bintime_add(&next, &interval);
+      count++;
+    }
+
+    hrtimer_start(&it->kit_timer, next);
+  }
+
+  /* If previous expirations haven't been notified about yet, this one gets
+   * compressed into them. */
+  atomic_fetch_add(&it->kit_count, count);
+  callout_run(&it->kit_callout);
+}
+
+static void kitimer_timeout(void *arg) {
+  kitimer_t *it = arg;
+
+  unsigned count = atomic_exchange(&it->kit_count, 0);
+  if (count > 0)
+    it->kit_notify(it, count);
+}
+
+static void kitimer_setup(kitimer_t *it, proc_t *p, kit_notify_t notify) {
+  hrtimer_setup(&it->kit_timer, kitimer_expire, it);
+  callout_setup(&it->kit_callout, kitimer_timeout, it);
+  it->kit_notify = notify;
+  it->kit_proc = p;
+}
+
+/* Arms the timer to expire at `when` (uptime) and then every `interval`.
+ * Zero `when` leaves the timer disarmed.
+ * The timer must have been stopped prior to calling this function. */
+static void kitimer_start(kitimer_t *it, const bintime_t *when,
+                          const timespec_t *interval) {
+  assert(mtx_owned(&it->kit_proc->p_lock));
+
+  if (bintime_isset(when)) {
+    it->kit_interval = *interval;
+    hrtimer_start(&it->kit_timer, *when);
+  } else {
+    timespecclear(&it->kit_interval);
+  }
+}
+
+/*
+ * Interval timer.
+ */
+
+static void itimer_notify(kitimer_t *it, unsigned count) {
+  proc_t *p = it->kit_proc;
+
+  SCOPED_MTX_LOCK(&p->p_lock);
+
+  /* Multiple expirations are compressed into a single SIGALRM. */
+  if (proc_is_alive(p))
+    sig_kill(p, &DEF_KSI_RAW(SIGALRM));
+}
+
+static void itimer_get(proc_t *p, struct itimerval *tval) {
+  kitimer_t *it = &p->p_itimer;
+  bintime_t left = kitimer_left(it);
+  bt2tv(&left, &tval->it_value);
+  ts2tv(&it->kit_interval, &tval->it_interval);
 }
 
 int do_getitimer(proc_t *p, int which, struct itimerval *tval) {
@@ -190,108 +274,331 @@ int do_getitimer(proc_t *p, int which, struct itimerval *tval) {
 
   SCOPED_MTX_LOCK(&p->p_lock);
 
-  kitimer_get(p, tval);
+  itimer_get(p, tval);
 
   return 0;
 }
 
 bool kitimer_stop(proc_t *p) {
-  assert(mtx_owned(&p->p_lock));
+  return kitimer_halt(&p->p_itimer);
+}
 
-  kitimer_t *it = &p->p_itimer;
+void kitimer_init(proc_t *p) {
+  kitimer_setup(&p->p_itimer, p, itimer_notify);
+}
 
-  if (callout_stop(&it->kit_callout))
-    return true;
+int do_setitimer(proc_t *p, int which, const struct itimerval *itval,
+                 struct itimerval *oval) {
+  if (which == ITIMER_PROF || which == ITIMER_VIRTUAL)
+    return ENOTSUP;
+  else if (which != ITIMER_REAL)
+    return EINVAL;
 
-  mtx_unlock(&p->p_lock);
-  callout_drain(&it->kit_callout);
-  mtx_lock(&p->p_lock);
-  return false;
-}
+  if (timeval_invalid(&itval->it_value) || timeval_invalid(&itval->it_interval))
+    return EINVAL;
 
-static void kitimer_timeout(void *arg) {
-  proc_t *p = arg;
+  if (tv2hz(&itval->it_value) == UINT_MAX ||
+      tv2hz(&itval->it_interval) == UINT_MAX)
+    return EINVAL;
 
   SCOPED_MTX_LOCK(&p->p_lock);
 
-  if (!proc_is_alive(p))
-    return;
+  if (oval) {
+    /* Store old timer value before stopping the timer discards it. */
+    itimer_get(p, oval);
+  }
+
+  /* We need to successfully stop the timer without dropping p_lock.  */
+  while (!kitimer_stop(p))
+    continue;
+
+  /* Convert expiration time to absolute time. */
+  bintime_t when = BINTIME(0);
+  if (timerisset(&itval->it_value)) {
+    bintime_t now = binuptime();
+    tv2bt(&itval->it_value, &when);
+    bintime_add(&when, &now);
+  }
 
-  sig_kill(p, &DEF_KSI_RAW(SIGALRM));
+  timespec_t interval;
+  tv2ts(&itval->it_interval, &interval);
+  kitimer_start(&p->p_itimer, &when, &interval);
 
-  kitimer_t *it = &p->p_itimer;
+  return 0;
+}
+
+/*
+ * POSIX timers.
+ *
+ * A timer is referenced by its slot in the process' table and by each knote
+ * that watches it, so a deleted timer lives on (stopped) until these knotes
+ * are dropped. Field locking:
+ *
+ * (@) - p_lock of the owner
+ * (t) - pt_lock
+ * (!) - read-only access
+ */
+struct ptimer {
+  kitimer_t pt_kit;    /* (@) underlying timer */
+  int pt_id;           /* (!) index in p_timers */
+  clockid_t pt_clock;  /* (!) clock that measures expiration time */
+  sigevent_t pt_sigev; /* (!) how to notify the owner */
+  int pt_overrun;      /* (@) overrun count of the last notification */
+  refcnt_t pt_refcnt;  /* slot in p_timers and knotes */
+  mtx_t pt_lock;       /* protects knotes, taken after p_lock */
+  knlist_t pt_knlist;  /* (t) EVFILT_TIMER knotes */
+};
+
+static POOL_DEFINE(P_PTIMER, "ptimer", sizeof(ptimer_t));
+
+static ptimer_t *ptimer_lookup(proc_t *p, int timerid) {
+  assert(mtx_owned(&p->p_lock));
+
+  if (timerid < 0 || timerid >= TIMER_MAX)
+    return NULL;
+  return p->p_timers[timerid];
+}
 
-  if (!timerisset(&it->kit_interval)) {
-    timerclear(&it->kit_next);
-    return;
+static void ptimer_notify(kitimer_t *it, unsigned count) {
+  ptimer_t *pt = container_of(it, ptimer_t, pt_kit);
+  proc_t *p = it->kit_proc;
+
+  WITH_MTX_LOCK (&p->p_lock) {
+    /* Timer could have been deleted while we were waiting for the lock. */
+    if (p->p_timers[pt->pt_id] != pt)
+      return;
+
+    /* If the previous signal is still pending, it's going to be replaced with
+     * this one, so its expirations are lost. */
+    pt->pt_overrun = min(count - 1, (unsigned)DELAYTIMER_MAX);
+
+    if (pt->pt_sigev.sigev_notify == SIGEV_SIGNAL) {
+      ksiginfo_t ksi = {
+        .ksi_signo = pt->pt_sigev.sigev_signo,
+        .ksi_code = SI_TIMER,
+        .ksi_value = pt->pt_sigev.sigev_value,
+        .ksi_timerid = pt->pt_id,
+        .ksi_overrun = pt->pt_overrun,
+      };
+      sig_kill(p, &ksi);
+    }
   }
 
-  timeval_t next = it->kit_next;
-  timeradd(&next, &it->kit_interval, &next);
-  timeval_t now = microuptime();
-  /* Skip missed periods. This will have the effect of compressing multiple
-   * SIGALRM signals into one. */
-  while (timercmp(&next, &now, <=))
-    timeradd(&next, &it->kit_interval, &next);
-  it->kit_next = next;
+  WITH_MTX_LOCK (&pt->pt_lock)
+    knote(&pt->pt_knlist, count);
+}
 
-  /* Undo the `+ 1` done by ts2hz(). */
-  systime_t st = tv2hz(&next) - 1;
-  callout_reschedule(&it->kit_callout, st);
+static void ptimer_get(ptimer_t *pt, struct itimerspec *value) {
+  bintime_t left = kitimer_left(&pt->pt_kit);
+  bt2ts(&left, &value->it_value);
+  value->it_interval = pt->pt_kit.kit_interval;
 }
 
-void kitimer_init(proc_t *p) {
-  callout_setup(&p->p_itimer.kit_callout, kitimer_timeout, p);
+/* Frees the slot of the timer and stops it. */
+static void ptimer_delete(proc_t *p, ptimer_t *pt) {
+  assert(mtx_owned(&p->p_lock));
+
+  p->p_timers[pt->pt_id] = NULL;
+
+  /* Nobody else can start the timer, so it stays stopped even if p_lock gets
+   * released in the meantime. */
+  kitimer_halt(&pt->pt_kit);
+  ptimer_drop(pt);
 }
 
-/* The timer must have been stopped prior to calling this function. */
-static void kitimer_setup(proc_t *p, const struct itimerval *itval) {
+void ptimer_drop(ptimer_t *pt) {
+  if (refcnt_release(&pt->pt_refcnt)) {
+    assert(SLIST_EMPTY(&pt->pt_knlist));
+    mtx_destroy(&pt->pt_lock);
+    pool_free(P_PTIMER, pt);
+  }
+}
+
+int ptimer_hold(proc_t *p, int timerid, ptimer_t **ptp) {
+  SCOPED_MTX_LOCK(&p->p_lock);
+
+  ptimer_t *pt = ptimer_lookup(p, timerid);
+  if (pt == NULL)
+    return EINVAL;
+
+  refcnt_acquire(&pt->pt_refcnt);
+  *ptp = pt;
+  return 0;
+}
+
+void ptimer_deleteall(proc_t *p) {
   assert(mtx_owned(&p->p_lock));
 
-  kitimer_t *it = &p->p_itimer;
-  const timeval_t *value = &itval->it_value;
-
-  if (timerisset(value)) {
-    /* Convert next to absolute time.  */
-    timeval_t abs = microuptime();
-    timeradd(value, &abs, &abs);
-    it->kit_next = abs;
-    it->kit_interval = itval->it_interval;
-    /* Undo the `+ 1` done by ts2hz(). */
-    systime_t st = tv2hz(&it->kit_next) - 1;
-    callout_schedule_abs(&it->kit_callout, st);
+  for (int i = 0; i < TIMER_MAX; i++) {
+    ptimer_t *pt = p->p_timers[i];
+    if (pt != NULL)
+      ptimer_delete(p, pt);
+  }
+}
+
+int do_timer_create(proc_t *p, clockid_t clk, const sigevent_t *sev,
+                    int *timerid) {
+  if (clk != CLOCK_REALTIME && clk != CLOCK_MONOTONIC)
+    return EINVAL;
+
+  if (sev != NULL) {
+    if (sev->sigev_notify == SIGEV_THREAD)
+      return ENOTSUP;
+    if (sev->sigev_notify != SIGEV_NONE && sev->sigev_notify != SIGEV_SIGNAL)
+      return EINVAL;
+    if (sev->sigev_notify == SIGEV_SIGNAL &&
+        (sev->sigev_signo <= 0 || sev->sigev_signo >= NSIG))
+      return EINVAL;
+  }
+
+  ptimer_t *pt = pool_alloc(P_PTIMER, M_ZERO);
+  kitimer_setup(&pt->pt_kit, p, ptimer_notify);
+  pt->pt_clock = clk;
+  pt->pt_refcnt = 1;
+  mtx_init(&pt->pt_lock, 0);
+  SLIST_INIT(&pt->pt_knlist);
+
+  SCOPED_MTX_LOCK(&p->p_lock);
+
+  int id;
+  for (id = 0; id < TIMER_MAX; id++)
+    if (p->p_timers[id] == NULL)
+      break;
+
+  if (id == TIMER_MAX) {
+    ptimer_drop(pt);
+    return EAGAIN;
+  }
+
+  pt->pt_id = id;
+  if (sev != NULL) {
+    pt->pt_sigev = *sev;
   } else {
-    timerclear(&it->kit_next);
-    timerclear(&it->kit_interval);
+    /* Default notification as required by POSIX. */
+    pt->pt_sigev.sigev_notify = SIGEV_SIGNAL;
+    pt->pt_sigev.sigev_signo = SIGALRM;
+    pt->pt_sigev.sigev_value.sival_int = id;
   }
+
+  p->p_timers[id] = pt;
+  *timerid = id;
+  return 0;
 }
 
-int do_setitimer(proc_t *p, int which, const struct itimerval *itval,
-                 struct itimerval *oval) {
-  if (which == ITIMER_PROF || which == ITIMER_VIRTUAL)
-    return ENOTSUP;
-  else if (which != ITIMER_REAL)
+int do_timer_delete(proc_t *p, int timerid) {
+  SCOPED_MTX_LOCK(&p->p_lock);
+
+  ptimer_t *pt = ptimer_lookup(p, timerid);
+  if (pt == NULL)
     return EINVAL;
 
-  if (timeval_invalid(&itval->it_value) || timeval_invalid(&itval->it_interval))
+  ptimer_delete(p, pt);
+  return 0;
+}
+
+int do_timer_settime(proc_t *p, int timerid, int flags,
+                     const struct itimerspec *value,
+                     struct itimerspec *ovalue) {
+  if (flags & ~TIMER_ABSTIME)
     return EINVAL;
 
-  if (tv2hz(&itval->it_value) == UINT_MAX ||
-      tv2hz(&itval->it_interval) == UINT_MAX)
+  if (timespec_invalid(&value->it_value) ||
+      timespec_invalid(&value->it_interval))
     return EINVAL;
 
   SCOPED_MTX_LOCK(&p->p_lock);
 
-  /* We need to successfully stop the timer without dropping p_lock.  */
-  while (!kitimer_stop(p))
+  ptimer_t *pt = ptimer_lookup(p, timerid);
+  if (pt == NULL)
+    return EINVAL;
+
+  if (ovalue) {
+    /* Store old timer value before stopping the timer discards it. */
+    ptimer_get(pt, ovalue);
+  }
+
+  /* We need to successfully stop the timer without dropping p_lock, but while
+   * it's dropped the timer may get deleted, so keep it alive. */
+  refcnt_acquire(&pt->pt_refcnt);
+  while (!kitimer_halt(&pt->pt_kit))
     continue;
+  bool deleted = p->p_timers[timerid] != pt;
+  ptimer_drop(pt);
+  if (deleted)
+    return EINVAL;
 
-  if (oval) {
-    /* Store old timer value. */
-    kitimer_get(p, oval);
+  bintime_t when = BINTIME(0);
+  if (timespecisset(&value->it_value)) {
+    bintime_t now = binuptime();
+    ts2bt(&value->it_value, &when);
+    if (flags & TIMER_ABSTIME) {
+      /* Expiration time is converted to uptime once, so the timer doesn't
+       * follow changes of CLOCK_REALTIME made after it was set. */
+      if (pt->pt_clock == CLOCK_REALTIME) {
+        bintime_t boottime = bintime();
+        bintime_sub(&boottime, &now);
+        bintime_sub(&when, &boottime);
+      }
+      /* Time that has already passed makes the timer expire right away. */
+      if (bintime_cmp(&when, &now, <))
+        when = now;
+    } else {
+      bintime_add(&when, &now);
+    }
   }
 
-  kitimer_setup(p, itval);
+  kitimer_start(&pt->pt_kit, &when, &value->it_interval);
+  return 0;
+}
+
+int do_timer_gettime(proc_t *p, int timerid, struct itimerspec *value) {
+  SCOPED_MTX_LOCK(&p->p_lock);
+
+  ptimer_t *pt = ptimer_lookup(p, timerid);
+  if (pt == NULL)
+    return EINVAL;
+
+  ptimer_get(pt, value);
+  return 0;
+}
+
+int do_timer_getoverrun(proc_t *p, int timerid, int *overrun) {
+  SCOPED_MTX_LOCK(&p->p_lock);
+
+  ptimer_t *pt = ptimer_lookup(p, timerid);
+  if (pt == NULL)
+    return EINVAL;
+
+  *overrun = pt->pt_overrun;
+  return 0;
+}
+
+/* Each knote counts expirations since they were last reported. */
+static int filt_timerevent(knote_t *kn, long hint) {
+  kn->kn_kevent.data += hint;
+  return kn->kn_kevent.data > 0;
+}
+
+static void filt_timerdetach(knote_t *kn) {
+  ptimer_t *pt = kn->kn_obj;
+
+  WITH_MTX_LOCK (&pt->pt_lock)
+    SLIST_REMOVE(&pt->pt_knlist, kn, knote, kn_objlink);
+}
+
+static filterops_t ptimer_filtops = {
+  .filt_detach = filt_timerdetach,
+  .filt_event = filt_timerevent,
+};
+
+int ptimer_kqfilter(ptimer_t *pt, knote_t *kn) {
+  kn->kn_filtops = &ptimer_filtops;
+  kn->kn_objlock = &pt->pt_lock;
+  /* Expirations are reported only once. */
+  kn->kn_kevent.flags |= EV_CLEAR;
+
+  WITH_MTX_LOCK (&pt->pt_lock)
+    SLIST_INSERT_HEAD(&pt->pt_knlist, kn, kn_objlink);
 
   return 0;
 }
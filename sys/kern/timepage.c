@@ -0,0 +1,47 @@
+#include <sys/timepage.h>
+#include <sys/mimiker.h>
+#include <sys/klog.h>
+#include <sys/mutex.h>
+#include <sys/pmap.h>
+#include <sys/timer.h>
+#include <sys/vm_amap.h>
+#include <sys/vm_map.h>
+#include <sys/vm_physmem.h>
+#include <stdatomic.h>
+
+static MTX_DEFINE(timepage_lock, MTX_SPIN);
+static timepage_t *timepage; /* kernel view of the page */
+static vm_amap_t *timepage_amap;
+
+void init_timepage(void) {
+  vm_page_t *pg = vm_page_alloc(1);
+  assert(pg != NULL);
+  pmap_zero_page(pg);
+
+  /* The amap is never dropped, so the page stays around forever. */
+  timepage_amap = vm_amap_alloc(1);
+  vm_amap_add_page((vm_aref_t){.offset = 0, .amap = timepage_amap}, pg, 0);
+  timepage = phys_to_dmap(pg->paddr);
+}
+
+void timepage_update(timer_t *tm, bintime_t boottime) {
+  if (timepage == NULL)
+    return;
+
+  SCOPED_MTX_LOCK(&timepage_lock);
+
+  timepage->tp_gen++;
+  atomic_thread_fence(memory_order_release);
+
+  timepage->tp_counter = tm ? tm->tm_usercounter : TP_COUNTER_NONE;
+  timepage->tp_period = tm ? tm->tm_min_period : BINTIME(0);
+  timepage->tp_boottime = boottime;
+
+  atomic_thread_fence(memory_order_release);
+  timepage->tp_gen++;
+}
+
+int timepage_map(vm_map_t *map) {
+  return vm_map_enter_amap(map, TIMEPAGE_ADDR, PAGESIZE, VM_PROT_READ,
+                           timepage_amap);
+}
@@ -3,13 +3,45 @@
 #include <sys/mimiker.h>
 #include <sys/libkern.h>
 #include <sys/timer.h>
+#include <sys/timepage.h>
 #include <sys/mutex.h>
 #include <sys/errno.h>
+#include <stdatomic.h>
 
 static MTX_DEFINE(timers_mtx, 0);
 static timer_list_t timers = TAILQ_HEAD_INITIALIZER(timers);
-static timer_t *time_source = NULL;
-static bintime_t boottime = BINTIME(0);
+
+/*
+ * Timekeeping state is kept in a ring of timehands, i.e. snapshots of the time
+ * source, boot time and uptime at the moment of the last windup. A writer
+ * fills in the next snapshot in the ring and then publishes it, so readers
+ * never wait and may run in any context, including interrupt filters and klog.
+ *
+ * A reader fetches the generation number of the current snapshot, reads it
+ * and retries if the generation number has changed in the meantime, which
+ * happens only if the snapshot got reused by a writer. Zero generation means
+ * the snapshot is being updated.
+ */
+typedef struct timehands timehands_t;
+
+struct timehands {
+  timer_t *th_source;    /* time source or NULL if there's none yet */
+  bintime_t th_boottime; /* UTC time when uptime was zero */
+  bintime_t th_offset;   /* uptime at the last windup */
+  atomic_uint th_gen;    /* generation number, 0 while being updated */
+  timehands_t *th_next;  /* next snapshot in the ring */
+};
+
+#define TH_COUNT 4
+
+static timehands_t ths[TH_COUNT] = {
+  [0] = {.th_gen = 1, .th_next = &ths[1]},
+  [1] = {.th_next = &ths[2]},
+  [2] = {.th_next = &ths[3]},
+  [3] = {.th_next = &ths[0]},
+};
+static timehands_t *_Atomic timehands = &ths[0];
+static MTX_DEFINE(timehands_lock, MTX_SPIN);
 
 /* These flags are used internally to encode timer state.
  * Following state transitions are possible:
@@ -105,13 +137,48 @@ int tm_release(timer_t *tm) {
   return 0;
 }
 
+/* Publishes a new snapshot with given time source and boot time. */
+static void windup(timer_t *tm, const bintime_t *boottime) {
+  assert(mtx_owned(&timehands_lock));
+
+  timehands_t *oth = atomic_load_explicit(&timehands, memory_order_relaxed);
+  timehands_t *th = oth->th_next;
+  unsigned gen = atomic_load_explicit(&oth->th_gen, memory_order_relaxed);
+
+  /* Readers that still use the snapshot we're reusing will retry. */
+  atomic_store_explicit(&th->th_gen, 0, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  th->th_source = tm;
+  th->th_boottime = *boottime;
+  th->th_offset = tm ? tm->tm_gettime(tm) : BINTIME(0);
+
+  if (++gen == 0)
+    gen = 1;
+  atomic_store_explicit(&th->th_gen, gen, memory_order_release);
+  atomic_store_explicit(&timehands, th, memory_order_release);
+}
+
+void tm_windup(void) {
+  SCOPED_MTX_LOCK(&timehands_lock);
+  timehands_t *th = atomic_load_explicit(&timehands, memory_order_relaxed);
+  windup(th->th_source, &th->th_boottime);
+}
+
 void tm_setclock(const bintime_t *bt) {
-  bintime_t bt1 = *bt, bt2;
-  /* TODO: Add (spin) lock for settime */
-  bt2 = binuptime();
-  /* Setting boottime - this is why we subtract time elapsed since boottime */
-  bintime_sub(&bt1, &bt2);
-  boottime = bt1;
+  timer_t *tm;
+  bintime_t boottime = *bt;
+
+  WITH_MTX_LOCK (&timehands_lock) {
+    timehands_t *th = atomic_load_explicit(&timehands, memory_order_relaxed);
+    tm = th->th_source;
+    /* Setting boottime - this is why we subtract time elapsed since boottime */
+    bintime_t uptime = tm ? tm->tm_gettime(tm) : BINTIME(0);
+    bintime_sub(&boottime, &uptime);
+    windup(tm, &boottime);
+  }
+
+  timepage_update(tm, boottime);
 }
 
 int tm_init(timer_t *tm, tm_event_cb_t event, void *arg) {
@@ -130,7 +197,7 @@ int tm_start(timer_t *tm, unsigned flags, const bintime_t start,
              const bintime_t period) {
   assert(is_initialized(tm));
 
-  if (is_active(tm))
+  if (is_active(tm) && !(flags & TMF_ONESHOT))
     return EBUSY;
   if (((tm->tm_flags & flags) & TMF_TYPEMASK) == 0)
     return ENODEV;
@@ -144,7 +211,7 @@ int tm_start(timer_t *tm, unsigned flags, const bintime_t start,
   if (retval == 0)
     tm->tm_flags |= TMF_ACTIVE;
   if (flags & TMF_TIMESOURCE)
-    time_source = tm;
+    tm_select(tm);
   return retval;
 }
 
@@ -168,19 +235,59 @@ void tm_trigger(timer_t *tm) {
 }
 
 void tm_select(timer_t *tm) {
-  time_source = tm;
+  bintime_t boottime;
+
+  WITH_MTX_LOCK (&timehands_lock) {
+    timehands_t *th = atomic_load_explicit(&timehands, memory_order_relaxed);
+    boottime = th->th_boottime;
+    windup(tm, &boottime);
+  }
+
+  timepage_update(tm, boottime);
+}
+
+/* Reads uptime (from the time source if `precise`) and boot time
+ * consistently. */
+static bintime_t fetch_time(bool precise, bintime_t *boottime) {
+  timehands_t *th;
+  unsigned gen;
+  bintime_t bt;
+
+  do {
+    th = atomic_load_explicit(&timehands, memory_order_acquire);
+    gen = atomic_load_explicit(&th->th_gen, memory_order_acquire);
+    timer_t *tm = th->th_source;
+    if (precise && tm != NULL)
+      bt = tm->tm_gettime(tm);
+    else
+      bt = th->th_offset;
+    if (boottime)
+      *boottime = th->th_boottime;
+    atomic_thread_fence(memory_order_acquire);
+  } while (gen == 0 ||
+           gen != atomic_load_explicit(&th->th_gen, memory_order_relaxed));
+
+  return bt;
 }
 
 bintime_t binuptime(void) {
-  /* XXX: probably a race condition here */
-  timer_t *tm = time_source;
-  if (tm == NULL)
-    return BINTIME(0);
-  return tm->tm_gettime(tm);
+  return fetch_time(true, NULL);
 }
 
 bintime_t bintime(void) {
-  bintime_t retval = binuptime();
+  bintime_t boottime;
+  bintime_t retval = fetch_time(true, &boottime);
+  bintime_add(&retval, &boottime);
+  return retval;
+}
+
+bintime_t getbinuptime(void) {
+  return fetch_time(false, NULL);
+}
+
+bintime_t getbintime(void) {
+  bintime_t boottime;
+  bintime_t retval = fetch_time(false, &boottime);
   bintime_add(&retval, &boottime);
   return retval;
 }
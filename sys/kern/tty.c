@@ -117,6 +117,10 @@ unsigned char const char_type[] = {
 #define CTL_ECHO(c)                                                            \
   (((c) <= 0x1f && (c) != '\t' && (c) != '\n') || (c) == ASCII_DEL)
 
+/* Characters written to the master side of a pty are processed in chunks of
+ * that size. */
+#define TTY_INPUT_CHUNK 64
+
 /* termios flags that can be changed using TIOCSETA{,W,F}. */
 #define TTYSUP_IFLAG_CHANGE (INLCR | IGNCR | ICRNL | IMAXBEL)
 #define TTYSUP_OFLAG_CHANGE (OPOST | ONLCR | OCRNL | ONOCR | ONLRET)
@@ -169,6 +173,7 @@ tty_t *tty_alloc(void) {
                TTY_QUEUE_SIZE);
   cv_init(&tty->t_outcv, "t_outcv");
   cv_init(&tty->t_serialize_cv, "t_serialize_cv");
+  SLIST_INIT(&tty->t_knlist);
   tty->t_line.ln_buf = kmalloc(M_DEV, LINEBUF_SIZE, M_WAITOK);
   tty->t_line.ln_size = LINEBUF_SIZE;
   tty_init_termios(&tty->t_termios);
@@ -408,6 +413,7 @@ static void tty_erase(tty_t *tty, uint8_t c) {
 /* Wake up readers waiting for input. */
 static void tty_wakeup(tty_t *tty) {
   cv_broadcast(&tty->t_incv);
+  knote(&tty->t_knlist, 0);
 }
 
 /*
@@ -468,7 +474,12 @@ static void tty_in_hiwat(tty_t *tty) {
   }
 }
 
-bool tty_input(tty_t *tty, uint8_t c) {
+/*
+ * Process a single input character. Readers are not woken up and the driver
+ * isn't notified about echoed characters, it's up to the caller to do that
+ * once per chunk of input. `wakeup` is set when there's new data for readers.
+ */
+static bool tty_input_char(tty_t *tty, uint8_t c, bool *wakeup) {
   int iflag = tty->t_iflag;
   int lflag = tty->t_lflag;
   uint8_t *cc = tty->t_cc;
@@ -503,7 +514,6 @@ bool tty_input(tty_t *tty, uint8_t c) {
       if (pg)
         WITH_MTX_LOCK (&pg->pg_lock)
           sig_pgkill(pg, &DEF_KSI_RAW(signal));
-      tty_notify_out(tty);
       return true;
     }
   }
@@ -513,10 +523,8 @@ bool tty_input(tty_t *tty, uint8_t c) {
     if (CCEQ(cc[VERASE], c)) {
       /* Erase/backspace */
       uint8_t erased;
-      if (tty_line_unputc(tty, &erased)) {
+      if (tty_line_unputc(tty, &erased))
         tty_erase(tty, erased);
-        tty_notify_out(tty);
-      }
       return true;
     }
 
@@ -533,7 +541,6 @@ bool tty_input(tty_t *tty, uint8_t c) {
         tty->t_line.ln_count = 0;
         tty->t_rocount = 0;
       }
-      tty_notify_out(tty);
       return true;
     }
 
@@ -552,7 +559,7 @@ bool tty_input(tty_t *tty, uint8_t c) {
     if (is_break) {
       tty_line_finish(tty);
       tty->t_rocount = 0;
-      tty_wakeup(tty);
+      *wakeup = true;
     } else if (tty->t_rocount++ == 0) {
       tty->t_rocol = tty->t_column;
     }
@@ -564,7 +571,6 @@ bool tty_input(tty_t *tty, uint8_t c) {
       while (i--)
         tty_output(tty, '\b');
     }
-    tty_notify_out(tty);
     return true;
   } else {
     /* Raw (non-canonical) mode */
@@ -575,11 +581,95 @@ bool tty_input(tty_t *tty, uint8_t c) {
 
     tty_echo(tty, c);
     ringbuf_putb(&tty->t_inq, c);
-    tty_wakeup(tty);
+    *wakeup = true;
     return true;
   }
 }
 
+/* In raw mode without echo and input translation characters go straight
+ * to the input queue. */
+static bool tty_input_verbatim(tty_t *tty) {
+  return !(tty->t_lflag & (ICANON | ISIG | ECHO | ECHONL)) &&
+         !(tty->t_iflag & (IGNCR | ICRNL | INLCR));
+}
+
+/* Returns the number of characters accepted. If `skip` is set, characters
+ * that weren't accepted are skipped, otherwise processing stops at the first
+ * such character. */
+static size_t tty_input_chunk(tty_t *tty, const uint8_t *buf, size_t len,
+                              bool skip) {
+  assert(mtx_owned(&tty->t_lock));
+
+  bool wakeup = false;
+  size_t n = 0;
+
+  if (tty_input_verbatim(tty)) {
+    n = min(len, tty->t_inq.size - tty->t_inq.count);
+    ringbuf_putnb(&tty->t_inq, buf, n);
+    wakeup = n > 0;
+    if (n < len)
+      tty_in_hiwat(tty);
+  } else {
+    for (size_t i = 0; i < len; i++) {
+      if (tty_input_char(tty, buf[i], &wakeup))
+        n++;
+      else if (!skip)
+        break;
+    }
+  }
+
+  if (wakeup)
+    tty_wakeup(tty);
+  tty_notify_out(tty);
+  return n;
+}
+
+size_t tty_input_bulk(tty_t *tty, const uint8_t *buf, size_t len) {
+  return tty_input_chunk(tty, buf, len, false);
+}
+
+size_t tty_input_lossy(tty_t *tty, const uint8_t *buf, size_t len) {
+  return len - tty_input_chunk(tty, buf, len, true);
+}
+
+bool tty_input(tty_t *tty, uint8_t c) {
+  return tty_input_bulk(tty, &c, 1) == 1;
+}
+
+int tty_input_uio(tty_t *tty, uio_t *uio) {
+  assert(mtx_owned(&tty->t_lock));
+
+  if (tty_input_verbatim(tty)) {
+    size_t start_resid = uio->uio_resid;
+    int error = ringbuf_write(&tty->t_inq, uio);
+    if (uio->uio_resid < start_resid)
+      tty_wakeup(tty);
+    if (!error && uio->uio_resid > 0)
+      tty_in_hiwat(tty);
+    return error;
+  }
+
+  uint8_t chunk[TTY_INPUT_CHUNK];
+  uiostate_t save;
+  int error = 0;
+
+  while (uio->uio_resid > 0) {
+    size_t n = min(uio->uio_resid, sizeof(chunk));
+    uio_save(uio, &save);
+    if ((error = uiomove(chunk, n, uio)))
+      break;
+    size_t done = tty_input_bulk(tty, chunk, n);
+    if (done < n) {
+      /* Give back characters that didn't fit into the input queue. */
+      uio_restore(uio, &save);
+      error = uiomove(chunk, done, uio);
+      break;
+    }
+  }
+
+  return error;
+}
+
 static void tty_check_in_lowat(tty_t *tty) {
   assert(mtx_owned(&tty->t_lock));
 
@@ -632,11 +722,10 @@ static int tty_do_read(file_t *f, uio_t *uio) {
           break;
       }
     } else {
-      /* In raw mode, read a single character.
+      /* In raw mode, read all available characters.
        * In theory we should respect things such as VMIN and VTIME, but most
        * programs don't use them. */
-      ringbuf_getb(&tty->t_inq, &c);
-      error = uiomove(&c, 1, uio);
+      error = ringbuf_read(&tty->t_inq, uio);
     }
 
     tty_check_in_lowat(tty);
@@ -752,6 +841,18 @@ static bool tty_output(tty_t *tty, uint8_t c) {
   return true;
 }
 
+/* Push the output queue to the device and wait until it drains below the low
+ * water mark. */
+static int tty_wait_outq(tty_t *tty) {
+  tty_notify_out(tty);
+  /* tty_notify_out() can synchronously write characters to the device,
+   * so it may have written enough characters for us not to need to sleep. */
+  if (tty->t_outq.count < TTY_OUT_LOW_WATER)
+    return 0;
+  tty->t_flags |= TF_WAIT_OUT_LOWAT;
+  return tty_wait(tty, &tty->t_outcv);
+}
+
 /*
  * Write a single character to the terminal.
  * If it can't immediately write the character due to lack of space
@@ -759,16 +860,9 @@ static bool tty_output(tty_t *tty, uint8_t c) {
  */
 static int tty_output_sleep(tty_t *tty, uint8_t c) {
   int error;
-  while (!tty_output(tty, c)) {
-    tty_notify_out(tty);
-    /* tty_notify_out() can synchronously write characters to the device,
-     * so it may have written enough characters for us not to need to sleep. */
-    if (tty->t_outq.count < TTY_OUT_LOW_WATER)
-      continue;
-    tty->t_flags |= TF_WAIT_OUT_LOWAT;
-    if ((error = tty_wait(tty, &tty->t_outcv)))
+  while (!tty_output(tty, c))
+    if ((error = tty_wait_outq(tty)))
       return error;
-  }
   return 0;
 }
 
@@ -778,10 +872,21 @@ static int tty_do_write(tty_t *tty, uio_t *uio) {
   int error = 0;
 
   while (uio->uio_resid > 0) {
-    if ((error = uiomove(&c, 1, uio)))
-      break;
-    if ((error = tty_output_sleep(tty, c)))
-      break;
+    if (!(tty->t_oflag & OPOST) &&
+        !(tty->t_lflag & (FLUSHO | ICANON | ECHO))) {
+      /* Without output processing characters are copied straight into
+       * the output queue, as many as there's space for. The output column
+       * isn't tracked here, since only echo and line editing need it. */
+      if ((error = ringbuf_write(&tty->t_outq, uio)))
+        break;
+      if (uio->uio_resid > 0 && (error = tty_wait_outq(tty)))
+        break;
+    } else {
+      if ((error = uiomove(&c, 1, uio)))
+        break;
+      if ((error = tty_output_sleep(tty, c)))
+        break;
+    }
     tty->t_rocount = 0;
   }
   tty_notify_out(tty);
@@ -839,6 +944,9 @@ void tty_getc_done(tty_t *tty) {
 
   if (tty->t_flags != oldf)
     cv_broadcast(&tty->t_outcv);
+
+  if (cnt < TTY_OUT_LOW_WATER)
+    knote(&tty->t_knlist, 0);
 }
 
 static int tty_drain_out(tty_t *tty) {
@@ -1084,6 +1192,7 @@ void tty_detach_driver(tty_t *tty) {
   cv_broadcast(&tty->t_incv);
   cv_broadcast(&tty->t_outcv);
   cv_broadcast(&tty->t_serialize_cv);
+  knote(&tty->t_knlist, 0);
 
   /* We can't free the tty structure yet, as there may still be existing
    * references to the vnode. We free it in tty_vn_reclaim, once all
@@ -1097,6 +1206,68 @@ void tty_detach_driver(tty_t *tty) {
   vnode_drop(v);
 }
 
+static void filt_ttydetach(knote_t *kn) {
+  tty_t *tty = kn->kn_hook;
+
+  WITH_MTX_LOCK (&tty->t_lock)
+    SLIST_REMOVE(&tty->t_knlist, kn, knote, kn_objlink);
+}
+
+static int filt_ttyread(knote_t *kn, long hint) {
+  tty_t *tty = kn->kn_hook;
+  assert(mtx_owned(&tty->t_lock));
+
+  kn->kn_kevent.data = tty->t_inq.count;
+  if (tty_detached(tty)) {
+    kn->kn_kevent.flags |= EV_EOF;
+    return 1;
+  }
+  kn->kn_kevent.flags &= ~EV_EOF;
+  return tty->t_inq.count > 0;
+}
+
+static int filt_ttywrite(knote_t *kn, long hint) {
+  tty_t *tty = kn->kn_hook;
+  assert(mtx_owned(&tty->t_lock));
+
+  kn->kn_kevent.data = tty->t_outq.size - tty->t_outq.count;
+  if (tty_detached(tty)) {
+    kn->kn_kevent.flags |= EV_EOF;
+    return 1;
+  }
+  kn->kn_kevent.flags &= ~EV_EOF;
+  return tty->t_outq.count < TTY_OUT_LOW_WATER;
+}
+
+static filterops_t tty_read_filtops = {
+  .filt_detach = filt_ttydetach,
+  .filt_event = filt_ttyread,
+};
+
+static filterops_t tty_write_filtops = {
+  .filt_detach = filt_ttydetach,
+  .filt_event = filt_ttywrite,
+};
+
+static int tty_kqfilter(file_t *f, knote_t *kn) {
+  tty_t *tty = f->f_data;
+
+  if (kn->kn_kevent.filter == EVFILT_READ)
+    kn->kn_filtops = &tty_read_filtops;
+  else if (kn->kn_kevent.filter == EVFILT_WRITE)
+    kn->kn_filtops = &tty_write_filtops;
+  else
+    return EINVAL;
+
+  kn->kn_hook = tty;
+  kn->kn_objlock = &tty->t_lock;
+
+  WITH_MTX_LOCK (&tty->t_lock)
+    SLIST_INSERT_HEAD(&tty->t_knlist, kn, kn_objlink);
+
+  return 0;
+}
+
 /* We implement I/O operations as fileops in order to bypass
  * the vnode layer's locking. */
 static fileops_t tty_fileops = {
@@ -1106,6 +1277,7 @@ static fileops_t tty_fileops = {
   .fo_seek = default_vnseek,
   .fo_stat = default_vnstat,
   .fo_ioctl = tty_ioctl,
+  .fo_kqfilter = tty_kqfilter,
 };
 
 bool maybe_assoc_ctty(proc_t *p, tty_t *tty) {
@@ -1,8 +1,11 @@
-#include <sys/sched.h>
+#include <sys/mimiker.h>
 #include <sys/tty.h>
 #include <dev/uart.h>
 #include <sys/uart_tty.h>
 
+/* Received characters are passed to the tty in chunks of that size. */
+#define UART_RX_CHUNK 64
+
 static void tty_set_outq_nonempty_flag(tty_thread_t *ttd) {
   if (ringbuf_empty(&ttd->ttd_tty->t_outq))
     ttd->ttd_flags &= ~TTY_THREAD_OUTQ_NONEMPTY;
@@ -10,9 +13,12 @@ static void tty_set_outq_nonempty_flag(tty_thread_t *ttd) {
     ttd->ttd_flags |= TTY_THREAD_OUTQ_NONEMPTY;
 }
 
-static bool uart_getb_lock(uart_state_t *uart, uint8_t *byte_p) {
+/* Take at most `len` characters from rx_buf. Returns their number. */
+static size_t uart_getnb_lock(uart_state_t *uart, uint8_t *buf, size_t len) {
   SCOPED_MTX_LOCK(&uart->u_lock);
-  return ringbuf_getb(&uart->u_rx_buf, byte_p);
+  len = min(len, uart->u_rx_buf.count);
+  ringbuf_getnb(&uart->u_rx_buf, buf, len);
+  return len;
 }
 
 /*
@@ -39,20 +45,16 @@ static void uart_tty_try_bypass_txbuf(device_t *dev) {
 static void uart_tty_fill_txbuf(device_t *dev) {
   uart_state_t *uart = dev->state;
   tty_t *tty = uart->u_ttd.ttd_tty;
-  uint8_t byte;
+  ringbuf_t *txbuf = &uart->u_tx_buf;
 
-  while (true) {
-    SCOPED_MTX_LOCK(&uart->u_lock);
+  WITH_MTX_LOCK (&uart->u_lock) {
     uart_tty_try_bypass_txbuf(dev);
-    if (ringbuf_full(&uart->u_tx_buf) || !ringbuf_getb(&tty->t_outq, &byte)) {
-      /* Enable TXRDY interrupts if there are characters in tx_buf. */
-      if (!ringbuf_empty(&uart->u_tx_buf))
-        uart_tx_enable(dev);
-      tty_set_outq_nonempty_flag(&uart->u_ttd);
-      break;
-    }
+    size_t n = min(tty->t_outq.count, txbuf->size - txbuf->count);
+    ringbuf_movenb(&tty->t_outq, txbuf, n);
+    /* Enable TXRDY interrupts if there are characters in tx_buf. */
+    if (!ringbuf_empty(txbuf))
+      uart_tx_enable(dev);
     tty_set_outq_nonempty_flag(&uart->u_ttd);
-    ringbuf_putb(&uart->u_tx_buf, byte);
   }
   tty_getc_done(tty);
 }
@@ -71,41 +73,36 @@ void uart_tty_notify_out(tty_t *tty) {
   uart_tty_fill_txbuf(dev);
 }
 
-/* TODO: revisit after per-intr_event ithreads are implemented. */
-static void uart_tty_thread(void *arg) {
-  device_t *dev = arg;
+void uart_tty_service(void *data) {
+  device_t *dev = data;
   uart_state_t *uart = dev->state;
   tty_thread_t *ttd = &uart->u_ttd;
   tty_t *tty = ttd->ttd_tty;
-  uint8_t work, byte;
+  uint8_t work, chunk[UART_RX_CHUNK];
+  size_t n;
 
-  while (true) {
-    WITH_MTX_LOCK (&uart->u_lock) {
-      /* Sleep until there's work for us to do. */
-      while ((work = ttd->ttd_flags & TTY_THREAD_WORK_MASK) == 0)
-        cv_wait(&ttd->ttd_cv, &uart->u_lock);
-      ttd->ttd_flags &= ~TTY_THREAD_WORK_MASK;
-    }
-    WITH_MTX_LOCK (&tty->t_lock) {
-      if (work & TTY_THREAD_RXRDY) {
-        /* Move characters from rx_buf into the tty's input queue. */
-        while (uart_getb_lock(uart, &byte))
-          if (!tty_input(tty, byte))
-            klog("dropped character %hhx", byte);
+  WITH_MTX_LOCK (&uart->u_lock) {
+    work = ttd->ttd_flags & TTY_THREAD_WORK_MASK;
+    ttd->ttd_flags &= ~TTY_THREAD_WORK_MASK;
+  }
+
+  WITH_MTX_LOCK (&tty->t_lock) {
+    if (work & TTY_THREAD_RXRDY) {
+      /* Move characters from rx_buf into the tty's input queue. */
+      while ((n = uart_getnb_lock(uart, chunk, sizeof(chunk)))) {
+        size_t dropped = tty_input_lossy(tty, chunk, n);
+        if (dropped)
+          klog("dropped %lu characters", dropped);
       }
-      if (work & TTY_THREAD_TXRDY)
-        uart_tty_fill_txbuf(dev);
     }
+    if (work & TTY_THREAD_TXRDY)
+      uart_tty_fill_txbuf(dev);
   }
 }
 
-void uart_tty_thread_create(const char *name, device_t *dev, tty_t *tty) {
+void uart_tty_init(device_t *dev, tty_t *tty) {
   uart_state_t *uart = dev->state;
   tty_thread_t *ttd = &uart->u_ttd;
   ttd->ttd_tty = tty;
   tty->t_data = dev;
-  cv_init(&ttd->ttd_cv, "TTY thread notification");
-  ttd->ttd_thread =
-    thread_create(name, uart_tty_thread, dev, prio_ithread(PRIO_ITHRD_QTY - 1));
-  sched_add(ttd->ttd_thread);
 }
@@ -12,9 +12,12 @@
 #include <sys/mutex.h>
 #include <sys/condvar.h>
 #include <sys/cred.h>
+#include <sys/sdt.h>
 
 static POOL_DEFINE(P_VNODE, "vnode", sizeof(vnode_t));
 
+SDT_PROBE_DEFINE(vfs, vop, "vnode, op");
+
 static void vnlock_init(vnlock_t *vl);
 
 /* Actually, vnode management should be much more complex than this, because
@@ -8,11 +8,15 @@
 #include <sys/vm_map.h>
 #include <sys/vm_amap.h>
 #include <sys/errno.h>
+#include <sys/evcnt.h>
 #include <sys/proc.h>
 #include <sys/sched.h>
 #include <sys/pcpu.h>
+#include <sys/sdt.h>
 #include <machine/vm_param.h>
 
+#define VM_ENT_INHERIT_MASK (VM_ENT_SHARED | VM_ENT_PRIVATE)
+
 struct vm_map_entry {
   TAILQ_ENTRY(vm_map_entry) link;
   vm_aref_t aref;
@@ -26,7 +30,9 @@ struct vm_map {
   TAILQ_HEAD(vm_map_list, vm_map_entry) entries;
   size_t nentries;
   pmap_t *pmap;
-  mtx_t mtx; /* Mutex guarding vm_map structure and all its entries. */
+  mtx_t mtx;       /* Mutex guarding vm_map structure and all its entries. */
+  size_t maxrss;   /* peak number of resident pages */
+  uint64_t minflt; /* number of faults resolved without I/O */
 };
 
 static POOL_DEFINE(P_VM_MAP, "vm_map", sizeof(vm_map_t));
@@ -246,6 +252,9 @@ int vm_map_protect(vm_map_t *map, vaddr_t start, vaddr_t end, vm_prot_t prot) {
     return ENOMEM;
 
   while (range_intersects_map_entry(ent, start, end)) {
+    if ((prot & VM_PROT_WRITE) && (ent->flags & VM_ENT_NOWRITE))
+      return EACCES;
+
     vaddr_t prot_start = max(start, vm_map_entry_start(ent));
     vaddr_t prot_end = min(end, vm_map_entry_end(ent));
     vm_map_entry_t *affected = ent;
@@ -361,7 +370,7 @@ int vm_map_insert(vm_map_t *map, vm_map_entry_t *ent, vm_flags_t flags) {
 
   ent->start = start;
   ent->end = start + length;
-  ent->flags = entry_flags;
+  ent->flags = (ent->flags & ~VM_ENT_INHERIT_MASK) | entry_flags;
 
   vm_map_insert_after(map, after, ent);
   return 0;
@@ -398,6 +407,22 @@ int vm_map_alloc_entry(vm_map_t *map, vaddr_t addr, size_t length,
   return 0;
 }
 
+int vm_map_enter_amap(vm_map_t *map, vaddr_t addr, size_t length,
+                      vm_prot_t prot, vm_amap_t *amap) {
+  assert(page_aligned_p(addr) && page_aligned_p(length));
+  assert(vaddr_to_slot(length) <= vm_amap_slots(amap));
+
+  vm_map_entry_t *ent =
+    vm_map_entry_alloc(addr, addr + length, prot, VM_ENT_NOWRITE);
+  vm_amap_hold(amap);
+  ent->aref = (vm_aref_t){.offset = 0, .amap = amap};
+
+  int error = vm_map_insert(map, ent, VM_FIXED | VM_SHARED);
+  if (error)
+    vm_map_entry_free(ent);
+  return error;
+}
+
 int vm_map_entry_resize(vm_map_t *map, vm_map_entry_t *ent, vaddr_t new_end) {
   assert(page_aligned_p(new_end));
   assert(new_end >= ent->start);
@@ -481,8 +506,6 @@ static vm_map_entry_t *vm_map_entry_clone_copy(vm_map_t *map,
   return NULL;
 }
 
-#define VM_ENT_INHERIT_MASK (VM_ENT_SHARED | VM_ENT_PRIVATE)
-
 vm_map_t *vm_map_clone(vm_map_t *map) {
   thread_t *td = thread_self();
   assert(td->td_proc);
@@ -517,33 +540,48 @@ vm_map_t *vm_map_clone(vm_map_t *map) {
   return new_map;
 }
 
+SDT_PROBE_DEFINE(vm, fault, "map, addr, type");
+
+static EVCNT_DEFINE(fault_total, "vm", "fault");
+static EVCNT_DEFINE(fault_invalid, "vm", "fault invalid");
+static EVCNT_DEFINE(fault_zerofill, "vm", "fault zero-fill");
+static EVCNT_DEFINE(fault_resident, "vm", "fault resident page");
+
 int vm_page_fault(vm_map_t *map, vaddr_t fault_addr, vm_prot_t fault_type) {
+  SDT_PROBE(vm, fault, map, fault_addr, fault_type);
+  evcnt_inc(&fault_total);
+
   SCOPED_VM_MAP_LOCK(map);
 
   vm_map_entry_t *ent = vm_map_find_entry(map, fault_addr);
 
   if (!ent) {
     klog("Tried to access unmapped memory region: 0x%08lx!", fault_addr);
+    evcnt_inc(&fault_invalid);
     return EFAULT;
   }
 
   if (ent->prot == VM_PROT_NONE) {
     klog("Cannot access to address: 0x%08lx", fault_addr);
+    evcnt_inc(&fault_invalid);
     return EACCES;
   }
 
   if (!(ent->prot & VM_PROT_WRITE) && (fault_type & VM_PROT_WRITE)) {
     klog("Cannot write to address: 0x%08lx", fault_addr);
+    evcnt_inc(&fault_invalid);
     return EACCES;
   }
 
   if (!(ent->prot & VM_PROT_READ) && (fault_type & VM_PROT_READ)) {
     klog("Cannot read from address: 0x%08lx", fault_addr);
+    evcnt_inc(&fault_invalid);
     return EACCES;
   }
 
   if (!(ent->prot & VM_PROT_EXEC) && (fault_type & VM_PROT_EXEC)) {
     klog("Cannot exec at address: 0x%08lx", fault_addr);
+    evcnt_inc(&fault_invalid);
     return EACCES;
   }
 
@@ -567,11 +605,51 @@ int vm_page_fault(vm_map_t *map, vaddr_t fault_addr, vm_prot_t fault_type) {
     if (frame == NULL)
       return EFAULT;
     pmap_zero_page(frame);
+    evcnt_inc(&fault_zerofill);
+  } else {
+    evcnt_inc(&fault_resident);
   }
 
   if (insert)
     vm_amap_add_page(ent->aref, frame, offset);
 
   pmap_enter(map->pmap, fault_page, frame, ent->prot, 0);
+
+  /* Page was available in memory, hence the fault is a minor one. */
+  map->minflt++;
+  map->maxrss = max(map->maxrss, pmap_resident_count(map->pmap));
+  return 0;
+}
+
+void vm_map_stats(vm_map_t *map, vm_map_stats_t *stats) {
+  SCOPED_VM_MAP_LOCK(map);
+
+  stats->vs_resident = pmap_resident_count(map->pmap);
+  stats->vs_maxrss = map->maxrss;
+  stats->vs_minflt = map->minflt;
+}
+
+int vm_map_lookup_shared(vm_map_t *map, vaddr_t addr, vm_amap_t **amap_p,
+                         size_t *offset_p) {
+  SCOPED_VM_MAP_LOCK(map);
+
+  *amap_p = NULL;
+
+  vm_map_entry_t *ent = vm_map_find_entry(map, addr);
+  if (!ent)
+    return EFAULT;
+
+  if (!(ent->flags & VM_ENT_SHARED))
+    return 0;
+
+  if (!ent->aref.amap) {
+    size_t slots = vaddr_to_slot(ent->end - ent->start);
+    ent->aref.offset = 0;
+    ent->aref.amap = vm_amap_alloc(slots);
+  }
+
+  vm_amap_hold(ent->aref.amap);
+  *amap_p = ent->aref.amap;
+  *offset_p = ent->aref.offset * PAGESIZE + (addr - ent->start);
   return 0;
 }
@@ -3,6 +3,7 @@
 #include <sys/mimiker.h>
 #include <sys/libkern.h>
 #include <sys/errno.h>
+#include <sys/memstat.h>
 #include <sys/mutex.h>
 #include <sys/pmap.h>
 #include <sys/vm_physmem.h>
@@ -314,6 +315,29 @@ void vm_pagelist_free(vm_pagelist_t *pglist) {
   }
 }
 
+size_t vm_physmem_memstat(memstat_record_t *recs, size_t n) {
+  vm_physseg_t *seg;
+  size_t npages = 0;
+
+  SCOPED_MTX_LOCK(&physmem_lock);
+
+  TAILQ_FOREACH (seg, &seglist, seglink)
+    if (!seg->used)
+      npages += seg->npages;
+
+  for (size_t i = 0; i < min(n, PM_NQUEUES); i++) {
+    memstat_record_t *mr = &recs[i];
+    mr->mr_kind = MS_PHYSMEM;
+    snprintf(mr->mr_name, MEMSTAT_NAMELEN, "%uK blocks",
+             (unsigned)((PAGESIZE << i) / 1024));
+    mr->mr_physmem.order = i;
+    mr->mr_physmem.nfree = pagecount[i];
+    mr->mr_physmem.npages = npages;
+  }
+
+  return PM_NQUEUES;
+}
+
 vm_page_t *vm_page_find(paddr_t pa) {
   SCOPED_MTX_LOCK(&physmem_lock);
 
@@ -50,6 +50,23 @@ void mcontext_init(mcontext_t *ctx, void *pc, void *sp) {
   _REG(ctx, SR) = mips32_get_c0(C0_STATUS) | SR_IE | SR_KSU_USER;
 }
 
+void mcontext_setup_thread(mcontext_t *ctx, void *pc, void *sp,
+                           register_t arg) {
+  /* Position independent code computes global pointer from t9. */
+  _REG(ctx, EPC) = (register_t)pc;
+  _REG(ctx, T9) = (register_t)pc;
+  _REG(ctx, A0) = arg;
+  _REG(ctx, RA) = 0;
+
+  /* O32 ABI: the caller reserves space on stack for four argument registers. */
+  _REG(ctx, SP) = (register_t)sp - 4 * sizeof(register_t);
+}
+
+void mcontext_set_tls(mcontext_t *ctx, void *tls) {
+  /* Loaded into UserLocal register by user_exc_leave. */
+  ctx->_mc_tlsbase = (__greg_t)tls;
+}
+
 void mcontext_set_retval(mcontext_t *ctx, register_t value, register_t error) {
   _REG(ctx, V0) = (register_t)value;
   _REG(ctx, V1) = (register_t)error;
@@ -5,6 +5,7 @@
 #include <mips/cpuinfo.h>
 
 cpuinfo_t cpuinfo;
+int cpu_userlocal;
 
 #define bitfield(value, field)                                                 \
   (((value) >> field##_SHIFT) & ((1L << field##_BITS) - 1))
@@ -165,4 +166,10 @@ static void cpu_dump(void) {
 void init_mips_cpu(void) {
   cpu_read_config();
   cpu_dump();
+
+  /* Let user-space read thread pointer from UserLocal register. */
+  if (mips32_getconfig3() & CFG3_ULRI) {
+    mips32_bishwrena(HWRENA_ULR);
+    cpu_userlocal = 1;
+  }
 }
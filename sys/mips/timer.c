@@ -6,6 +6,7 @@
 #include <sys/devclass.h>
 #include <sys/device.h>
 #include <sys/interrupt.h>
+#include <sys/mimiker.h>
 #include <sys/timer.h>
 
 typedef struct mips_timer_state {
@@ -15,6 +16,8 @@ typedef struct mips_timer_state {
   uint32_t last_count_lo;     /* used to detect counter overflow */
   volatile timercntr_t count; /* last written value of counter reg. (64 bits) */
   volatile timercntr_t compare; /* last read value of compare reg. (64 bits) */
+  bool running; /* counter has been started and interrupt is set up */
+  bool oneshot; /* compare register must not be advanced by the interrupt */
   timer_t timer;
   resource_t *irq_res;
 } mips_timer_state_t;
@@ -60,33 +63,62 @@ static int set_next_tick(mips_timer_state_t *state) {
   return ticks;
 }
 
+static void set_oneshot(mips_timer_state_t *state, uint64_t ticks) {
+  SCOPED_INTR_DISABLED();
+
+  ticks = max(ticks, 1ULL);
+
+  /* Compare register must be ahead of the counter, as the interrupt is
+   * raised only when they become equal. */
+  do {
+    state->compare.val = read_count(state) + ticks;
+    mips32_set_c0(C0_COMPARE, state->compare.lo);
+  } while (state->compare.val <= read_count(state));
+}
+
 static intr_filter_t mips_timer_intr(void *data) {
   device_t *dev = data;
   mips_timer_state_t *state = dev->state;
-  /* TODO(cahir): can we tell scheduler that clock ticked more than once? */
-  (void)set_next_tick(state);
+  if (state->oneshot) {
+    /* Acknowledge the interrupt, the callback is going to program the next
+     * event if it needs one. */
+    mips32_set_c0(C0_COMPARE, state->compare.lo);
+  } else {
+    /* TODO(cahir): can we tell scheduler that clock ticked more than once? */
+    (void)set_next_tick(state);
+  }
   tm_trigger(&state->timer);
   return IF_FILTERED;
 }
 
 static int mips_timer_start(timer_t *tm, unsigned flags, const bintime_t start,
                             const bintime_t period) {
-  assert(flags & TMF_PERIODIC);
-  assert(!(flags & TMF_ONESHOT));
-
-  mips32_setcount(0);
-
   device_t *dev = tm->tm_priv;
   mips_timer_state_t *state = dev->state;
-  state->sec = 0;
-  state->cntr_modulo = 0;
-  state->last_count_lo = 0;
-  state->period_cntr = bintime_mul(period, tm->tm_frequency).sec;
-  state->compare.val = read_count(state);
-
-  set_next_tick(state);
-  pic_setup_intr(dev, state->irq_res, mips_timer_intr, NULL, dev,
-                 "MIPS CPU timer");
+
+  if (!state->running) {
+    mips32_setcount(0);
+
+    state->sec = 0;
+    state->cntr_modulo = 0;
+    state->last_count_lo = 0;
+    state->compare.val = read_count(state);
+  }
+
+  if (flags & TMF_ONESHOT) {
+    state->oneshot = true;
+    set_oneshot(state, bintime_mul(start, tm->tm_frequency).sec);
+  } else {
+    state->oneshot = false;
+    state->period_cntr = bintime_mul(period, tm->tm_frequency).sec;
+    set_next_tick(state);
+  }
+
+  if (!state->running) {
+    pic_setup_intr(dev, state->irq_res, mips_timer_intr, NULL, dev,
+                   "MIPS CPU timer");
+    state->running = true;
+  }
   return 0;
 }
 
@@ -94,6 +126,7 @@ static int mips_timer_stop(timer_t *tm) {
   device_t *dev = tm->tm_priv;
   mips_timer_state_t *state = dev->state;
   pic_teardown_intr(dev, state->irq_res);
+  state->running = false;
   return 0;
 }
 
@@ -125,7 +158,7 @@ static int mips_timer_attach(device_t *dev) {
 
   state->timer = (timer_t){
     .tm_name = "mips-cpu-timer",
-    .tm_flags = TMF_PERIODIC,
+    .tm_flags = TMF_PERIODIC | TMF_ONESHOT,
     .tm_quality = 200,
     .tm_frequency = CPU_FREQ,
     .tm_min_period = HZ2BT(CPU_FREQ),
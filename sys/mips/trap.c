@@ -88,6 +88,24 @@ static vm_prot_t exc_access(u_long code) {
   panic("unknown code: %s", exceptions[code]);
 }
 
+/* Encoding of `rdhwr $3, $29` instruction, i.e. read UserLocal into v1. */
+#define RDHWR_V1_ULR 0x7c03e83b
+
+/* Emulate reading the thread pointer on CPUs without UserLocal register. */
+static bool emulate_rdhwr(ctx_t *ctx) {
+  uint32_t insn;
+
+  if (_REG(ctx, CAUSE) & CR_BD)
+    return false;
+
+  if (copyin_s((void *)_REG(ctx, EPC), insn) || insn != RDHWR_V1_ULR)
+    return false;
+
+  _REG(ctx, V1) = ((mcontext_t *)ctx)->_mc_tlsbase;
+  _REG(ctx, EPC) += sizeof(insn);
+  return true;
+}
+
 static void user_trap_handler(ctx_t *ctx) {
   /* We came here from user-space,
    * hence interrupts and preemption must have be enabled. */
@@ -147,7 +165,8 @@ static void user_trap_handler(ctx_t *ctx) {
       break;
 
     case EXC_RI:
-      sig_trap(SIGILL, ILL_PRVOPC, (void *)epc, code);
+      if (!emulate_rdhwr(ctx))
+        sig_trap(SIGILL, ILL_PRVOPC, (void *)epc, code);
       break;
 
     default:
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+#
+# Convert scheduler events printed by `sdt 'sched:*'` into Chrome trace event
+# format, which can be loaded into Perfetto UI (https://ui.perfetto.dev) or
+# chrome://tracing.
+#
+# Each thread gets a track showing when it was running, runnable, sleeping or
+# blocked (with wait channel and wait point of the sleep). Wakeups are drawn
+# as arrows from the waker, and priority changes as a counter, so priority
+# lending on turnstiles is easy to spot. CPU track shows which thread ran.
+
+import argparse
+import json
+import re
+import sys
+
+# Keep in sync with thread_state_t in include/sys/thread.h
+STATES = ['inactive', 'ready', 'running', 'sleeping', 'blocked', 'stopped',
+          'dead']
+
+# Keep in sync with td_flags in include/sys/thread.h
+TDF_SLPINTR = 0x0040
+TDF_SLPTIMED = 0x0080
+
+CPU_PID = 0
+THREADS_PID = 1
+
+RECORD = re.compile(r'\s*(\d+)\.(\d+)\s+(\d+)\s+sched:(\w+)((?:\s+\S+)*)')
+
+
+def state_name(state):
+    return STATES[state] if state < len(STATES) else str(state)
+
+
+def wakeup_reason(flags):
+    if flags & TDF_SLPINTR:
+        return 'signal'
+    if flags & TDF_SLPTIMED:
+        return 'timeout'
+    return 'normal'
+
+
+class Converter():
+    def __init__(self):
+        self.events = []
+        self.threads = set()
+        self.running = {}   # tid -> time it was switched in
+        self.runnable = {}  # tid -> time it became runnable
+        self.waiting = {}   # tid -> (time, state, wchan, waitpt)
+        self.flow_id = 0
+
+    def slice(self, pid, tid, name, start, end, args=None):
+        self.events.append({'ph': 'X', 'pid': pid, 'tid': tid, 'name': name,
+                            'ts': start, 'dur': end - start,
+                            'args': args or {}})
+
+    def thread_slice(self, tid, name, start, end, args=None):
+        self.threads.add(tid)
+        self.slice(THREADS_PID, tid, name, start, end, args)
+
+    def switch(self, ts, tid, prio, state, newtid, newprio):
+        if tid in self.running:
+            start = self.running.pop(tid)
+            args = {'prio': prio, 'reason': state_name(state)}
+            self.thread_slice(tid, 'running', start, ts, args)
+            self.slice(CPU_PID, 0, 'thread %d' % tid, start, ts, args)
+        if state == STATES.index('ready'):
+            self.runnable[tid] = ts
+        if newtid in self.runnable:
+            self.thread_slice(newtid, 'runnable', self.runnable.pop(newtid),
+                              ts)
+        self.running[newtid] = ts
+
+    def block(self, ts, tid, prio, state, wchan, waitpt):
+        self.waiting[tid] = (ts, state, wchan, waitpt)
+
+    def wakeup(self, ts, tid, prio, waker, flags):
+        if tid in self.waiting:
+            start, state, wchan, waitpt = self.waiting.pop(tid)
+            args = {'wchan': hex(wchan), 'waitpt': hex(waitpt),
+                    'reason': wakeup_reason(flags)}
+            self.thread_slice(tid, state_name(state), start, ts, args)
+        self.runnable[tid] = ts
+
+        # Draw an arrow from the waker to the thread being woken up.
+        self.threads.add(waker)
+        self.flow_id += 1
+        for ph, who in [('s', waker), ('f', tid)]:
+            self.events.append({'ph': ph, 'pid': THREADS_PID, 'tid': who,
+                                'name': 'wakeup', 'cat': 'sched',
+                                'id': self.flow_id, 'ts': ts, 'bp': 'e'})
+
+    def prio(self, ts, tid, oldprio, newprio, borrowing):
+        self.threads.add(tid)
+        self.events.append({'ph': 'C', 'pid': THREADS_PID,
+                            'name': 'prio %d' % tid, 'ts': ts,
+                            'args': {'prio': newprio}})
+
+    def metadata(self):
+        meta = [{'ph': 'M', 'pid': CPU_PID, 'name': 'process_name',
+                 'args': {'name': 'CPU'}},
+                {'ph': 'M', 'pid': CPU_PID, 'tid': 0, 'name': 'thread_name',
+                 'args': {'name': 'CPU 0'}},
+                {'ph': 'M', 'pid': THREADS_PID, 'name': 'process_name',
+                 'args': {'name': 'threads'}}]
+        for tid in sorted(self.threads):
+            meta.append({'ph': 'M', 'pid': THREADS_PID, 'tid': tid,
+                         'name': 'thread_name',
+                         'args': {'name': 'thread %d' % tid}})
+        return meta
+
+    def convert(self, lines):
+        for line in lines:
+            m = RECORD.match(line)
+            if not m:
+                continue
+            sec, nsec, _, probe, args = m.groups()
+            handler = getattr(self, probe, None)
+            if handler is None:
+                continue
+            ts = int(sec) * 1e6 + int(nsec.ljust(9, '0')) / 1e3
+            args = [int(arg, 0) for arg in args.split()]
+            nargs = handler.__code__.co_argcount - 2
+            handler(ts, *args[:nargs])
+        return {'traceEvents': self.metadata() + self.events,
+                'displayTimeUnit': 'ns'}
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description='Convert scheduler trace to Perfetto timeline.')
+    parser.add_argument('input', nargs='?', type=argparse.FileType('r'),
+                        default=sys.stdin,
+                        help='output of sdt program (default: stdin)')
+    parser.add_argument('-o', '--output', type=argparse.FileType('w'),
+                        default=sys.stdout,
+                        help='JSON trace file (default: stdout)')
+    args = parser.parse_args()
+
+    json.dump(Converter().convert(args.input), args.output)
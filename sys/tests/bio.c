@@ -0,0 +1,111 @@
+#include <sys/bio.h>
+#include <sys/condvar.h>
+#include <sys/klog.h>
+#include <sys/ktest.h>
+#include <sys/libkern.h>
+#include <sys/mutex.h>
+#include <sys/uio.h>
+
+#define RAMDISK_BLKSIZE 512
+#define RAMDISK_NBLKS 16
+#define NREQS 8
+
+static uint8_t ramdisk[RAMDISK_NBLKS * RAMDISK_BLKSIZE];
+
+static int ramdisk_rw(void *arg, bio_cmd_t cmd, uint64_t blkno, void *data,
+                      size_t nblks) {
+  void *blk = ramdisk + blkno * RAMDISK_BLKSIZE;
+  if (cmd == BIO_READ)
+    memcpy(data, blk, nblks * RAMDISK_BLKSIZE);
+  else
+    memcpy(blk, data, nblks * RAMDISK_BLKSIZE);
+  return 0;
+}
+
+static MTX_DEFINE(done_lock, 0);
+static condvar_t done_cv;
+static unsigned ndone, nerrors;
+
+static void count_done(bio_t *bp) {
+  SCOPED_MTX_LOCK(&done_lock);
+  ndone++;
+  if (bp->bio_error)
+    nerrors++;
+  cv_signal(&done_cv);
+}
+
+/* Requests for adjacent blocks submitted to a plugged queue are transferred
+ * at once, regardless of the order they were submitted in. */
+static int test_bio_merge(void) {
+  static uint8_t data[NREQS][RAMDISK_BLKSIZE];
+  static const int order[NREQS] = {3, 0, 7, 1, 5, 2, 6, 4};
+  bio_queue_t bq;
+  bio_t bios[NREQS];
+
+  bioq_init(&bq, "test-bio", RAMDISK_BLKSIZE, RAMDISK_NBLKS, ramdisk_rw, NULL);
+
+  cv_init(&done_cv, "bio test done");
+  ndone = nerrors = 0;
+  bioq_plug(&bq);
+  for (int i = 0; i < NREQS; i++) {
+    int n = order[i];
+    memset(data[n], 'a' + n, RAMDISK_BLKSIZE);
+    bios[i] = (bio_t){.bio_cmd = BIO_WRITE,
+                      .bio_blkno = n,
+                      .bio_bcount = RAMDISK_BLKSIZE,
+                      .bio_data = data[n],
+                      .bio_done = count_done};
+    bio_submit(&bq, &bios[i]);
+  }
+  bioq_unplug(&bq);
+
+  WITH_MTX_LOCK (&done_lock) {
+    while (ndone < NREQS)
+      cv_wait(&done_cv, &done_lock);
+  }
+
+  assert(nerrors == 0);
+  assert(bq.bq_ntransfers == 1);
+  assert(bq.bq_nmerged == NREQS - 1);
+
+  for (int n = 0; n < NREQS; n++)
+    assert(ramdisk[n * RAMDISK_BLKSIZE] == 'a' + n);
+
+  bioq_destroy(&bq);
+  return KTEST_SUCCESS;
+}
+
+/* Unaligned writes through `bioq_uio` preserve the rest of the blocks. */
+static int test_bio_uio(void) {
+  bio_queue_t bq;
+  char buf[RAMDISK_BLKSIZE];
+  const char *text = "spans two blocks";
+  size_t len = strlen(text);
+  off_t offset = RAMDISK_BLKSIZE - 4;
+
+  memset(ramdisk, '=', sizeof(ramdisk));
+  bioq_init(&bq, "test-bio", RAMDISK_BLKSIZE, RAMDISK_NBLKS, ramdisk_rw, NULL);
+
+  uio_t uio = UIO_SINGLE_KERNEL(UIO_WRITE, offset, (char *)text, len);
+  assert(bioq_uio(&bq, &uio) == 0);
+  assert(uio.uio_resid == 0);
+
+  assert(ramdisk[offset - 1] == '=');
+  assert(memcmp(ramdisk + offset, text, len) == 0);
+  assert(ramdisk[offset + len] == '=');
+
+  uio = UIO_SINGLE_KERNEL(UIO_READ, offset, buf, len);
+  assert(bioq_uio(&bq, &uio) == 0);
+  assert(memcmp(buf, text, len) == 0);
+
+  /* Reading past the end of the device returns nothing. */
+  uio = UIO_SINGLE_KERNEL(UIO_READ, sizeof(ramdisk), buf, len);
+  assert(bioq_uio(&bq, &uio) == 0);
+  assert(uio.uio_resid == len);
+
+  bioq_destroy(&bq);
+  return KTEST_SUCCESS;
+}
+
+KTEST_ADD(bio_merge, test_bio_merge, 0);
+KTEST_ADD(bio_uio, test_bio_uio, 0);
@@ -61,6 +61,50 @@ static int test_callout_order(void) {
   return KTEST_SUCCESS;
 }
 
+/* This test checks the order of callouts that initially land on upper levels
+ * of the timing wheel and have to be cascaded before they expire. */
+static int test_callout_cascade(void) {
+  callout_t callouts[ORDER_N];
+  for (int i = 0; i < ORDER_N; i++)
+    callout_setup(&callouts[i], callout_ordered, (void *)(intptr_t)order[i]);
+  current = 0;
+
+  systime_t now = getsystime();
+  for (int i = 0; i < ORDER_N; i++)
+    callout_schedule_abs(&callouts[i], now + 30 + order[i] * 37);
+
+  for (int i = 0; i < ORDER_N; i++)
+    callout_drain(&callouts[i]);
+
+  assert(current == ORDER_N);
+
+  return KTEST_SUCCESS;
+}
+
+/* This test verifies that direct callouts are called in interrupt context. */
+static void callout_direct(void *arg) {
+  assert(intr_disabled());
+  counter++;
+}
+
+static int test_callout_direct(void) {
+  const int N = 10;
+
+  callout_t callout;
+  callout_setup_direct(&callout, callout_direct, NULL);
+
+  counter = 0;
+
+  for (int i = 0; i < N; i++) {
+    callout_schedule(&callout, 1);
+    callout_drain(&callout);
+  }
+
+  assert(counter == N);
+
+  return KTEST_SUCCESS;
+}
+
 /* This test verifies that callouts removed with callout_stop are not run. */
 static void callout_bad(void *arg) {
   panic("%s: should never be called!", __func__);
@@ -105,5 +149,7 @@ static int test_callout_drain(void) {
 
 KTEST_ADD(callout_simple, test_callout_simple, 0);
 KTEST_ADD(callout_order, test_callout_order, 0);
+KTEST_ADD(callout_cascade, test_callout_cascade, 0);
+KTEST_ADD(callout_direct, test_callout_direct, 0);
 KTEST_ADD(callout_stop, test_callout_stop, 0);
 KTEST_ADD(callout_drain, test_callout_drain, 0);
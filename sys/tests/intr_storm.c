@@ -0,0 +1,48 @@
+#include <sys/interrupt.h>
+#include <sys/klog.h>
+#include <sys/ktest.h>
+#include <sys/thread.h>
+
+#define STORM_THRESHOLD 16
+#define NINTRS (4 * STORM_THRESHOLD)
+
+static volatile unsigned nservice;
+
+static intr_filter_t storm_filter(void *arg) {
+  return IF_DELEGATE;
+}
+
+static void storm_service(void *arg) {
+  nservice++;
+}
+
+/* A device that keeps raising an interrupt which needs the interrupt thread
+ * gets throttled once the thread is woken up too many times in a second. */
+static int test_intr_storm(void) {
+  unsigned threshold = intr_storm_threshold;
+  intr_storm_threshold = STORM_THRESHOLD;
+  nservice = 0;
+
+  /* The event has no way to mask the interrupt, so each run of handlers
+   * delegates the service routine once again. */
+  intr_event_t *ie = intr_event_create(NULL, -1, NULL, NULL, "test-storm");
+  intr_handler_t *ih = intr_event_add_handler(ie, storm_filter, storm_service,
+                                              NULL, "test-storm");
+
+  for (int i = 0; i < NINTRS; i++) {
+    WITH_INTR_DISABLED
+      intr_event_run_handlers(ie);
+    /* Let the interrupt thread run. */
+    thread_yield();
+  }
+
+  assert(ie->ie_storming);
+  assert(nservice > 0 && nservice < NINTRS);
+
+  /* The handler is freed by the interrupt thread once it's done throttling. */
+  intr_event_remove_handler(ih);
+  intr_storm_threshold = threshold;
+  return KTEST_SUCCESS;
+}
+
+KTEST_ADD(intr_storm, test_intr_storm, 0);
@@ -1,6 +1,7 @@
 #include <sys/file.h>
 #include <sys/filedesc.h>
 #include <sys/ktest.h>
+#include <sys/errno.h>
 
 static int test_resizable_fdt(void) {
   fdtab_t *fdt_test = fdtab_create();
@@ -11,7 +12,7 @@ static int test_resizable_fdt(void) {
     fdtab_install_file(fdt_test, tmp_file, 0, &new_fd);
   }
 
-  fdtab_t *another_fdt_test = fdtab_copy(fdt_test);
+  fdtab_t *another_fdt_test = fdtab_copy(fdt_test, false);
 
   fdtab_drop(fdt_test);
   fdtab_drop(another_fdt_test);
@@ -19,4 +20,35 @@ static int test_resizable_fdt(void) {
   return KTEST_SUCCESS;
 }
 
+static int test_shared_fdt(void) {
+  fdtab_t *fdt = fdtab_create();
+  file_t *f = file_alloc();
+  file_t *got;
+  int fd;
+
+  fdtab_install_file(fdt, f, 0, &fd);
+
+  /* Table that is not shared is not copied. */
+  assert(fdtab_unshare(fdt) == fdt);
+
+  /* Shared table gets replaced by a private copy with the same files. */
+  fdtab_hold(fdt);
+  fdtab_t *copy = fdtab_unshare(fdt);
+  assert(copy != fdt);
+  assert(fdtab_get_file(copy, fd, 0, &got) == 0 && got == f);
+  file_drop(got);
+
+  /* Closing a descriptor in one table does not affect the other. */
+  fdtab_close_fd(copy, fd);
+  assert(fdtab_get_file(copy, fd, 0, &got) == EBADF);
+  assert(fdtab_get_file(fdt, fd, 0, &got) == 0 && got == f);
+  file_drop(got);
+
+  fdtab_drop(copy);
+  fdtab_drop(fdt);
+
+  return KTEST_SUCCESS;
+}
+
 KTEST_ADD(resizable_fdt, test_resizable_fdt, 0);
+KTEST_ADD(shared_fdt, test_shared_fdt, 0);
@@ -112,6 +112,36 @@ static int test_ringbuf_move(void) {
   return KTEST_SUCCESS;
 }
 
+static int test_ringbuf_cyclic_bulk(void) {
+  ringbuf_t src, dst;
+  char buf0[5], buf1[5];
+  ringbuf_init(&src, buf0, 5);
+  ringbuf_init(&dst, buf1, 5);
+
+  uint8_t res[5];
+
+  /* Move heads and tails of both buffers, so that transfers wrap around. */
+  assert(ringbuf_putnb(&src, (uint8_t *)"xyz", 3));
+  assert(ringbuf_getnb(&src, res, 3));
+  assert(ringbuf_putnb(&dst, (uint8_t *)"xy", 2));
+  assert(ringbuf_getnb(&dst, res, 2));
+
+  assert(ringbuf_putnb(&src, (uint8_t *)"abcd", 4));
+  assert(!ringbuf_putnb(&src, (uint8_t *)"ef", 2));
+  assert(ringbuf_movenb(&src, &dst, 4));
+  assert(ringbuf_empty(&src));
+  assert(!ringbuf_getnb(&dst, res, 5));
+  assert(ringbuf_getnb(&dst, res, 4));
+  assert(ringbuf_empty(&dst));
+
+  assert(res[0] == 'a');
+  assert(res[1] == 'b');
+  assert(res[2] == 'c');
+  assert(res[3] == 'd');
+
+  return KTEST_SUCCESS;
+}
+
 static int test_uio_ringbuf_trivial(void) {
   ringbuf_t rbt;
   char buf[5];
@@ -225,6 +255,7 @@ static int test_uio_ringbuf_cyclic_transfers(void) {
 KTEST_ADD(ringbuf_trivial, test_ringbuf_trivial, 0);
 KTEST_ADD(ringbuf_nontrivial, test_ringbuf_nontrivial, 0);
 KTEST_ADD(ringbuf_move, test_ringbuf_move, 0);
+KTEST_ADD(ringbuf_cyclic_bulk, test_ringbuf_cyclic_bulk, 0);
 KTEST_ADD(uio_ringbuf_trivial, test_uio_ringbuf_trivial, 0);
 KTEST_ADD(uio_ringbuf_one_transfer, test_uio_ringbuf_one_transfer, 0);
 KTEST_ADD(uio_ringbuf_two_transfers, test_uio_ringbuf_two_transfers, 0);
@@ -0,0 +1,40 @@
+#include <sys/klog.h>
+#include <sys/ktest.h>
+#include <sys/libkern.h>
+#include <sys/mutex.h>
+#include <sys/ringbuf.h>
+#include <sys/tty.h>
+
+static void dummy_notify_out(tty_t *tty) {
+  /* Echoed characters are left in the output queue. */
+}
+
+/* A line pasted at once that doesn't fit into the line buffer is truncated,
+ * but the newline that follows it still gets through. */
+static int test_tty_input_lossy(void) {
+  static uint8_t paste[LINEBUF_SIZE + 16];
+  size_t len = sizeof(paste);
+  tty_t *tty = tty_alloc();
+  tty->t_ops.t_notify_out = dummy_notify_out;
+
+  memset(paste, 'x', len - 1);
+  paste[len - 1] = '\n';
+
+  WITH_MTX_LOCK (&tty->t_lock) {
+    assert(tty->t_lflag & ICANON);
+    assert(tty_input_lossy(tty, paste, len) == len - LINEBUF_SIZE);
+    assert(tty->t_inq.count == LINEBUF_SIZE);
+
+    uint8_t line[LINEBUF_SIZE];
+    assert(ringbuf_getnb(&tty->t_inq, line, LINEBUF_SIZE));
+    assert(memcmp(line, paste, LINEBUF_SIZE - 1) == 0);
+    assert(line[LINEBUF_SIZE - 1] == '\n');
+  }
+
+  /* The tty has never been attached to a device. */
+  tty->t_flags |= TF_DRIVER_DETACHED;
+  tty_free(tty);
+  return KTEST_SUCCESS;
+}
+
+KTEST_ADD(tty_input_lossy, test_tty_input_lossy, 0);
@@ -34,7 +34,7 @@ static int utest_generic(const char *name, int status_success) {
   klog("User test '%s' started", name);
 
   pid_t cpid;
-  if (do_fork(utest_generic_thread, (void *)name, &cpid))
+  if (do_fork(utest_generic_thread, (void *)name, 0, &cpid))
     panic("Could not start test!");
 
   int status;
@@ -114,6 +114,7 @@ UTEST_ADD(signal_handler_mask);
 UTEST_ADD(fork_wait);
 UTEST_ADD(fork_signal);
 UTEST_ADD(fork_sigchld_ignored);
+UTEST_ADD(fork_rfork_fdtable);
 
 UTEST_ADD(lseek_basic);
 UTEST_ADD(lseek_errors);
@@ -184,6 +185,9 @@ UTEST_ADD(gettimeofday);
 #endif
 // UTEST_ADD(nanosleep);
 UTEST_ADD(itimer);
+UTEST_ADD(timer_signal);
+UTEST_ADD(timer_kqueue);
+UTEST_ADD(timepage);
 
 UTEST_ADD(get_set_uid);
 UTEST_ADD(get_set_gid);
@@ -193,12 +197,20 @@ UTEST_ADD(sharing_memory_simple);
 UTEST_ADD(sharing_memory_child_and_grandchild);
 
 UTEST_ADD(pty_simple);
+UTEST_ADD(pty_bulk);
+UTEST_ADD(pty_kqueue_reopen);
 
 UTEST_ADD(tty_canon);
 UTEST_ADD(tty_echo);
 UTEST_ADD(tty_signals);
 
 UTEST_ADD(procstat);
+UTEST_ADD(klog_read);
+UTEST_ADD(sdt_syscall);
+UTEST_ADD(latency_tracer);
+UTEST_ADD(evcnt_syscall);
+UTEST_ADD(getrusage_faults);
+UTEST_ADD(memstat_read);
 
 UTEST_ADD(pipe_parent_signaled);
 UTEST_ADD(pipe_child_signaled);
@@ -208,3 +220,27 @@ UTEST_ADD(pipe_write_errno_eagain);
 UTEST_ADD(pipe_read_interruptible_sleep);
 UTEST_ADD(pipe_read_errno_eagain);
 UTEST_ADD(pipe_read_return_zero);
+
+UTEST_ADD(poll_pipe);
+UTEST_ADD(poll_bad_fd);
+UTEST_ADD(poll_wakeup);
+UTEST_ADD(poll_pty);
+UTEST_ADD(poll_ppoll_sigmask);
+UTEST_ADD(select_pipe);
+
+UTEST_ADD(futex_basic);
+UTEST_ADD(futex_shared);
+UTEST_ADD(futex_requeue);
+UTEST_ADD(futex_requeue_self);
+
+UTEST_ADD(thread_create_join);
+UTEST_ADD(thread_mutex);
+UTEST_ADD(thread_cond);
+UTEST_ADD(thread_sigmask);
+UTEST_ADD(thread_exit);
+
+UTEST_ADD(vfork_shared_memory);
+UTEST_ADD(vfork_exec);
+UTEST_ADD(posix_spawn_exit);
+UTEST_ADD(posix_spawn_file_actions);
+UTEST_ADD(posix_spawn_noent);
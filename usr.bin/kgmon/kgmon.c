@@ -0,0 +1,128 @@
+/*
+ * kgmon - control kernel profiling and dump its results to gmon.out file
+ *
+ * Works only if the kernel was built with KGPROF=1, which provides /dev/kgmon.
+ */
+#include <sys/types.h>
+#include <sys/gmon.h>
+#include <sys/ioctl.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define KGMON_DEV "/dev/kgmon"
+
+static const char *state_name(int state) {
+  switch (state) {
+    case GMON_PROF_ON:
+      return "running";
+    case GMON_PROF_BUSY:
+      return "busy";
+    case GMON_PROF_ERROR:
+      return "stopped (out of arc records)";
+    case GMON_PROF_OFF:
+      return "off";
+    default:
+      return "not initialized";
+  }
+}
+
+static int get_state(int fd) {
+  int state;
+  if (ioctl(fd, GMONIOCGSTATE, &state) < 0)
+    err(EXIT_FAILURE, "GMONIOCGSTATE");
+  return state;
+}
+
+static void set_state(int fd, int state) {
+  if (ioctl(fd, GMONIOCSSTATE, &state) < 0)
+    err(EXIT_FAILURE, "GMONIOCSSTATE");
+}
+
+static void dump(int fd, const char *path) {
+  int state = get_state(fd);
+  char buf[4096];
+  ssize_t n;
+
+  /* Profiling data can only be read when it's not being updated. */
+  if (state == GMON_PROF_ON)
+    set_state(fd, GMON_PROF_OFF);
+
+  int out = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out < 0)
+    err(EXIT_FAILURE, "%s", path);
+
+  if (lseek(fd, 0, SEEK_SET) < 0)
+    err(EXIT_FAILURE, "lseek");
+
+  while ((n = read(fd, buf, sizeof(buf))) > 0)
+    if (write(out, buf, n) != n)
+      err(EXIT_FAILURE, "%s", path);
+
+  if (n < 0)
+    err(EXIT_FAILURE, "read");
+
+  close(out);
+
+  if (state == GMON_PROF_ON)
+    set_state(fd, GMON_PROF_ON);
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: kgmon [-bhrp] [-o file]\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  bool bflag = false, hflag = false, rflag = false, pflag = false;
+  const char *path = "gmon.out";
+  int ch;
+
+  while ((ch = getopt(argc, argv, "bhrpo:")) != -1) {
+    switch (ch) {
+      case 'b':
+        bflag = true;
+        break;
+      case 'h':
+        hflag = true;
+        break;
+      case 'r':
+        rflag = true;
+        break;
+      case 'p':
+        pflag = true;
+        break;
+      case 'o':
+        path = optarg;
+        break;
+      default:
+        usage();
+    }
+  }
+
+  if ((argc -= optind) > 0 || (bflag && hflag))
+    usage();
+
+  int fd = open(KGMON_DEV, O_RDONLY);
+  if (fd < 0)
+    err(EXIT_FAILURE, "%s (kernel built without KGPROF?)", KGMON_DEV);
+
+  /* Halt first, so that the dump and reset see the final state. */
+  if (hflag)
+    set_state(fd, GMON_PROF_OFF);
+  if (pflag)
+    dump(fd, path);
+  if (rflag && ioctl(fd, GMONIOCRESET) < 0)
+    err(EXIT_FAILURE, "GMONIOCRESET");
+  if (bflag)
+    set_state(fd, GMON_PROF_ON);
+
+  printf("kernel profiling is %s\n", state_name(get_state(fd)));
+
+  close(fd);
+  return EXIT_SUCCESS;
+}
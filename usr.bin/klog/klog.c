@@ -0,0 +1,118 @@
+/*
+ * klog - decode kernel log messages read from /dev/klog
+ *
+ * Reading the device consumes messages, so each message is printed only once.
+ */
+#include <sys/types.h>
+#include <sys/klog.h>
+#include <sys/time.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define KLOG_DEV "/dev/klog"
+
+static const char *subsystems[] = KL_ORIGIN_NAMES;
+
+#define NSUBSYSTEMS (sizeof(subsystems) / sizeof(subsystems[0]))
+
+/* Conversion of a single parameter. String parameters point into kernel
+ * memory, hence they are printed as addresses. */
+static void print_param(const char *spec, size_t len, char conv,
+                        uintptr_t param) {
+  char fmt[32];
+
+  if (len >= sizeof(fmt) || conv == 's' || conv == 'n') {
+    printf("[%#lx]", (u_long)param);
+    return;
+  }
+
+  memcpy(fmt, spec, len);
+  fmt[len] = '\0';
+
+  if (conv == 'c')
+    printf(fmt, (int)param);
+  else if (strstr(fmt, "ll") || strchr(fmt, 'j'))
+    printf(fmt, (long long)param);
+  else if (strchr(fmt, 'l') || strchr(fmt, 'z') || strchr(fmt, 't') ||
+           conv == 'p')
+    printf(fmt, (long)param);
+  else
+    printf(fmt, (int)param);
+}
+
+static void print_message(const char *fmt, const uintptr_t *params) {
+  unsigned n = 0;
+
+  while (*fmt) {
+    if (*fmt != '%') {
+      putchar(*fmt++);
+      continue;
+    }
+
+    if (fmt[1] == '%') {
+      putchar('%');
+      fmt += 2;
+      continue;
+    }
+
+    size_t len = strcspn(fmt + 1, "diouxXcspn") + 1;
+    if (fmt[len] == '\0' || n == KL_NPARAMS) {
+      fputs(fmt, stdout);
+      return;
+    }
+
+    print_param(fmt, len + 1, fmt[len], params[n++]);
+    fmt += len + 1;
+  }
+}
+
+static void print_record(klog_record_t *rec) {
+  const char *file = (const char *)(rec + 1);
+  const char *fmt = file + strlen(file) + 1;
+  timespec_t ts;
+
+  bt2ts(&rec->kr_timestamp, &ts);
+  printf("%5ld.%06ld %4u ", (long)ts.tv_sec, ts.tv_nsec / 1000, rec->kr_tid);
+
+  if (rec->kr_origin == KL_UNDEF || rec->kr_origin >= NSUBSYSTEMS)
+    printf("[%s:%u] ", file, rec->kr_line);
+  else
+    printf("[%s] ", subsystems[rec->kr_origin]);
+
+  print_message(fmt, rec->kr_params);
+  putchar('\n');
+}
+
+int main(int argc, char **argv) {
+  static char buf[4096] __aligned(sizeof(uintptr_t));
+  ssize_t n;
+
+  if (argc > 1) {
+    fprintf(stderr, "usage: klog\n");
+    return EXIT_FAILURE;
+  }
+
+  int fd = open(KLOG_DEV, O_RDONLY);
+  if (fd < 0)
+    err(EXIT_FAILURE, "%s", KLOG_DEV);
+
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    for (ssize_t off = 0; off < n;) {
+      klog_record_t *rec = (klog_record_t *)(buf + off);
+      print_record(rec);
+      off += rec->kr_size;
+    }
+  }
+
+  if (n < 0)
+    err(EXIT_FAILURE, "read");
+
+  close(fd);
+  return EXIT_SUCCESS;
+}
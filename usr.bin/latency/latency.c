@@ -0,0 +1,147 @@
+/*
+ * latency - report the longest sections run with interrupts or preemption
+ * disabled
+ *
+ * If a command is given, the tracer is reset and enabled only while the
+ * command runs. Use addr2line on the kernel image to resolve addresses.
+ */
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/latency.h>
+#include <sys/wait.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define LATENCY_DEV "/dev/latency"
+
+static const char *type_name[LAT_NTYPES] = {
+  [LAT_IRQSOFF] = "irqsoff",
+  [LAT_PREEMPTOFF] = "preemptoff",
+};
+
+static void set_state(int fd, int state) {
+  if (ioctl(fd, LATIOCSSTATE, &state) < 0)
+    err(EXIT_FAILURE, "LATIOCSSTATE");
+}
+
+static void reset(int fd) {
+  if (ioctl(fd, LATIOCRESET) < 0)
+    err(EXIT_FAILURE, "LATIOCRESET");
+}
+
+static int run(char **argv) {
+  int status;
+  pid_t pid = fork();
+
+  if (pid < 0)
+    err(EXIT_FAILURE, "fork");
+
+  if (pid == 0) {
+    execvp(argv[0], argv);
+    err(EXIT_FAILURE, "%s", argv[0]);
+  }
+
+  if (waitpid(pid, &status, 0) < 0)
+    err(EXIT_FAILURE, "waitpid");
+
+  return WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+}
+
+static int compare(const void *a, const void *b) {
+  const latency_record_t *lr1 = a, *lr2 = b;
+
+  if (lr1->lr_type != lr2->lr_type)
+    return lr1->lr_type - lr2->lr_type;
+  if (lr1->lr_max != lr2->lr_max)
+    return lr1->lr_max < lr2->lr_max ? 1 : -1;
+  return 0;
+}
+
+static void print(int fd) {
+  latency_record_t lrs[LAT_NTYPES * LAT_NWORST];
+  ssize_t nread;
+
+  if (lseek(fd, 0, SEEK_SET) < 0)
+    err(EXIT_FAILURE, "lseek");
+  if ((nread = read(fd, lrs, sizeof(lrs))) < 0)
+    err(EXIT_FAILURE, "read");
+
+  size_t n = nread / sizeof(latency_record_t);
+  qsort(lrs, n, sizeof(latency_record_t), compare);
+
+  printf("%-10s %14s %10s %6s  %-18s %-18s\n", "type", "max[us]", "count",
+         "tid", "start", "end");
+
+  for (size_t i = 0; i < n; i++) {
+    latency_record_t *lr = &lrs[i];
+
+    if (lr->lr_count == 0 || lr->lr_type < 0 || lr->lr_type >= LAT_NTYPES)
+      continue;
+
+    printf("%-10s %10llu.%03llu %10llu %6u  %-18p %-18p\n",
+           type_name[lr->lr_type], (unsigned long long)lr->lr_max / 1000,
+           (unsigned long long)lr->lr_max % 1000,
+           (unsigned long long)lr->lr_count, (unsigned)lr->lr_tid,
+           (void *)lr->lr_start_pc, (void *)lr->lr_end_pc);
+  }
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: latency [-edr] [command [args...]]\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  bool eflag = false, dflag = false, rflag = false;
+  int status = EXIT_SUCCESS;
+  int ch;
+
+  while ((ch = getopt(argc, argv, "+edr")) != -1) {
+    switch (ch) {
+      case 'e':
+        eflag = true;
+        break;
+      case 'd':
+        dflag = true;
+        break;
+      case 'r':
+        rflag = true;
+        break;
+      default:
+        usage();
+    }
+  }
+
+  argc -= optind;
+  argv += optind;
+
+  if (eflag && dflag)
+    usage();
+
+  int fd = open(LATENCY_DEV, O_RDONLY);
+  if (fd < 0)
+    err(EXIT_FAILURE, "%s", LATENCY_DEV);
+
+  if (argc > 0) {
+    reset(fd);
+    set_state(fd, 1);
+    status = run(argv);
+    set_state(fd, 0);
+    print(fd);
+  } else {
+    if (rflag)
+      reset(fd);
+    if (eflag || dflag)
+      set_state(fd, eflag);
+    if (!eflag && !dflag && !rflag)
+      print(fd);
+  }
+
+  close(fd);
+  return status;
+}
@@ -0,0 +1,194 @@
+/*
+ * lockstat - report kernel lock contention statistics
+ *
+ * Works only if the kernel was built with LOCKDEP=1, which provides
+ * /dev/lockstat. If a command is given, statistics are reset and collected
+ * only while the command runs.
+ */
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/lockstat.h>
+#include <sys/wait.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define LOCKSTAT_DEV "/dev/lockstat"
+
+static bool sort_by_hold;
+
+static void set_state(int fd, int state) {
+  if (ioctl(fd, LOCKSTATIOCSSTATE, &state) < 0)
+    err(EXIT_FAILURE, "LOCKSTATIOCSSTATE");
+}
+
+static void reset(int fd) {
+  if (ioctl(fd, LOCKSTATIOCRESET) < 0)
+    err(EXIT_FAILURE, "LOCKSTATIOCRESET");
+}
+
+static int run(char **argv) {
+  int status;
+  pid_t pid = fork();
+
+  if (pid < 0)
+    err(EXIT_FAILURE, "fork");
+
+  if (pid == 0) {
+    execvp(argv[0], argv);
+    err(EXIT_FAILURE, "%s", argv[0]);
+  }
+
+  if (waitpid(pid, &status, 0) < 0)
+    err(EXIT_FAILURE, "waitpid");
+
+  return WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+}
+
+static int compare(const void *a, const void *b) {
+  const lockstat_record_t *lr1 = a, *lr2 = b;
+  uint64_t t1 = sort_by_hold ? lr1->lr_hold_total : lr1->lr_wait_total;
+  uint64_t t2 = sort_by_hold ? lr2->lr_hold_total : lr2->lr_wait_total;
+
+  if (t1 != t2)
+    return t1 < t2 ? 1 : -1;
+  if (lr1->lr_acquired != lr2->lr_acquired)
+    return lr1->lr_acquired < lr2->lr_acquired ? 1 : -1;
+  return 0;
+}
+
+static void print_sites(lockstat_record_t *lr) {
+  /* There're only a few sites, so simple selection sort is fine. */
+  for (int i = 0; i < LOCKSTAT_NSITES; i++) {
+    lockstat_site_t *best = NULL;
+
+    for (int j = 0; j < LOCKSTAT_NSITES; j++) {
+      lockstat_site_t *ls = &lr->lr_sites[j];
+      if (ls->ls_count && (best == NULL || ls->ls_wait > best->ls_wait))
+        best = ls;
+    }
+
+    if (best == NULL)
+      break;
+
+    printf("%10s %10llu %12llu %34s  %p\n", "",
+           (unsigned long long)best->ls_count,
+           (unsigned long long)best->ls_wait / 1000, "",
+           (void *)best->ls_waitpt);
+    best->ls_count = 0;
+  }
+}
+
+static void print(int fd, int count, bool sites) {
+  lockstat_record_t *lrs = NULL;
+  size_t n = 0, size = 0;
+  ssize_t nread;
+
+  if (lseek(fd, 0, SEEK_SET) < 0)
+    err(EXIT_FAILURE, "lseek");
+
+  do {
+    if (n == size) {
+      size = size ? size * 2 : 64;
+      if (!(lrs = realloc(lrs, size * sizeof(lockstat_record_t))))
+        err(EXIT_FAILURE, "realloc");
+    }
+    nread = read(fd, &lrs[n], (size - n) * sizeof(lockstat_record_t));
+    if (nread < 0)
+      err(EXIT_FAILURE, "read");
+    n += nread / sizeof(lockstat_record_t);
+  } while (nread > 0);
+
+  qsort(lrs, n, sizeof(lockstat_record_t), compare);
+
+  printf("%10s %10s %12s %10s %12s %10s  %s\n", "acquired", "contended",
+         "wait[us]", "max[us]", "hold[us]", "max[us]", "class");
+
+  for (size_t i = 0; i < n && (count == 0 || (int)i < count); i++) {
+    lockstat_record_t *lr = &lrs[i];
+
+    if (lr->lr_acquired == 0)
+      break;
+
+    printf("%10llu %10llu %12llu %10llu %12llu %10llu  %s\n",
+           (unsigned long long)lr->lr_acquired,
+           (unsigned long long)lr->lr_contended,
+           (unsigned long long)lr->lr_wait_total / 1000,
+           (unsigned long long)lr->lr_wait_max / 1000,
+           (unsigned long long)lr->lr_hold_total / 1000,
+           (unsigned long long)lr->lr_hold_max / 1000, lr->lr_name);
+
+    if (sites)
+      print_sites(lr);
+  }
+
+  free(lrs);
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: lockstat [-edrHs] [-n count] [command [args...]]\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  bool eflag = false, dflag = false, rflag = false, sflag = false;
+  int count = 0, status = EXIT_SUCCESS;
+  int ch;
+
+  while ((ch = getopt(argc, argv, "+edrHsn:")) != -1) {
+    switch (ch) {
+      case 'e':
+        eflag = true;
+        break;
+      case 'd':
+        dflag = true;
+        break;
+      case 'r':
+        rflag = true;
+        break;
+      case 'H':
+        sort_by_hold = true;
+        break;
+      case 's':
+        sflag = true;
+        break;
+      case 'n':
+        count = atoi(optarg);
+        break;
+      default:
+        usage();
+    }
+  }
+
+  argc -= optind;
+  argv += optind;
+
+  if (eflag && dflag)
+    usage();
+
+  int fd = open(LOCKSTAT_DEV, O_RDONLY);
+  if (fd < 0)
+    err(EXIT_FAILURE, "%s (kernel built without LOCKDEP?)", LOCKSTAT_DEV);
+
+  if (argc > 0) {
+    reset(fd);
+    set_state(fd, 1);
+    status = run(argv);
+    set_state(fd, 0);
+    print(fd, count, sflag);
+  } else {
+    if (rflag)
+      reset(fd);
+    if (eflag || dflag)
+      set_state(fd, eflag);
+    if (!eflag && !dflag && !rflag)
+      print(fd, count, sflag);
+  }
+
+  close(fd);
+  return status;
+}
@@ -0,0 +1,166 @@
+/*
+ * sdt - list, enable and consume kernel static tracepoints
+ *
+ * Probes are given as `provider:name`, where either part may be `*`.
+ * Tracing stops after given number of records or on SIGINT.
+ */
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/sdt.h>
+#include <sys/time.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SDT_DEV "/dev/sdt"
+#define NRECORDS 64
+
+static sdt_probe_info_t *probes;
+static unsigned nprobes;
+static volatile sig_atomic_t stop;
+
+static void sigint_handler(int signo) {
+  stop = 1;
+}
+
+static void fetch_probes(int fd) {
+  sdt_probe_info_t info;
+
+  for (info.spi_id = 0; ioctl(fd, SDTIOCGPROBE, &info) == 0; info.spi_id++) {
+    probes = realloc(probes, (nprobes + 1) * sizeof(sdt_probe_info_t));
+    if (probes == NULL)
+      err(EXIT_FAILURE, "realloc");
+    probes[nprobes++] = info;
+  }
+}
+
+static void list_probes(void) {
+  printf("%4s %-10s %-10s %s\n", "ID", "PROVIDER", "NAME", "ARGUMENTS");
+  for (unsigned i = 0; i < nprobes; i++) {
+    sdt_probe_info_t *p = &probes[i];
+    printf("%4u %-10s %-10s %s\n", p->spi_id, p->spi_provider, p->spi_name,
+           p->spi_args);
+  }
+}
+
+static bool match(const char *pattern, const char *name, size_t len) {
+  if (len == 1 && pattern[0] == '*')
+    return true;
+  return strlen(name) == len && strncmp(pattern, name, len) == 0;
+}
+
+static void enable_probes(int fd, const char *spec) {
+  const char *colon = strchr(spec, ':');
+  bool found = false;
+
+  if (colon == NULL)
+    errx(EXIT_FAILURE, "%s: probe must be given as provider:name", spec);
+
+  for (unsigned i = 0; i < nprobes; i++) {
+    sdt_probe_info_t *p = &probes[i];
+    if (!match(spec, p->spi_provider, colon - spec) ||
+        !match(colon + 1, p->spi_name, strlen(colon + 1)))
+      continue;
+    if (ioctl(fd, SDTIOCENABLE, &p->spi_id) < 0)
+      err(EXIT_FAILURE, "SDTIOCENABLE");
+    found = true;
+  }
+
+  if (!found)
+    errx(EXIT_FAILURE, "%s: no such probe", spec);
+}
+
+static void print_record(sdt_record_t *rec) {
+  sdt_probe_info_t *p = &probes[rec->sr_probe];
+  timespec_t ts;
+
+  bt2ts(&rec->sr_timestamp, &ts);
+  printf("%5ld.%09ld %4u %s:%s", (long)ts.tv_sec, ts.tv_nsec, rec->sr_tid,
+         p->spi_provider, p->spi_name);
+  for (int i = 0; i < SDT_NARGS; i++)
+    printf(" %#lx", (u_long)rec->sr_args[i]);
+  putchar('\n');
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: sdt -l\n"
+                  "       sdt [-c count] provider:name ...\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  static sdt_record_t recs[NRECORDS];
+  long count = -1;
+  bool lflag = false;
+  unsigned drops;
+  ssize_t n;
+  int ch;
+
+  while ((ch = getopt(argc, argv, "c:l")) != -1) {
+    switch (ch) {
+      case 'c':
+        count = strtol(optarg, NULL, 10);
+        break;
+      case 'l':
+        lflag = true;
+        break;
+      default:
+        usage();
+    }
+  }
+
+  argc -= optind;
+  argv += optind;
+
+  if (lflag == (argc > 0))
+    usage();
+
+  int fd = open(SDT_DEV, O_RDONLY);
+  if (fd < 0)
+    err(EXIT_FAILURE, "%s", SDT_DEV);
+
+  fetch_probes(fd);
+
+  if (lflag) {
+    list_probes();
+    return EXIT_SUCCESS;
+  }
+
+  for (int i = 0; i < argc; i++)
+    enable_probes(fd, argv[i]);
+
+  signal(SIGINT, sigint_handler);
+
+  while (!stop && count != 0) {
+    if ((n = read(fd, recs, sizeof(recs))) < 0) {
+      if (stop)
+        break;
+      err(EXIT_FAILURE, "read");
+    }
+
+    /* Nothing happened since the last read. */
+    if (n == 0) {
+      usleep(10000);
+      continue;
+    }
+
+    for (size_t i = 0; i < n / sizeof(sdt_record_t) && count != 0; i++) {
+      print_record(&recs[i]);
+      if (count > 0)
+        count--;
+    }
+  }
+
+  if (ioctl(fd, SDTIOCGDROPS, &drops) == 0 && drops > 0)
+    fprintf(stderr, "sdt: %u records dropped\n", drops);
+
+  /* Closing the device disables all probes. */
+  close(fd);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,322 @@
+/*
+ * vmstat - report kernel event rates
+ *
+ * Reads event counters from /dev/evcnt. The first report shows averages since
+ * boot, subsequent ones (with -w) show rates over the last interval.
+ *
+ * With -m reports kernel memory usage from /dev/memstat instead. Fragmentation
+ * of a pool is the fraction of memory taken by its slabs that isn't occupied by
+ * used items.
+ */
+#include <sys/types.h>
+#include <sys/evcnt.h>
+#include <sys/memstat.h>
+#include <sys/time.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define EVCNT_DEV "/dev/evcnt"
+#define MEMSTAT_DEV "/dev/memstat"
+
+typedef struct sample {
+  evcnt_record_t *recs;
+  size_t n;      /* number of records */
+  size_t size;   /* capacity of `recs` */
+  timespec_t ts; /* when the sample was taken */
+} sample_t;
+
+static void take_sample(int fd, sample_t *s) {
+  ssize_t nread;
+
+  s->n = 0;
+
+  if (lseek(fd, 0, SEEK_SET) < 0)
+    err(EXIT_FAILURE, "lseek");
+
+  do {
+    if (s->n == s->size) {
+      s->size = s->size ? s->size * 2 : 128;
+      if (!(s->recs = realloc(s->recs, s->size * sizeof(evcnt_record_t))))
+        err(EXIT_FAILURE, "realloc");
+    }
+    nread =
+      read(fd, &s->recs[s->n], (s->size - s->n) * sizeof(evcnt_record_t));
+    if (nread < 0)
+      err(EXIT_FAILURE, "read");
+    s->n += nread / sizeof(evcnt_record_t);
+  } while (nread > 0);
+
+  clock_gettime(CLOCK_MONOTONIC, &s->ts);
+}
+
+static bool same_counter(evcnt_record_t *er1, evcnt_record_t *er2) {
+  return !strcmp(er1->er_group, er2->er_group) &&
+         !strcmp(er1->er_name, er2->er_name);
+}
+
+/* Returns number of events counted by `er` since `prev` was sampled. */
+static uint64_t delta(sample_t *prev, evcnt_record_t *er) {
+  if (prev == NULL)
+    return er->er_count;
+
+  for (size_t i = 0; i < prev->n; i++)
+    if (same_counter(&prev->recs[i], er))
+      return er->er_count - prev->recs[i].er_count;
+
+  /* Counter has been attached after the previous sample. */
+  return er->er_count;
+}
+
+/* Milliseconds since `prev` was sampled or since boot. */
+static uint64_t elapsed_ms(sample_t *prev, sample_t *cur) {
+  timespec_t ts = cur->ts;
+  if (prev)
+    timespecsub(&cur->ts, &prev->ts, &ts);
+  uint64_t ms = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+  return ms ? ms : 1;
+}
+
+static uint64_t rate(uint64_t n, uint64_t ms) {
+  return n * 1000 / ms;
+}
+
+/* Sums up rates of counters in `group`. If `name` is given, then only the
+ * counter with that name is taken into account. */
+static uint64_t group_rate(sample_t *prev, sample_t *cur, const char *group,
+                           const char *name) {
+  uint64_t n = 0;
+
+  for (size_t i = 0; i < cur->n; i++) {
+    evcnt_record_t *er = &cur->recs[i];
+    if (strcmp(er->er_group, group))
+      continue;
+    if (name && strcmp(er->er_name, name))
+      continue;
+    n += delta(prev, er);
+  }
+
+  return rate(n, elapsed_ms(prev, cur));
+}
+
+static void print_summary(sample_t *prev, sample_t *cur, bool header) {
+  if (header)
+    printf("%8s %8s %8s %8s %8s %8s\n", "cs/s", "sy/s", "in/s", "flt/s",
+           "tlb/s", "refill/s");
+
+  printf("%8llu %8llu %8llu %8llu %8llu %8llu\n",
+         (unsigned long long)group_rate(prev, cur, "sched", NULL),
+         (unsigned long long)group_rate(prev, cur, "syscall", NULL),
+         (unsigned long long)group_rate(prev, cur, "intr", NULL),
+         (unsigned long long)group_rate(prev, cur, "vm", "fault"),
+         (unsigned long long)group_rate(prev, cur, "pmap", NULL),
+         (unsigned long long)group_rate(prev, cur, "pool", NULL));
+}
+
+static void print_events(sample_t *prev, sample_t *cur, bool zeros) {
+  uint64_t ms = elapsed_ms(prev, cur);
+
+  printf("%-*s %-*s %12s %10s\n", EVCNT_GROUPLEN, "group", EVCNT_NAMELEN,
+         "event", prev ? "delta" : "total", "rate");
+
+  for (size_t i = 0; i < cur->n; i++) {
+    evcnt_record_t *er = &cur->recs[i];
+    uint64_t n = delta(prev, er);
+
+    if (n == 0 && !zeros)
+      continue;
+
+    printf("%-*s %-*s %12llu %10llu\n", EVCNT_GROUPLEN, er->er_group,
+           EVCNT_NAMELEN, er->er_name, (unsigned long long)n,
+           (unsigned long long)rate(n, ms));
+  }
+}
+
+static memstat_record_t *read_memstat(size_t *np) {
+  memstat_record_t *recs = NULL;
+  size_t n = 0, size = 0;
+  ssize_t nread;
+
+  int fd = open(MEMSTAT_DEV, O_RDONLY);
+  if (fd < 0)
+    err(EXIT_FAILURE, "%s", MEMSTAT_DEV);
+
+  do {
+    if (n == size) {
+      size = size ? size * 2 : 128;
+      if (!(recs = realloc(recs, size * sizeof(memstat_record_t))))
+        err(EXIT_FAILURE, "realloc");
+    }
+    nread = read(fd, &recs[n], (size - n) * sizeof(memstat_record_t));
+    if (nread < 0)
+      err(EXIT_FAILURE, "read");
+    n += nread / sizeof(memstat_record_t);
+  } while (nread > 0);
+
+  close(fd);
+  *np = n;
+  return recs;
+}
+
+static void print_pools(memstat_record_t *recs, size_t n, bool zeros) {
+  printf("%-*s %6s %7s %7s %7s %6s %6s %8s %5s\n", MEMSTAT_NAMELEN, "pool",
+         "size", "inuse", "peak", "total", "slabs", "empty", "kbytes", "frag%");
+
+  for (size_t i = 0; i < n; i++) {
+    memstat_record_t *mr = &recs[i];
+    if (mr->mr_kind != MS_POOL)
+      continue;
+    if (mr->mr_pool.nmaxused == 0 && !zeros)
+      continue;
+
+    uint64_t used = mr->mr_pool.nused * mr->mr_pool.itemsize;
+    uint64_t nbytes = mr->mr_pool.nbytes;
+    unsigned frag = nbytes ? (nbytes - used) * 1000 / nbytes : 0;
+
+    printf("%-*s %6llu %7llu %7llu %7llu %6llu %6llu %8llu %3u.%u\n",
+           MEMSTAT_NAMELEN, mr->mr_name,
+           (unsigned long long)mr->mr_pool.itemsize,
+           (unsigned long long)mr->mr_pool.nused,
+           (unsigned long long)mr->mr_pool.nmaxused,
+           (unsigned long long)mr->mr_pool.ntotal,
+           (unsigned long long)mr->mr_pool.nslabs,
+           (unsigned long long)mr->mr_pool.nempty,
+           (unsigned long long)nbytes / 1024, frag / 10, frag % 10);
+  }
+}
+
+static void print_kmalloc(memstat_record_t *recs, size_t n, bool zeros) {
+  printf("%-*s %10s %8s %10s %10s\n", MEMSTAT_NAMELEN, "type", "requests",
+         "inuse", "kbytes", "peak");
+
+  for (size_t i = 0; i < n; i++) {
+    memstat_record_t *mr = &recs[i];
+    if (mr->mr_kind != MS_KMALLOC)
+      continue;
+    if (mr->mr_kmalloc.nrequests == 0 && !zeros)
+      continue;
+
+    printf("%-*s %10llu %8llu %10llu %10llu\n", MEMSTAT_NAMELEN, mr->mr_name,
+           (unsigned long long)mr->mr_kmalloc.nrequests,
+           (unsigned long long)mr->mr_kmalloc.active,
+           (unsigned long long)mr->mr_kmalloc.used / 1024,
+           (unsigned long long)mr->mr_kmalloc.maxused / 1024);
+  }
+}
+
+static void print_physmem(memstat_record_t *recs, size_t n) {
+  uint64_t npages = 0, nfree = 0;
+
+  printf("%-*s %6s %8s %10s\n", MEMSTAT_NAMELEN, "physmem", "order", "free",
+         "kbytes");
+
+  for (size_t i = 0; i < n; i++) {
+    memstat_record_t *mr = &recs[i];
+    if (mr->mr_kind != MS_PHYSMEM)
+      continue;
+
+    uint64_t pages = mr->mr_physmem.nfree << mr->mr_physmem.order;
+    npages = mr->mr_physmem.npages;
+    nfree += pages;
+
+    printf("%-*s %6llu %8llu %10llu\n", MEMSTAT_NAMELEN, mr->mr_name,
+           (unsigned long long)mr->mr_physmem.order,
+           (unsigned long long)mr->mr_physmem.nfree,
+           (unsigned long long)pages * getpagesize() / 1024);
+  }
+
+  printf("%llu of %llu pages free\n", (unsigned long long)nfree,
+         (unsigned long long)npages);
+}
+
+static void print_memory(bool zeros) {
+  size_t n;
+  memstat_record_t *recs = read_memstat(&n);
+
+  print_pools(recs, n, zeros);
+  printf("\n");
+  print_kmalloc(recs, n, zeros);
+  printf("\n");
+  print_physmem(recs, n);
+
+  free(recs);
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: vmstat [-emz] [-c count] [-w wait]\n");
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  bool eflag = false, mflag = false, zflag = false, cflag = false;
+  int count = 1, wait = 0;
+  int ch;
+
+  while ((ch = getopt(argc, argv, "emzc:w:")) != -1) {
+    switch (ch) {
+      case 'e':
+        eflag = true;
+        break;
+      case 'm':
+        mflag = true;
+        break;
+      case 'z':
+        zflag = true;
+        break;
+      case 'c':
+        count = atoi(optarg);
+        cflag = true;
+        break;
+      case 'w':
+        wait = atoi(optarg);
+        break;
+      default:
+        usage();
+    }
+  }
+
+  if (optind < argc || wait < 0)
+    usage();
+
+  if (mflag) {
+    print_memory(zflag);
+    return EXIT_SUCCESS;
+  }
+
+  /* Interval given without count means run until interrupted. */
+  if (wait > 0 && !cflag)
+    count = 0;
+
+  int fd = open(EVCNT_DEV, O_RDONLY);
+  if (fd < 0)
+    err(EXIT_FAILURE, "%s", EVCNT_DEV);
+
+  sample_t samples[2] = {};
+  sample_t *prev = NULL, *cur = &samples[0];
+
+  for (int i = 0; count == 0 || i < count; i++) {
+    if (i > 0)
+      sleep(wait ? wait : 1);
+
+    take_sample(fd, cur);
+
+    if (eflag) {
+      if (i > 0)
+        printf("\n");
+      print_events(prev, cur, zflag);
+    } else {
+      print_summary(prev, cur, i % 20 == 0);
+    }
+
+    prev = cur;
+    cur = (cur == &samples[0]) ? &samples[1] : &samples[0];
+  }
+
+  close(fd);
+  return EXIT_SUCCESS;
+}